@@ -14,6 +14,7 @@
 #include "soc/rtc_cntl_reg.h"
 #include "driver/ledc.h"
 #include <Update.h>
+#include "deferred_log.h"
 
 // Firmware version to be updated on major milestones
 #define FIRMWARE_VERSION "1.0.0"
@@ -22,12 +23,7 @@
 const char* ssid1 = "MadKatz Hot Rod";
 const char* password1 = "1234567890";
 
-extern volatile unsigned int motor_speed;
-extern void robot_stop();
 extern void robot_setup();
-extern uint8_t robo;
-extern volatile unsigned long previous_time;        
-extern volatile unsigned long move_interval; 
 
 // Camera pinout configuration for AI-THINKER ESP32-CAM
 #define CAMERA_MODEL_AI_THINKER
@@ -143,6 +139,9 @@ void setup() {
   Serial.println("ESP32 CAM Robot Car");
   Serial.printf("Firmware Version: %s\n", FIRMWARE_VERSION);
 
+  // Start the deferred log drain before anything logs from a hot path
+  dlog_start();
+
   // Initialize camera
   initCamera();
 
@@ -158,10 +157,10 @@ void setup() {
   Serial.println(myIP);
   Serial.println("OTA Update available at http://" + myIP.toString() + "/update");
   
-  startCameraServer();
-
-  // Setup robot
+  // Setup robot before the server starts taking drive commands
   robot_setup();
+
+  startCameraServer();
   
   // Flash LED to indicate setup complete
   for (int i=0; i<5; i++) {
@@ -173,23 +172,9 @@ void setup() {
     delay(50);    
   }
   digitalWrite(33, LOW);
-      
-  previous_time = millis();
 }
 
 void loop() {
-  if(robo) {
-    unsigned long currentMillis = millis();
-    if (currentMillis - previous_time >= move_interval) {
-      previous_time = currentMillis;
-      delay(2000); // Add a 2-second delay before stopping the motors
-      robot_stop();
-      char rsp[32];
-      sprintf(rsp, "SPEED: %d", motor_speed);
-      Serial.println("Stop");
-      robo = 0;
-    }
-  }
-  delay(1);
-  yield();
+  // Motor auto-stop is driven by the motion scheduler timer in app_httpd.cpp
+  delay(1000);
 }
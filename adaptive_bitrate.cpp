@@ -0,0 +1,107 @@
+/*
+  ESP32_CAM_Robot_Car
+  adaptive_bitrate.cpp
+  Closed-loop JPEG quality and frame size control for the MJPEG stream
+
+*/
+
+#include "adaptive_bitrate.h"
+
+static bool window_is_bad(const abr_config_t *config, const abr_sample_t *sample)
+{
+  // Allow 20% under the target fps before reacting
+  return sample->fps_x10 * 10 < config->target_fps * 80 || sample->latency_ms > config->max_latency_ms;
+}
+
+static bool window_is_good(const abr_config_t *config, const abr_sample_t *sample)
+{
+  return sample->fps_x10 >= config->target_fps * 10 && sample->latency_ms * 2 <= config->max_latency_ms;
+}
+
+framesize_t abr_next_framesize(const abr_config_t *config, framesize_t framesize, int direction)
+{
+  const int count = sizeof(ABR_FRAMESIZES) / sizeof(ABR_FRAMESIZES[0]);
+  if (direction < 0)
+  {
+    for (int i = count - 1; i >= 0; i--)
+      if (ABR_FRAMESIZES[i] < framesize)
+        return ABR_FRAMESIZES[i] >= config->min_framesize ? ABR_FRAMESIZES[i] : framesize;
+  }
+  else
+  {
+    for (int i = 0; i < count; i++)
+      if (ABR_FRAMESIZES[i] > framesize)
+        return ABR_FRAMESIZES[i] <= config->max_framesize ? ABR_FRAMESIZES[i] : framesize;
+  }
+  return framesize;
+}
+
+abr_action_t abr_step(const abr_config_t *config, abr_state_t *state, const abr_sample_t *sample)
+{
+  abr_action_t action = ABR_HOLD;
+
+  if (window_is_bad(config, sample))
+  {
+    state->good_windows = 0;
+    if (++state->bad_windows >= ABR_DEGRADE_WINDOWS)
+    {
+      state->bad_windows = 0;
+      if (state->quality < config->worst_quality)
+      {
+        int quality = state->quality + ABR_QUALITY_STEP;
+        state->quality = quality > config->worst_quality ? config->worst_quality : quality;
+        action = ABR_DEGRADE_QUALITY;
+      }
+      else if (abr_next_framesize(config, state->framesize, -1) != state->framesize)
+      {
+        state->framesize = abr_next_framesize(config, state->framesize, -1);
+        action = ABR_DEGRADE_FRAMESIZE;
+      }
+    }
+  }
+  else if (window_is_good(config, sample))
+  {
+    state->bad_windows = 0;
+    if (++state->good_windows >= ABR_IMPROVE_WINDOWS)
+    {
+      state->good_windows = 0;
+      if (abr_next_framesize(config, state->framesize, 1) != state->framesize)
+      {
+        state->framesize = abr_next_framesize(config, state->framesize, 1);
+        action = ABR_IMPROVE_FRAMESIZE;
+      }
+      else if (state->quality > config->best_quality)
+      {
+        int quality = state->quality - ABR_QUALITY_STEP;
+        state->quality = quality < config->best_quality ? config->best_quality : quality;
+        action = ABR_IMPROVE_QUALITY;
+      }
+    }
+  }
+  else
+  {
+    // Inside the dead band: keep the current settings and start counting again
+    state->bad_windows = 0;
+    state->good_windows = 0;
+  }
+
+  state->last_action = action;
+  return action;
+}
+
+const char *abr_action_name(abr_action_t action)
+{
+  switch (action)
+  {
+  case ABR_DEGRADE_QUALITY:
+    return "degrade_quality";
+  case ABR_DEGRADE_FRAMESIZE:
+    return "degrade_framesize";
+  case ABR_IMPROVE_FRAMESIZE:
+    return "improve_framesize";
+  case ABR_IMPROVE_QUALITY:
+    return "improve_quality";
+  default:
+    return "hold";
+  }
+}
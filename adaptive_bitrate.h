@@ -0,0 +1,74 @@
+/*
+  ESP32_CAM_Robot_Car
+  adaptive_bitrate.h
+  Closed-loop JPEG quality and frame size control for the MJPEG stream
+
+*/
+
+#ifndef ADAPTIVE_BITRATE_H
+#define ADAPTIVE_BITRATE_H
+
+#include "Arduino.h"
+#include "esp_camera.h"
+
+// Consecutive measurement windows needed before stepping down or up.
+// Stepping up needs more evidence than stepping down, which is the hysteresis.
+#define ABR_DEGRADE_WINDOWS 2
+#define ABR_IMPROVE_WINDOWS 5
+#define ABR_QUALITY_STEP 5
+
+// Frame sizes the controller steps through, smallest first. All are 4:3,
+// so the picture never changes shape or crops; the enum order in between
+// holds 3:2, 1:1 and CIF sizes (HQVGA, 240X240, HVGA, CIF).
+static constexpr framesize_t ABR_FRAMESIZES[] = {
+    FRAMESIZE_QQVGA, FRAMESIZE_QVGA, FRAMESIZE_VGA, FRAMESIZE_SVGA, FRAMESIZE_XGA, FRAMESIZE_UXGA};
+
+typedef struct
+{
+  uint32_t target_fps;
+  uint32_t max_latency_ms;
+  uint8_t best_quality;       // lowest JPEG quality number allowed
+  uint8_t worst_quality;      // highest JPEG quality number allowed
+  framesize_t min_framesize;
+  framesize_t max_framesize;
+} abr_config_t;
+
+// One measurement window as seen by the slowest stream client
+typedef struct
+{
+  uint32_t fps_x10;
+  uint32_t latency_ms;        // capture to end of send, worst frame in the window
+  uint32_t throughput_kbps;   // bytes sent over time spent sending
+} abr_sample_t;
+
+typedef enum
+{
+  ABR_HOLD,
+  ABR_DEGRADE_QUALITY,
+  ABR_DEGRADE_FRAMESIZE,
+  ABR_IMPROVE_FRAMESIZE,
+  ABR_IMPROVE_QUALITY,
+} abr_action_t;
+
+typedef struct
+{
+  uint8_t quality;
+  framesize_t framesize;
+  uint8_t bad_windows;
+  uint8_t good_windows;
+  abr_action_t last_action;
+} abr_state_t;
+
+// Pure controller step: only reads config and sample and updates state.
+// Degrades quality first, then frame size; recovers in the reverse order.
+// Frame size moves along ABR_FRAMESIZES, never to the sizes between them.
+abr_action_t abr_step(const abr_config_t *config, abr_state_t *state, const abr_sample_t *sample);
+
+// Next rung of the 4:3 frame size ladder below (direction < 0) or above
+// framesize, within the config's limits; framesize itself when there is
+// none. A size off the ladder moves to the nearest rung that way.
+framesize_t abr_next_framesize(const abr_config_t *config, framesize_t framesize, int direction);
+
+const char *abr_action_name(abr_action_t action);
+
+#endif
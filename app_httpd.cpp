@@ -20,26 +20,41 @@
 #include "driver/ledc.h"
 #include <Update.h>
 #include <esp32-hal-ledc.h>
+#include "frame_hub.h"
+#include "command_table.h"
+#include "deferred_log.h"
+#include "metrics.h"
+#include "adaptive_bitrate.h"
+#include "web_assets.h"
+#include "rom/miniz.h"
+#include "diff_drive.h"
+#include "motor_output.h"
+#include "endpoint_stats.h"
+#include "command_trace.h"
+#include "motion_macro.h"
+#include "motion_deadline.h"
+#include "udp_stream.h"
+#include "httpd_profile.h"
+#include "telemetry.h"
+#include "multipart_parser.h"
+#include "ota_update.h"
+#include "ota_delta.h"
+#include "blackbox.h"
+#include "mjpeg_avi.h"
+#include "change_detect.h"
 
-#define LEFT_M0 13
-#define LEFT_M1 12
-#define RIGHT_M0 14
-#define RIGHT_M1 15
 #define LED_PIN 4 // Define LED pin
 
 // Define Speed variables
 int speed = 255;
 int noStop = 0;
 
-// Setting Motor PWM properties
-const int freq = 2000;
-const int motorPWMChannnel = 8;
-const int lresolution = 8;
-
-volatile unsigned int motor_speed = 200;
-volatile unsigned long previous_time = 0;
 volatile unsigned long move_interval = 250;
 
+// Motors keep running this long past move_interval before the scheduled
+// stop, matching the run time of the old delay() based stop in loop()
+#define MOTION_RUN_ON_MS 2000
+
 // Placeholder for functions
 void robot_setup();
 void robot_stop();
@@ -48,7 +63,6 @@ void robot_back();
 void robot_left();
 void robot_right();
 void setupLED();
-void test_pwm_output();
 uint8_t robo = 0;
 
 typedef struct
@@ -60,11 +74,61 @@ typedef struct
 #define PART_BOUNDARY "123456789000000000000987654321"
 static const char *_STREAM_CONTENT_TYPE = "multipart/x-mixed-replace;boundary=" PART_BOUNDARY;
 static const char *_STREAM_BOUNDARY = "\r\n--" PART_BOUNDARY "\r\n";
-static const char *_STREAM_PART = "Content-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n";
+static const char *_STREAM_PART = "Content-Type: image/jpeg\r\nContent-Length: %u\r\n"
+                                  "X-Frame-Seq: %u\r\nX-Timestamp: %u.%06u\r\nX-Send-Timestamp: %u.%06u\r\n\r\n";
+// Text of the JPEG COM segment carrying the same fields as the part headers
+static const char *_STREAM_COM = "seq=%u capture=%u.%06u send=%u.%06u";
+#define STREAM_PART_LEN 256
+
+// Give up on a stream client if no new frame arrives within this time
+#define STREAM_FRAME_TIMEOUT_MS 2000
+
+// /ws binary control records, see ws_handler
+#define WS_RECORD_LEN   3
+#define WS_MAX_FRAME_LEN 48
+// Record carrying the client sequence number for the record after it.
+// Not a command, so it must stay out of COMMANDS.
+#define WS_TRACE_SEQ    0x0F
 
 httpd_handle_t stream_httpd = NULL;
 httpd_handle_t camera_httpd = NULL;
 
+// Control runs on core 0 above the stream, so drive commands are not queued
+// behind frame sends. The stream server and its client tasks are not pinned:
+// on core 1 they would share one core with the capture and black-box tasks
+// and every viewer, while core 0 idles between WiFi bursts. Below the
+// capture (6) and encode (5) stages, frames are produced before they are
+// sent wherever the scheduler runs the senders.
+static constexpr httpd_profile_t CONTROL_PROFILE = {
+    "control", 80, 32768,
+    /* core */ 0, /* priority */ 6, /* stack */ 6144,
+    /* sockets */ 6, /* uri handlers */ 16, /* lru purge */ true,
+    /* send, recv timeout s */ 5, 5,
+    /* keepalive idle, interval, count */ 0, 0, 0};
+// Stream sockets are capped at the frame hub viewer limit plus one, so a
+// viewer too many is answered with a 503 instead of LRU-purging a viewer.
+// The black box and UDP stream use reserved hub clients and no socket here.
+// A short send timeout and TCP keepalive release sockets held by viewers
+// that vanished.
+static constexpr httpd_profile_t STREAM_PROFILE = {
+    "stream", 81, 32769,
+    /* core */ tskNO_AFFINITY, /* priority */ 4, /* stack */ 4096,
+    /* sockets */ FRAME_HUB_MAX_CLIENTS + 1, /* uri handlers */ 4, /* lru purge */ true,
+    /* send, recv timeout s */ 2, 5,
+    /* keepalive idle, interval, count */ 5, 2, 3};
+
+#ifdef CONFIG_LWIP_MAX_SOCKETS
+// Each server also holds a listening and a control socket, plus the UDP video socket
+static_assert(CONTROL_PROFILE.max_open_sockets + STREAM_PROFILE.max_open_sockets + 2 * 2 + 1 <= CONFIG_LWIP_MAX_SOCKETS,
+              "httpd socket budget exceeds CONFIG_LWIP_MAX_SOCKETS");
+#endif
+
+// Server and stream client tasks, recorded from inside their handlers for
+// the stack figures in /status
+static TaskHandle_t control_task = NULL;
+static TaskHandle_t stream_task = NULL;
+static volatile uint32_t stream_client_stack_free = UINT32_MAX;
+
 static size_t jpg_encode_stream(void *arg, size_t index, const void *data, size_t len)
 {
   jpg_chunking_t *j = (jpg_chunking_t *)arg;
@@ -80,11 +144,33 @@ static size_t jpg_encode_stream(void *arg, size_t index, const void *data, size_
   return len;
 }
 
+// /capture reuses the newest streamed frame when it is at most this old, so
+// a still does not take a camera buffer away from a running stream
+static int capture_max_age_ms = 200;
+static uint32_t capture_cached = 0;
+static uint32_t capture_grabbed = 0;
+
 static esp_err_t capture_handler(httpd_req_t *req)
 {
   camera_fb_t *fb = NULL;
   esp_err_t res = ESP_OK;
+  char age[16];
+
+  hub_frame_t *frame = frame_hub_acquire_latest((int64_t)capture_max_age_ms * 1000);
+  if (frame)
+  {
+    snprintf(age, sizeof(age), "%u", (uint32_t)((esp_timer_get_time() - frame->timestamp) / 1000));
+    httpd_resp_set_type(req, "image/jpeg");
+    httpd_resp_set_hdr(req, "Content-Disposition", "inline; filename=capture.jpg");
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+    httpd_resp_set_hdr(req, "X-Frame-Age-Ms", age);
+    res = httpd_resp_send(req, (const char *)frame->buf, frame->len);
+    frame_hub_release(frame);
+    capture_cached++;
+    return res;
+  }
 
+  capture_grabbed++;
   fb = esp_camera_fb_get();
   if (!fb)
   {
@@ -96,6 +182,7 @@ static esp_err_t capture_handler(httpd_req_t *req)
   httpd_resp_set_type(req, "image/jpeg");
   httpd_resp_set_hdr(req, "Content-Disposition", "inline; filename=capture.jpg");
   httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  httpd_resp_set_hdr(req, "X-Frame-Age-Ms", "0");
 
   size_t fb_len = 0;
   if (fb->format == PIXFORMAT_JPEG)
@@ -103,6 +190,13 @@ static esp_err_t capture_handler(httpd_req_t *req)
     fb_len = fb->len;
     res = httpd_resp_send(req, (const char *)fb->buf, fb->len);
   }
+  else if ((frame = frame_hub_encode(fb)) != NULL)
+  {
+    // Encoded into a pooled buffer, sent in one piece
+    fb_len = frame->len;
+    res = httpd_resp_send(req, (const char *)frame->buf, frame->len);
+    frame_hub_release(frame);
+  }
   else
   {
     jpg_chunking_t jchunk = {req, 0};
@@ -115,242 +209,1276 @@ static esp_err_t capture_handler(httpd_req_t *req)
   return res;
 }
 
-static esp_err_t stream_handler(httpd_req_t *req) {
-    camera_fb_t *fb = NULL;
-    esp_err_t res = ESP_OK;
-    size_t _jpg_buf_len = 0;
-    uint8_t *_jpg_buf = NULL;
-    char *part_buf[64];
+// Largest frame size the camera buffers were allocated for in initCamera
+static framesize_t max_framesize()
+{
+  return psramFound() ? FRAMESIZE_SVGA : FRAMESIZE_QVGA;
+}
 
-    static int64_t last_frame = 0;
-    if (!last_frame) {
-        last_frame = esp_timer_get_time();
-    }
+// Adaptive bitrate. Stream clients feed per-frame measurements into a shared
+// window; the client that closes a window runs abr_step and applies the result.
+#define ABR_WINDOW_MS 1000
 
-    res = httpd_resp_set_type(req, _STREAM_CONTENT_TYPE);
-    if (res != ESP_OK) {
-        Serial.println("Failed to set response type");
-        return res;
+static bool abr_enabled = false;
+static abr_config_t abr_config = {15, 250, 10, 40, FRAMESIZE_QQVGA, FRAMESIZE_SVGA};
+static abr_state_t abr_state;
+static abr_sample_t abr_last_sample;
+static portMUX_TYPE abr_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Indexed by frame hub client id; only viewers report, and their ids are
+// below FRAME_HUB_MAX_CLIENTS
+static struct
+{
+  int64_t start_us;
+  uint32_t frames[FRAME_HUB_MAX_CLIENTS];
+  uint64_t bytes;
+  uint64_t send_us;
+  uint32_t max_latency_us;
+} abr_window;
+
+static void abr_observe(int client, size_t bytes, uint32_t send_us, uint32_t latency_us)
+{
+  if (!abr_enabled)
+    return;
+
+  bool closed = false;
+  abr_sample_t sample;
+  int64_t now = esp_timer_get_time();
+
+  portENTER_CRITICAL(&abr_lock);
+  if (!abr_window.start_us)
+    abr_window.start_us = now;
+  abr_window.frames[client]++;
+  abr_window.bytes += bytes;
+  abr_window.send_us += send_us;
+  if (latency_us > abr_window.max_latency_us)
+    abr_window.max_latency_us = latency_us;
+
+  int64_t elapsed = now - abr_window.start_us;
+  if (elapsed >= ABR_WINDOW_MS * 1000)
+  {
+    // Rate of the slowest client that sent anything in this window
+    uint32_t frames = UINT32_MAX;
+    for (int i = 0; i < FRAME_HUB_MAX_CLIENTS; i++)
+      if (abr_window.frames[i] && abr_window.frames[i] < frames)
+        frames = abr_window.frames[i];
+    sample.fps_x10 = (uint32_t)(frames * 10000000LL / elapsed);
+    sample.latency_ms = abr_window.max_latency_us / 1000;
+    sample.throughput_kbps = abr_window.send_us ? (uint32_t)(abr_window.bytes * 8000 / abr_window.send_us) : 0;
+    memset(&abr_window, 0, sizeof(abr_window));
+    closed = true;
+  }
+  portEXIT_CRITICAL(&abr_lock);
+
+  if (!closed)
+    return;
+
+  abr_last_sample = sample;
+  sensor_t *s = esp_camera_sensor_get();
+  switch (abr_step(&abr_config, &abr_state, &sample))
+  {
+  case ABR_DEGRADE_QUALITY:
+  case ABR_IMPROVE_QUALITY:
+    s->set_quality(s, abr_state.quality);
+    break;
+  case ABR_DEGRADE_FRAMESIZE:
+  case ABR_IMPROVE_FRAMESIZE:
+    s->set_framesize(s, abr_state.framesize);
+    break;
+  default:
+    break;
+  }
+}
+
+// Build the multipart header for frame, followed by the start of the JPEG
+// itself: SOI and a COM segment with the frame sequence and the capture and
+// send timestamps (esp_timer clock, seconds), so saved frames keep them. The
+// caller then sends frame->buf from *skip on.
+static size_t stream_part(char *buf, size_t len, const hub_frame_t *frame, int64_t send_us, size_t *skip)
+{
+  uint32_t cap_s = frame->timestamp / 1000000, cap_us = frame->timestamp % 1000000;
+  uint32_t send_s = send_us / 1000000, send_frac = send_us % 1000000;
+  char com[64];
+  int com_len = 0;
+  *skip = 0;
+  if (frame->len >= 2 && frame->buf[0] == 0xFF && frame->buf[1] == 0xD8)
+  {
+    com_len = snprintf(com, sizeof(com), _STREAM_COM, frame->seq, cap_s, cap_us, send_s, send_frac);
+    *skip = 2;
+  }
+
+  // SOI is resent from here, so the COM marker, length and text are extra
+  size_t content_len = frame->len + (com_len ? 4 + com_len : 0);
+  size_t n = snprintf(buf, len, _STREAM_PART, content_len, frame->seq, cap_s, cap_us, send_s, send_frac);
+  if (com_len)
+  {
+    uint16_t seg_len = com_len + 2;
+    const uint8_t marker[6] = {0xFF, 0xD8, 0xFF, 0xFE, (uint8_t)(seg_len >> 8), (uint8_t)seg_len};
+    memcpy(buf + n, marker, sizeof(marker));
+    memcpy(buf + n + sizeof(marker), com, com_len);
+    n += sizeof(marker) + com_len;
+  }
+  return n;
+}
+
+// Still-scene skipping for /stream, off until change_skip sets a threshold.
+// Each client keeps its own detector; the counters cover all of them.
+static volatile uint16_t change_skip_permille = 0;
+static volatile uint32_t change_keepalive_ms = 1000;
+static uint32_t change_skipped = 0;
+static uint64_t change_saved_bytes = 0;
+static portMUX_TYPE change_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Each /stream viewer runs in its own task so the stream server stays free
+// to accept more connections. All viewers share the frames grabbed by frame_hub.
+static void stream_client_task(void *arg) {
+    httpd_req_t *req = (httpd_req_t *)arg;
+    esp_err_t res = ESP_OK;
+    char part_buf[STREAM_PART_LEN];
+    uint32_t last_seq = 0;
+    uint32_t skipped = 0;
+    int64_t last_frame = esp_timer_get_time();
+    change_detect_t change = {};
+
+    int client = frame_hub_attach();
+    if (client < 0) {
+        dlog_write(DLOG_STREAM_ERROR, client, (uintptr_t)"too many clients");
+        res = ESP_FAIL;
+    } else {
+        res = httpd_resp_set_type(req, _STREAM_CONTENT_TYPE);
+        if (res != ESP_OK) {
+            dlog_write(DLOG_STREAM_ERROR, client, (uintptr_t)"failed to set response type");
+        }
     }
 
-    while (true) {
-        fb = esp_camera_fb_get();
-        if (!fb) {
-            Serial.println("Camera capture failed");
+    while (res == ESP_OK) {
+        hub_frame_t *frame = frame_hub_acquire(last_seq, pdMS_TO_TICKS(STREAM_FRAME_TIMEOUT_MS));
+        if (!frame) {
+            dlog_write(DLOG_STREAM_ERROR, client, (uintptr_t)"no frame from camera");
             res = ESP_FAIL;
-        } else {
-            if (fb->format != PIXFORMAT_JPEG) {
-                bool jpeg_converted = frame2jpg(fb, 80, &_jpg_buf, &_jpg_buf_len);
-                esp_camera_fb_return(fb);
-                fb = NULL;
-                if (!jpeg_converted) {
-                    Serial.println("JPEG compression failed");
-                    res = ESP_FAIL;
-                }
-            } else {
-                _jpg_buf_len = fb->len;
-                _jpg_buf = fb->buf;
-            }
+            break;
+        }
+        if (last_seq && frame->seq > last_seq + 1) {
+            skipped += frame->seq - last_seq - 1;
+        }
+        last_seq = frame->seq;
+
+        if (change_skip_permille &&
+            !change_detect_send(&change, frame->len, frame->timestamp, change_skip_permille, change_keepalive_ms)) {
+            portENTER_CRITICAL(&change_lock);
+            change_skipped++;
+            change_saved_bytes += frame->len;
+            portEXIT_CRITICAL(&change_lock);
+            frame_hub_release(frame);
+            // Count it as delivered so adaptive bitrate does not read a
+            // still scene as a slow link
+            abr_observe(client, 0, 0, 0);
+            continue;
         }
 
-        if (res == ESP_OK) {
-            size_t hlen = snprintf((char *)part_buf, 64, _STREAM_PART, _jpg_buf_len);
-            res = httpd_resp_send_chunk(req, (const char *)part_buf, hlen);
-            if (res != ESP_OK) {
-                Serial.println("Failed to send JPEG header");
-            }
+        int64_t send_start = esp_timer_get_time();
+        size_t skip;
+        size_t hlen = stream_part(part_buf, sizeof(part_buf), frame, send_start, &skip);
+        res = httpd_resp_send_chunk(req, part_buf, hlen);
+        histogram_observe_since(&metric_send_header, send_start);
+        if (res != ESP_OK) {
+            dlog_write(DLOG_STREAM_ERROR, client, (uintptr_t)"failed to send JPEG header");
         }
 
         if (res == ESP_OK) {
-            res = httpd_resp_send_chunk(req, (const char *)_jpg_buf, _jpg_buf_len);
+            int64_t start = esp_timer_get_time();
+            res = httpd_resp_send_chunk(req, (const char *)frame->buf + skip, frame->len - skip);
+            histogram_observe_since(&metric_send_data, start);
             if (res != ESP_OK) {
-                Serial.println("Failed to send JPEG data");
+                dlog_write(DLOG_STREAM_ERROR, client, (uintptr_t)"failed to send JPEG data");
             }
         }
 
         if (res == ESP_OK) {
+            int64_t start = esp_timer_get_time();
             res = httpd_resp_send_chunk(req, _STREAM_BOUNDARY, strlen(_STREAM_BOUNDARY));
+            histogram_observe_since(&metric_send_boundary, start);
             if (res != ESP_OK) {
-                Serial.println("Failed to send stream boundary");
+                dlog_write(DLOG_STREAM_ERROR, client, (uintptr_t)"failed to send stream boundary");
             }
         }
 
-        if (fb) {
-            esp_camera_fb_return(fb);
-            fb = NULL;
-            _jpg_buf = NULL;
-        } else if (_jpg_buf) {
-            free(_jpg_buf);
-            _jpg_buf = NULL;
-        }
+        size_t frame_len = frame->len;
+        int64_t captured_us = frame->timestamp;
+        frame_hub_release(frame);
 
         if (res != ESP_OK) {
             break;
         }
 
         int64_t fr_end = esp_timer_get_time();
+        frame_hub_record_send((uint32_t)(fr_end - send_start));
+        abr_observe(client, frame_len, (uint32_t)(fr_end - send_start), (uint32_t)(fr_end - captured_us));
         int64_t frame_time = fr_end - last_frame;
         last_frame = fr_end;
         frame_time /= 1000;
-        Serial.printf("MJPG: %uB %ums (%.1ffps)\n", (uint32_t)(_jpg_buf_len), (uint32_t)frame_time, 1000.0 / (uint32_t)frame_time);
+        dlog_write(DLOG_MJPG_FRAME, client, frame_len, (uint32_t)frame_time, frame_time ? 1000 / (uint32_t)frame_time : 0, skipped);
+    }
+
+    frame_hub_detach(client);
+    httpd_req_async_handler_complete(req);
+    uint32_t stack_free = uxTaskGetStackHighWaterMark(NULL);
+    if (stack_free < stream_client_stack_free) {
+        stream_client_stack_free = stack_free;
+    }
+    vTaskDelete(NULL);
+}
+
+static esp_err_t stream_handler(httpd_req_t *req) {
+    stream_task = xTaskGetCurrentTaskHandle();
+    frame_hub_stats_t stats;
+    frame_hub_get_stats(&stats);
+    if (stats.clients >= FRAME_HUB_MAX_CLIENTS) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        return httpd_resp_sendstr(req, "Too many stream clients");
+    }
+
+    httpd_req_t *async_req = NULL;
+    if (httpd_req_async_handler_begin(req, &async_req) != ESP_OK) {
+        Serial.println("Failed to start stream client");
+        return ESP_FAIL;
+    }
+    if (xTaskCreatePinnedToCore(stream_client_task, "stream_client", 4096, async_req,
+                                STREAM_PROFILE.priority, NULL, STREAM_PROFILE.core) != pdPASS) {
+        Serial.println("Failed to create stream client task");
+        httpd_req_async_handler_complete(async_req);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+enum state
+{
+  fwd,
+  rev,
+  stp
+};
+state actstate = stp;
+
+static esp_err_t set_flash(int duty)
+{
+  ledc_channel_config_t flash_channel;
+  flash_channel.gpio_num = 4;  // Flash LED pin
+  flash_channel.speed_mode = LEDC_LOW_SPEED_MODE;
+  flash_channel.channel = LEDC_CHANNEL_7;
+  flash_channel.intr_type = LEDC_INTR_DISABLE;
+  flash_channel.timer_sel = LEDC_TIMER_1;
+  flash_channel.duty = duty;
+  flash_channel.hpoint = 0;
+  flash_channel.flags.output_invert = 0;
+  return ledc_channel_config(&flash_channel);
+}
+
+static esp_err_t set_speed(int val)
+{
+  speed = val;
+  return ESP_OK;
+}
+
+static esp_err_t set_nostop(int val)
+{
+  noStop = val;
+  return ESP_OK;
+}
+
+static esp_err_t set_loglevel(int val)
+{
+  dlog_set_level((dlog_level_t)val);
+  return ESP_OK;
+}
+
+static esp_err_t set_adaptive(int val)
+{
+  sensor_t *s = esp_camera_sensor_get();
+  if (val && s->pixformat != PIXFORMAT_JPEG)
+    return ESP_ERR_INVALID_STATE;
+
+  portENTER_CRITICAL(&abr_lock);
+  memset(&abr_window, 0, sizeof(abr_window));
+  portEXIT_CRITICAL(&abr_lock);
+  // Start from the current sensor settings and never go above the frame
+  // size the camera buffers were allocated for
+  abr_state.quality = s->status.quality;
+  abr_state.framesize = s->status.framesize;
+  abr_state.bad_windows = 0;
+  abr_state.good_windows = 0;
+  abr_state.last_action = ABR_HOLD;
+  abr_config.max_framesize = max_framesize();
+  abr_enabled = val;
+  return ESP_OK;
+}
+
+static esp_err_t set_target_fps(int val)
+{
+  abr_config.target_fps = val;
+  return ESP_OK;
+}
+
+static esp_err_t set_capture_age(int val)
+{
+  capture_max_age_ms = val;
+  return ESP_OK;
+}
+
+// Size change, in tenths of a percent, below which stream frames count as
+// unchanged and are skipped; 0 sends every frame
+static esp_err_t set_change_skip(int val)
+{
+  change_skip_permille = val;
+  return ESP_OK;
+}
+
+// Longest gap between frames sent while the scene is still
+static esp_err_t set_change_keepalive(int val)
+{
+  change_keepalive_ms = val;
+  return ESP_OK;
+}
+
+static esp_err_t set_framesize(int val)
+{
+  sensor_t *s = esp_camera_sensor_get();
+  if (s->pixformat != PIXFORMAT_JPEG)
+    return ESP_ERR_INVALID_STATE;
+  return s->set_framesize(s, (framesize_t)val) ? ESP_FAIL : ESP_OK;
+}
+
+static esp_err_t set_quality(int val)
+{
+  sensor_t *s = esp_camera_sensor_get();
+  return s->set_quality(s, val) ? ESP_FAIL : ESP_OK;
+}
+
+// Motion scheduler. Each drive command arms a one-shot esp_timer for its
+// stop deadline; a later command re-arms it under motion_lock, so a stale
+// timer callback can never stop a move that started after it fired. See
+// motion_deadline.h.
+static SemaphoreHandle_t motion_lock = NULL;
+static motion_deadline_t motion_deadline = {};
+static volatile uint32_t stop_latency_us = 0;
+static volatile uint32_t stop_latency_max_us = 0;
+
+// Continuous drive state, all guarded by motion_lock. See drive_task.
+static bool drive_active = false;
+static int drive_linear = 0;
+static int drive_angular = 0;
+static int64_t drive_last_us = 0;
+static int drive_ramp_rate = 1000;  // duty change per second
+static int drive_left = 0;          // signed duty currently applied per side
+static int drive_right = 0;
+static uint32_t drive_trace = 0;    // latency trace waiting for the next tick
+
+// Motion macro executor state, guarded by motion_lock. See macro_advance.
+static esp_timer_handle_t macro_timer = NULL;
+static macro_t macro;
+static macro_state_t macro_state = MACRO_IDLE;
+static uint8_t macro_step = 0;
+static int64_t macro_start_us = 0;
+static int64_t macro_due_us = 0;     // when the current step ends
+static int64_t macro_end_us = 0;     // when the macro finished or was cancelled
+
+static void motion_timer_cb(void *arg)
+{
+  xSemaphoreTake(motion_lock, portMAX_DELAY);
+  int64_t deadline = motion_deadline_expired(&motion_deadline);
+  if (deadline)
+  {
+    robot_stop();
+    // Time from the deadline until the stop reached the PWM outputs
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - deadline);
+    stop_latency_us = latency;
+    if (latency > stop_latency_max_us)
+      stop_latency_max_us = latency;
+    robo = 0;
+  }
+  xSemaphoreGive(motion_lock);
+}
+
+// Apply macro step macro_step and arm the timer for its end, or stop after
+// the last one. Step ends are measured from the macro start rather than from
+// when the previous callback ran, so timer latency does not accumulate.
+// Called with motion_lock held.
+static void macro_advance()
+{
+  if (macro_step >= macro.count)
+  {
+    robot_stop();
+    macro_state = MACRO_DONE;
+    macro_end_us = esp_timer_get_time();
+    robo = 0;
+    dlog_write(DLOG_MACRO, (uintptr_t)"done", macro_step, macro.count);
+    return;
+  }
+  const macro_step_t *step = &macro.steps[macro_step];
+  motor_output_motion((motion_t)step->motion, step->duty);
+  macro_due_us += (int64_t)step->duration_ms * 1000;
+  int64_t wait = macro_due_us - esp_timer_get_time();
+  esp_timer_start_once(macro_timer, wait > 0 ? wait : 1);
+}
+
+static void macro_timer_cb(void *arg)
+{
+  xSemaphoreTake(motion_lock, portMAX_DELAY);
+  if (macro_state == MACRO_RUNNING)
+  {
+    macro_step++;
+    macro_advance();
+  }
+  xSemaphoreGive(motion_lock);
+}
+
+// Stop a running macro where it is. Called with motion_lock held; the caller
+// decides what the motors do next.
+static void macro_cancel()
+{
+  if (macro_state != MACRO_RUNNING)
+    return;
+  esp_timer_stop(macro_timer);
+  macro_state = MACRO_CANCELLED;
+  macro_end_us = esp_timer_get_time();
+  dlog_write(DLOG_MACRO, (uintptr_t)"cancelled", macro_step, macro.count);
+}
+
+static void motion_setup()
+{
+  motion_lock = xSemaphoreCreateMutex();
+  esp_timer_create_args_t args = {};
+  args.callback = motion_timer_cb;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "motion_stop";
+  esp_timer_create(&args, &motion_deadline.timer);
+
+  args.callback = macro_timer_cb;
+  args.name = "motion_macro";
+  esp_timer_create(&args, &macro_timer);
+}
+
+// Apply a motion and schedule its stop move_interval + MOTION_RUN_ON_MS later
+static void motion_run(void (*move)())
+{
+  xSemaphoreTake(motion_lock, portMAX_DELAY);
+  macro_cancel();
+  drive_active = false;
+  move();
+  motion_deadline_arm(&motion_deadline, (uint64_t)(move_interval + MOTION_RUN_ON_MS) * 1000);
+  robo = 1;
+  xSemaphoreGive(motion_lock);
+}
+
+static void motion_stop()
+{
+  xSemaphoreTake(motion_lock, portMAX_DELAY);
+  macro_cancel();
+  drive_active = false;
+  motion_deadline_cancel(&motion_deadline);
+  robot_stop();
+  robo = 0;
+  xSemaphoreGive(motion_lock);
+}
+
+// Replace whatever is moving the car with a macro and start its first step
+static void macro_run(const macro_t *m)
+{
+  xSemaphoreTake(motion_lock, portMAX_DELAY);
+  macro_cancel();
+  drive_active = false;
+  motion_deadline_cancel(&motion_deadline);
+  macro = *m;
+  macro_state = MACRO_RUNNING;
+  macro_step = 0;
+  macro_start_us = esp_timer_get_time();
+  macro_due_us = macro_start_us;
+  robo = 1;
+  dlog_write(DLOG_MACRO, (uintptr_t)"started", 0, macro.count);
+  macro_advance();
+  xSemaphoreGive(motion_lock);
+}
+
+// Cancel a running macro and stop the motors
+static void macro_stop()
+{
+  xSemaphoreTake(motion_lock, portMAX_DELAY);
+  if (macro_state == MACRO_RUNNING)
+  {
+    macro_cancel();
+    robot_stop();
+    robo = 0;
+  }
+  xSemaphoreGive(motion_lock);
+}
+
+// Continuous drive. The drive command sets a linear/angular velocity target
+// that this 50 Hz task mixes into per-side duty and ramps towards, limiting
+// the duty change per tick so motor inrush stays below brownout levels.
+// Without a fresh command for DRIVE_TIMEOUT_MS the target falls back to zero.
+#define DRIVE_PERIOD_MS 20
+#define DRIVE_TIMEOUT_MS 500
+
+static void drive_task(void *arg)
+{
+  TickType_t wake = xTaskGetTickCount();
+  while (true)
+  {
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(DRIVE_PERIOD_MS));
+
+    xSemaphoreTake(motion_lock, portMAX_DELAY);
+    if (drive_active)
+    {
+      if (esp_timer_get_time() - drive_last_us > DRIVE_TIMEOUT_MS * 1000)
+      {
+        // Driving without a link is what the black box is for
+        if (drive_linear || drive_angular)
+          blackbox_freeze("drive timeout", BLACKBOX_POST_MS);
+        drive_linear = 0;
+        drive_angular = 0;
+      }
+      int left, right;
+      diff_drive_mix(drive_linear, drive_angular, speed, &left, &right);
+
+      int step = drive_ramp_rate * DRIVE_PERIOD_MS / 1000;
+      left = diff_drive_slew(drive_left, left, step);
+      right = diff_drive_slew(drive_right, right, step);
+      if (left != drive_left || right != drive_right)
+      {
+        drive_left = left;
+        drive_right = right;
+        motor_output_sides(left, right);
+      }
+      if (drive_trace)
+      {
+        trace_actuate(drive_trace, motor_output_applied_us());
+        drive_trace = 0;
+      }
+      if (!drive_linear && !drive_angular && !left && !right)
+      {
+        drive_active = false;
+        robo = 0;
+      }
+    }
+    xSemaphoreGive(motion_lock);
+  }
+}
+
+// val packs two signed bytes: linear velocity in the high byte and angular
+// velocity in the low byte, each -100..100 percent. For example forward at
+// half speed while turning left at 20% is (50 << 8) | 20.
+static esp_err_t set_drive(int val)
+{
+  int linear = (int8_t)(val >> 8);
+  int angular = (int8_t)(val & 0xff);
+  if (abs(linear) > DIFF_DRIVE_SCALE || abs(angular) > DIFF_DRIVE_SCALE)
+    return ESP_ERR_INVALID_ARG;
+
+  xSemaphoreTake(motion_lock, portMAX_DELAY);
+  // Take over from any discrete move or macro and its pending stop
+  macro_cancel();
+  motion_deadline_cancel(&motion_deadline);
+  if (!drive_active)
+  {
+    robot_stop();
+    drive_left = 0;
+    drive_right = 0;
+  }
+  drive_active = true;
+  drive_linear = linear;
+  drive_angular = angular;
+  drive_last_us = esp_timer_get_time();
+  robo = 1;
+  xSemaphoreGive(motion_lock);
+  return ESP_OK;
+}
+
+static esp_err_t set_ramp_rate(int val)
+{
+  xSemaphoreTake(motion_lock, portMAX_DELAY);
+  drive_ramp_rate = val;
+  xSemaphoreGive(motion_lock);
+  return ESP_OK;
+}
+
+static esp_err_t set_latency_trace(int val)
+{
+  return trace_set_enabled(val);
+}
+
+// Telemetry push on /events, see events_client_task
+#define EVENTS_MAX_CLIENTS 1
+#define EVENTS_BUF_LEN 512
+// Reconnect delay asked of a stream displaced by a newer one, so two open
+// pages take turns slowly instead of displacing each other every 2 s
+#define EVENTS_DISPLACED_RETRY_MS 30000
+// Comment line sent when nothing changed for this long, so proxies and the
+// browser keep the connection open
+#define EVENTS_KEEPALIVE_MS 15000
+static volatile int event_interval_ms = 500;
+
+// When the control server is full, LRU purge closes the session that least
+// recently received a request. Event streams and the /ws channel of a
+// driver holding still receive nothing, so either would be the one to go.
+// Together they leave this many sockets for ordinary requests, as many as a
+// page polling /status and sending /control keeps open.
+#define CONTROL_REQUEST_SOCKETS 4
+static_assert(1 + EVENTS_MAX_CLIENTS + CONTROL_REQUEST_SOCKETS <= CONTROL_PROFILE.max_open_sockets,
+              "/ws and /events clients leave too few control sockets for requests");
+
+static esp_err_t set_event_ms(int val)
+{
+  event_interval_ms = val;
+  return ESP_OK;
+}
+
+// Drive directions shared by /control (var=car) and the /ws channel
+static esp_err_t robot_drive(int dir)
+{
+  if (dir == 1)
+    motion_run(robot_fwd);
+  else if (dir == 2)
+    motion_run(robot_left);
+  else if (dir == 3)
+    motion_stop();
+  else if (dir == 4)
+    motion_run(robot_right);
+  else if (dir == 5)
+    motion_run(robot_back);
+  return ESP_OK;
+}
+
+// Every command accepted by /control and /ws. Adding a command is one row;
+// values outside [min, max] are rejected before the handler runs.
+static constexpr command_t COMMANDS[] = {
+    // name        opcode min  max  handler
+    {"car",        0x01,  1,   5,   robot_drive},
+    {"speed",      0x02,  0,   255, set_speed},
+    {"flash",      0x03,  0,   256, set_flash},
+    {"framesize",  0x04,  0,   FRAMESIZE_INVALID - 1, set_framesize},
+    {"quality",    0x05,  0,   63,  set_quality},
+    {"nostop",     0x06,  0,   1,   set_nostop},
+    {"flashoff",   0x07,  0,   256, set_flash},
+    {"loglevel",   0x08,  DLOG_LEVEL_ERROR, DLOG_LEVEL_DEBUG, set_loglevel},
+    {"adaptive",   0x09,  0,   1,   set_adaptive},
+    {"target_fps", 0x0A,  1,   30,  set_target_fps},
+    {"capture_age", 0x0B, 0,   5000, set_capture_age},
+    {"drive",      0x0C,  INT16_MIN, INT16_MAX, set_drive},
+    {"ramp_rate",  0x0D,  50,  5000, set_ramp_rate},
+    {"latency_trace", 0x0E, 0, 1,   set_latency_trace},
+    // 0x0F is WS_TRACE_SEQ
+    {"event_ms",   0x10,  50,  5000, set_event_ms},
+    {"change_skip", 0x11, 0,   200, set_change_skip},
+    {"change_keepalive", 0x12, 100, 10000, set_change_keepalive},
+};
+static constexpr command_index_t COMMAND_INDEX = command_index_build(COMMANDS);
+static_assert(COMMAND_INDEX.valid, "command name hash or opcode collision, grow COMMAND_BUCKETS");
+
+// received_us is when the request carrying the command arrived, used to
+// measure command-to-PWM latency for drive commands. seq and client_ms are
+// the optional client fields recorded with the latency trace.
+static esp_err_t run_command(const command_t *cmd, int val, int64_t received_us,
+                             uint16_t seq = 0, uint32_t client_ms = 0)
+{
+  if (!command_in_range(cmd, val))
+  {
+    dlog_write(DLOG_COMMAND_RANGE, (uintptr_t)cmd->name, val);
+    blackbox_command(cmd->name, val, received_us, ESP_ERR_INVALID_ARG);
+    return ESP_ERR_INVALID_ARG;
+  }
+  uint32_t trace = trace_begin(cmd->opcode, val, seq, client_ms, received_us);
+  dlog_write(DLOG_COMMAND, (uintptr_t)cmd->name, val);
+  trace_dispatch(trace, esp_timer_get_time());
+  esp_err_t res = cmd->handler(val);
+  if (cmd->handler == robot_drive)
+  {
+    histogram_observe_since(&metric_cmd_to_pwm, received_us);
+    trace_actuate(trace, motor_output_applied_us());
+  }
+  else if (cmd->handler == set_drive && trace && res == ESP_OK)
+  {
+    // Continuous drive reaches the outputs on the next drive_task tick
+    xSemaphoreTake(motion_lock, portMAX_DELAY);
+    drive_trace = trace;
+    xSemaphoreGive(motion_lock);
+  }
+  else
+  {
+    trace_actuate(trace, esp_timer_get_time());
+  }
+  blackbox_command(cmd->name, val, received_us, res);
+  return res;
+}
+
+static esp_err_t control_request(httpd_req_t *req, int64_t received_us)
+{
+  char query[COMMAND_MAX_QUERY];
+  const char *variable;
+  const char *value;
+  const char *seq_str = NULL;
+  const char *ts_str = NULL;
+  int val;
+
+  size_t query_len = httpd_req_get_url_query_len(req);
+  if (query_len >= sizeof(query))
+  {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Query too long");
+    return ESP_FAIL;
+  }
+  if (!query_len || httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+      !command_parse_query(query, &variable, &value, &seq_str, &ts_str))
+  {
+    httpd_resp_send_404(req);
+    return ESP_FAIL;
+  }
+
+  const command_t *cmd = command_find(COMMANDS, COMMAND_INDEX, variable);
+  if (!cmd)
+  {
+    httpd_resp_send_404(req);
+    return ESP_FAIL;
+  }
+  if (!command_parse_int(value, &val))
+  {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid value");
+    return ESP_FAIL;
+  }
+
+  // Trace fields are best effort; a malformed one is ignored, not rejected
+  uint16_t seq = seq_str ? (uint16_t)strtoul(seq_str, NULL, 10) : 0;
+  uint32_t client_ms = ts_str ? strtoul(ts_str, NULL, 10) : 0;
+
+  esp_err_t res = run_command(cmd, val, received_us, seq, client_ms);
+  if (res == ESP_ERR_INVALID_ARG)
+  {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Value out of range");
+    return ESP_FAIL;
+  }
+  if (res != ESP_OK)
+  {
+    httpd_resp_send_500(req);
+    return ESP_FAIL;
+  }
+
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  return httpd_resp_send(req, NULL, 0);
+}
+
+static esp_err_t cmd_handler(httpd_req_t *req)
+{
+  int64_t received_us = esp_timer_get_time();
+  esp_err_t res = control_request(req, received_us);
+  histogram_observe_since(&metric_control, received_us);
+  return res;
+}
+
+// Binary control channel on /ws. Each WebSocket frame carries one or more
+// 3 byte records: opcode followed by a signed 16 bit little endian value.
+// Opcodes come from COMMANDS. Every record is answered with [opcode, status]
+// so clients can time round trips. A WS_TRACE_SEQ record sets the client
+// sequence number traced for the record that follows it.
+static esp_err_t ws_handler(httpd_req_t *req)
+{
+  if (req->method == HTTP_GET)
+  {
+    Serial.println("WebSocket control client connected");
+    return ESP_OK;
+  }
+
+  uint8_t buf[WS_MAX_FRAME_LEN];
+  uint8_t ack[WS_MAX_FRAME_LEN / WS_RECORD_LEN * 2];
+  httpd_ws_frame_t frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.payload = buf;
+
+  esp_err_t ret = httpd_ws_recv_frame(req, &frame, sizeof(buf));
+  int64_t received_us = esp_timer_get_time();
+  if (ret != ESP_OK)
+  {
+    Serial.printf("WebSocket receive failed: 0x%x\n", ret);
+    return ret;
+  }
+  if (frame.type != HTTPD_WS_TYPE_BINARY)
+  {
+    return ESP_OK;
+  }
+
+  size_t ack_len = 0;
+  uint16_t seq = 0;
+  for (size_t i = 0; i + WS_RECORD_LEN <= frame.len; i += WS_RECORD_LEN)
+  {
+    int val = (int16_t)(buf[i + 1] | (buf[i + 2] << 8));
+    if (buf[i] == WS_TRACE_SEQ)
+    {
+      seq = (uint16_t)val;
+      continue;
+    }
+    const command_t *cmd = command_find(COMMANDS, COMMAND_INDEX, buf[i]);
+    ack[ack_len++] = buf[i];
+    ack[ack_len++] = cmd && run_command(cmd, val, received_us, seq) == ESP_OK ? 0 : 1;
+    seq = 0;
+  }
+
+  httpd_ws_frame_t reply;
+  memset(&reply, 0, sizeof(reply));
+  reply.type = HTTPD_WS_TYPE_BINARY;
+  reply.payload = ack;
+  reply.len = ack_len;
+  return httpd_ws_send_frame(req, &reply);
+}
+
+histogram_t metric_fb_get = HISTOGRAM_INIT("robot_fb_get", "Time waiting for a camera frame buffer");
+histogram_t metric_jpeg_encode = HISTOGRAM_INIT("robot_jpeg_encode", "Time copying or converting a frame to JPEG");
+histogram_t metric_send_header = HISTOGRAM_INIT("robot_stream_send_header", "Time sending a multipart part header");
+histogram_t metric_send_data = HISTOGRAM_INIT("robot_stream_send_data", "Time sending JPEG data");
+histogram_t metric_send_boundary = HISTOGRAM_INIT("robot_stream_send_boundary", "Time sending a multipart boundary");
+histogram_t metric_control = HISTOGRAM_INIT("robot_control_request", "Time handling a /control request");
+histogram_t metric_cmd_to_pwm = HISTOGRAM_INIT("robot_command_to_pwm", "Time from drive command receipt to PWM update");
+
+static histogram_t *const METRICS[] = {
+    &metric_fb_get, &metric_jpeg_encode, &metric_send_header, &metric_send_data,
+    &metric_send_boundary, &metric_control, &metric_cmd_to_pwm};
+
+static esp_err_t metrics_handler(httpd_req_t *req)
+{
+  char buf[1536];
+  httpd_resp_set_type(req, "text/plain; version=0.0.4");
+  for (size_t i = 0; i < sizeof(METRICS) / sizeof(METRICS[0]); i++)
+  {
+    size_t len = histogram_format(METRICS[i], buf, sizeof(buf));
+    if (len && httpd_resp_send_chunk(req, buf, len) != ESP_OK)
+      return ESP_FAIL;
+  }
+  for (size_t i = 0; i < endpoint_stats_families(); i++)
+  {
+    size_t len = endpoint_stats_format(i, buf, sizeof(buf));
+    if (len && httpd_resp_send_chunk(req, buf, len) != ESP_OK)
+      return ESP_FAIL;
+  }
+  return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// Motion macros. /macro?run=<steps> validates and starts a sequence (see
+// macro_parse for the format), /macro?cancel=1 stops it, and every request
+// answers with the executor's progress.
+static esp_err_t macro_handler(httpd_req_t *req)
+{
+  char query[MACRO_MAX_QUERY];
+  char steps[MACRO_MAX_QUERY];
+  char cancel[4];
+  static macro_t parsed;  // too big for the httpd stack, only used here
+
+  size_t query_len = httpd_req_get_url_query_len(req);
+  if (query_len >= sizeof(query))
+  {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Query too long");
+    return ESP_FAIL;
+  }
+  if (query_len && httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK)
+  {
+    if (httpd_query_key_value(query, "run", steps, sizeof(steps)) == ESP_OK)
+    {
+      const char *error = macro_parse(steps, &parsed);
+      if (error)
+      {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, error);
+        return ESP_FAIL;
+      }
+      macro_run(&parsed);
+    }
+    else if (httpd_query_key_value(query, "cancel", cancel, sizeof(cancel)) == ESP_OK)
+    {
+      macro_stop();
+    }
+  }
+
+  char json[160];
+  xSemaphoreTake(motion_lock, portMAX_DELAY);
+  int64_t end_us = macro_state == MACRO_RUNNING ? esp_timer_get_time() : macro_end_us;
+  snprintf(json, sizeof(json),
+           "{\"state\":\"%s\",\"step\":%u,\"steps\":%u,\"elapsed_ms\":%u,\"total_ms\":%u}",
+           macro_state_name(macro_state), macro_step, macro.count,
+           macro_state == MACRO_IDLE ? 0 : (uint32_t)((end_us - macro_start_us) / 1000), macro.total_ms);
+  xSemaphoreGive(motion_lock);
+
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  return httpd_resp_sendstr(req, json);
+}
+
+// Recent command traces, oldest first. Times are microseconds relative to
+// receipt of the request that carried the command.
+static esp_err_t trace_handler(httpd_req_t *req)
+{
+  static trace_t traces[TRACE_RING_SIZE];  // only touched from the httpd task
+  char buf[160];
+  size_t n = trace_snapshot(traces, TRACE_RING_SIZE);
+
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  snprintf(buf, sizeof(buf), "{\"enabled\":%u,\"traces\":[", trace_enabled);
+  if (httpd_resp_sendstr_chunk(req, buf) != ESP_OK)
+    return ESP_FAIL;
+  for (size_t i = 0; i < n; i++)
+  {
+    const command_t *cmd = command_find(COMMANDS, COMMAND_INDEX, traces[i].opcode);
+    snprintf(buf, sizeof(buf),
+             "%s{\"seq\":%u,\"t\":%u,\"cmd\":\"%s\",\"val\":%d,\"received_us\":%lld,\"dispatch_us\":%u,\"actuate_us\":%u}",
+             i ? "," : "", traces[i].seq, traces[i].client_ms, cmd ? cmd->name : "?", traces[i].value,
+             (long long)traces[i].received_us, traces[i].dispatch_us, traces[i].actuate_us);
+    if (httpd_resp_sendstr_chunk(req, buf) != ESP_OK)
+      return ESP_FAIL;
+  }
+  if (httpd_resp_sendstr_chunk(req, "]}") != ESP_OK)
+    return ESP_FAIL;
+  return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// Frozen recording as an MJPEG AVI. Frames are sent straight from the PSRAM
+// ring; the AVI frame rate is the average over the recording, exact capture
+// times are in the commands sidecar.
+static esp_err_t blackbox_send_video(httpd_req_t *req, uint16_t count)
+{
+  uint8_t buf[AVI_HEADER_LEN];
+  blackbox_frame_t frame, first = {}, last = {};
+  const uint8_t *jpeg;
+  uint32_t movi_len = 0;
+  uint32_t max_frame = 0;
+  uint16_t width = 0, height = 0;
+
+  for (uint16_t i = 0; i < count && blackbox_frame(i, &frame, &jpeg); i++)
+  {
+    if (!i)
+    {
+      first = frame;
+      jpeg_dimensions(jpeg, frame.len, &width, &height);
+    }
+    last = frame;
+    movi_len += avi_chunk_len(frame.len);
+    max_frame = frame.len > max_frame ? frame.len : max_frame;
+  }
+  uint32_t us_per_frame = count > 1 ? (last.timestamp - first.timestamp) / (count - 1) : 1000000 / BLACKBOX_FPS;
+
+  httpd_resp_set_type(req, "video/x-msvideo");
+  httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=blackbox.avi");
+  avi_header(buf, count, movi_len, width, height, us_per_frame ? us_per_frame : 1, max_frame);
+  if (httpd_resp_send_chunk(req, (const char *)buf, AVI_HEADER_LEN) != ESP_OK)
+    return ESP_FAIL;
+  for (uint16_t i = 0; i < count && blackbox_frame(i, &frame, &jpeg); i++)
+  {
+    avi_chunk_header(buf, frame.len);
+    if (httpd_resp_send_chunk(req, (const char *)buf, AVI_CHUNK_HEADER_LEN) != ESP_OK ||
+        httpd_resp_send_chunk(req, (const char *)jpeg, frame.len) != ESP_OK ||
+        ((frame.len & 1) && httpd_resp_send_chunk(req, "", 1) != ESP_OK))
+      return ESP_FAIL;
+  }
+
+  avi_index_header(buf, count);
+  size_t n = AVI_CHUNK_HEADER_LEN;
+  uint32_t offset = 4;
+  for (uint16_t i = 0; i < count && blackbox_frame(i, &frame, &jpeg); i++)
+  {
+    if (n + AVI_INDEX_ENTRY_LEN > sizeof(buf))
+    {
+      if (httpd_resp_send_chunk(req, (const char *)buf, n) != ESP_OK)
+        return ESP_FAIL;
+      n = 0;
     }
-
-    last_frame = 0;
-    return res;
+    avi_index_entry(buf + n, offset, frame.len);
+    n += AVI_INDEX_ENTRY_LEN;
+    offset += avi_chunk_len(frame.len);
+  }
+  if (httpd_resp_send_chunk(req, (const char *)buf, n) != ESP_OK)
+    return ESP_FAIL;
+  return httpd_resp_send_chunk(req, NULL, 0);
 }
 
-enum state
-{
-  fwd,
-  rev,
-  stp
-};
-state actstate = stp;
-
-static esp_err_t cmd_handler(httpd_req_t *req)
+// Sidecar for the AVI: frames and commands merged into one timeline, with
+// the AVI frame number of each frame so commands can be lined up with video
+static esp_err_t blackbox_send_commands(httpd_req_t *req, const blackbox_stats_t *stats)
 {
-  char *buf;
-  size_t buf_len;
-  char variable[32] = {
-      0,
-  };
-  char value[32] = {
-      0,
-  };
+  char line[128];
+  blackbox_frame_t frame;
+  blackbox_command_t command;
+  const uint8_t *jpeg;
+  uint16_t f = 0, c = 0;
+  int64_t frozen = blackbox_frozen_us();
+
+  httpd_resp_set_type(req, "text/csv");
+  httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=blackbox.csv");
+  snprintf(line, sizeof(line), "# trigger: %s, frozen at %u.%06u s\ntime_s,event,frame,seq,bytes,command,value,result\n",
+           stats->reason, (uint32_t)(frozen / 1000000), (uint32_t)(frozen % 1000000));
+  if (httpd_resp_sendstr_chunk(req, line) != ESP_OK)
+    return ESP_FAIL;
 
-  buf_len = httpd_req_get_url_query_len(req) + 1;
-  if (buf_len > 1)
+  bool more_frames = blackbox_frame(f, &frame, &jpeg);
+  bool more_commands = blackbox_command_at(c, &command);
+  while (more_frames || more_commands)
   {
-    buf = (char *)malloc(buf_len);
-    if (!buf)
+    if (more_frames && (!more_commands || frame.timestamp <= command.time_us))
     {
-      httpd_resp_send_500(req);
-      return ESP_FAIL;
+      snprintf(line, sizeof(line), "%u.%06u,frame,%u,%u,%u,,,\n",
+               (uint32_t)(frame.timestamp / 1000000), (uint32_t)(frame.timestamp % 1000000), f, frame.seq, frame.len);
+      more_frames = blackbox_frame(++f, &frame, &jpeg);
     }
-    if (httpd_req_get_url_query_str(req, buf, buf_len) == ESP_OK)
+    else
     {
-      if (httpd_query_key_value(buf, "var", variable, sizeof(variable)) == ESP_OK &&
-          httpd_query_key_value(buf, "val", value, sizeof(value)) == ESP_OK)
-      {
-      }
-      else
+      snprintf(line, sizeof(line), "%u.%06u,command,,,,%s,%d,%s\n",
+               (uint32_t)(command.time_us / 1000000), (uint32_t)(command.time_us % 1000000),
+               command.name, command.value, esp_err_to_name(command.result));
+      more_commands = blackbox_command_at(++c, &command);
+    }
+    if (httpd_resp_sendstr_chunk(req, line) != ESP_OK)
+      return ESP_FAIL;
+  }
+  return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// Black-box recorder control and download: ?record=1 or ?record=0 enables
+// or disables recording, ?freeze=1 stops recording now, ?resume=1 drops a
+// frozen recording and starts over, ?get=video or ?get=commands downloads a
+// frozen recording. Otherwise reports its state.
+static esp_err_t blackbox_handler(httpd_req_t *req)
+{
+  char query[48];
+  char value[12];
+  blackbox_stats_t stats;
+
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK)
+  {
+    if (httpd_query_key_value(query, "record", value, sizeof(value)) == ESP_OK)
+      blackbox_record(atoi(value) != 0);
+    else if (httpd_query_key_value(query, "freeze", value, sizeof(value)) == ESP_OK)
+      blackbox_freeze("manual", 0);
+    else if (httpd_query_key_value(query, "resume", value, sizeof(value)) == ESP_OK)
+      blackbox_resume();
+    else if (httpd_query_key_value(query, "get", value, sizeof(value)) == ESP_OK)
+    {
+      // Downloads run on the httpd task, which is also the only caller of
+      // blackbox_resume, so the recording cannot change underneath them
+      blackbox_get_stats(&stats);
+      if (stats.state != BLACKBOX_FROZEN || !stats.frames)
       {
-        free(buf);
-        httpd_resp_send_404(req);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No frozen recording");
         return ESP_FAIL;
       }
-    }
-    else
-    {
-      free(buf);
+      if (!strcmp(value, "video"))
+        return blackbox_send_video(req, stats.frames);
+      if (!strcmp(value, "commands"))
+        return blackbox_send_commands(req, &stats);
       httpd_resp_send_404(req);
       return ESP_FAIL;
     }
-    free(buf);
   }
-  else
+
+  char json[200];
+  blackbox_get_stats(&stats);
+  snprintf(json, sizeof(json),
+           "{\"state\":\"%s\",\"reason\":\"%s\",\"frames\":%u,\"commands\":%u,\"bytes\":%u,"
+           "\"span_ms\":%u,\"overwritten\":%u,\"too_large\":%u}",
+           blackbox_state_name(stats.state), stats.reason, stats.frames, stats.commands, stats.bytes,
+           stats.span_ms, stats.overwritten, stats.too_large);
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  return httpd_resp_sendstr(req, json);
+}
+
+// One /events connection. Each keeps its own event buffer and the last
+// snapshot it sent, so connections never share encoder state.
+typedef struct
+{
+  bool used;
+  volatile bool displaced;  // a newer connection is waiting for the slot
+  TaskHandle_t task;
+  int64_t claimed_us;
+  telemetry_t last;
+  uint32_t frames;        // frame hub count at the last fps sample
+  int64_t frames_us;
+  char buf[EVENTS_BUF_LEN];
+} events_client_t;
+
+static events_client_t events_clients[EVENTS_MAX_CLIENTS];
+static portMUX_TYPE events_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Take a free slot, or displace the oldest stream and wait for its task to
+// end. A page that was reloaded or closed leaves its stream open until a
+// send fails, which can take a keepalive interval; the newest connection is
+// the one a driver is looking at. The wait covers the old task's send
+// timeout, after which its socket is dead and the send has failed anyway.
+static events_client_t *events_claim()
+{
+  const int wait_ms = (CONTROL_PROFILE.send_timeout_s + 1) * 1000;
+  for (int waited = 0;; waited += 10)
   {
-    httpd_resp_send_404(req);
-    return ESP_FAIL;
+    events_client_t *client = NULL, *oldest = NULL;
+    portENTER_CRITICAL(&events_lock);
+    for (int i = 0; i < EVENTS_MAX_CLIENTS; i++)
+    {
+      events_client_t *c = &events_clients[i];
+      if (!c->used)
+      {
+        client = c;
+        client->used = true;
+        client->displaced = false;
+        client->task = xTaskGetCurrentTaskHandle();
+        client->claimed_us = esp_timer_get_time();
+        break;
+      }
+      if (!oldest || c->claimed_us < oldest->claimed_us)
+        oldest = c;
+    }
+    if (!client)
+      oldest->displaced = true;
+    portEXIT_CRITICAL(&events_lock);
+    if (client)
+      return client;
+    if (waited >= wait_ms)
+      return NULL;
+    // Cut its wait for the next event short
+    xTaskNotifyGive(oldest->task);
+    vTaskDelay(pdMS_TO_TICKS(10));
   }
+}
 
-  int val = atoi(value);
-  sensor_t *s = esp_camera_sensor_get();
-  int res = 0;
+static int events_client_count()
+{
+  int count = 0;
+  for (int i = 0; i < EVENTS_MAX_CLIENTS; i++)
+    count += events_clients[i].used;
+  return count;
+}
 
-  Serial.printf("Received request: var=%s, val=%s\n", variable, value);
-  Serial.printf("Parsed value: %d\n", val);
+// Fill a snapshot. Fields are read without motion_lock; a value that is one
+// update stale is fine for telemetry.
+static void telemetry_snapshot(events_client_t *client, telemetry_t *t)
+{
+  if (macro_state == MACRO_RUNNING)
+    t->v[TELEMETRY_MOTION] = TELEMETRY_MACRO;
+  else if (drive_active)
+    t->v[TELEMETRY_MOTION] = TELEMETRY_DRIVING;
+  else
+    t->v[TELEMETRY_MOTION] = robo ? TELEMETRY_MOVING : TELEMETRY_STOPPED;
+
+  int left, right;
+  motor_output_get_sides(&left, &right);
+  t->v[TELEMETRY_DUTY_LEFT] = left;
+  t->v[TELEMETRY_DUTY_RIGHT] = right;
+  t->v[TELEMETRY_SPEED] = speed;
+
+  frame_hub_stats_t hub;
+  frame_hub_get_stats(&hub);
+  int64_t now = esp_timer_get_time();
+  t->v[TELEMETRY_FPS] = 0;
+  if (client->frames_us && now > client->frames_us)
+    t->v[TELEMETRY_FPS] = (int32_t)((uint64_t)(hub.produced - client->frames) * 10000000 / (now - client->frames_us));
+  client->frames = hub.produced;
+  client->frames_us = now;
+  t->v[TELEMETRY_STREAM_CLIENTS] = hub.clients;
 
-  // Updated command handling
-  if (!strcmp(variable, "framesize"))
-  {
-    if (s->pixformat == PIXFORMAT_JPEG)
-      res = s->set_framesize(s, (framesize_t)val);
-  }
-  else if (!strcmp(variable, "quality"))
-    res = s->set_quality(s, val);
-  else if (!strcmp(variable, "flash"))
-  {
-    ledc_channel_config_t flash_channel;
-    flash_channel.gpio_num = 4;  // Flash LED pin
-    flash_channel.speed_mode = LEDC_LOW_SPEED_MODE;
-    flash_channel.channel = LEDC_CHANNEL_7;
-    flash_channel.intr_type = LEDC_INTR_DISABLE;
-    flash_channel.timer_sel = LEDC_TIMER_1;
-    flash_channel.duty = val;
-    flash_channel.hpoint = 0;
-    flash_channel.flags.output_invert = 0;
-    ledc_channel_config(&flash_channel);
-    Serial.printf("LED Control: Duty cycle set to %d\n", val);
-  }
-  else if (!strcmp(variable, "flashoff"))
+  sensor_t *s = esp_camera_sensor_get();
+  t->v[TELEMETRY_FRAMESIZE] = s ? s->status.framesize : 0;
+  t->v[TELEMETRY_HEAP_KB] = heap_caps_get_free_size(MALLOC_CAP_INTERNAL) / 1024;
+  t->v[TELEMETRY_PSRAM_KB] = heap_caps_get_free_size(MALLOC_CAP_SPIRAM) / 1024;
+
+  wifi_sta_list_t stations;
+  int rssi = 0;
+  if (esp_wifi_ap_get_sta_list(&stations) != ESP_OK)
+    stations.num = 0;
+  for (int i = 0; i < stations.num; i++)
   {
-    ledc_channel_config_t flash_channel;
-    flash_channel.gpio_num = 4;  // Flash LED pin
-    flash_channel.speed_mode = LEDC_LOW_SPEED_MODE;
-    flash_channel.channel = LEDC_CHANNEL_7;
-    flash_channel.intr_type = LEDC_INTR_DISABLE;
-    flash_channel.timer_sel = LEDC_TIMER_1;
-    flash_channel.duty = val;
-    flash_channel.hpoint = 0;
-    flash_channel.flags.output_invert = 0;
-    ledc_channel_config(&flash_channel);
-    Serial.printf("LED Control: Duty cycle set to %d\n", val);
+    if (!rssi || stations.sta[i].rssi > rssi)
+      rssi = stations.sta[i].rssi;
   }
-  else if (!strcmp(variable, "speed"))
+  t->v[TELEMETRY_RSSI] = rssi;
+  t->v[TELEMETRY_STATIONS] = stations.num;
+
+  udp_stream_stats_t udp;
+  udp_stream_get_stats(&udp);
+  t->v[TELEMETRY_UDP_RECEIVERS] = udp.receivers;
+}
+
+// Push a telemetry event whenever a snapshot differs from the previous one,
+// at most once per event_interval_ms. Events carry only the changed fields;
+// the first one on a connection carries all of them.
+static void events_client_task(void *arg)
+{
+  httpd_req_t *req = (httpd_req_t *)arg;
+  events_client_t *client = events_claim();
+  int64_t last_sent = esp_timer_get_time();
+  bool full = true;
+
+  esp_err_t res = client ? ESP_OK : ESP_FAIL;
+  if (client)
   {
-    if (val > 255)
-      val = 255;
-    else if (val < 0)
-      val = 0;
-    speed = val;
-    Serial.printf("Speed updated: %d\n", speed);
+    client->frames_us = 0;
+    httpd_resp_set_type(req, "text/event-stream");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+    res = httpd_resp_sendstr_chunk(req, "retry: 2000\n\n");
   }
-  else if (!strcmp(variable, "nostop"))
+  else
   {
-    noStop = val;
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    httpd_resp_sendstr(req, "Too many event clients");
   }
-  else if (!strcmp(variable, "car"))
+
+  while (res == ESP_OK)
   {
-    Serial.printf("Received command: var=%s, val=%s\n", variable, value);
-    if (val == 1)
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(event_interval_ms));
+    if (client->displaced)
     {
-      Serial.println("Forward");
-      robot_fwd();
-      robo = 1;
-    }
-    else if (val == 2)
-    {
-      Serial.println("Left");
-      robot_left();
-      robo = 1;
-    }
-    else if (val == 3)
-    {
-      Serial.println("Stop");
-      robot_stop();
-    }
-    else if (val == 4)
+      char retry[32];
+      snprintf(retry, sizeof(retry), "retry: %d\n\n", EVENTS_DISPLACED_RETRY_MS);
+      httpd_resp_sendstr_chunk(req, retry);
+      httpd_resp_send_chunk(req, NULL, 0);
+      break;
+    }
+    telemetry_t now;
+    telemetry_snapshot(client, &now);
+    size_t len = telemetry_encode_event(&now, &client->last, full, client->buf, sizeof(client->buf));
+    int64_t now_us = esp_timer_get_time();
+    if (len)
     {
-      Serial.println("Right");
-      robot_right();
-      robo = 1;
+      res = httpd_resp_send_chunk(req, client->buf, len);
+      last_sent = now_us;
+      full = false;
     }
-    else if (val == 5)
+    else if (now_us - last_sent > EVENTS_KEEPALIVE_MS * 1000LL)
     {
-      Serial.println("Backward");
-      robot_back();
-      robo = 1;
+      res = httpd_resp_sendstr_chunk(req, ": keepalive\n\n");
+      last_sent = now_us;
     }
   }
 
-  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
-  return httpd_resp_send(req, NULL, 0);
+  if (client)
+  {
+    portENTER_CRITICAL(&events_lock);
+    client->used = false;
+    portEXIT_CRITICAL(&events_lock);
+  }
+  httpd_req_async_handler_complete(req);
+  vTaskDelete(NULL);
+}
+
+static esp_err_t events_handler(httpd_req_t *req)
+{
+  httpd_req_t *async_req = NULL;
+  if (httpd_req_async_handler_begin(req, &async_req) != ESP_OK)
+    return ESP_FAIL;
+  // Below the control server so telemetry never delays a drive command
+  if (xTaskCreatePinnedToCore(events_client_task, "events_client", 3072, async_req,
+                              CONTROL_PROFILE.priority - 2, NULL, CONTROL_PROFILE.core) != pdPASS)
+  {
+    httpd_req_async_handler_complete(async_req);
+    return ESP_FAIL;
+  }
+  return ESP_OK;
 }
 
 static esp_err_t status_handler(httpd_req_t *req)
 {
-  static char json_response[1024];
+  char json_response[1536];
+  control_task = xTaskGetCurrentTaskHandle();
 
   sensor_t *s = esp_camera_sensor_get();
   char *p = json_response;
@@ -358,6 +1486,63 @@ static esp_err_t status_handler(httpd_req_t *req)
 
   p += sprintf(p, "\"framesize\":%u,", s->status.framesize);
   p += sprintf(p, "\"quality\":%u,", s->status.quality);
+
+  frame_hub_stats_t hub;
+  frame_hub_get_stats(&hub);
+  udp_stream_stats_t udp;
+  udp_stream_get_stats(&udp);
+  blackbox_stats_t blackbox;
+  blackbox_get_stats(&blackbox);
+  p += sprintf(p, "\"stream_clients\":%u,", hub.clients);
+  p += sprintf(p, "\"internal_clients\":%u,", hub.internal_clients);
+  p += sprintf(p, "\"frames\":%u,", hub.produced);
+  p += sprintf(p, "\"frames_dropped\":%u,", hub.dropped);
+  p += sprintf(p, "\"pool_hits\":%u,", hub.pool_hits);
+  p += sprintf(p, "\"pool_misses\":%u,", hub.pool_misses);
+  p += sprintf(p, "\"capture_queue\":%u,", hub.queue_depth);
+  p += sprintf(p, "\"capture_queue_max\":%u,", hub.queue_max);
+  p += sprintf(p, "\"capture_us\":%u,", hub.capture_us);
+  p += sprintf(p, "\"encode_us\":%u,", hub.encode_us);
+  p += sprintf(p, "\"send_us\":%u,", hub.send_us);
+  p += sprintf(p, "\"stop_latency_us\":%u,", stop_latency_us);
+  p += sprintf(p, "\"stop_latency_max_us\":%u,", stop_latency_max_us);
+  p += sprintf(p, "\"log_level\":%u,", dlog_get_level());
+  p += sprintf(p, "\"log_dropped\":%u,", dlog_dropped());
+  p += sprintf(p, "\"adaptive\":%u,", abr_enabled);
+  p += sprintf(p, "\"target_fps\":%u,", abr_config.target_fps);
+  p += sprintf(p, "\"abr_action\":\"%s\",", abr_action_name(abr_state.last_action));
+  p += sprintf(p, "\"abr_fps\":%u.%u,", abr_last_sample.fps_x10 / 10, abr_last_sample.fps_x10 % 10);
+  p += sprintf(p, "\"abr_latency_ms\":%u,", abr_last_sample.latency_ms);
+  p += sprintf(p, "\"abr_kbps\":%u,", abr_last_sample.throughput_kbps);
+  p += sprintf(p, "\"capture_age\":%d,", capture_max_age_ms);
+  p += sprintf(p, "\"capture_cached\":%u,", capture_cached);
+  p += sprintf(p, "\"capture_grabbed\":%u,", capture_grabbed);
+  p += sprintf(p, "\"latency_trace\":%u,", trace_enabled);
+  p += sprintf(p, "\"macro\":\"%s\",", macro_state_name(macro_state));
+  p += sprintf(p, "\"udp_receivers\":%u,", udp.receivers);
+  p += sprintf(p, "\"udp_frames\":%u,", udp.frames);
+  p += sprintf(p, "\"udp_aborted\":%u,", udp.aborted);
+  p += sprintf(p, "\"blackbox\":\"%s\",", blackbox_state_name(blackbox.state));
+  p += sprintf(p, "\"blackbox_frames\":%u,", blackbox.frames);
+  p += sprintf(p, "\"blackbox_span_ms\":%u,", blackbox.span_ms);
+  p += sprintf(p, "\"control_sockets\":%u,", httpd_profile_sessions(camera_httpd, CONTROL_PROFILE.max_open_sockets));
+  p += sprintf(p, "\"stream_sockets\":%u,", httpd_profile_sessions(stream_httpd, STREAM_PROFILE.max_open_sockets));
+  p += sprintf(p, "\"control_stack_free\":%u,", control_task ? uxTaskGetStackHighWaterMark(control_task) : 0);
+  p += sprintf(p, "\"stream_stack_free\":%u,", stream_task ? uxTaskGetStackHighWaterMark(stream_task) : 0);
+  p += sprintf(p, "\"stream_client_stack_free\":%u,",
+               stream_client_stack_free == UINT32_MAX ? 0 : stream_client_stack_free);
+  p += sprintf(p, "\"event_clients\":%u,", events_client_count());
+  p += sprintf(p, "\"event_ms\":%d,", event_interval_ms);
+  portENTER_CRITICAL(&change_lock);
+  uint32_t skipped = change_skipped;
+  uint32_t saved_kb = change_saved_bytes / 1024;
+  portEXIT_CRITICAL(&change_lock);
+  p += sprintf(p, "\"change_skip\":%u,", change_skip_permille);
+  p += sprintf(p, "\"change_keepalive\":%u,", change_keepalive_ms);
+  p += sprintf(p, "\"change_skipped\":%u,", skipped);
+  p += sprintf(p, "\"change_saved_kb\":%u,", saved_kb);
+  p += sprintf(p, "\"heap_free\":%u,", esp_get_free_heap_size());
+  p += sprintf(p, "\"heap_min_free\":%u", esp_get_minimum_free_heap_size());
   *p++ = '}';
   *p++ = 0;
   httpd_resp_set_type(req, "application/json");
@@ -365,554 +1550,203 @@ static esp_err_t status_handler(httpd_req_t *req)
   return httpd_resp_send(req, json_response, strlen(json_response));
 }
 
-static const char PROGMEM INDEX_HTML[] = R"rawliteral(
-<!doctype html>
-<html>
-    <head>
-        <meta charset="utf-8">
-        <meta name="viewport" content="width=device-width,initial-scale=1">
-        <title>ESP32 CAM Robot</title>
-        <style>
-    body {
-        font-family: Arial, Helvetica, sans-serif;
-        background: #181818;
-        color: #efefef;
-        font-size: 16px;
-    }
-    h2 {
-        font-size: 18px;
-    }
-    section.main {
-        display: flex;
-    }
-    #menu,
-    section.main {
-        flex-direction: column;
-    }
-    #menu {
-        display: none;
-        flex-wrap: nowrap;
-        min-width: 340px;
-        background: #363636;
-        padding: 8px;
-        border-radius: 4px;
-        margin-top: 1px;
-        margin-right: 10px;
-    }
-    #content {
-        display: flex;
-        flex-wrap: wrap;
-        align-items: stretch;
-    }
-    figure {
-        padding: 0;
-        margin: 0;
-        -webkit-margin-before: 0;
-        margin-block-start: 0;
-        -webkit-margin-after: 0;
-        margin-block-end: 0;
-        -webkit-margin-start: 0;
-        margin-inline-start: 0;
-        -webkit-margin-end: 0;
-        margin-inline-end: 0;
-    }
-    figure img {
-        display: block;
-        width: 100%;
-        height: auto;
-        border-radius: 4px;
-        margin-top: 15px;
-    }
-    @media (min-width: 800px) and (orientation: landscape) {
-        #content {
-            display: flex;
-            flex-wrap: nowrap;
-            align-items: stretch;
-        }
-        figure img {
-            display: block;
-            max-width: 100%;
-            max-height: calc(100vh - 40px);
-            width: auto;
-            height: auto;
+// Whether Accept-Encoding lists gzip without q=0
+static bool accepts_gzip(httpd_req_t *req) {
+    char value[128];
+    esp_err_t res = httpd_req_get_hdr_value_str(req, "Accept-Encoding", value, sizeof(value));
+    if (res != ESP_OK && res != ESP_ERR_HTTPD_RESULT_TRUNC)
+        return false;
+    char *save = NULL;
+    for (char *token = strtok_r(value, ",", &save); token; token = strtok_r(NULL, ",", &save)) {
+        while (*token == ' ')
+            token++;
+        if (strcspn(token, " ;") == 4 && !strncasecmp(token, "gzip", 4)) {
+            const char *q = strstr(token, "q=");
+            return !q || strtod(q + 2, NULL) > 0;
         }
-        figure {
-            padding: 0;
-            margin: 0;
-            -webkit-margin-before: 0;
-            margin-block-start: 0;
-            -webkit-margin-after: 0;
-            margin-block-end: 0;
-            -webkit-margin-start: 0;
-            margin-inline-start: 0;
-            -webkit-margin-end: 0;
-            margin-inline-end: 0;
-        }
-    }
-    section #buttons {
-        display: flex;
-        flex-wrap: nowrap;
-        justify-content: space-between;
-    }
-    #nav-toggle {
-        cursor: pointer;
-        display: block;
-    }
-    #nav-toggle-cb {
-        outline: 0;
-        opacity: 0;
-        width: 0;
-        height: 0;
-    }
-    #nav-toggle-cb:checked + #menu {
-        display: flex;
-    }
-    .input-group {
-        display: flex;
-        flex-wrap: nowrap;
-        line-height: 22px;
-        margin: 5px 0;
-    }
-    .input-group > label {
-        display: inline-block;
-        padding-right: 10px;
-        min-width: 47%;
-    }
-    .input-group input,
-    .input-group select {
-        flex-grow: 1;
-    }
-    .range-max,
-    .range-min {
-        display: inline-block;
-        padding: 0 5px;
-    }
-    button {
-        display: block;
-        margin: 5px;
-        padding: 5px 12px;
-        border: 0;
-        line-height: 28px;
-        cursor: pointer;
-        color: #fff;
-        background: #30D5C8; /* Turquoise */
-        border-radius: 5px;
-        font-size: 16px;
-        outline: 0;
-        width: 100px;
-    }
-    .button2 {background-color: #98FF98; width: 100px;} /* Mint green */
-    .button3 {background-color: #f44336; width: 100px;} /* Red */ 
-    .button4 {background-color: #E6E6FA; color: black; width: 120px;} /* Lavender */ 
-    .button5 {background-color: #555555; width: 100px;} /* Black */
-    .button6 {visibility: hidden; width: 100px;} /* Hidden */
-
-    button:hover {
-        background: #98FF98; /* Mint green */
-    }
-    button:active {
-        background: #30D5C8; /* Turquoise */
-    }
-    button.disabled {
-        cursor: default;
-        background: #a0a0a0; /* Gray */
-    }
-    input[type="range"] {
-        -webkit-appearance: none;
-        width: 80%;
-        height: 22px;
-        background: #363636;
-        cursor: pointer;
-        margin: 0;
-    }
-    input[type="range"]:focus {
-        outline: 0;
-    }
-    input[type="range"]::-webkit-slider-runnable-track {
-        width: 80%;
-        height: 2px;
-        cursor: pointer;
-        background: #efefef;
-        border-radius: 0;
-        border: 0 solid #efefef;
-    }
-    input[type="range"]::-webkit-slider-thumb {
-        border: 1px solid rgba(0, 0, 30, 0);
-        height: 22px;
-        width: 22px;
-        border-radius: 50px;
-        background: #ff3034;
-        cursor: pointer;
-        -webkit-appearance: none;
-        margin-top: -11.5px;
-    }
-    input[type="range"]:focus::-webkit-slider-runnable-track {
-        background: #efefef;
-    }
-    input[type="range"]::-moz-range-track {
-        width: 80%;
-        height: 2px;
-        cursor: pointer;
-        background: #efefef;
-        border-radius: 0;
-        border: 0 solid #efefef;
-    }
-    input[type="range"]::-moz-range-thumb {
-        border: 1px solid rgba(0, 0, 30, 0);
-        height: 22px;
-        width: 22px;
-        border-radius: 50px;
-        background: #ff3034;
-        cursor: pointer;
-    }
-    input[type="range"]::-ms-track {
-        width: 80%;
-        height: 2px;
-        cursor: pointer;
-        background: 0 0;
-        border-color: transparent;
-        color: transparent;
-    }
-    input[type="range"]::-ms-fill-lower {
-        background: #efefef;
-        border: 0 solid #efefef;
-        border-radius: 0;
-    }
-    input[type="range"]::-ms-fill-upper {
-        background: #efefef;
-        border: 0 solid #efefef;
-        border-radius: 0;
-    }
-    input[type="range"]::-ms-thumb {
-        border: 1px solid rgba(0, 0, 30, 0);
-        height: 22px;
-        width: 22px;
-        border-radius: 50px;
-        background: #ff3034;
-        cursor: pointer;
-        height: 2px;
-    }
-    input[type="range"]:focus::-ms-fill-lower {
-        background: #efefef;
-    }
-    input[type="range"]:focus::-ms-fill-upper {
-        background: #363636;
-    }
-    .switch {
-        display: block;
-        position: relative;
-        line-height: 22px;
-        font-size: 16px;
-        height: 22px;
-    }
-    .switch input {
-        outline: 0;
-        opacity: 0;
-        width: 0;
-        height: 0;
-    }
-    .slider {
-        width: 50px;
-        height: 22px;
-        border-radius: 22px;
-        cursor: pointer;
-        background-color: grey;
-    }
-    .slider,
-    .slider:before {
-        display: inline-block;
-        transition: 0.4s;
-    }
-    .slider:before {
-        position: relative;
-        content: "";
-        border-radius: 50%;
-        height: 16px;
-        width: 16px;
-        left: 4px;
-        top: 3px;
-        background-color: #fff;
-    }
-    input:checked + .slider {
-        background-color: #ff3034;
-    }
-    input:checked + .slider:before {
-        -webkit-transform: translateX(26px);
-        transform: translateX(26px);
-    }
-    select {
-        border: 1px solid #363636;
-        font-size: 14px;
-        height: 22px;
-        outline: 0;
-        border-radius: 5px;
-    }
-    .image-container {
-        position: absolute;
-        top: 150px;
-        left: 50%;
-        margin-right: -50%;
-        transform: translate(-50%, -50%);
-        min-width: 160px;
-        
     }
+    return false;
+}
 
-    .control-container {
-        position: relative;
-        top: 450px;
-        left: 50%;
-        margin-right: -50%;
-        transform: translate(-50%, -50%);
-        
-   
+// A page inflated for a client that does not take gzip, malloc'd, or NULL.
+// embed_assets.py writes a 10 byte gzip header with no optional fields,
+// then raw deflate and an 8 byte trailer. The ROM inflater and the page
+// are on the heap only while the request is answered.
+static uint8_t *inflate_asset(const web_asset_t *asset) {
+    if (asset->len < 18 || asset->data[0] != 0x1f || asset->data[1] != 0x8b || asset->data[3])
+        return NULL;
+    tinfl_decompressor *inflator = (tinfl_decompressor *)malloc(sizeof(tinfl_decompressor));
+    uint8_t *page = (uint8_t *)malloc(asset->raw_len);
+    if (inflator && page) {
+        tinfl_init(inflator);
+        size_t in = asset->len - 18, out = asset->raw_len;
+        tinfl_status status = tinfl_decompress(inflator, asset->data + 10, &in, page, page, &out,
+                                               TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+        if (status != TINFL_STATUS_DONE || out != asset->raw_len) {
+            free(page);
+            page = NULL;
+        }
+    } else {
+        free(page);
+        page = NULL;
     }
+    free(inflator);
+    return page;
+}
 
-    .slider-container {
-        position: relative;
-        top: 550px;
-        left: auto;
-        margin-right: auto;
-        
-       
-        
-   
-    }
-    .close {
-        position: absolute;
-        right: 5px;
-        top: 5px;
-        background: #ff3034;
-        width: 16px;
-        height: 16px;
-        border-radius: 100px;
-        color: #fff;
-        text-align: center;
-        line-height: 18px;
-        cursor: pointer;
-    }
-    .hidden {
-        display: none;
-    }
-    .rotate90 {
-        -webkit-transform: rotate(0deg);
-        -moz-transform: rotate(0deg);
-        -o-transform: rotate(0deg);
-        -ms-transform: rotate(0deg);
-        transform: rotate(0deg);
-    }
-</style>
+// Serve a page from web_assets.h, gzipped to browsers that take it and
+// inflated for the rest. Browsers revalidate with If-None-Match on every
+// load and get a bodiless 304 while the ETag matches; the inflated page
+// is a separate representation with its own tag.
+static esp_err_t send_asset(httpd_req_t *req, const web_asset_t *asset) {
+    char etag[32], if_none_match[32];
+    bool gzip = accepts_gzip(req);
+    if (gzip)
+        snprintf(etag, sizeof(etag), "%s", asset->etag);
+    else
+        snprintf(etag, sizeof(etag), "%.*s-identity\"", (int)strlen(asset->etag) - 1, asset->etag);
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match, sizeof(if_none_match)) == ESP_OK &&
+        !strcmp(if_none_match, etag)) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+    httpd_resp_set_type(req, asset->content_type);
+    if (gzip) {
+        httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+        return httpd_resp_send(req, (const char *)asset->data, asset->len);
+    }
+    uint8_t *page = inflate_asset(asset);
+    if (!page)
+        return httpd_resp_send_500(req);
+    esp_err_t res = httpd_resp_send(req, (const char *)page, asset->raw_len);
+    free(page);
+    return res;
+}
 
-    </head>
-    <body>
-    <br/>
-    
-        <section class="main">
-        <figure>
-      <div id="stream-container" class="image-container">
-        <div class="close" id="close-stream">×</div>
-        <img id="stream" src="" class="rotate90">
-      </div>
-    </figure>
-    <br/>
-
-          <section id="buttons">
-
-                <div id="controls" class="control-container">
-                  <table>
-                  <tr><td align="center"><button class="button button6" id="get-still">Image</button></td><td align="center"><button id="toggle-stream">Start</button></td><td></td></tr>
-                  <tr><td></td><td align="center"><button class="button button2" id="forward" onclick="fetch(document.location.origin+'/control?var=car&val=1');">FORWARD</button></td><td></td></tr>
-                  <tr><td align="center"><button class="button button2" id="turnleft" onclick="fetch(document.location.origin+'/control?var=car&val=2');">LEFT</button></td><td align="center"></td><td align="center"><button class="button button2" id="turnright" onclick="fetch(document.location.origin+'/control?var=car&val=4');">RIGHT</button></td></tr>
-                  <tr><td></td><td align="center"><button class="button button2" id="backward" onclick="fetch(document.location.origin+'/control?var=car&val=5');">REVERSE</button></td><td></td></tr>
-                  <tr><td align="center"><button class="button button4" id="flash" onclick="fetch(document.location.origin+'/control?var=flash&val=256');">LIGHT ON</button></td><td align="center"></td><td align="center"><button class="button button4" id="flashoff" onclick="fetch(document.location.origin+'/control?var=flashoff&val=0');">LIGHT OFF</button></td></tr>
-                  
-                  <tr><td align="right">Speed:</td><td align="center" colspan="2"><input type="range" id="speed" min="0" max="255" value="200" onchange="try{fetch(document.location.origin+'/control?var=speed&val='+this.value);}catch(e){}"></td><td>  </td></tr>
-                  <!--<tr><td align="right">Quality:</td><td align="center" colspan="2"><input type="range" id="quality" min="10" max="63" value="10" onchange="try{fetch(document.location.origin+'/control?var=quality&val='+this.value);}catch(e){}"></td><td>  </td></tr>
-                  <tr><td align="right">Size:</td><td align="center" colspan="2"><input type="range" id="framesize" min="0" max="6" value="5" onchange="try{fetch(document.location.origin+'/control?var=framesize&val='+this.value);}catch(e){}"></td><td>  </td></tr>
-                  -->
-                  </table>
-                </div>
-               <br/>
-               
-            </section>         
-        </section>   
-        <script>
-          document.addEventListener('DOMContentLoaded',function(){function b(B){let C;switch(B.type){case'checkbox':C=B.checked?1:0;break;case'range':case'select-one':C=B.value;break;case'button':case'submit':C='1';break;default:return;}if(B.id&&C!==undefined){const D=`${c}/control?var=${B.id}&val=${C}`;fetch(D).then(E=>{console.log(`request to ${D} finished, status: ${E.status}`)})}else{console.error("Invalid control parameters:",B.id,C)}}var c=document.location.origin;const e=B=>{B.classList.add('hidden')},f=B=>{B.classList.remove('hidden')},g=B=>{B.classList.add('disabled'),B.disabled=!0},h=B=>{B.classList.remove('disabled'),B.disabled=!1},i=(B,C,D)=>{D=!(null!=D)||D;let E;'checkbox'===B.type?(E=B.checked,C=!!C,B.checked=C):(E=B.value,B.value=C),D&&E!==C?b(B):!D&&('aec'===B.id?C?e(v):f(v):'agc'===B.id?C?(f(t),e(s)):(e(t),f(s)):'awb_gain'===B.id?C?f(x):e(x):'face_recognize'===B.id&&(C?h(n):g(n)))};document.querySelectorAll('.close').forEach(B=>{B.onclick=()=>{e(B.parentNode)}}),fetch(`${c}/status`).then(function(B){return B.json()}).then(function(B){document.querySelectorAll('.default-action').forEach(C=>{i(C,B[C.id],!1)})});const j=document.getElementById('stream'),k=document.getElementById('stream-container'),l=document.getElementById('get-still'),m=document.getElementById('toggle-stream'),n=document.getElementById('face_enroll'),o=document.getElementById('close-stream'),p=()=>{window.stop(),m.innerHTML='Start',console.log("Stream stopped")},q=()=>{j.src=`${c+':81'}/stream`,f(k),m.innerHTML='Stop',console.log("Stream started, src set to:", j.src)};l.onclick=()=>{p(),j.src=`${c}/capture?_cb=${Date.now()}`,f(k),console.log("Capture image, src set to:", j.src)},o.onclick=()=>{p(),e(k),console.log("Stream container closed")},m.onclick=()=>{const isStreaming = 'Stop' === m.innerHTML; alert(`Toggle stream button clicked, current state: ${isStreaming ? 'Stop' : 'Start'}`); isStreaming ? p() : q();},n.onclick=()=>{b(n)},document.querySelectorAll('.default-action').forEach(B=>{B.onchange=()=>b(B)});const r=document.getElementById('agc'),s=document.getElementById('agc_gain-group'),t=document.getElementById('gainceiling-group');r.onchange=()=>{b(r),r.checked?(f(t),e(s))};const u=document.getElementById('aec'),v=document.getElementById('aec_value-group');u.onchange=()=>{b(u),u.checked?e(v):f(v)};const w=document.getElementById('awb_gain'),x=document.getElementById('wb_mode-group');w.onchange=()=>{b(w),w.checked?f(x):e(x)};const y=document.getElementById('face_detect'),z=document.getElementById('face_recognize'),A=document.getElementById('framesize');A.onchange=()=>{b(A),5<A.value&&(i(y,!1),i(z,!1))},y.onchange=()=>{return 5<A.value?(alert('Please select CIF or lower resolution before enabling this feature!'),void i(y,!1)):void(b(y),!y.checked&&(g(n),i(z,!1)))},z.onchange=()=>{return 5<A.value?(alert('Please select CIF or lower resolution before enabling this feature!'),void i(z,!1)):void(b(z),z.checked?(h(n),i(y,!0)):g(n))}});
-        </script>
-        <script>
-document.addEventListener('DOMContentLoaded', function() {
-    console.log("JavaScript loaded and DOMContentLoaded triggered.");
-
-    const m = document.getElementById('toggle-stream');
-    if (m) {
-        console.log("Start button found.");
-        m.onclick = () => {
-            console.log("Start button clicked.");
-            const isStreaming = 'Stop' === m.innerHTML;
-            console.log("Current state:", isStreaming ? "Stop" : "Start");
-            isStreaming ? p() : q();
-        };
-    } else {
-        console.error("Start button not found.");
-    }
+static esp_err_t handle_update_get(httpd_req_t *req) {
+    return send_asset(req, &UPDATE_HTML_ASSET);
+}
 
-    const j = document.getElementById('stream');
-    if (j) {
-        console.log("Stream image element found.");
-    } else {
-        console.error("Stream image element not found.");
-    }
+static bool update_data(void *ctx, const uint8_t *data, size_t len) {
+    return ota_write(data, len);
+}
 
-    const p = () => {
-        console.log("Stopping stream.");
-        window.stop();
-        m.innerHTML = 'Start';
-    };
-
-    const q = () => {
-        console.log("Starting stream.");
-        j.src = `${document.location.origin}:81/stream`;
-        console.log("Stream source set to:", j.src);
-        m.innerHTML = 'Stop';
-    };
-});
-</script>
-    </body>
-</html>
-)rawliteral";
-
-// HTML for update page with improved styling and error handling
-static const char* PROGMEM updateIndex = R"(
-<!DOCTYPE html>
-<html>
-<head>
-    <meta charset="utf-8">
-    <meta name="viewport" content="width=device-width,initial-scale=1">
-    <title>ESP32 CAM Robot Car Update</title>
-    <style>
-        body {
-            font-family: Arial, sans-serif;
-            margin: 20px;
-            background: #f0f0f0;
-        }
-        .container {
-            background: white;
-            border-radius: 5px;
-            padding: 20px;
-            max-width: 400px;
-            margin: 0 auto;
-            box-shadow: 0 2px 4px rgba(0,0,0,0.1);
-        }
-        h2 {
-            color: #333;
-            margin-top: 0;
-        }
-        .upload-form {
-            margin-top: 20px;
-        }
-        input[type="file"] {
-            display: block;
-            margin: 10px 0;
-            width: 100%;
-        }
-        input[type="submit"] {
-            background: #4CAF50;
-            color: white;
-            padding: 10px 20px;
-            border: none;
-            border-radius: 4px;
-            cursor: pointer;
-        }
-        input[type="submit"]:hover {
-            background: #45a049;
-        }
-        #progress {
-            margin-top: 20px;
-            display: none;
-        }
-        .progress-bar {
-            background: #f1f1f1;
-            height: 20px;
-            border-radius: 10px;
-            overflow: hidden;
-        }
-        .progress-fill {
-            background: #4CAF50;
-            height: 100%;
-            width: 0%;
-            transition: width 0.3s;
-        }
-    </style>
-</head>
-<body>
-    <div class="container">
-        <h2>ESP32 CAM Robot Car Firmware Update</h2>
-        <form method='POST' action='/update' enctype='multipart/form-data' class="upload-form">
-            <input type='file' name='update' accept='.bin'>
-            <input type='submit' value='Update Firmware'>
-        </form>
-        <div id="progress">
-            <p>Update Progress:</p>
-            <div class="progress-bar">
-                <div class="progress-fill"></div>
-            </div>
-        </div>
-    </div>
-</body>
-</html>
-)";
+// Parse 64 hex digits into a SHA-256 digest
+static bool parse_sha256(const char *hex, uint8_t sha[OTA_SHA256_LEN]) {
+    if (strlen(hex) != OTA_SHA256_LEN * 2)
+        return false;
+    for (int i = 0; i < OTA_SHA256_LEN; i++) {
+        char byte[3] = {hex[i * 2], hex[i * 2 + 1], 0};
+        char *end;
+        sha[i] = strtoul(byte, &end, 16);
+        if (*end)
+            return false;
+    }
+    return true;
+}
 
-static esp_err_t handle_update_get(httpd_req_t *req) {
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_send(req, updateIndex, strlen(updateIndex));
-    return ESP_OK;
+static void format_sha256(const uint8_t sha[OTA_SHA256_LEN], char hex[OTA_SHA256_LEN * 2 + 1]) {
+    for (int i = 0; i < OTA_SHA256_LEN; i++)
+        sprintf(hex + i * 2, "%02x", sha[i]);
 }
 
 static esp_err_t handle_update_post(httpd_req_t *req) {
-    char buf[1024];
-    int ret;
+    // Slightly more than a TCP segment per recv; the 4 KB flash buffers live in ota_update
+    char buf[1460];
+    char content_type[128] = "";
+    char sha_hex[OTA_SHA256_LEN * 2 + 1] = "";
+    uint8_t expected[OTA_SHA256_LEN];
+    uint8_t sha[OTA_SHA256_LEN];
+    multipart_parser_t *parser = NULL;
     size_t remaining = req->content_len;
+    int last_percent = -1;
+    int ret;
+
+    httpd_req_get_hdr_value_str(req, "Content-Type", content_type, sizeof(content_type));
+    // Optional digest of the image, checked before the update is committed
+    bool verify = httpd_req_get_hdr_value_str(req, "X-Update-SHA256", sha_hex, sizeof(sha_hex)) == ESP_OK;
+    if (verify && !parse_sha256(sha_hex, expected)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid X-Update-SHA256");
+        return ESP_FAIL;
+    }
+
+    // Browser form uploads are multipart and only the file part is written;
+    // anything else is taken as the raw image, which also tells us its size
+    if (!strncmp(content_type, "multipart/", 10)) {
+        parser = (multipart_parser_t *)malloc(sizeof(multipart_parser_t));
+        if (!parser || !multipart_init(parser, content_type, update_data, NULL)) {
+            free(parser);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid multipart body");
+            return ESP_FAIL;
+        }
+    }
 
-    // Check if there's enough space for the update
-    if (!Update.begin(UPDATE_SIZE_UNKNOWN)) {
-        Serial.println("[OTA] Not enough space for update");
+    if (!ota_begin(parser ? UPDATE_SIZE_UNKNOWN : req->content_len)) {
+        Serial.printf("[OTA] Update failed to start: %s\n", ota_error());
+        free(parser);
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Not enough space for update");
         return ESP_FAIL;
     }
 
     Serial.printf("[OTA] Update started, total size: %d bytes\n", req->content_len);
 
-    // Process the firmware file in chunks
-    while (remaining > 0) {
+    const char *failure = NULL;
+    while (remaining > 0 && !failure) {
         size_t chunk_size = (remaining < sizeof(buf)) ? remaining : sizeof(buf);
         ret = httpd_req_recv(req, buf, chunk_size);
-        
+
         if (ret <= 0) {
             if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
                 continue;
             }
-            Serial.println("[OTA] Failed to receive data");
-            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to receive data");
-            return ESP_FAIL;
+            failure = "Failed to receive data";
+            break;
         }
+        remaining -= ret;
 
-        if (Update.write((uint8_t*)buf, ret) != ret) {
-            Serial.println("[OTA] Failed to write data");
-            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to write data");
-            return ESP_FAIL;
+        if (parser) {
+            multipart_status_t status = multipart_feed(parser, (uint8_t *)buf, ret);
+            if (status == MULTIPART_ERROR)
+                failure = "Failed to write data";
+            else if (status == MULTIPART_DONE)
+                break;
+        } else if (!ota_write((uint8_t *)buf, ret)) {
+            failure = "Failed to write data";
         }
 
-        Serial.printf("[OTA] Progress: %d%%\n", (int)((req->content_len - remaining) * 100 / req->content_len));
-        remaining -= ret;
+        int percent = (req->content_len - remaining) * 100 / req->content_len;
+        if (percent / 10 != last_percent / 10) {
+            Serial.printf("[OTA] Progress: %d%%\n", percent);
+            last_percent = percent;
+        }
+    }
+    if (!failure && parser && parser->state != MP_DONE)
+        failure = "Incomplete multipart body";
+    if (!failure && !ota_received())
+        failure = "No firmware in request";
+    free(parser);
+
+    if (failure) {
+        ota_abort();
+        Serial.printf("[OTA] %s: %s\n", failure, ota_error());
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, failure);
+        return ESP_FAIL;
     }
 
-    if (!Update.end(true)) {
-        Serial.println("[OTA] Update failed to complete");
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Update failed to complete");
+    bool ok = ota_finish(verify ? expected : NULL, sha);
+    format_sha256(sha, sha_hex);
+    if (!ok) {
+        Serial.printf("[OTA] Update failed to complete: %s, sha256 %s\n", ota_error(), sha_hex);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, ota_error());
         return ESP_FAIL;
     }
 
-    Serial.println("[OTA] Update successful");
-    httpd_resp_sendstr(req, "Update successful! Rebooting...");
+    Serial.printf("[OTA] Update successful, sha256 %s\n", sha_hex);
+    snprintf(buf, sizeof(buf), "Update successful! sha256 %s. Rebooting...", sha_hex);
+    httpd_resp_sendstr(req, buf);
     
     delay(1000);
     ESP.restart();
@@ -920,16 +1754,70 @@ static esp_err_t handle_update_post(httpd_req_t *req) {
     return ESP_OK;
 }
 
+// Body is a patch from tools/delta_ota.py against the running firmware
+static esp_err_t handle_update_delta(httpd_req_t *req) {
+    char buf[1460];
+    char sha_hex[OTA_SHA256_LEN * 2 + 1];
+    uint8_t sha[OTA_SHA256_LEN];
+    size_t remaining = req->content_len;
+    int ret;
+
+    if (!ota_delta_begin()) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, ota_delta_error());
+        return ESP_FAIL;
+    }
+
+    Serial.printf("[OTA] Delta update started, patch size: %d bytes\n", req->content_len);
+
+    const char *failure = NULL;
+    while (remaining > 0 && !failure) {
+        size_t chunk_size = (remaining < sizeof(buf)) ? remaining : sizeof(buf);
+        ret = httpd_req_recv(req, buf, chunk_size);
+
+        if (ret <= 0) {
+            if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+                continue;
+            }
+            failure = "Failed to receive data";
+            break;
+        }
+        remaining -= ret;
+        if (!ota_delta_write((uint8_t *)buf, ret))
+            failure = ota_delta_error();
+    }
+
+    if (failure) {
+        ota_delta_abort();
+        Serial.printf("[OTA] Delta update failed: %s\n", failure);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, failure);
+        return ESP_FAIL;
+    }
+
+    bool ok = ota_delta_finish(sha);
+    format_sha256(sha, sha_hex);
+    if (!ok) {
+        Serial.printf("[OTA] Delta update failed to complete: %s\n", ota_delta_error());
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, ota_delta_error());
+        return ESP_FAIL;
+    }
+
+    Serial.printf("[OTA] Delta update successful, sha256 %s\n", sha_hex);
+    snprintf(buf, sizeof(buf), "Update successful! sha256 %s. Rebooting...", sha_hex);
+    httpd_resp_sendstr(req, buf);
+
+    delay(1000);
+    ESP.restart();
+
+    return ESP_OK;
+}
+
 static esp_err_t index_handler(httpd_req_t *req) {
-    httpd_resp_set_type(req, "text/html");
-    return httpd_resp_send(req, (const char *)INDEX_HTML, strlen(INDEX_HTML));
+    return send_asset(req, &INDEX_HTML_ASSET);
 }
 
 void startCameraServer()
 {
-  httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-  config.server_port = 80;
-  config.ctrl_port = 32768;
+  httpd_config_t config = httpd_profile_config(&CONTROL_PROFILE);
 
   httpd_uri_t index_uri = {
       .uri = "/",
@@ -961,6 +1849,43 @@ void startCameraServer()
       .handler = stream_handler,
       .user_ctx = NULL};
 
+  httpd_uri_t metrics_uri = {
+      .uri = "/metrics",
+      .method = HTTP_GET,
+      .handler = metrics_handler,
+      .user_ctx = NULL};
+
+  httpd_uri_t ws_uri = {
+      .uri = "/ws",
+      .method = HTTP_GET,
+      .handler = ws_handler,
+      .user_ctx = NULL,
+      .is_websocket = true};
+
+  httpd_uri_t trace_uri = {
+      .uri = "/trace",
+      .method = HTTP_GET,
+      .handler = trace_handler,
+      .user_ctx = NULL};
+
+  httpd_uri_t events_uri = {
+      .uri = "/events",
+      .method = HTTP_GET,
+      .handler = events_handler,
+      .user_ctx = NULL};
+
+  httpd_uri_t macro_uri = {
+      .uri = "/macro",
+      .method = HTTP_GET,
+      .handler = macro_handler,
+      .user_ctx = NULL};
+
+  httpd_uri_t blackbox_uri = {
+      .uri = "/blackbox",
+      .method = HTTP_GET,
+      .handler = blackbox_handler,
+      .user_ctx = NULL};
+
   httpd_uri_t update_uri = {
       .uri = "/update",
       .method = HTTP_GET,
@@ -975,73 +1900,56 @@ void startCameraServer()
       .user_ctx = NULL
   };
 
-  Serial.printf("Starting web server on port: '%d'\n", config.server_port);
+  httpd_uri_t update_delta_uri = {
+      .uri = "/update/delta",
+      .method = HTTP_POST,
+      .handler = handle_update_delta,
+      .user_ctx = NULL
+  };
+
+  httpd_uri_t *control_uris[] = {
+      &index_uri, &cmd_uri, &status_uri, &ws_uri, &metrics_uri, &trace_uri, &macro_uri,
+      &blackbox_uri, &events_uri, &capture_uri, &update_uri, &update_post_uri, &update_delta_uri};
+  httpd_uri_t *stream_uris[] = {&stream_uri};
+  static_assert(sizeof(control_uris) / sizeof(control_uris[0]) <= CONTROL_PROFILE.max_uri_handlers,
+                "raise the control server's uri handler limit");
+  static_assert(sizeof(stream_uris) / sizeof(stream_uris[0]) <= STREAM_PROFILE.max_uri_handlers,
+                "raise the stream server's uri handler limit");
+  static_assert((sizeof(control_uris) + sizeof(stream_uris)) / sizeof(httpd_uri_t *) <= ENDPOINT_MAX,
+                "more endpoints than ENDPOINT_MAX, grow it");
+
+  Serial.printf("Starting %s server on port: '%d' (core %s, priority %u)\n", CONTROL_PROFILE.name,
+                config.server_port, httpd_profile_core(&CONTROL_PROFILE), CONTROL_PROFILE.priority);
   if (httpd_start(&camera_httpd, &config) == ESP_OK)
   {
-    httpd_register_uri_handler(camera_httpd, &index_uri);
-    httpd_register_uri_handler(camera_httpd, &cmd_uri);
-    httpd_register_uri_handler(camera_httpd, &status_uri);
-    httpd_register_uri_handler(camera_httpd, &capture_uri);
-    httpd_register_uri_handler(camera_httpd, &update_uri);
-    httpd_register_uri_handler(camera_httpd, &update_post_uri);
+    for (httpd_uri_t *uri : control_uris)
+      endpoint_register(camera_httpd, uri);
   }
 
-  config.server_port += 1;
-  config.ctrl_port += 1;
-  Serial.printf("Starting stream server on port: '%d'\n", config.server_port);
+  frame_hub_start(max_framesize());
+  udp_stream_start();
+  blackbox_start();
+
+  config = httpd_profile_config(&STREAM_PROFILE);
+  Serial.printf("Starting %s server on port: '%d' (core %s, priority %u)\n", STREAM_PROFILE.name,
+                config.server_port, httpd_profile_core(&STREAM_PROFILE), STREAM_PROFILE.priority);
   if (httpd_start(&stream_httpd, &config) == ESP_OK)
   {
-    httpd_register_uri_handler(stream_httpd, &stream_uri);
+    for (httpd_uri_t *uri : stream_uris)
+      endpoint_register(stream_httpd, uri);
   }
 }
 
-unsigned int get_speed(unsigned int sp)
-{
-  return map(sp, 0, 100, 0, 255);
-}
-
-// Wrapper function to initialize PWM channels
-void initPWMChannel(int channel, int freq, int resolution, int pin) {
-    ledc_timer_config_t ledc_timer = {
-        .speed_mode = LEDC_LOW_SPEED_MODE,
-        .duty_resolution = (ledc_timer_bit_t)resolution,
-        .timer_num = (ledc_timer_t)(channel / 4),
-        .freq_hz = freq,
-        .clk_cfg = LEDC_AUTO_CLK
-    };
-    ledc_timer_config(&ledc_timer);
-
-    ledc_channel_config_t ledc_channel = {
-        .gpio_num = pin,
-        .speed_mode = LEDC_LOW_SPEED_MODE,
-        .channel = (ledc_channel_t)channel,
-        .intr_type = LEDC_INTR_DISABLE,
-        .timer_sel = (ledc_timer_t)(channel / 4),
-        .duty = 0,
-        .hpoint = 0
-    };
-    ledc_channel_config(&ledc_channel);
-}
-
 void robot_setup() {
-    Serial.println("Initializing PWM channels for motors...");
-    // Initialize PWM channels for motor control
-    initPWMChannel(3, 2000, 8, RIGHT_M0);
-    initPWMChannel(4, 2000, 8, RIGHT_M1);
-    initPWMChannel(5, 2000, 8, LEFT_M0);
-    initPWMChannel(6, 2000, 8, LEFT_M1);
+    motion_setup();
+    xTaskCreate(drive_task, "drive", 2048, NULL, 6, NULL);
 
-    // Debug logs for initialization
+    Serial.println("Initializing PWM channels for motors...");
+    motor_output_setup();
     Serial.println("PWM channels initialized and attached to GPIO pins.");
 
     // Ensure motors are stopped
     robot_stop();
-
-    // Debug log to confirm motors are stopped
-    Serial.println("Motors stopped during setup.");
-
-    // Test PWM output after all initializers
-    test_pwm_output();
 }
 
 void setupLED() {
@@ -1053,113 +1961,42 @@ void setupLED() {
 
 // Motor Control Functions
 
-void update_speed() {
-    // Update all active channels with new speed value
-    for (int i = 0; i < 4; i++) {
-        ledc_set_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)i, get_speed(motor_speed));
-        ledc_update_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)i);
-    }
+static void robot_motion(motion_t motion)
+{
+  motor_output_motion(motion, speed);
+  if (MOTIONS[motion].interval_ms)
+    move_interval = MOTIONS[motion].interval_ms;
+  if (motion == MOTION_STOP)
+  {
+    dlog_write(DLOG_MOTION_STOP);
+    return;
+  }
+  dlog_write(DLOG_MOTION, (uintptr_t)MOTIONS[motion].name,
+             MOTIONS[motion].active[MOTOR_RIGHT_M0] ? speed : 0, MOTIONS[motion].active[MOTOR_RIGHT_M1] ? speed : 0,
+             MOTIONS[motion].active[MOTOR_LEFT_M0] ? speed : 0, MOTIONS[motion].active[MOTOR_LEFT_M1] ? speed : 0);
 }
 
 void robot_stop()
 {
-  Serial.println("Stopping motors...");
-  ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, 0);
-  ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_1, 0);
-  ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_2, 0);
-  ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_3, 0);
-  ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
-  ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_1);
-  ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_2);
-  ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_3);
-}
-
-void robot_fwd() {
-    Serial.println("Executing robot_fwd()");
-    // Front motors forward
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, 0);
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_1, speed);
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_2, 0);
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_3, speed);
-    
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_1);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_2);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_3);
-    
-    move_interval = 250;
-    previous_time = millis();
-    Serial.printf("robot_fwd: PWM values - RIGHT_M0: %d, RIGHT_M1: %d, LEFT_M0: %d, LEFT_M1: %d\n", 0, speed, 0, speed);
-}
-
-void robot_back() {
-    Serial.println("Executing robot_back()");
-    // Front motors backward
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, speed);
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_1, 0);
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_2, speed);
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_3, 0);
-    
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_1);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_2);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_3);
-    
-    move_interval = 250;
-    previous_time = millis();
-    Serial.printf("robot_back: PWM values - RIGHT_M0: %d, RIGHT_M1: %d, LEFT_M0: %d, LEFT_M1: %d\n", speed, 0, speed, 0);
-}
-
-void robot_right() {
-    Serial.println("Executing robot_right()");
-    // Turn right: Left motors forward, right motors backward
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, 0);
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_1, speed);
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_2, speed);
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_3, 0);
-    
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_1);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_2);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_3);
-    
-    move_interval = 100;
-    previous_time = millis();
-    Serial.printf("robot_right: PWM values - RIGHT_M0: %d, RIGHT_M1: %d, LEFT_M0: %d, LEFT_M1: %d\n", 0, speed, speed, 0);
-}
-
-void robot_left() {
-    Serial.println("Executing robot_left()");
-    // Turn left: Right motors forward, left motors backward
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, speed);
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_1, 0);
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_2, 0);
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_3, speed);
-    
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_1);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_2);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_3);
-    
-    move_interval = 100;
-    previous_time = millis();
-    Serial.printf("robot_left: PWM values - RIGHT_M0: %d, RIGHT_M1: %d, LEFT_M0: %d, LEFT_M1: %d\n", speed, 0, 0, speed);
+  robot_motion(MOTION_STOP);
 }
 
-void test_pwm_output() {
-    Serial.println("Testing PWM output with constant duty cycle...");
+void robot_fwd()
+{
+  robot_motion(MOTION_FWD);
+}
 
-    // Set a constant duty cycle for all motor control pins
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_3, 128); // 50% duty cycle for RIGHT_M0
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_4, 128); // 50% duty cycle for RIGHT_M1
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_5, 128); // 50% duty cycle for LEFT_M0
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_6, 128); // 50% duty cycle for LEFT_M1
+void robot_back()
+{
+  robot_motion(MOTION_BACK);
+}
 
-    // Update the duty cycle to apply changes
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_3);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_4);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_5);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_6);
+void robot_right()
+{
+  robot_motion(MOTION_RIGHT);
+}
 
-    Serial.println("PWM output test complete. Observe motor behavior.");
+void robot_left()
+{
+  robot_motion(MOTION_LEFT);
 }
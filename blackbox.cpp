@@ -0,0 +1,269 @@
+/*
+  ESP32_CAM_Robot_Car
+  blackbox.cpp
+  Black-box recorder: the last seconds of video and control commands in a
+  preallocated PSRAM ring, frozen on demand or when the drive link drops
+
+*/
+
+#include "blackbox.h"
+#include "frame_hub.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+
+// Frames are stored back to back in the video ring, wrapping to the start
+// when the next one does not fit, so the oldest frame is always the next
+// one ahead of write_pos. Everything is allocated once in blackbox_start.
+static uint8_t *video = NULL;
+static blackbox_frame_t *frames = NULL;
+static blackbox_command_t *commands = NULL;
+static uint16_t frame_head = 0;     // oldest frame
+static uint16_t frame_count = 0;
+static uint32_t write_pos = 0;
+static uint32_t frame_bytes = 0;
+static uint16_t command_head = 0;
+static uint16_t command_count = 0;
+
+static blackbox_state_t state = BLACKBOX_OFF;
+static bool enabled = BLACKBOX_RECORD_AT_BOOT;
+static const char *reason = "";
+static int64_t freeze_at_us = 0;
+static int64_t frozen_us = 0;
+static uint32_t overwritten = 0;
+static uint32_t too_large = 0;
+static portMUX_TYPE blackbox_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool recording()
+{
+  return state == BLACKBOX_RECORDING || state == BLACKBOX_TRIGGERED;
+}
+
+// Empty both rings. Called with blackbox_lock held.
+static void clear()
+{
+  frame_head = frame_count = 0;
+  command_head = command_count = 0;
+  write_pos = frame_bytes = 0;
+  overwritten = too_large = 0;
+  reason = "";
+}
+
+// Make room for len bytes and return where they go. Only the recorder task
+// writes frames.
+static uint32_t reserve(uint32_t len)
+{
+  uint32_t pos = write_pos + len > BLACKBOX_VIDEO_BYTES ? 0 : write_pos;
+  portENTER_CRITICAL(&blackbox_lock);
+  while (frame_count)
+  {
+    const blackbox_frame_t *oldest = &frames[frame_head];
+    // Frames past the wrap point are older than anything at the start
+    bool behind_wrap = pos < write_pos && oldest->offset >= write_pos;
+    bool overlaps = oldest->offset < pos + len && oldest->offset + oldest->len > pos;
+    if (frame_count < BLACKBOX_MAX_FRAMES && !behind_wrap && !overlaps)
+      break;
+    frame_bytes -= oldest->len;
+    frame_head = (frame_head + 1) % BLACKBOX_MAX_FRAMES;
+    frame_count--;
+    overwritten++;
+  }
+  portEXIT_CRITICAL(&blackbox_lock);
+  return pos;
+}
+
+static void record_frame(const hub_frame_t *frame)
+{
+  if (frame->len > BLACKBOX_VIDEO_BYTES / 4)
+  {
+    too_large++;
+    return;
+  }
+  uint32_t pos = reserve(frame->len);
+  memcpy(video + pos, frame->buf, frame->len);
+
+  portENTER_CRITICAL(&blackbox_lock);
+  blackbox_frame_t *f = &frames[(frame_head + frame_count) % BLACKBOX_MAX_FRAMES];
+  f->offset = pos;
+  f->len = frame->len;
+  f->seq = frame->seq;
+  f->timestamp = frame->timestamp;
+  frame_count++;
+  frame_bytes += frame->len;
+  write_pos = pos + frame->len;
+  portEXIT_CRITICAL(&blackbox_lock);
+}
+
+static void blackbox_task(void *arg)
+{
+  int client = -1;
+  uint32_t last_seq = 0;
+  int64_t last_recorded = 0;
+
+  while (true)
+  {
+    portENTER_CRITICAL(&blackbox_lock);
+    if (state == BLACKBOX_TRIGGERED && esp_timer_get_time() >= freeze_at_us)
+    {
+      state = BLACKBOX_FROZEN;
+      frozen_us = esp_timer_get_time();
+    }
+    bool active = recording();
+    portEXIT_CRITICAL(&blackbox_lock);
+
+    // Let the camera stop while idle or while a frozen recording waits to
+    // be downloaded
+    if (!active)
+    {
+      if (client >= 0)
+      {
+        frame_hub_detach(client);
+        client = -1;
+      }
+      vTaskDelay(pdMS_TO_TICKS(100));
+      continue;
+    }
+    if (client < 0 && (client = frame_hub_attach_internal()) < 0)
+    {
+      vTaskDelay(pdMS_TO_TICKS(1000));
+      continue;
+    }
+
+    hub_frame_t *frame = frame_hub_acquire(last_seq, pdMS_TO_TICKS(100));
+    if (!frame)
+      continue;
+    last_seq = frame->seq;
+    if (frame->timestamp - last_recorded >= 1000000 / BLACKBOX_FPS)
+    {
+      last_recorded = frame->timestamp;
+      record_frame(frame);
+    }
+    frame_hub_release(frame);
+  }
+}
+
+bool blackbox_start()
+{
+  if (video || !psramFound())
+    return video != NULL;
+  video = (uint8_t *)heap_caps_malloc(BLACKBOX_VIDEO_BYTES, MALLOC_CAP_SPIRAM);
+  frames = (blackbox_frame_t *)heap_caps_calloc(BLACKBOX_MAX_FRAMES, sizeof(blackbox_frame_t), MALLOC_CAP_SPIRAM);
+  commands = (blackbox_command_t *)heap_caps_calloc(BLACKBOX_MAX_COMMANDS, sizeof(blackbox_command_t), MALLOC_CAP_SPIRAM);
+  if (!video || !frames || !commands)
+  {
+    heap_caps_free(video);
+    heap_caps_free(frames);
+    heap_caps_free(commands);
+    video = NULL;
+    Serial.println("Black box: not enough PSRAM");
+    return false;
+  }
+  state = enabled ? BLACKBOX_RECORDING : BLACKBOX_IDLE;
+  xTaskCreatePinnedToCore(blackbox_task, "blackbox", 3072, NULL, 3, NULL, FRAME_HUB_CAPTURE_CORE);
+  Serial.printf("Black box %s, %u KB video ring\n", blackbox_state_name(state), BLACKBOX_VIDEO_BYTES / 1024);
+  return true;
+}
+
+void blackbox_record(bool on)
+{
+  portENTER_CRITICAL(&blackbox_lock);
+  enabled = on;
+  if (on && state == BLACKBOX_IDLE)
+  {
+    clear();
+    state = BLACKBOX_RECORDING;
+  }
+  else if (!on && recording())
+    state = BLACKBOX_IDLE;
+  portEXIT_CRITICAL(&blackbox_lock);
+}
+
+void blackbox_command(const char *name, int value, int64_t time_us, esp_err_t result)
+{
+  portENTER_CRITICAL(&blackbox_lock);
+  if (recording())
+  {
+    blackbox_command_t *c;
+    if (command_count < BLACKBOX_MAX_COMMANDS)
+      c = &commands[(command_head + command_count++) % BLACKBOX_MAX_COMMANDS];
+    else
+    {
+      c = &commands[command_head];
+      command_head = (command_head + 1) % BLACKBOX_MAX_COMMANDS;
+    }
+    c->time_us = time_us;
+    c->name = name;
+    c->value = value;
+    c->result = result;
+  }
+  portEXIT_CRITICAL(&blackbox_lock);
+}
+
+void blackbox_freeze(const char *why, uint32_t post_ms)
+{
+  portENTER_CRITICAL(&blackbox_lock);
+  if (state == BLACKBOX_RECORDING)
+  {
+    state = BLACKBOX_TRIGGERED;
+    reason = why;
+    freeze_at_us = esp_timer_get_time() + (int64_t)post_ms * 1000;
+  }
+  portEXIT_CRITICAL(&blackbox_lock);
+}
+
+void blackbox_resume()
+{
+  portENTER_CRITICAL(&blackbox_lock);
+  if (state == BLACKBOX_FROZEN)
+  {
+    clear();
+    state = enabled ? BLACKBOX_RECORDING : BLACKBOX_IDLE;
+  }
+  portEXIT_CRITICAL(&blackbox_lock);
+}
+
+void blackbox_get_stats(blackbox_stats_t *stats)
+{
+  portENTER_CRITICAL(&blackbox_lock);
+  stats->state = state;
+  stats->reason = reason;
+  stats->frames = frame_count;
+  stats->commands = command_count;
+  stats->bytes = frame_bytes;
+  stats->span_ms = 0;
+  if (frame_count > 1)
+  {
+    const blackbox_frame_t *oldest = &frames[frame_head];
+    const blackbox_frame_t *newest = &frames[(frame_head + frame_count - 1) % BLACKBOX_MAX_FRAMES];
+    stats->span_ms = (newest->timestamp - oldest->timestamp) / 1000;
+  }
+  stats->overwritten = overwritten;
+  stats->too_large = too_large;
+  portEXIT_CRITICAL(&blackbox_lock);
+}
+
+bool blackbox_frame(uint16_t i, blackbox_frame_t *frame, const uint8_t **jpeg)
+{
+  portENTER_CRITICAL(&blackbox_lock);
+  bool ok = state == BLACKBOX_FROZEN && i < frame_count;
+  if (ok)
+    *frame = frames[(frame_head + i) % BLACKBOX_MAX_FRAMES];
+  portEXIT_CRITICAL(&blackbox_lock);
+  if (ok)
+    *jpeg = video + frame->offset;
+  return ok;
+}
+
+bool blackbox_command_at(uint16_t i, blackbox_command_t *command)
+{
+  portENTER_CRITICAL(&blackbox_lock);
+  bool ok = state == BLACKBOX_FROZEN && i < command_count;
+  if (ok)
+    *command = commands[(command_head + i) % BLACKBOX_MAX_COMMANDS];
+  portEXIT_CRITICAL(&blackbox_lock);
+  return ok;
+}
+
+int64_t blackbox_frozen_us()
+{
+  return frozen_us;
+}
@@ -0,0 +1,113 @@
+/*
+  ESP32_CAM_Robot_Car
+  blackbox.h
+  Black-box recorder: the last seconds of video and control commands in a
+  preallocated PSRAM ring, frozen on demand or when the drive link drops
+
+*/
+
+#ifndef BLACKBOX_H
+#define BLACKBOX_H
+
+#include "Arduino.h"
+
+// JPEG ring size; at SVGA and BLACKBOX_FPS this holds roughly 8 s of video
+#define BLACKBOX_VIDEO_BYTES (1536 * 1024)
+#define BLACKBOX_MAX_FRAMES 256
+#define BLACKBOX_MAX_COMMANDS 1024
+// Frames recorded per second; the rest of the stream is skipped
+#define BLACKBOX_FPS 10
+// After an automatic trigger, keep recording this long to see the outcome
+#define BLACKBOX_POST_MS 2000
+// Record from boot. Off by default: while recording, the recorder holds an
+// internal frame hub client and the camera never idles.
+#define BLACKBOX_RECORD_AT_BOOT 0
+
+typedef enum
+{
+  BLACKBOX_OFF,         // no PSRAM, nothing is recorded
+  BLACKBOX_IDLE,        // rings allocated, recording not enabled
+  BLACKBOX_RECORDING,
+  BLACKBOX_TRIGGERED,   // still recording until the post-trigger time is up
+  BLACKBOX_FROZEN,
+} blackbox_state_t;
+
+static inline const char *blackbox_state_name(blackbox_state_t state)
+{
+  switch (state)
+  {
+  case BLACKBOX_IDLE:
+    return "idle";
+  case BLACKBOX_RECORDING:
+    return "recording";
+  case BLACKBOX_TRIGGERED:
+    return "triggered";
+  case BLACKBOX_FROZEN:
+    return "frozen";
+  default:
+    return "off";
+  }
+}
+
+typedef struct
+{
+  uint32_t offset;      // position in the video ring
+  uint32_t len;
+  uint32_t seq;         // frame hub sequence number
+  int64_t timestamp;    // sensor capture time in us
+} blackbox_frame_t;
+
+typedef struct
+{
+  int64_t time_us;      // when the request carrying the command arrived
+  const char *name;     // command table name, static
+  int32_t value;
+  int32_t result;       // esp_err_t returned by the command
+} blackbox_command_t;
+
+typedef struct
+{
+  blackbox_state_t state;
+  const char *reason;   // why it was triggered, "" while recording
+  uint16_t frames;
+  uint16_t commands;
+  uint32_t bytes;
+  uint32_t span_ms;     // time between the oldest and newest frame
+  uint32_t overwritten; // frames dropped from the ring since the last resume
+  uint32_t too_large;   // frames skipped because they would not fit
+} blackbox_stats_t;
+
+// Allocate the rings in PSRAM and start the recorder task, recording if
+// BLACKBOX_RECORD_AT_BOOT. Returns false, leaving the recorder off, without
+// PSRAM.
+bool blackbox_start();
+
+// Enable or disable recording. The recorder only holds its frame hub client
+// while recording, so the camera keeps running with no viewers then and can
+// idle otherwise. Disabling drops an unfrozen recording; a frozen one stays
+// until resumed.
+void blackbox_record(bool on);
+
+// Record a control command
+void blackbox_command(const char *name, int value, int64_t time_us, esp_err_t result);
+
+// Stop recording post_ms from now. Ignored unless recording, so the first
+// trigger wins.
+void blackbox_freeze(const char *reason, uint32_t post_ms);
+
+// Drop a frozen recording and start over, or go idle if recording was
+// disabled meanwhile
+void blackbox_resume();
+
+void blackbox_get_stats(blackbox_stats_t *stats);
+
+// Read access to a frozen recording, oldest first. Only valid while frozen;
+// callers must not resume while iterating. Frames hand back a pointer into
+// the ring.
+bool blackbox_frame(uint16_t i, blackbox_frame_t *frame, const uint8_t **jpeg);
+bool blackbox_command_at(uint16_t i, blackbox_command_t *command);
+
+// When the recording was frozen, in us since boot
+int64_t blackbox_frozen_us();
+
+#endif
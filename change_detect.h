@@ -0,0 +1,57 @@
+/*
+  ESP32_CAM_Robot_Car
+  change_detect.h
+  Cheap still-scene detection from JPEG sizes, used to stop streaming
+  identical frames from a parked car
+
+*/
+
+#ifndef CHANGE_DETECT_H
+#define CHANGE_DETECT_H
+
+#include "Arduino.h"
+
+// Frames sent after a change regardless of size, so the viewer ends on the
+// settled scene rather than the last frame of the motion
+#define CHANGE_SETTLE_FRAMES 2
+
+// A JPEG's size tracks its content closely: sensor noise moves it by well
+// under 1% on a still scene, while anything moving in view or a change of
+// exposure moves it by more. Comparing against both the previous frame and
+// the last one sent catches sudden changes as well as slow drift.
+typedef struct
+{
+  uint32_t sent_len;       // size of the last frame sent, 0 before the first
+  uint32_t prev_len;       // size of the previous frame seen
+  int64_t sent_us;
+  uint8_t settle;
+} change_detect_t;
+
+static inline bool change_detect_differs(uint32_t a, uint32_t b, uint16_t threshold_permille)
+{
+  uint32_t diff = a > b ? a - b : b - a;
+  return (uint64_t)diff * 1000 > (uint64_t)threshold_permille * b;
+}
+
+// Decide whether to send a frame of len bytes captured at now_us. Frames
+// within threshold_permille of both references are skipped until
+// keepalive_ms has passed since the last frame sent.
+static inline bool change_detect_send(change_detect_t *d, uint32_t len, int64_t now_us,
+                                      uint16_t threshold_permille, uint32_t keepalive_ms)
+{
+  bool changed = !d->sent_len ||
+                 change_detect_differs(len, d->sent_len, threshold_permille) ||
+                 change_detect_differs(len, d->prev_len, threshold_permille);
+  d->prev_len = len;
+  if (changed)
+    d->settle = CHANGE_SETTLE_FRAMES;
+  else if (d->settle)
+    d->settle--;
+  else if (now_us - d->sent_us < (int64_t)keepalive_ms * 1000)
+    return false;
+  d->sent_len = len;
+  d->sent_us = now_us;
+  return true;
+}
+
+#endif
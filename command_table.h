@@ -0,0 +1,136 @@
+/*
+  ESP32_CAM_Robot_Car
+  command_table.h
+  Compile-time command table and allocation-free query parsing
+
+*/
+
+#ifndef COMMAND_TABLE_H
+#define COMMAND_TABLE_H
+
+#include "Arduino.h"
+
+// Hash buckets for name lookup. Must be a power of two; grow it if the
+// static_assert on the command table reports a collision.
+#define COMMAND_BUCKETS 32
+#define COMMAND_MAX_OPCODE 31
+// Longest /control query string accepted, including the terminator
+#define COMMAND_MAX_QUERY 64
+
+typedef esp_err_t (*command_fn_t)(int val);
+
+typedef struct
+{
+  const char *name;    // /control var name
+  uint8_t opcode;      // /ws opcode
+  int16_t min;
+  int16_t max;
+  command_fn_t handler;
+} command_t;
+
+// FNV-1a, usable at compile time to build the lookup index
+constexpr uint32_t command_hash(const char *s, uint32_t h = 2166136261u)
+{
+  return *s ? command_hash(s + 1, (h ^ (uint8_t)*s) * 16777619u) : h;
+}
+
+typedef struct
+{
+  int8_t by_name[COMMAND_BUCKETS];
+  int8_t by_opcode[COMMAND_MAX_OPCODE + 1];
+  bool valid;  // false on a hash bucket or opcode collision
+} command_index_t;
+
+template <size_t N>
+constexpr command_index_t command_index_build(const command_t (&table)[N])
+{
+  command_index_t index = {};
+  index.valid = true;
+  for (size_t i = 0; i < COMMAND_BUCKETS; i++)
+    index.by_name[i] = -1;
+  for (size_t i = 0; i <= COMMAND_MAX_OPCODE; i++)
+    index.by_opcode[i] = -1;
+  for (size_t i = 0; i < N; i++)
+  {
+    uint32_t bucket = command_hash(table[i].name) & (COMMAND_BUCKETS - 1);
+    if (index.by_name[bucket] >= 0)
+      index.valid = false;
+    index.by_name[bucket] = i;
+    if (table[i].opcode > COMMAND_MAX_OPCODE || index.by_opcode[table[i].opcode] >= 0)
+      index.valid = false;
+    else
+      index.by_opcode[table[i].opcode] = i;
+  }
+  return index;
+}
+
+template <size_t N>
+const command_t *command_find(const command_t (&table)[N], const command_index_t &index, const char *name)
+{
+  int8_t i = index.by_name[command_hash(name) & (COMMAND_BUCKETS - 1)];
+  if (i < 0 || strcmp(table[i].name, name))
+    return NULL;
+  return &table[i];
+}
+
+template <size_t N>
+const command_t *command_find(const command_t (&table)[N], const command_index_t &index, uint8_t opcode)
+{
+  if (opcode > COMMAND_MAX_OPCODE || index.by_opcode[opcode] < 0)
+    return NULL;
+  return &table[index.by_opcode[opcode]];
+}
+
+// Split a "var=NAME&val=N" query in place. var and val point into query.
+// The optional seq and t (client sequence and timestamp) fields used for
+// latency tracing are returned through seq and ts when those are non-NULL.
+static inline bool command_parse_query(char *query, const char **var, const char **val,
+                                       const char **seq = NULL, const char **ts = NULL)
+{
+  *var = NULL;
+  *val = NULL;
+  if (seq)
+    *seq = NULL;
+  if (ts)
+    *ts = NULL;
+  char *p = query;
+  while (p && *p)
+  {
+    char *next = strchr(p, '&');
+    if (next)
+      *next++ = 0;
+    char *eq = strchr(p, '=');
+    if (eq)
+    {
+      *eq = 0;
+      if (!strcmp(p, "var"))
+        *var = eq + 1;
+      else if (!strcmp(p, "val"))
+        *val = eq + 1;
+      else if (seq && !strcmp(p, "seq"))
+        *seq = eq + 1;
+      else if (ts && !strcmp(p, "t"))
+        *ts = eq + 1;
+    }
+    p = next;
+  }
+  return *var && **var && *val && **val;
+}
+
+// Strict decimal parse: rejects empty strings, trailing junk and overflow
+static inline bool command_parse_int(const char *str, int *out)
+{
+  char *end;
+  long v = strtol(str, &end, 10);
+  if (end == str || *end || v < INT16_MIN || v > INT16_MAX)
+    return false;
+  *out = (int)v;
+  return true;
+}
+
+static inline bool command_in_range(const command_t *cmd, int val)
+{
+  return val >= cmd->min && val <= cmd->max;
+}
+
+#endif
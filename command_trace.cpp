@@ -0,0 +1,87 @@
+/*
+  ESP32_CAM_Robot_Car
+  command_trace.cpp
+  Command-to-actuation latency tracing for /control and /ws commands
+
+*/
+
+#include "command_trace.h"
+#include "esp_heap_caps.h"
+
+volatile bool trace_enabled = false;
+
+static trace_t *ring = NULL;
+static uint32_t next_id = 1;
+static portMUX_TYPE trace_lock = portMUX_INITIALIZER_UNLOCKED;
+
+uint32_t trace_record(uint8_t opcode, int16_t value, uint16_t seq, uint32_t client_ms, int64_t received_us)
+{
+  if (!ring)
+    return 0;
+  portENTER_CRITICAL(&trace_lock);
+  uint32_t id = next_id++;
+  if (!next_id)
+    next_id = 1;
+  trace_t *t = &ring[id & (TRACE_RING_SIZE - 1)];
+  t->id = id;
+  t->seq = seq;
+  t->opcode = opcode;
+  t->value = value;
+  t->client_ms = client_ms;
+  t->received_us = received_us;
+  t->dispatch_us = 0;
+  t->actuate_us = 0;
+  portEXIT_CRITICAL(&trace_lock);
+  return id;
+}
+
+void trace_mark(uint32_t id, bool actuate, int64_t us)
+{
+  portENTER_CRITICAL(&trace_lock);
+  trace_t *t = &ring[id & (TRACE_RING_SIZE - 1)];
+  // The slot may have been reused by a newer command in the meantime
+  if (t->id == id)
+  {
+    uint32_t offset = us > t->received_us ? (uint32_t)(us - t->received_us) : 0;
+    if (actuate)
+      t->actuate_us = offset ? offset : 1;
+    else
+      t->dispatch_us = offset;
+  }
+  portEXIT_CRITICAL(&trace_lock);
+}
+
+esp_err_t trace_set_enabled(bool enabled)
+{
+  if (enabled && !ring)
+  {
+    ring = (trace_t *)heap_caps_calloc(TRACE_RING_SIZE, sizeof(trace_t), MALLOC_CAP_8BIT);
+    if (!ring)
+      return ESP_ERR_NO_MEM;
+  }
+  if (enabled && !trace_enabled)
+  {
+    portENTER_CRITICAL(&trace_lock);
+    memset(ring, 0, TRACE_RING_SIZE * sizeof(trace_t));
+    portEXIT_CRITICAL(&trace_lock);
+  }
+  trace_enabled = enabled;
+  return ESP_OK;
+}
+
+size_t trace_snapshot(trace_t *out, size_t max)
+{
+  if (!ring)
+    return 0;
+  size_t n = 0;
+  portENTER_CRITICAL(&trace_lock);
+  uint32_t last = next_id;
+  for (uint32_t i = 0; i < TRACE_RING_SIZE && n < max; i++)
+  {
+    trace_t *t = &ring[(last + i) & (TRACE_RING_SIZE - 1)];
+    if (t->id)
+      out[n++] = *t;
+  }
+  portEXIT_CRITICAL(&trace_lock);
+  return n;
+}
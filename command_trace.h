@@ -0,0 +1,60 @@
+/*
+  ESP32_CAM_Robot_Car
+  command_trace.h
+  Command-to-actuation latency tracing for /control and /ws commands
+
+*/
+
+#ifndef COMMAND_TRACE_H
+#define COMMAND_TRACE_H
+
+#include "Arduino.h"
+
+// Traces kept in the ring. Must be a power of two.
+#define TRACE_RING_SIZE 64
+
+typedef struct
+{
+  uint32_t id;           // 0 marks an unused slot
+  uint16_t seq;          // client sequence number, 0 if none was sent
+  uint8_t opcode;
+  int16_t value;
+  uint32_t client_ms;    // client timestamp, 0 if none was sent
+  int64_t received_us;   // request receipt, esp_timer clock
+  uint32_t dispatch_us;  // handler start, relative to received_us
+  uint32_t actuate_us;   // outputs updated, relative to received_us; 0 while pending
+} trace_t;
+
+extern volatile bool trace_enabled;
+
+uint32_t trace_record(uint8_t opcode, int16_t value, uint16_t seq, uint32_t client_ms, int64_t received_us);
+void trace_mark(uint32_t id, bool actuate, int64_t us);
+
+// Start a trace for a command. Returns 0 without touching the ring while
+// tracing is off, and every other trace_* call ignores id 0, so a disabled
+// tracer costs one load and branch per command.
+static inline uint32_t trace_begin(uint8_t opcode, int16_t value, uint16_t seq, uint32_t client_ms, int64_t received_us)
+{
+  return trace_enabled ? trace_record(opcode, value, seq, client_ms, received_us) : 0;
+}
+
+static inline void trace_dispatch(uint32_t id, int64_t us)
+{
+  if (id)
+    trace_mark(id, false, us);
+}
+
+static inline void trace_actuate(uint32_t id, int64_t us)
+{
+  if (id)
+    trace_mark(id, true, us);
+}
+
+// Enable or disable tracing. The ring is allocated on first enable and
+// cleared every time tracing is turned on.
+esp_err_t trace_set_enabled(bool enabled);
+
+// Copy traces oldest first into out. Returns the number copied.
+size_t trace_snapshot(trace_t *out, size_t max);
+
+#endif
@@ -0,0 +1,137 @@
+/*
+  ESP32_CAM_Robot_Car
+  deferred_log.cpp
+  Deferred logging: hot paths queue fixed-size binary records that a
+  low priority task formats and prints to Serial
+
+*/
+
+#include "deferred_log.h"
+#include <atomic>
+
+typedef struct
+{
+  dlog_level_t level;
+  const char *fmt;
+} dlog_format_info_t;
+
+static const dlog_format_info_t FORMATS[] = {
+#define DLOG_INFO(id, level, fmt) {level, fmt "\n"},
+    DLOG_FORMATS(DLOG_INFO)
+#undef DLOG_INFO
+};
+static_assert(sizeof(FORMATS) / sizeof(FORMATS[0]) == DLOG_FORMAT_COUNT, "DLOG_FORMATS table mismatch");
+static_assert((DLOG_RING_SIZE & (DLOG_RING_SIZE - 1)) == 0, "DLOG_RING_SIZE must be a power of two");
+
+typedef struct
+{
+  std::atomic<uint32_t> seq;  // slot sequence less the slot index, see dlog_write/drain_one
+  uint32_t time_ms;
+  uint16_t fmt;
+  uintptr_t args[DLOG_MAX_ARGS];
+} dlog_record_t;
+
+// Bounded multi-producer ring with per-slot sequence numbers. Producers claim
+// a slot with a CAS on head and publish it by bumping its sequence; the single
+// drain task consumes in order. Nothing blocks and nothing takes a lock.
+// Sequences are stored less the slot index, so the zero-initialized ring is
+// ready before dlog_start and records written early wait for the drain task.
+static dlog_record_t ring[DLOG_RING_SIZE];
+static std::atomic<uint32_t> head(0);
+static uint32_t tail = 0;
+static std::atomic<uint32_t> dropped(0);
+static std::atomic<int> current_level(DLOG_LEVEL_INFO);
+static TaskHandle_t drain_task = NULL;
+
+bool dlog_write(dlog_format_t fmt, uintptr_t a0, uintptr_t a1, uintptr_t a2, uintptr_t a3, uintptr_t a4)
+{
+  if (fmt >= DLOG_FORMAT_COUNT || FORMATS[fmt].level > current_level.load(std::memory_order_relaxed))
+    return false;
+
+  uint32_t pos = head.load(std::memory_order_relaxed);
+  uint32_t slot;
+  dlog_record_t *rec;
+  while (true)
+  {
+    slot = pos & (DLOG_RING_SIZE - 1);
+    rec = &ring[slot];
+    int32_t diff = (int32_t)(rec->seq.load(std::memory_order_acquire) + slot - pos);
+    if (diff == 0)
+    {
+      if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if (diff < 0)
+    {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    else
+    {
+      pos = head.load(std::memory_order_relaxed);
+    }
+  }
+
+  rec->time_ms = millis();
+  rec->fmt = fmt;
+  rec->args[0] = a0;
+  rec->args[1] = a1;
+  rec->args[2] = a2;
+  rec->args[3] = a3;
+  rec->args[4] = a4;
+  rec->seq.store(pos + 1 - slot, std::memory_order_release);
+  return true;
+}
+
+static bool drain_one()
+{
+  uint32_t slot = tail & (DLOG_RING_SIZE - 1);
+  dlog_record_t *rec = &ring[slot];
+  if (rec->seq.load(std::memory_order_acquire) != tail + 1 - slot)
+    return false;
+
+  Serial.printf("[%u] ", rec->time_ms);
+  Serial.printf(FORMATS[rec->fmt].fmt, rec->args[0], rec->args[1], rec->args[2], rec->args[3], rec->args[4]);
+  rec->seq.store(tail + DLOG_RING_SIZE - slot, std::memory_order_release);
+  tail++;
+  return true;
+}
+
+static void drain(void *arg)
+{
+  uint32_t reported = 0;
+  while (true)
+  {
+    while (drain_one())
+      ;
+    uint32_t lost = dropped.load(std::memory_order_relaxed);
+    if (lost != reported)
+    {
+      Serial.printf("[log] %u records dropped\n", lost - reported);
+      reported = lost;
+    }
+    vTaskDelay(pdMS_TO_TICKS(20));
+  }
+}
+
+void dlog_start()
+{
+  if (drain_task)
+    return;
+  xTaskCreate(drain, "dlog", 3072, NULL, tskIDLE_PRIORITY + 1, &drain_task);
+}
+
+void dlog_set_level(dlog_level_t level)
+{
+  current_level.store(level, std::memory_order_relaxed);
+}
+
+dlog_level_t dlog_get_level()
+{
+  return (dlog_level_t)current_level.load(std::memory_order_relaxed);
+}
+
+uint32_t dlog_dropped()
+{
+  return dropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,58 @@
+/*
+  ESP32_CAM_Robot_Car
+  deferred_log.h
+  Deferred logging: hot paths queue fixed-size binary records that a
+  low priority task formats and prints to Serial
+
+*/
+
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+#include "Arduino.h"
+
+// Record slots in the ring. Must be a power of two.
+#define DLOG_RING_SIZE 64
+#define DLOG_MAX_ARGS 5
+
+typedef enum
+{
+  DLOG_LEVEL_ERROR,
+  DLOG_LEVEL_WARN,
+  DLOG_LEVEL_INFO,
+  DLOG_LEVEL_DEBUG,
+} dlog_level_t;
+
+// Every deferred message: id, level and printf format. Arguments are stored
+// as pointer sized words, so formats may only use integer conversions and %s
+// with strings that live forever (literals, table entries).
+#define DLOG_FORMATS(X)                                                              \
+  X(DLOG_MJPG_FRAME,    DLOG_LEVEL_DEBUG, "MJPG[%d]: %uB %ums (%ufps) skipped %u")  \
+  X(DLOG_STREAM_ERROR,  DLOG_LEVEL_ERROR, "Stream client %d: %s")                   \
+  X(DLOG_CAPTURE_ERROR, DLOG_LEVEL_ERROR, "%s")                                     \
+  X(DLOG_COMMAND,       DLOG_LEVEL_INFO,  "Command %s=%d")                          \
+  X(DLOG_COMMAND_RANGE, DLOG_LEVEL_WARN,  "Command %s: value %d out of range")      \
+  X(DLOG_MOTION,        DLOG_LEVEL_DEBUG, "%s: PWM values - RIGHT_M0: %d, RIGHT_M1: %d, LEFT_M0: %d, LEFT_M1: %d") \
+  X(DLOG_MOTION_STOP,   DLOG_LEVEL_DEBUG, "Stopping motors...")                     \
+  X(DLOG_MACRO,         DLOG_LEVEL_INFO,  "Macro %s after %u of %u steps")
+
+typedef enum
+{
+#define DLOG_ENUM(id, level, fmt) id,
+  DLOG_FORMATS(DLOG_ENUM)
+#undef DLOG_ENUM
+  DLOG_FORMAT_COUNT
+} dlog_format_t;
+
+// Start the drain task
+void dlog_start();
+
+// Queue a record without blocking. Returns false if it was filtered by the
+// current level or the ring was full (counted in dlog_dropped()).
+bool dlog_write(dlog_format_t fmt, uintptr_t a0 = 0, uintptr_t a1 = 0, uintptr_t a2 = 0, uintptr_t a3 = 0, uintptr_t a4 = 0);
+
+void dlog_set_level(dlog_level_t level);
+dlog_level_t dlog_get_level();
+uint32_t dlog_dropped();
+
+#endif
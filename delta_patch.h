@@ -0,0 +1,173 @@
+/*
+  ESP32_CAM_Robot_Car
+  delta_patch.h
+  Delta firmware patch format and a streaming decoder for its operations
+
+*/
+
+#ifndef DELTA_PATCH_H
+#define DELTA_PATCH_H
+
+#include "Arduino.h"
+
+// A patch file is a delta_header_t followed by a zlib stream of operations,
+// generated by tools/delta_ota.py. Each operation is a type byte and
+// little-endian fields:
+//   DELTA_ADD    u32 source offset, u32 length, then length bytes that are
+//                added (mod 256) to the source bytes at that offset
+//   DELTA_INSERT u32 length, then length literal bytes
+//   DELTA_END    no fields, must be the last operation
+// Relinked code moves by small amounts, so ADD bytes are mostly zero and
+// compress to almost nothing.
+#define DELTA_MAGIC "RVDP"
+#define DELTA_VERSION 1
+#define DELTA_CHUNK 256   // source bytes read per step of an ADD
+
+typedef struct __attribute__((packed))
+{
+  char magic[4];
+  uint8_t version;
+  uint8_t reserved[3];
+  uint32_t source_len;
+  uint32_t target_len;
+  uint8_t source_sha256[32];   // first source_len bytes of the running partition
+  uint8_t target_sha256[32];   // the image the patch produces
+} delta_header_t;
+
+static_assert(sizeof(delta_header_t) == 80, "delta header layout");
+
+typedef enum
+{
+  DELTA_END,
+  DELTA_ADD,
+  DELTA_INSERT,
+} delta_op_t;
+
+// Read len bytes of the source image at offset into buf
+typedef bool (*delta_read_fn)(void *ctx, uint32_t offset, uint8_t *buf, size_t len);
+// Output the next len bytes of the target image
+typedef bool (*delta_write_fn)(void *ctx, const uint8_t *data, size_t len);
+
+typedef struct
+{
+  uint32_t source_len;
+  uint32_t target_len;
+  uint32_t written;
+  uint8_t op;
+  uint8_t field[8];      // fields of the current op as they arrive
+  uint8_t field_len;
+  uint8_t field_need;
+  uint32_t source_offset;
+  uint32_t remaining;    // data bytes left in the current op
+  bool in_data;
+  bool done;
+  uint8_t chunk[DELTA_CHUNK];
+  delta_read_fn read;
+  delta_write_fn write;
+  void *ctx;
+} delta_patch_t;
+
+static inline uint32_t delta_u32(const uint8_t *p)
+{
+  return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// Check a header and set up d to decode the operations that follow it.
+// Returns NULL or what is wrong with the header.
+static inline const char *delta_init(delta_patch_t *d, const delta_header_t *h, delta_read_fn read, delta_write_fn write, void *ctx)
+{
+  if (memcmp(h->magic, DELTA_MAGIC, 4))
+    return "Not a delta patch";
+  if (h->version != DELTA_VERSION)
+    return "Unsupported patch version";
+  memset(d, 0, sizeof(*d));
+  d->source_len = h->source_len;
+  d->target_len = h->target_len;
+  d->read = read;
+  d->write = write;
+  d->ctx = ctx;
+  return NULL;
+}
+
+// Feed decompressed operation bytes. Returns NULL or the reason the patch
+// was rejected.
+static inline const char *delta_feed(delta_patch_t *d, const uint8_t *data, size_t len)
+{
+  while (len)
+  {
+    if (d->done)
+      return "Data after end of patch";
+
+    if (!d->in_data)
+    {
+      // Op type, then its fields
+      if (!d->field_need)
+      {
+        d->op = *data++;
+        len--;
+        d->field_len = 0;
+        switch (d->op)
+        {
+        case DELTA_END:
+          if (d->written != d->target_len)
+            return "Patch ended early";
+          d->done = true;
+          continue;
+        case DELTA_ADD:
+          d->field_need = 8;
+          break;
+        case DELTA_INSERT:
+          d->field_need = 4;
+          break;
+        default:
+          return "Unknown patch operation";
+        }
+        continue;
+      }
+      d->field[d->field_len++] = *data++;
+      len--;
+      if (d->field_len < d->field_need)
+        continue;
+      d->field_need = 0;
+      if (d->op == DELTA_ADD)
+      {
+        d->source_offset = delta_u32(d->field);
+        d->remaining = delta_u32(d->field + 4);
+        if (d->source_offset > d->source_len || d->remaining > d->source_len - d->source_offset)
+          return "Patch reads past source";
+      }
+      else
+        d->remaining = delta_u32(d->field);
+      if (d->remaining > d->target_len - d->written)
+        return "Patch writes past target";
+      d->in_data = d->remaining > 0;
+      continue;
+    }
+
+    size_t n = len < d->remaining ? len : d->remaining;
+    if (d->op == DELTA_INSERT)
+    {
+      if (!d->write(d->ctx, data, n))
+        return "Write failed";
+    }
+    else
+    {
+      n = n < DELTA_CHUNK ? n : DELTA_CHUNK;
+      if (!d->read(d->ctx, d->source_offset, d->chunk, n))
+        return "Source read failed";
+      for (size_t i = 0; i < n; i++)
+        d->chunk[i] += data[i];
+      if (!d->write(d->ctx, d->chunk, n))
+        return "Write failed";
+      d->source_offset += n;
+    }
+    data += n;
+    len -= n;
+    d->written += n;
+    d->remaining -= n;
+    d->in_data = d->remaining > 0;
+  }
+  return NULL;
+}
+
+#endif
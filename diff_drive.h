@@ -0,0 +1,44 @@
+/*
+  ESP32_CAM_Robot_Car
+  diff_drive.h
+  Differential-drive mixing and slew-rate limiting
+
+*/
+
+#ifndef DIFF_DRIVE_H
+#define DIFF_DRIVE_H
+
+#include "Arduino.h"
+
+// Velocity commands are in percent of full scale
+#define DIFF_DRIVE_SCALE 100
+
+// Mix a linear/angular velocity pair into signed per-side duty in
+// [-max_duty, max_duty]. Positive angular turns left (counter-clockwise).
+// When a side would saturate, both sides are scaled down together so the
+// turn radius is kept.
+static inline void diff_drive_mix(int linear, int angular, int max_duty, int *left, int *right)
+{
+  int l = linear - angular;
+  int r = linear + angular;
+  int peak = abs(l) > abs(r) ? abs(l) : abs(r);
+  if (peak > DIFF_DRIVE_SCALE)
+  {
+    l = l * DIFF_DRIVE_SCALE / peak;
+    r = r * DIFF_DRIVE_SCALE / peak;
+  }
+  *left = l * max_duty / DIFF_DRIVE_SCALE;
+  *right = r * max_duty / DIFF_DRIVE_SCALE;
+}
+
+// Move current towards target by at most max_step
+static inline int diff_drive_slew(int current, int target, int max_step)
+{
+  if (target > current + max_step)
+    return current + max_step;
+  if (target < current - max_step)
+    return current - max_step;
+  return target;
+}
+
+#endif
@@ -0,0 +1,171 @@
+/*
+  ESP32_CAM_Robot_Car
+  endpoint_stats.cpp
+  Per-endpoint request, time, heap and byte counters for the HTTP servers
+
+*/
+
+#include "endpoint_stats.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+
+static endpoint_stats_t endpoints[ENDPOINT_MAX];
+static size_t endpoint_count = 0;
+// Endpoint that last handled a request on each socket, indexed by
+// sockfd - LWIP_SOCKET_OFFSET. Async handlers keep sending on the same
+// socket, so /stream bytes land on /stream after its handler returns.
+static endpoint_stats_t *socket_endpoint[ENDPOINT_MAX_SOCKETS];
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static endpoint_stats_t *socket_lookup(int sockfd)
+{
+  int i = sockfd - LWIP_SOCKET_OFFSET;
+  return i >= 0 && i < ENDPOINT_MAX_SOCKETS ? socket_endpoint[i] : NULL;
+}
+
+// Same behaviour as the httpd default send function, plus byte counting
+static int counting_send(httpd_handle_t hd, int sockfd, const char *buf, size_t len, int flags)
+{
+  if (!buf)
+    return HTTPD_SOCK_ERR_INVALID;
+  int ret = send(sockfd, buf, len, flags);
+  if (ret < 0)
+  {
+    if (errno == EAGAIN || errno == EINTR)
+      return HTTPD_SOCK_ERR_TIMEOUT;
+    return HTTPD_SOCK_ERR_FAIL;
+  }
+  endpoint_stats_t *ep = socket_lookup(sockfd);
+  if (ep)
+  {
+    portENTER_CRITICAL(&stats_lock);
+    ep->sent_bytes += ret;
+    portEXIT_CRITICAL(&stats_lock);
+  }
+  return ret;
+}
+
+static esp_err_t endpoint_dispatch(httpd_req_t *req)
+{
+  endpoint_stats_t *ep = (endpoint_stats_t *)req->user_ctx;
+  int sockfd = httpd_req_to_sockfd(req);
+  int i = sockfd - LWIP_SOCKET_OFFSET;
+  if (i >= 0 && i < ENDPOINT_MAX_SOCKETS)
+  {
+    socket_endpoint[i] = ep;
+    httpd_sess_set_send_override(req->handle, sockfd, counting_send);
+  }
+
+  // The heap figure is the net drop across the call. Other tasks allocate
+  // concurrently, so treat it as an upper bound on what the handler holds.
+  size_t heap_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  int64_t start = esp_timer_get_time();
+  esp_err_t res = ep->handler(req);
+  uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+  size_t heap_after = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  uint32_t heap = heap_before > heap_after ? heap_before - heap_after : 0;
+
+  portENTER_CRITICAL(&stats_lock);
+  ep->requests++;
+  if (res != ESP_OK)
+    ep->errors++;
+  ep->handler_us += us;
+  if (us > ep->handler_max_us)
+    ep->handler_max_us = us;
+  if (heap > ep->heap_max_bytes)
+    ep->heap_max_bytes = heap;
+  portEXIT_CRITICAL(&stats_lock);
+  return res;
+}
+
+esp_err_t endpoint_register(httpd_handle_t server, httpd_uri_t *uri)
+{
+  if (endpoint_count >= ENDPOINT_MAX)
+  {
+    Serial.printf("Endpoint stats full, %s %s is not counted\n", uri->method == HTTP_POST ? "POST" : "GET", uri->uri);
+    return httpd_register_uri_handler(server, uri);
+  }
+
+  endpoint_stats_t *ep = &endpoints[endpoint_count++];
+  snprintf(ep->name, sizeof(ep->name), "%s %s", uri->method == HTTP_POST ? "POST" : "GET", uri->uri);
+  ep->handler = uri->handler;
+  uri->handler = endpoint_dispatch;
+  uri->user_ctx = ep;
+  return httpd_register_uri_handler(server, uri);
+}
+
+typedef enum
+{
+  VALUE_REQUESTS,
+  VALUE_ERRORS,
+  VALUE_HANDLER_SECONDS,
+  VALUE_HANDLER_MAX_SECONDS,
+  VALUE_SENT_BYTES,
+  VALUE_HEAP_MAX_BYTES,
+} family_value_t;
+
+typedef struct
+{
+  const char *name;
+  const char *type;
+  const char *help;
+  family_value_t value;
+} family_t;
+
+static const family_t FAMILIES[] = {
+    {"robot_http_requests_total", "counter", "Requests handled per endpoint", VALUE_REQUESTS},
+    {"robot_http_errors_total", "counter", "Handler calls that returned an error", VALUE_ERRORS},
+    {"robot_http_handler_seconds_total", "counter", "Time spent inside the handler", VALUE_HANDLER_SECONDS},
+    {"robot_http_handler_max_seconds", "gauge", "Longest single handler call", VALUE_HANDLER_MAX_SECONDS},
+    {"robot_http_sent_bytes_total", "counter", "Bytes written to the socket", VALUE_SENT_BYTES},
+    {"robot_http_heap_max_bytes", "gauge", "Largest net heap drop across one handler call", VALUE_HEAP_MAX_BYTES},
+};
+
+size_t endpoint_stats_families()
+{
+  return sizeof(FAMILIES) / sizeof(FAMILIES[0]);
+}
+
+size_t endpoint_stats_format(size_t family, char *buf, size_t len)
+{
+  if (family >= endpoint_stats_families())
+    return 0;
+  const family_t *f = &FAMILIES[family];
+
+  size_t n = 0;
+  int r = snprintf(buf, len, "# HELP %s %s\n# TYPE %s %s\n", f->name, f->help, f->name, f->type);
+  if (r < 0 || (size_t)r >= len)
+    return 0;
+  n += r;
+
+  for (size_t i = 0; i < endpoint_count; i++)
+  {
+    portENTER_CRITICAL(&stats_lock);
+    endpoint_stats_t ep = endpoints[i];
+    portEXIT_CRITICAL(&stats_lock);
+
+    switch (f->value)
+    {
+    case VALUE_HANDLER_SECONDS:
+      r = snprintf(buf + n, len - n, "%s{endpoint=\"%s\"} %u.%06u\n", f->name, ep.name,
+                   (uint32_t)(ep.handler_us / 1000000), (uint32_t)(ep.handler_us % 1000000));
+      break;
+    case VALUE_HANDLER_MAX_SECONDS:
+      r = snprintf(buf + n, len - n, "%s{endpoint=\"%s\"} %u.%06u\n", f->name, ep.name,
+                   ep.handler_max_us / 1000000, ep.handler_max_us % 1000000);
+      break;
+    case VALUE_SENT_BYTES:
+      r = snprintf(buf + n, len - n, "%s{endpoint=\"%s\"} %llu\n", f->name, ep.name, (unsigned long long)ep.sent_bytes);
+      break;
+    default:
+      r = snprintf(buf + n, len - n, "%s{endpoint=\"%s\"} %u\n", f->name, ep.name,
+                   f->value == VALUE_REQUESTS ? ep.requests : f->value == VALUE_ERRORS ? ep.errors : ep.heap_max_bytes);
+      break;
+    }
+    if (r < 0 || (size_t)r >= len - n)
+      return 0;
+    n += r;
+  }
+  return n;
+}
@@ -0,0 +1,44 @@
+/*
+  ESP32_CAM_Robot_Car
+  endpoint_stats.h
+  Per-endpoint request, time, heap and byte counters for the HTTP servers
+
+*/
+
+#ifndef ENDPOINT_STATS_H
+#define ENDPOINT_STATS_H
+
+#include "Arduino.h"
+#include "esp_http_server.h"
+
+// Registered endpoints across both servers; startCameraServer checks its
+// registration lists against this at compile time
+#define ENDPOINT_MAX 16
+// Sockets tracked for byte counting; covers CONFIG_LWIP_MAX_SOCKETS
+#define ENDPOINT_MAX_SOCKETS 16
+
+typedef struct
+{
+  char name[24];       // "GET /control", used as the metric label
+  esp_err_t (*handler)(httpd_req_t *req);
+  uint32_t requests;
+  uint32_t errors;     // handler returned something other than ESP_OK
+  uint64_t handler_us;
+  uint32_t handler_max_us;
+  uint64_t sent_bytes; // everything written to the socket, headers included
+  uint32_t heap_max_bytes;  // largest heap drop across one handler call
+} endpoint_stats_t;
+
+// Register uri on server with its handler wrapped for accounting. Replaces
+// uri->user_ctx, so wrapped handlers must not rely on it. Once the table is
+// full, further endpoints are registered uncounted and logged.
+esp_err_t endpoint_register(httpd_handle_t server, httpd_uri_t *uri);
+
+// Number of metric families endpoint_stats_format can write
+size_t endpoint_stats_families();
+
+// Write one metric family for all endpoints in Prometheus text format.
+// Returns the number of bytes written, or 0 if buf was too small.
+size_t endpoint_stats_format(size_t family, char *buf, size_t len);
+
+#endif
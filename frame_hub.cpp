@@ -0,0 +1,395 @@
+/*
+  ESP32_CAM_Robot_Car
+  frame_hub.cpp
+  Single producer, multi-client frame sharing for the MJPEG stream
+
+*/
+
+#include "frame_hub.h"
+#include "esp_camera.h"
+#include "esp_timer.h"
+#include "img_converters.h"
+#include "deferred_log.h"
+#include "metrics.h"
+
+static hub_frame_t slots[FRAME_HUB_SLOTS];
+static hub_frame_t *latest = NULL;
+static uint32_t next_seq = 1;
+
+// Viewers first, then the internal clients
+#define HUB_CLIENTS (FRAME_HUB_MAX_CLIENTS + FRAME_HUB_INTERNAL_CLIENTS)
+
+static TaskHandle_t clients[HUB_CLIENTS];
+static volatile uint8_t client_count = 0;
+static uint8_t internal_count = 0;
+
+static TaskHandle_t capture_task = NULL;
+static QueueHandle_t capture_queue = NULL;
+static frame_hub_stats_t hub_stats;
+static portMUX_TYPE hub_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Ensure a slot can hold len bytes, leaving some headroom so small
+// JPEG size changes between frames do not reallocate every time.
+static bool slot_reserve(hub_frame_t *slot, size_t len)
+{
+  if (slot->cap >= len) {
+    return true;
+  }
+  size_t cap = len + len / 4;
+  uint32_t caps = psramFound() ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT;
+  uint8_t *buf = (uint8_t *)heap_caps_realloc(slot->buf, cap, caps);
+  if (!buf) {
+    return false;
+  }
+  slot->buf = buf;
+  slot->cap = cap;
+  return true;
+}
+
+// Claim a slot that no client is reading and that is not the newest frame.
+// The caller owns the returned reference.
+static hub_frame_t *claim_slot()
+{
+  hub_frame_t *slot = NULL;
+  portENTER_CRITICAL(&hub_lock);
+  for (int i = 0; i < FRAME_HUB_SLOTS; i++) {
+    if (slots[i].refs == 0 && &slots[i] != latest) {
+      slot = &slots[i];
+      slot->refs = 1;
+      break;
+    }
+  }
+  portEXIT_CRITICAL(&hub_lock);
+  return slot;
+}
+
+static void pool_count(bool hit)
+{
+  portENTER_CRITICAL(&hub_lock);
+  if (hit) {
+    hub_stats.pool_hits++;
+  } else {
+    hub_stats.pool_misses++;
+  }
+  portEXIT_CRITICAL(&hub_lock);
+}
+
+typedef struct
+{
+  hub_frame_t *slot;
+  bool overflow;
+} slot_writer_t;
+
+// frame2jpg_cb output callback: append encoder output to the slot buffer
+static size_t slot_write(void *arg, size_t index, const void *data, size_t len)
+{
+  slot_writer_t *w = (slot_writer_t *)arg;
+  hub_frame_t *slot = w->slot;
+  if (!index) {
+    slot->len = 0;
+  }
+  if (slot->len + len > slot->cap) {
+    w->overflow = true;
+    return 0;
+  }
+  memcpy(slot->buf + slot->len, data, len);
+  slot->len += len;
+  return len;
+}
+
+// Fill a claimed slot from a camera frame, converting to JPEG if needed.
+// Frames that fit the pooled buffer count as hits; anything that forces the
+// buffer to grow counts as one miss, however many times it grows.
+static bool slot_fill(hub_frame_t *slot, camera_fb_t *fb)
+{
+  slot->timestamp = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+
+  if (fb->format == PIXFORMAT_JPEG) {
+    bool hit = slot->cap >= fb->len;
+    if (!slot_reserve(slot, fb->len)) {
+      return false;
+    }
+    memcpy(slot->buf, fb->buf, fb->len);
+    slot->len = fb->len;
+    pool_count(hit);
+    return true;
+  }
+
+  slot_writer_t writer = {slot, false};
+  if (slot->cap && frame2jpg_cb(fb, 80, slot_write, &writer)) {
+    pool_count(true);
+    return true;
+  }
+  if (slot->cap && !writer.overflow) {
+    return false;
+  }
+
+  // Too small for this frame: double and encode again, up to the size of
+  // the raw frame
+  pool_count(false);
+  size_t cap = slot->cap ? slot->cap * 2 : fb->len / 4;
+  while (true) {
+    if (!slot_reserve(slot, cap)) {
+      return false;
+    }
+    writer.overflow = false;
+    if (frame2jpg_cb(fb, 80, slot_write, &writer)) {
+      return true;
+    }
+    if (!writer.overflow || slot->cap >= fb->len) {
+      return false;
+    }
+    cap = slot->cap * 2;
+  }
+}
+
+static void publish(hub_frame_t *slot)
+{
+  TaskHandle_t waiting[HUB_CLIENTS];
+  uint8_t n = 0;
+
+  portENTER_CRITICAL(&hub_lock);
+  slot->seq = next_seq++;
+  // A frame still in flight when the last client detached would greet the
+  // next one as a stale picture
+  if (!client_count) {
+    slot->refs--;
+    portEXIT_CRITICAL(&hub_lock);
+    return;
+  }
+  // The claim reference becomes the hub's reference to the newest frame
+  if (latest) {
+    latest->refs--;
+  }
+  latest = slot;
+  hub_stats.produced++;
+  for (int i = 0; i < HUB_CLIENTS; i++) {
+    if (clients[i]) {
+      waiting[n++] = clients[i];
+    }
+  }
+  portEXIT_CRITICAL(&hub_lock);
+
+  for (int i = 0; i < n; i++) {
+    xTaskNotifyGive(waiting[i]);
+  }
+}
+
+// Exponential moving average with a 1/8 weight for the newest sample
+static void stage_update(uint32_t *avg, uint32_t sample)
+{
+  portENTER_CRITICAL(&hub_lock);
+  *avg = *avg ? *avg - *avg / 8 + sample / 8 : sample;
+  portEXIT_CRITICAL(&hub_lock);
+}
+
+static void capture_stage(void *arg)
+{
+  while (true) {
+    if (!client_count) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      continue;
+    }
+
+    int64_t start = esp_timer_get_time();
+    camera_fb_t *fb = esp_camera_fb_get();
+    if (!fb) {
+      dlog_write(DLOG_CAPTURE_ERROR, (uintptr_t)"Camera capture failed");
+      vTaskDelay(pdMS_TO_TICKS(10));
+      continue;
+    }
+    uint32_t capture_us = (uint32_t)(esp_timer_get_time() - start);
+    stage_update(&hub_stats.capture_us, capture_us);
+    histogram_observe(&metric_fb_get, capture_us);
+
+    // Blocks while the encode stage is behind, which holds the sensor back
+    xQueueSend(capture_queue, &fb, portMAX_DELAY);
+
+    uint8_t depth = uxQueueMessagesWaiting(capture_queue);
+    portENTER_CRITICAL(&hub_lock);
+    if (depth > hub_stats.queue_max) {
+      hub_stats.queue_max = depth;
+    }
+    portEXIT_CRITICAL(&hub_lock);
+  }
+}
+
+static void encode_stage(void *arg)
+{
+  camera_fb_t *fb = NULL;
+  while (true) {
+    xQueueReceive(capture_queue, &fb, portMAX_DELAY);
+
+    hub_frame_t *slot = claim_slot();
+    if (!slot) {
+      esp_camera_fb_return(fb);
+      portENTER_CRITICAL(&hub_lock);
+      hub_stats.dropped++;
+      portEXIT_CRITICAL(&hub_lock);
+      vTaskDelay(1);
+      continue;
+    }
+
+    int64_t start = esp_timer_get_time();
+    bool ok = slot_fill(slot, fb);
+    esp_camera_fb_return(fb);
+    if (!ok) {
+      frame_hub_release(slot);
+      dlog_write(DLOG_CAPTURE_ERROR, (uintptr_t)"JPEG compression failed");
+      continue;
+    }
+    uint32_t encode_us = (uint32_t)(esp_timer_get_time() - start);
+    stage_update(&hub_stats.encode_us, encode_us);
+    histogram_observe(&metric_jpeg_encode, encode_us);
+    publish(slot);
+  }
+}
+
+void frame_hub_start(framesize_t max_framesize)
+{
+  if (capture_task) {
+    return;
+  }
+  // Preallocate the slot pool in PSRAM for the largest frame size in use.
+  // A quarter of the pixel count covers typical JPEG output; bigger frames
+  // grow their slot once and are counted as pool misses.
+  if (psramFound()) {
+    size_t len = (size_t)resolution[max_framesize].width * resolution[max_framesize].height / 4;
+    for (int i = 0; i < FRAME_HUB_SLOTS; i++) {
+      slot_reserve(&slots[i], len);
+    }
+    hub_stats.pool_slot_bytes = slots[0].cap;
+  }
+  capture_queue = xQueueCreate(FRAME_HUB_QUEUE_DEPTH, sizeof(camera_fb_t *));
+  xTaskCreate(encode_stage, "frame_encode", 4096, NULL, 5, NULL);
+  xTaskCreatePinnedToCore(capture_stage, "frame_capture", 3072, NULL, 6, &capture_task, FRAME_HUB_CAPTURE_CORE);
+}
+
+static int attach_range(int first, int count)
+{
+  int client = -1;
+  portENTER_CRITICAL(&hub_lock);
+  for (int i = first; i < first + count; i++) {
+    if (!clients[i]) {
+      clients[i] = xTaskGetCurrentTaskHandle();
+      client_count++;
+      if (i >= FRAME_HUB_MAX_CLIENTS) {
+        internal_count++;
+      }
+      client = i;
+      break;
+    }
+  }
+  portEXIT_CRITICAL(&hub_lock);
+
+  if (client >= 0 && capture_task) {
+    xTaskNotifyGive(capture_task);
+  }
+  return client;
+}
+
+int frame_hub_attach()
+{
+  return attach_range(0, FRAME_HUB_MAX_CLIENTS);
+}
+
+int frame_hub_attach_internal()
+{
+  return attach_range(FRAME_HUB_MAX_CLIENTS, FRAME_HUB_INTERNAL_CLIENTS);
+}
+
+void frame_hub_detach(int client)
+{
+  if (client < 0 || client >= HUB_CLIENTS) {
+    return;
+  }
+  portENTER_CRITICAL(&hub_lock);
+  if (clients[client]) {
+    clients[client] = NULL;
+    client_count--;
+    if (client >= FRAME_HUB_MAX_CLIENTS) {
+      internal_count--;
+    }
+  }
+  // Drop the last frame once nobody is watching so the next viewer
+  // does not start with a stale picture.
+  if (!client_count && latest) {
+    latest->refs--;
+    latest = NULL;
+  }
+  portEXIT_CRITICAL(&hub_lock);
+}
+
+hub_frame_t *frame_hub_acquire(uint32_t last_seq, TickType_t timeout)
+{
+  TickType_t start = xTaskGetTickCount();
+  while (true) {
+    portENTER_CRITICAL(&hub_lock);
+    hub_frame_t *frame = latest;
+    if (frame && frame->seq != last_seq) {
+      frame->refs++;
+      portEXIT_CRITICAL(&hub_lock);
+      return frame;
+    }
+    portEXIT_CRITICAL(&hub_lock);
+
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    if (elapsed >= timeout) {
+      return NULL;
+    }
+    ulTaskNotifyTake(pdTRUE, timeout - elapsed);
+  }
+}
+
+hub_frame_t *frame_hub_acquire_latest(int64_t max_age_us)
+{
+  int64_t now = esp_timer_get_time();
+  portENTER_CRITICAL(&hub_lock);
+  hub_frame_t *frame = latest;
+  if (frame && now - frame->timestamp <= max_age_us) {
+    frame->refs++;
+  } else {
+    frame = NULL;
+  }
+  portEXIT_CRITICAL(&hub_lock);
+  return frame;
+}
+
+hub_frame_t *frame_hub_encode(camera_fb_t *fb)
+{
+  hub_frame_t *slot = claim_slot();
+  if (!slot) {
+    return NULL;
+  }
+  if (!slot_fill(slot, fb)) {
+    frame_hub_release(slot);
+    return NULL;
+  }
+  return slot;
+}
+
+void frame_hub_release(hub_frame_t *frame)
+{
+  if (!frame) {
+    return;
+  }
+  portENTER_CRITICAL(&hub_lock);
+  frame->refs--;
+  portEXIT_CRITICAL(&hub_lock);
+}
+
+void frame_hub_record_send(uint32_t us)
+{
+  stage_update(&hub_stats.send_us, us);
+}
+
+void frame_hub_get_stats(frame_hub_stats_t *stats)
+{
+  uint8_t depth = capture_queue ? uxQueueMessagesWaiting(capture_queue) : 0;
+  portENTER_CRITICAL(&hub_lock);
+  *stats = hub_stats;
+  stats->clients = client_count - internal_count;
+  stats->internal_clients = internal_count;
+  stats->queue_depth = depth;
+  portEXIT_CRITICAL(&hub_lock);
+}
@@ -0,0 +1,88 @@
+/*
+  ESP32_CAM_Robot_Car
+  frame_hub.h
+  Single producer, multi-client frame sharing for the MJPEG stream
+
+*/
+
+#ifndef FRAME_HUB_H
+#define FRAME_HUB_H
+
+#include "Arduino.h"
+#include "esp_camera.h"
+
+// Number of shared JPEG slots. The newest frame always holds one slot, so
+// with N slots up to N-1 older frames can still be on the wire to slow clients.
+#define FRAME_HUB_SLOTS 4
+// Maximum number of concurrent /stream viewers
+#define FRAME_HUB_MAX_CLIENTS 4
+// Clients reserved for in-firmware consumers (black box recorder, UDP
+// stream), so they never take a viewer's place
+#define FRAME_HUB_INTERNAL_CLIENTS 2
+// Camera frames waiting between the capture and encode stages. Kept below
+// fb_count so queued frames never hold every sensor buffer at once.
+#define FRAME_HUB_QUEUE_DEPTH 1
+// Capture runs on the application core, away from the WiFi/lwIP core 0
+#define FRAME_HUB_CAPTURE_CORE 1
+
+typedef struct
+{
+  uint8_t *buf;
+  size_t len;
+  size_t cap;
+  uint32_t seq;
+  int64_t timestamp;   // sensor capture time in us
+  uint8_t refs;
+} hub_frame_t;
+
+typedef struct
+{
+  uint32_t produced;
+  uint32_t dropped;    // frames discarded because every slot was in use
+  uint8_t clients;          // /stream viewers
+  uint8_t internal_clients;
+  uint8_t queue_depth; // camera frames waiting for the encode stage
+  uint8_t queue_max;
+  // JPEG slot pool: frames that fit the preallocated buffer vs. ones that grew it
+  uint32_t pool_hits;
+  uint32_t pool_misses;
+  uint32_t pool_slot_bytes;
+  // Smoothed per-stage times in us
+  uint32_t capture_us;
+  uint32_t encode_us;
+  uint32_t send_us;
+} frame_hub_stats_t;
+
+// Create the capture and encode tasks. Capture feeds encode through a bounded
+// queue and encode publishes into the shared slots, so the sensor keeps
+// working while clients are sending. Frames are only grabbed while a client is attached.
+// The slot pool is preallocated for max_framesize when PSRAM is available.
+void frame_hub_start(framesize_t max_framesize);
+
+// Register the calling task as a stream viewer. Returns a client id below
+// FRAME_HUB_MAX_CLIENTS, or -1 when full.
+int frame_hub_attach();
+// Register the calling task as an internal client. Returns a client id at or
+// above FRAME_HUB_MAX_CLIENTS, or -1 when full.
+int frame_hub_attach_internal();
+void frame_hub_detach(int client);
+
+// Wait for a frame newer than last_seq and take a reference on it.
+// Slow clients always get the newest frame, skipping anything in between.
+hub_frame_t *frame_hub_acquire(uint32_t last_seq, TickType_t timeout);
+void frame_hub_release(hub_frame_t *frame);
+
+// Take a reference on the newest frame without waiting, if one was captured
+// within max_age_us. Returns NULL when no stream is running or it is too old.
+hub_frame_t *frame_hub_acquire_latest(int64_t max_age_us);
+
+// Encode a camera frame into a free pooled slot outside the stream. The caller
+// owns the returned reference and must release it. NULL if no slot is free.
+hub_frame_t *frame_hub_encode(camera_fb_t *fb);
+
+// Report how long a client took to put one frame on the wire
+void frame_hub_record_send(uint32_t us);
+
+void frame_hub_get_stats(frame_hub_stats_t *stats);
+
+#endif
@@ -0,0 +1,89 @@
+/*
+  ESP32_CAM_Robot_Car
+  histogram.h
+  Fixed-bucket latency histograms with Prometheus text output
+
+*/
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include "Arduino.h"
+#include "esp_timer.h"
+
+#define HISTOGRAM_BUCKETS 13
+
+// Bucket upper bounds in us and the matching Prometheus "le" labels in seconds
+static const uint32_t HISTOGRAM_BOUNDS_US[HISTOGRAM_BUCKETS] = {
+    50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 1000000};
+static const char *const HISTOGRAM_LABELS[HISTOGRAM_BUCKETS] = {
+    "0.00005", "0.0001", "0.00025", "0.0005", "0.001", "0.0025", "0.005",
+    "0.01", "0.025", "0.05", "0.1", "0.25", "1"};
+
+typedef struct
+{
+  const char *name;    // metric name, reported with a _seconds suffix
+  const char *help;
+  uint32_t counts[HISTOGRAM_BUCKETS + 1];  // last bucket is +Inf
+  uint64_t sum_us;
+  uint32_t count;
+  portMUX_TYPE lock;
+} histogram_t;
+
+#define HISTOGRAM_INIT(name, help) {name, help, {0}, 0, 0, portMUX_INITIALIZER_UNLOCKED}
+
+static inline void histogram_observe(histogram_t *h, uint32_t us)
+{
+  int i = 0;
+  while (i < HISTOGRAM_BUCKETS && us > HISTOGRAM_BOUNDS_US[i])
+    i++;
+  portENTER_CRITICAL(&h->lock);
+  h->counts[i]++;
+  h->sum_us += us;
+  h->count++;
+  portEXIT_CRITICAL(&h->lock);
+}
+
+static inline void histogram_observe_since(histogram_t *h, int64_t start_us)
+{
+  histogram_observe(h, (uint32_t)(esp_timer_get_time() - start_us));
+}
+
+// Write h in Prometheus text exposition format. Returns the number of bytes
+// written, or 0 if buf was too small.
+static inline size_t histogram_format(histogram_t *h, char *buf, size_t len)
+{
+  uint32_t counts[HISTOGRAM_BUCKETS + 1];
+  uint64_t sum_us;
+  uint32_t count;
+  portENTER_CRITICAL(&h->lock);
+  memcpy(counts, h->counts, sizeof(counts));
+  sum_us = h->sum_us;
+  count = h->count;
+  portEXIT_CRITICAL(&h->lock);
+
+  size_t n = 0;
+  int r = snprintf(buf, len, "# HELP %s_seconds %s\n# TYPE %s_seconds histogram\n", h->name, h->help, h->name);
+  if (r < 0 || (size_t)r >= len)
+    return 0;
+  n += r;
+
+  uint32_t cumulative = 0;
+  for (int i = 0; i <= HISTOGRAM_BUCKETS; i++)
+  {
+    cumulative += counts[i];
+    r = snprintf(buf + n, len - n, "%s_seconds_bucket{le=\"%s\"} %u\n", h->name,
+                 i < HISTOGRAM_BUCKETS ? HISTOGRAM_LABELS[i] : "+Inf", cumulative);
+    if (r < 0 || (size_t)r >= len - n)
+      return 0;
+    n += r;
+  }
+
+  r = snprintf(buf + n, len - n, "%s_seconds_sum %u.%06u\n%s_seconds_count %u\n", h->name,
+               (uint32_t)(sum_us / 1000000), (uint32_t)(sum_us % 1000000), h->name, count);
+  if (r < 0 || (size_t)r >= len - n)
+    return 0;
+  return n + r;
+}
+
+#endif
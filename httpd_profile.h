@@ -0,0 +1,75 @@
+/*
+  ESP32_CAM_Robot_Car
+  httpd_profile.h
+  Per-server httpd tuning: core, priority, stack and socket budget
+
+*/
+
+#ifndef HTTPD_PROFILE_H
+#define HTTPD_PROFILE_H
+
+#include "Arduino.h"
+#include "esp_http_server.h"
+
+typedef struct
+{
+  const char *name;
+  uint16_t port;
+  uint16_t ctrl_port;
+  BaseType_t core;
+  UBaseType_t priority;
+  uint32_t stack_size;
+  uint16_t max_open_sockets;
+  uint16_t max_uri_handlers;
+  bool lru_purge;             // close the least recently used session when full
+  uint16_t send_timeout_s;    // give up on a send that makes no progress
+  uint16_t recv_timeout_s;
+  // TCP keepalive so a peer that vanished without closing is noticed;
+  // keepalive_idle_s 0 leaves it off
+  uint16_t keepalive_idle_s;
+  uint16_t keepalive_interval_s;
+  uint16_t keepalive_count;
+} httpd_profile_t;
+
+static inline httpd_config_t httpd_profile_config(const httpd_profile_t *profile)
+{
+  httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+  config.server_port = profile->port;
+  config.ctrl_port = profile->ctrl_port;
+  config.core_id = profile->core;
+  config.task_priority = profile->priority;
+  config.stack_size = profile->stack_size;
+  config.max_open_sockets = profile->max_open_sockets;
+  config.max_uri_handlers = profile->max_uri_handlers;
+  config.lru_purge_enable = profile->lru_purge;
+  config.send_wait_timeout = profile->send_timeout_s;
+  config.recv_wait_timeout = profile->recv_timeout_s;
+  if (profile->keepalive_idle_s)
+  {
+    config.keep_alive_enable = true;
+    config.keep_alive_idle = profile->keepalive_idle_s;
+    config.keep_alive_interval = profile->keepalive_interval_s;
+    config.keep_alive_count = profile->keepalive_count;
+  }
+  return config;
+}
+
+// Core a profile runs on, for log lines
+static inline const char *httpd_profile_core(const httpd_profile_t *profile)
+{
+  if (profile->core == tskNO_AFFINITY)
+    return "any";
+  return profile->core ? "1" : "0";
+}
+
+// Open sessions on a running server, or 0 if it is not running
+static inline size_t httpd_profile_sessions(httpd_handle_t server, uint16_t max_open_sockets)
+{
+  int fds[16];
+  size_t count = max_open_sockets < 16 ? max_open_sockets : 16;
+  if (!server || httpd_get_client_list(server, &count, fds) != ESP_OK)
+    return 0;
+  return count;
+}
+
+#endif
@@ -0,0 +1,21 @@
+/*
+  ESP32_CAM_Robot_Car
+  metrics.h
+  Always-on latency histograms served at /metrics
+
+*/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "histogram.h"
+
+extern histogram_t metric_fb_get;
+extern histogram_t metric_jpeg_encode;
+extern histogram_t metric_send_header;
+extern histogram_t metric_send_data;
+extern histogram_t metric_send_boundary;
+extern histogram_t metric_control;
+extern histogram_t metric_cmd_to_pwm;
+
+#endif
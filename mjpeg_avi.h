@@ -0,0 +1,147 @@
+/*
+  ESP32_CAM_Robot_Car
+  mjpeg_avi.h
+  Minimal MJPEG AVI layout: the headers and index around a run of JPEG
+  frames whose sizes are known up front, so the file can be streamed
+
+*/
+
+#ifndef MJPEG_AVI_H
+#define MJPEG_AVI_H
+
+#include "Arduino.h"
+
+// RIFF header, hdrl list and the movi list header, written before the first frame
+#define AVI_HEADER_LEN 224
+#define AVI_CHUNK_HEADER_LEN 8
+#define AVI_INDEX_ENTRY_LEN 16
+
+static inline uint8_t *avi_u32(uint8_t *p, uint32_t v)
+{
+  p[0] = v;
+  p[1] = v >> 8;
+  p[2] = v >> 16;
+  p[3] = v >> 24;
+  return p + 4;
+}
+
+static inline uint8_t *avi_fourcc(uint8_t *p, const char *cc)
+{
+  memcpy(p, cc, 4);
+  return p + 4;
+}
+
+// Frame chunks are padded to an even length
+static inline uint32_t avi_chunk_len(uint32_t jpeg_len)
+{
+  return AVI_CHUNK_HEADER_LEN + jpeg_len + (jpeg_len & 1);
+}
+
+// Write the AVI_HEADER_LEN bytes that precede the frames. movi_len is the
+// sum of avi_chunk_len over all frames.
+static inline void avi_header(uint8_t *buf, uint32_t frames, uint32_t movi_len,
+                              uint16_t width, uint16_t height, uint32_t us_per_frame, uint32_t max_frame)
+{
+  uint8_t *p = buf;
+  memset(buf, 0, AVI_HEADER_LEN);
+  uint32_t idx_len = frames * AVI_INDEX_ENTRY_LEN;
+  uint32_t rate = us_per_frame ? 1000000 / us_per_frame : 0;
+
+  p = avi_fourcc(p, "RIFF");
+  p = avi_u32(p, 4 + 200 + 12 + movi_len + 8 + idx_len);
+  p = avi_fourcc(p, "AVI ");
+
+  p = avi_fourcc(p, "LIST");
+  p = avi_u32(p, 192);
+  p = avi_fourcc(p, "hdrl");
+  p = avi_fourcc(p, "avih");
+  p = avi_u32(p, 56);
+  p = avi_u32(p, us_per_frame);
+  p = avi_u32(p, max_frame * rate);   // max bytes per second
+  p = avi_u32(p, 0);                  // padding granularity
+  p = avi_u32(p, 0x10);               // AVIF_HASINDEX
+  p = avi_u32(p, frames);
+  p = avi_u32(p, 0);                  // initial frames
+  p = avi_u32(p, 1);                  // streams
+  p = avi_u32(p, max_frame);          // suggested buffer size
+  p = avi_u32(p, width);
+  p = avi_u32(p, height);
+  p += 16;                            // reserved
+
+  p = avi_fourcc(p, "LIST");
+  p = avi_u32(p, 116);
+  p = avi_fourcc(p, "strl");
+  p = avi_fourcc(p, "strh");
+  p = avi_u32(p, 56);
+  p = avi_fourcc(p, "vids");
+  p = avi_fourcc(p, "MJPG");
+  p += 12;                            // flags, priority, language, initial frames
+  p = avi_u32(p, us_per_frame);       // scale
+  p = avi_u32(p, 1000000);            // rate, so fps = rate / scale
+  p = avi_u32(p, 0);                  // start
+  p = avi_u32(p, frames);             // length
+  p = avi_u32(p, max_frame);
+  p = avi_u32(p, 0xFFFFFFFF);         // quality, default
+  p = avi_u32(p, 0);                  // sample size, varies
+  p = avi_u32(p, 0);                  // frame rectangle left, top
+  p = avi_u32(p, width | (uint32_t)height << 16);
+
+  p = avi_fourcc(p, "strf");
+  p = avi_u32(p, 40);
+  p = avi_u32(p, 40);                 // BITMAPINFOHEADER size
+  p = avi_u32(p, width);
+  p = avi_u32(p, height);
+  p = avi_u32(p, 1 | 24 << 16);       // planes, bits per pixel
+  p = avi_fourcc(p, "MJPG");
+  p = avi_u32(p, (uint32_t)width * height * 3);
+  p += 16;                            // resolution and palette
+
+  p = avi_fourcc(p, "LIST");
+  p = avi_u32(p, 4 + movi_len);
+  avi_fourcc(p, "movi");
+}
+
+// Header of one frame chunk; the JPEG and a pad byte for odd lengths follow
+static inline void avi_chunk_header(uint8_t *buf, uint32_t jpeg_len)
+{
+  avi_u32(avi_fourcc(buf, "00dc"), jpeg_len);
+}
+
+// Header of the idx1 chunk that follows the movi list
+static inline void avi_index_header(uint8_t *buf, uint32_t frames)
+{
+  avi_u32(avi_fourcc(buf, "idx1"), frames * AVI_INDEX_ENTRY_LEN);
+}
+
+// offset is the chunk position relative to the "movi" fourcc, so the first
+// frame is at 4
+static inline void avi_index_entry(uint8_t *buf, uint32_t offset, uint32_t jpeg_len)
+{
+  uint8_t *p = avi_fourcc(buf, "00dc");
+  p = avi_u32(p, 0x10);               // AVIIF_KEYFRAME
+  p = avi_u32(p, offset);
+  avi_u32(p, jpeg_len);
+}
+
+// Width and height from the SOF marker of a baseline or progressive JPEG
+static inline bool jpeg_dimensions(const uint8_t *jpeg, size_t len, uint16_t *width, uint16_t *height)
+{
+  size_t i = 2;
+  while (i + 9 < len)
+  {
+    if (jpeg[i] != 0xFF)
+      return false;
+    uint8_t marker = jpeg[i + 1];
+    uint16_t seg = jpeg[i + 2] << 8 | jpeg[i + 3];
+    if (marker == 0xC0 || marker == 0xC1 || marker == 0xC2)
+    {
+      *height = jpeg[i + 5] << 8 | jpeg[i + 6];
+      *width = jpeg[i + 7] << 8 | jpeg[i + 8];
+      return true;
+    }
+    i += 2 + seg;
+  }
+  return false;
+}
+
+#endif
@@ -0,0 +1,50 @@
+/*
+  ESP32_CAM_Robot_Car
+  motion_deadline.h
+  Stop deadline for timed moves, kept by a one-shot esp_timer
+
+*/
+
+#ifndef MOTION_DEADLINE_H
+#define MOTION_DEADLINE_H
+
+#include "Arduino.h"
+#include "esp_timer.h"
+
+// Every move re-arms the timer for its own deadline. The timer callback
+// may already have been dispatched for an older deadline and be waiting
+// for the caller's lock when that happens, so it checks the deadline
+// again rather than trusting that it fired for the current move. All
+// calls must hold the same lock as the callback.
+typedef struct
+{
+  esp_timer_handle_t timer;
+  int64_t deadline_us;     // esp_timer time, 0 while stopped
+} motion_deadline_t;
+
+// Replace any pending deadline with one duration_us from now
+static inline void motion_deadline_arm(motion_deadline_t *d, uint64_t duration_us)
+{
+  esp_timer_stop(d->timer);
+  d->deadline_us = esp_timer_get_time() + duration_us;
+  esp_timer_start_once(d->timer, duration_us);
+}
+
+static inline void motion_deadline_cancel(motion_deadline_t *d)
+{
+  esp_timer_stop(d->timer);
+  d->deadline_us = 0;
+}
+
+// From the timer callback: the deadline if it has passed, clearing it, or
+// 0 for an expiry left over from an earlier move or one cancelled since
+static inline int64_t motion_deadline_expired(motion_deadline_t *d)
+{
+  int64_t deadline = d->deadline_us;
+  if (!deadline || esp_timer_get_time() < deadline)
+    return 0;
+  d->deadline_us = 0;
+  return deadline;
+}
+
+#endif
@@ -0,0 +1,95 @@
+/*
+  ESP32_CAM_Robot_Car
+  motion_macro.h
+  Timed motion macros: compact step sequences run by an on-device timer
+
+*/
+
+#ifndef MOTION_MACRO_H
+#define MOTION_MACRO_H
+
+#include "Arduino.h"
+#include "motor_output.h"
+
+#define MACRO_MAX_STEPS 32
+#define MACRO_MAX_STEP_MS 10000
+// Longest /macro query string accepted, including the terminator
+#define MACRO_MAX_QUERY 400
+
+typedef struct
+{
+  uint8_t motion;        // motion_t
+  uint8_t duty;
+  uint16_t duration_ms;
+} macro_step_t;
+
+typedef struct
+{
+  macro_step_t steps[MACRO_MAX_STEPS];
+  uint8_t count;
+  uint32_t total_ms;
+} macro_t;
+
+typedef enum
+{
+  MACRO_IDLE,
+  MACRO_RUNNING,
+  MACRO_DONE,
+  MACRO_CANCELLED,
+} macro_state_t;
+
+static inline const char *macro_state_name(macro_state_t state)
+{
+  switch (state)
+  {
+  case MACRO_RUNNING:
+    return "running";
+  case MACRO_DONE:
+    return "done";
+  case MACRO_CANCELLED:
+    return "cancelled";
+  default:
+    return "idle";
+  }
+}
+
+// Motion letter used in macro text, indexed by motion_t
+static constexpr char MACRO_LETTERS[MOTION_COUNT + 1] = "sfbrl";
+
+// Parse steps written as <motion><duty>:<ms>, comma separated, for example
+// "f200:1000,r180:350,s0:200". Motions are s(top), f(orward), b(ack),
+// r(ight) and l(eft); duty is 0-255 and ms 1-MACRO_MAX_STEP_MS. Returns
+// NULL on success or a message describing the first invalid step.
+static inline const char *macro_parse(const char *text, macro_t *macro)
+{
+  macro->count = 0;
+  macro->total_ms = 0;
+  const char *p = text;
+  while (*p)
+  {
+    if (macro->count >= MACRO_MAX_STEPS)
+      return "Too many steps";
+    const char *letter = strchr(MACRO_LETTERS, *p);
+    if (!letter)
+      return "Unknown motion";
+
+    char *end;
+    long duty = strtol(p + 1, &end, 10);
+    if (end == p + 1 || *end != ':' || duty < 0 || duty > 255)
+      return "Invalid duty";
+    p = end + 1;
+    long ms = strtol(p, &end, 10);
+    if (end == p || (*end && *end != ',') || ms < 1 || ms > MACRO_MAX_STEP_MS)
+      return "Invalid duration";
+    p = *end ? end + 1 : end;
+
+    macro_step_t *step = &macro->steps[macro->count++];
+    step->motion = letter - MACRO_LETTERS;
+    step->duty = duty;
+    step->duration_ms = ms;
+    macro->total_ms += ms;
+  }
+  return macro->count ? NULL : "No steps";
+}
+
+#endif
@@ -0,0 +1,115 @@
+/*
+  ESP32_CAM_Robot_Car
+  motor_output.cpp
+  L298N motor output layer: channel map, motion primitives and drivers
+
+*/
+
+#include "motor_output.h"
+#include "esp_timer.h"
+
+static void ledc_driver_setup()
+{
+  ledc_timer_config_t timer = {};
+  timer.speed_mode = LEDC_LOW_SPEED_MODE;
+  timer.duty_resolution = MOTOR_PWM_RESOLUTION;
+  timer.timer_num = MOTOR_PWM_TIMER;
+  timer.freq_hz = MOTOR_PWM_FREQ;
+  timer.clk_cfg = LEDC_AUTO_CLK;
+  ledc_timer_config(&timer);
+
+  for (int i = 0; i < MOTOR_OUTPUTS; i++)
+  {
+    ledc_channel_config_t channel = {};
+    channel.gpio_num = MOTOR_CHANNELS[i].pin;
+    channel.speed_mode = LEDC_LOW_SPEED_MODE;
+    channel.channel = MOTOR_CHANNELS[i].channel;
+    channel.intr_type = LEDC_INTR_DISABLE;
+    channel.timer_sel = MOTOR_PWM_TIMER;
+    channel.duty = 0;
+    channel.hpoint = 0;
+    ledc_channel_config(&channel);
+  }
+}
+
+// Last duty written per output, so unchanged channels cost no register writes
+static uint32_t ledc_duty[MOTOR_OUTPUTS];
+
+static void ledc_driver_apply(const uint32_t duty[MOTOR_OUTPUTS])
+{
+  for (int i = 0; i < MOTOR_OUTPUTS; i++)
+  {
+    if (duty[i] != ledc_duty[i])
+      ledc_set_duty(LEDC_LOW_SPEED_MODE, MOTOR_CHANNELS[i].channel, duty[i]);
+  }
+  for (int i = 0; i < MOTOR_OUTPUTS; i++)
+  {
+    if (duty[i] != ledc_duty[i])
+    {
+      ledc_update_duty(LEDC_LOW_SPEED_MODE, MOTOR_CHANNELS[i].channel);
+      ledc_duty[i] = duty[i];
+    }
+  }
+}
+
+const motor_driver_t motor_ledc_driver = {ledc_driver_setup, ledc_driver_apply};
+
+static const motor_driver_t *driver = &motor_ledc_driver;
+static volatile int64_t applied_us = 0;
+static uint32_t applied[MOTOR_OUTPUTS];
+static portMUX_TYPE applied_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void apply(const uint32_t duty[MOTOR_OUTPUTS])
+{
+  driver->apply(duty);
+  applied_us = esp_timer_get_time();
+  portENTER_CRITICAL(&applied_lock);
+  memcpy(applied, duty, sizeof(applied));
+  portEXIT_CRITICAL(&applied_lock);
+}
+
+void motor_output_set_driver(const motor_driver_t *d)
+{
+  driver = d;
+}
+
+void motor_output_setup()
+{
+  driver->setup();
+}
+
+void motor_output_apply(const uint32_t duty[MOTOR_OUTPUTS])
+{
+  apply(duty);
+}
+
+void motor_output_motion(motion_t motion, uint32_t duty)
+{
+  uint32_t vector[MOTOR_OUTPUTS];
+  for (int i = 0; i < MOTOR_OUTPUTS; i++)
+    vector[i] = MOTIONS[motion].active[i] ? duty : 0;
+  apply(vector);
+}
+
+void motor_output_sides(int left, int right)
+{
+  uint32_t vector[MOTOR_OUTPUTS];
+  vector[MOTOR_RIGHT_M0] = right < 0 ? -right : 0;
+  vector[MOTOR_RIGHT_M1] = right > 0 ? right : 0;
+  vector[MOTOR_LEFT_M0] = left < 0 ? -left : 0;
+  vector[MOTOR_LEFT_M1] = left > 0 ? left : 0;
+  apply(vector);
+}
+
+int64_t motor_output_applied_us()
+{
+  return applied_us;
+}
+
+void motor_output_get_sides(int *left, int *right)
+{
+  portENTER_CRITICAL(&applied_lock);
+  *left = (int)applied[MOTOR_LEFT_M1] - (int)applied[MOTOR_LEFT_M0];
+  *right = (int)applied[MOTOR_RIGHT_M1] - (int)applied[MOTOR_RIGHT_M0];
+  portEXIT_CRITICAL(&applied_lock);
+}
@@ -0,0 +1,96 @@
+/*
+  ESP32_CAM_Robot_Car
+  motor_output.h
+  L298N motor output layer: channel map, motion primitives and drivers
+
+*/
+
+#ifndef MOTOR_OUTPUT_H
+#define MOTOR_OUTPUT_H
+
+#include "Arduino.h"
+#include "driver/ledc.h"
+
+#define LEFT_M0 13
+#define LEFT_M1 12
+#define RIGHT_M0 14
+#define RIGHT_M1 15
+
+// Motor PWM properties. Channel 0 / timer 0 belong to the camera XCLK and
+// channel 7 / timer 1 to the flash LED, so the motors get their own timer.
+#define MOTOR_PWM_TIMER LEDC_TIMER_2
+#define MOTOR_PWM_FREQ 2000
+#define MOTOR_PWM_RESOLUTION LEDC_TIMER_8_BIT
+
+// Positions in a duty vector. M0 drives a side backward, M1 forward.
+typedef enum
+{
+  MOTOR_RIGHT_M0,
+  MOTOR_RIGHT_M1,
+  MOTOR_LEFT_M0,
+  MOTOR_LEFT_M1,
+  MOTOR_OUTPUTS
+} motor_output_t;
+
+typedef struct
+{
+  ledc_channel_t channel;
+  int pin;
+} motor_channel_t;
+
+// The one channel map used by setup and by every motion
+static constexpr motor_channel_t MOTOR_CHANNELS[MOTOR_OUTPUTS] = {
+    {LEDC_CHANNEL_2, RIGHT_M0},
+    {LEDC_CHANNEL_3, RIGHT_M1},
+    {LEDC_CHANNEL_4, LEFT_M0},
+    {LEDC_CHANNEL_5, LEFT_M1},
+};
+
+typedef enum
+{
+  MOTION_STOP,
+  MOTION_FWD,
+  MOTION_BACK,
+  MOTION_RIGHT,
+  MOTION_LEFT,
+  MOTION_COUNT
+} motion_t;
+
+typedef struct
+{
+  const char *name;
+  uint8_t active[MOTOR_OUTPUTS];  // outputs driven at the current speed
+  uint16_t interval_ms;           // nominal move time before the auto-stop
+} motion_primitive_t;
+
+static constexpr motion_primitive_t MOTIONS[MOTION_COUNT] = {
+    {"robot_stop",  {0, 0, 0, 0}, 0},
+    {"robot_fwd",   {0, 1, 0, 1}, 250},
+    {"robot_back",  {1, 0, 1, 0}, 250},
+    {"robot_right", {0, 1, 1, 0}, 100},
+    {"robot_left",  {1, 0, 0, 1}, 100},
+};
+
+// A driver applies a complete duty vector in one call
+typedef struct
+{
+  void (*setup)();
+  void (*apply)(const uint32_t duty[MOTOR_OUTPUTS]);
+} motor_driver_t;
+
+extern const motor_driver_t motor_ledc_driver;
+
+// Select the driver used by motor_output_*; defaults to motor_ledc_driver
+void motor_output_set_driver(const motor_driver_t *driver);
+void motor_output_setup();
+void motor_output_apply(const uint32_t duty[MOTOR_OUTPUTS]);
+// Apply a motion primitive at the given duty
+void motor_output_motion(motion_t motion, uint32_t duty);
+// Apply signed duty per side: positive forward, negative backward
+void motor_output_sides(int left, int right);
+// esp_timer time at which the last duty vector finished applying
+int64_t motor_output_applied_us();
+// Signed per-side duty last applied: positive forward, negative backward
+void motor_output_get_sides(int *left, int *right);
+
+#endif
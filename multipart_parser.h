@@ -0,0 +1,210 @@
+/*
+  ESP32_CAM_Robot_Car
+  multipart_parser.h
+  Streaming multipart/form-data parser that passes the file part through
+  without copying it
+
+*/
+
+#ifndef MULTIPART_PARSER_H
+#define MULTIPART_PARSER_H
+
+#include "Arduino.h"
+
+// RFC 2046 limits boundaries to 70 characters
+#define MULTIPART_MAX_BOUNDARY 70
+// Part headers are buffered until the blank line that ends them
+#define MULTIPART_MAX_HEADERS 512
+
+// Called with consecutive slices of the file part. The pointers are into the
+// buffer passed to multipart_feed, or into the delimiter itself for bytes
+// that looked like the start of a boundary but were not. Return false to abort.
+typedef bool (*multipart_data_fn)(void *ctx, const uint8_t *data, size_t len);
+
+typedef enum
+{
+  MULTIPART_OK,     // need more input
+  MULTIPART_DONE,   // closing boundary seen
+  MULTIPART_ERROR,  // malformed input or the data callback failed
+} multipart_status_t;
+
+typedef enum
+{
+  MP_SKIP,          // preamble or a part that is not a file
+  MP_FILE,          // inside the file part, data goes to on_data
+  MP_AFTER_DELIM,   // after a delimiter: "--" ends the body, CRLF starts a part
+  MP_HEADERS,
+  MP_DONE,
+} multipart_state_t;
+
+typedef struct
+{
+  char delim[4 + MULTIPART_MAX_BOUNDARY + 1];  // "\r\n--" + boundary
+  size_t delim_len;
+  multipart_state_t state;
+  size_t match;       // delimiter bytes matched at the end of the last chunk
+  char headers[MULTIPART_MAX_HEADERS];
+  size_t headers_len;
+  char after[2];
+  size_t after_len;
+  bool file_seen;
+  multipart_data_fn on_data;
+  void *ctx;
+} multipart_parser_t;
+
+// Set up p from a Content-Type header value. Returns false if it is not
+// multipart or has no usable boundary.
+static inline bool multipart_init(multipart_parser_t *p, const char *content_type, multipart_data_fn on_data, void *ctx)
+{
+  const char *b = strstr(content_type, "boundary=");
+  if (strncmp(content_type, "multipart/", 10) || !b)
+    return false;
+  b += 9;
+  size_t len = strcspn(b, "; \t");
+  if (*b == '"')
+  {
+    b++;
+    len = strcspn(b, "\"");
+  }
+  if (!len || len > MULTIPART_MAX_BOUNDARY)
+    return false;
+
+  memcpy(p->delim, "\r\n--", 4);
+  memcpy(p->delim + 4, b, len);
+  p->delim[4 + len] = 0;
+  p->delim_len = 4 + len;
+  // The body opens with "--boundary" without the leading CRLF, so start as
+  // if the CRLF had already been matched
+  p->state = MP_SKIP;
+  p->match = 2;
+  p->headers_len = 0;
+  p->after_len = 0;
+  p->file_seen = false;
+  p->on_data = on_data;
+  p->ctx = ctx;
+  return true;
+}
+
+// Scan body bytes for the delimiter, forwarding data before it when in the
+// file part. Returns bytes consumed up to and including the delimiter, or
+// len if it was not found. Sets *found when the delimiter completed.
+static inline size_t multipart_scan(multipart_parser_t *p, const uint8_t *data, size_t len, bool *found, bool *ok)
+{
+  const uint8_t *delim = (const uint8_t *)p->delim;
+  bool emit = p->state == MP_FILE;
+  *found = false;
+  *ok = true;
+
+  // Finish a match carried over from the previous chunk
+  if (p->match)
+  {
+    size_t need = p->delim_len - p->match;
+    size_t n = need < len ? need : len;
+    if (!memcmp(data, delim + p->match, n))
+    {
+      if (n == need)
+      {
+        p->match = 0;
+        *found = true;
+        return n;
+      }
+      p->match += n;
+      return len;
+    }
+    // Not a delimiter after all. The carried bytes equal the delimiter
+    // prefix, and boundaries cannot contain CR, so no delimiter can start
+    // inside them: hand them over and rescan this chunk from the start.
+    if (emit && !p->on_data(p->ctx, delim, p->match))
+      *ok = false;
+    p->match = 0;
+  }
+
+  // Every delimiter starts with CR, so memchr skips through binary data and
+  // memcmp only runs at candidate positions
+  size_t start = 0;
+  size_t i = 0;
+  while (i < len)
+  {
+    const uint8_t *cr = (const uint8_t *)memchr(data + i, '\r', len - i);
+    if (!cr)
+      break;
+    size_t j = cr - data;
+    size_t avail = len - j;
+    size_t n = avail < p->delim_len ? avail : p->delim_len;
+    if (!memcmp(data + j, delim, n))
+    {
+      if (emit && j > start && !p->on_data(p->ctx, data + start, j - start))
+        *ok = false;
+      if (n == p->delim_len)
+      {
+        *found = true;
+        return j + n;
+      }
+      // Delimiter prefix at the end of the chunk
+      p->match = n;
+      return len;
+    }
+    i = j + 1;
+  }
+  if (emit && len > start && !p->on_data(p->ctx, data + start, len - start))
+    *ok = false;
+  return len;
+}
+
+// Feed the next slice of the request body
+static inline multipart_status_t multipart_feed(multipart_parser_t *p, const uint8_t *data, size_t len)
+{
+  size_t i = 0;
+  while (i < len)
+  {
+    switch (p->state)
+    {
+    case MP_SKIP:
+    case MP_FILE:
+    {
+      bool found, ok;
+      i += multipart_scan(p, data + i, len - i, &found, &ok);
+      if (!ok)
+        return MULTIPART_ERROR;
+      if (found)
+      {
+        p->state = MP_AFTER_DELIM;
+        p->after_len = 0;
+      }
+      break;
+    }
+    case MP_AFTER_DELIM:
+      p->after[p->after_len++] = data[i++];
+      if (p->after_len < 2)
+        break;
+      if (!memcmp(p->after, "--", 2))
+        p->state = MP_DONE;
+      else if (!memcmp(p->after, "\r\n", 2))
+      {
+        p->state = MP_HEADERS;
+        p->headers_len = 0;
+      }
+      else
+        return MULTIPART_ERROR;
+      break;
+    case MP_HEADERS:
+      if (p->headers_len >= sizeof(p->headers) - 1)
+        return MULTIPART_ERROR;
+      p->headers[p->headers_len++] = data[i++];
+      if (p->headers_len >= 4 && !memcmp(p->headers + p->headers_len - 4, "\r\n\r\n", 4))
+      {
+        p->headers[p->headers_len] = 0;
+        // Only the first part with a filename is the upload
+        bool file = !p->file_seen && strstr(p->headers, "filename=");
+        p->file_seen |= file;
+        p->state = file ? MP_FILE : MP_SKIP;
+      }
+      break;
+    case MP_DONE:
+      return MULTIPART_DONE;
+    }
+  }
+  return p->state == MP_DONE ? MULTIPART_DONE : MULTIPART_OK;
+}
+
+#endif
@@ -0,0 +1,178 @@
+/*
+  ESP32_CAM_Robot_Car
+  ota_delta.cpp
+  Delta firmware updates: patches against the running image are inflated
+  and applied in a stream into the inactive OTA partition
+
+*/
+
+#include "ota_delta.h"
+#include "delta_patch.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "rom/miniz.h"
+#include "mbedtls/sha256.h"
+
+// RAM use is fixed: the inflate state and its 32 KB window, the decoder
+// with one source chunk, and the two flash buffers in ota_update
+typedef struct
+{
+  delta_header_t header;
+  size_t header_len;
+  tinfl_decompressor inflator;
+  uint8_t window[TINFL_LZ_DICT_SIZE];
+  size_t window_pos;
+  bool inflated;        // zlib stream finished
+  bool updating;        // ota_begin has been called
+  delta_patch_t patch;
+} delta_state_t;
+
+static delta_state_t *state = NULL;
+static const char *error = "";
+
+static bool delta_read_source(void *ctx, uint32_t offset, uint8_t *buf, size_t len)
+{
+  return esp_partition_read((const esp_partition_t *)ctx, offset, buf, len) == ESP_OK;
+}
+
+static bool delta_write_target(void *ctx, const uint8_t *data, size_t len)
+{
+  return ota_write(data, len);
+}
+
+static bool delta_fail(const char *message)
+{
+  error = message;
+  return false;
+}
+
+// The header carries the SHA-256 of the first source_len bytes of the image
+// as it was flashed. esp_partition_get_sha256 returns the digest appended
+// to the app instead, so hash that range of the partition here. The inflate
+// window is not in use yet and serves as the read buffer.
+static bool delta_source_matches(const esp_partition_t *running)
+{
+  mbedtls_sha256_context ctx;
+  uint8_t sha[32];
+  bool ok = true;
+  mbedtls_sha256_init(&ctx);
+  mbedtls_sha256_starts(&ctx, 0);
+  for (uint32_t pos = 0; ok && pos < state->header.source_len; pos += sizeof(state->window))
+  {
+    size_t n = state->header.source_len - pos;
+    n = n < sizeof(state->window) ? n : sizeof(state->window);
+    ok = esp_partition_read(running, pos, state->window, n) == ESP_OK;
+    if (ok)
+      mbedtls_sha256_update(&ctx, state->window, n);
+  }
+  mbedtls_sha256_finish(&ctx, sha);
+  mbedtls_sha256_free(&ctx);
+  return ok && !memcmp(sha, state->header.source_sha256, sizeof(sha));
+}
+
+// The header names the image the patch was made against; refuse it unless
+// that is exactly what is running
+static bool delta_start()
+{
+  const esp_partition_t *running = esp_ota_get_running_partition();
+  const char *message = delta_init(&state->patch, &state->header, delta_read_source, delta_write_target, (void *)running);
+  if (message)
+    return delta_fail(message);
+  if (state->header.source_len > running->size)
+    return delta_fail("Patch source larger than partition");
+  if (!delta_source_matches(running))
+    return delta_fail("Patch is not for the running firmware");
+  if (!ota_begin(state->header.target_len))
+    return delta_fail(ota_error());
+  state->updating = true;
+  tinfl_init(&state->inflator);
+  return true;
+}
+
+bool ota_delta_begin()
+{
+  error = "";
+  free(state);
+  state = (delta_state_t *)malloc(sizeof(delta_state_t));
+  if (!state)
+    return delta_fail("Out of memory");
+  state->header_len = 0;
+  state->window_pos = 0;
+  state->inflated = false;
+  state->updating = false;
+  return true;
+}
+
+bool ota_delta_write(const uint8_t *data, size_t len)
+{
+  if (state->header_len < sizeof(delta_header_t))
+  {
+    size_t n = sizeof(delta_header_t) - state->header_len;
+    n = n < len ? n : len;
+    memcpy((uint8_t *)&state->header + state->header_len, data, n);
+    state->header_len += n;
+    data += n;
+    len -= n;
+    if (state->header_len < sizeof(delta_header_t))
+      return true;
+    if (!delta_start())
+      return false;
+  }
+
+  // Inflate into the circular window and decode each run of output as it
+  // appears; the window doubles as the back-reference history
+  while (len || !state->inflated)
+  {
+    if (state->inflated)
+      return delta_fail("Data after end of patch");
+    size_t in = len;
+    size_t out = TINFL_LZ_DICT_SIZE - state->window_pos;
+    tinfl_status status = tinfl_decompress(&state->inflator, data, &in, state->window,
+                                           state->window + state->window_pos, &out,
+                                           TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_HAS_MORE_INPUT);
+    data += in;
+    len -= in;
+    if (status < TINFL_STATUS_DONE)
+      return delta_fail("Corrupt patch data");
+    const char *message = delta_feed(&state->patch, state->window + state->window_pos, out);
+    if (message)
+      return delta_fail(message);
+    state->window_pos = (state->window_pos + out) & (TINFL_LZ_DICT_SIZE - 1);
+    if (status == TINFL_STATUS_DONE)
+      state->inflated = true;
+    else if (status == TINFL_STATUS_NEEDS_MORE_INPUT && !len)
+      break;
+  }
+  return true;
+}
+
+bool ota_delta_finish(uint8_t sha256[OTA_SHA256_LEN])
+{
+  bool ok = state->inflated && state->patch.done;
+  if (!ok)
+  {
+    error = "Incomplete patch";
+    ota_delta_abort();
+    return false;
+  }
+  state->updating = false;
+  ok = ota_finish(state->header.target_sha256, sha256);
+  if (!ok)
+    error = ota_error();
+  free(state);
+  state = NULL;
+  return ok;
+}
+
+void ota_delta_abort()
+{
+  if (state && state->updating)
+    ota_abort();
+  free(state);
+  state = NULL;
+}
+
+const char *ota_delta_error()
+{
+  return error;
+}
@@ -0,0 +1,31 @@
+/*
+  ESP32_CAM_Robot_Car
+  ota_delta.h
+  Delta firmware updates: patches against the running image are inflated
+  and applied in a stream into the inactive OTA partition
+
+*/
+
+#ifndef OTA_DELTA_H
+#define OTA_DELTA_H
+
+#include "Arduino.h"
+#include "ota_update.h"
+
+// Prepare for a patch upload. The update itself starts once the patch
+// header has arrived and matched the running image.
+bool ota_delta_begin();
+
+// Feed the next slice of the patch file
+bool ota_delta_write(const uint8_t *data, size_t len);
+
+// Check the patch was complete, then verify the target image SHA-256 and
+// switch the boot partition. sha256 receives the digest of the new image.
+bool ota_delta_finish(uint8_t sha256[OTA_SHA256_LEN]);
+
+void ota_delta_abort();
+
+// Why the last delta update failed
+const char *ota_delta_error();
+
+#endif
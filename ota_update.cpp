@@ -0,0 +1,190 @@
+/*
+  ESP32_CAM_Robot_Car
+  ota_update.cpp
+  Pipelined firmware writes: sector-sized double buffering with a flash
+  writer task and incremental SHA-256
+
+*/
+
+#include "ota_update.h"
+#include <Update.h>
+#include "mbedtls/sha256.h"
+
+typedef struct
+{
+  uint8_t index;
+  uint16_t len;   // 0 tells the writer to stop
+} ota_block_t;
+
+static uint8_t *buffers[2];
+static QueueHandle_t free_queue = NULL;    // buffer indices ready to fill
+static QueueHandle_t full_queue = NULL;    // ota_block_t waiting for flash
+static SemaphoreHandle_t writer_done = NULL;
+static mbedtls_sha256_context sha;
+static volatile bool writer_failed = false;
+static const char *error = "";
+
+static int fill_index = -1;   // buffer being filled by ota_write, -1 for none
+static size_t fill_len = 0;
+static size_t received = 0;
+
+// Hashes and writes full buffers. Runs at the caller's priority, so while
+// it waits on flash the receive side gets the CPU.
+static void ota_writer_task(void *arg)
+{
+  ota_block_t block;
+  while (xQueueReceive(full_queue, &block, portMAX_DELAY) == pdTRUE && block.len)
+  {
+    if (!writer_failed)
+    {
+      mbedtls_sha256_update(&sha, buffers[block.index], block.len);
+      if (Update.write(buffers[block.index], block.len) != block.len)
+      {
+        error = Update.errorString();
+        writer_failed = true;
+      }
+    }
+    xQueueSend(free_queue, &block.index, portMAX_DELAY);
+  }
+  xSemaphoreGive(writer_done);
+  vTaskDelete(NULL);
+}
+
+static void ota_release()
+{
+  for (int i = 0; i < 2; i++)
+  {
+    heap_caps_free(buffers[i]);
+    buffers[i] = NULL;
+  }
+  if (free_queue)
+    vQueueDelete(free_queue);
+  if (full_queue)
+    vQueueDelete(full_queue);
+  if (writer_done)
+    vSemaphoreDelete(writer_done);
+  free_queue = NULL;
+  full_queue = NULL;
+  writer_done = NULL;
+  mbedtls_sha256_free(&sha);
+}
+
+// Hand the current buffer to the writer, or the stop marker when len is 0
+static void ota_submit(uint16_t len)
+{
+  ota_block_t block = {(uint8_t)(fill_index < 0 ? 0 : fill_index), len};
+  xQueueSend(full_queue, &block, portMAX_DELAY);
+  fill_index = -1;
+  fill_len = 0;
+}
+
+// Stop the writer task after it has drained every queued buffer
+static void ota_stop_writer()
+{
+  if (fill_index >= 0 && fill_len)
+    ota_submit(fill_len);
+  ota_submit(0);
+  xSemaphoreTake(writer_done, portMAX_DELAY);
+}
+
+bool ota_begin(size_t image_len)
+{
+  error = "";
+  writer_failed = false;
+  fill_index = -1;
+  fill_len = 0;
+  received = 0;
+
+  buffers[0] = (uint8_t *)heap_caps_malloc(OTA_BUF_LEN, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  buffers[1] = (uint8_t *)heap_caps_malloc(OTA_BUF_LEN, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  free_queue = xQueueCreate(2, sizeof(uint8_t));
+  full_queue = xQueueCreate(2, sizeof(ota_block_t));
+  writer_done = xSemaphoreCreateBinary();
+  mbedtls_sha256_init(&sha);
+  if (!buffers[0] || !buffers[1] || !free_queue || !full_queue || !writer_done)
+  {
+    error = "Out of memory";
+    ota_release();
+    return false;
+  }
+  for (uint8_t i = 0; i < 2; i++)
+    xQueueSend(free_queue, &i, 0);
+  mbedtls_sha256_starts(&sha, 0);
+
+  if (!Update.begin(image_len))
+  {
+    error = Update.errorString();
+    ota_release();
+    return false;
+  }
+  if (xTaskCreate(ota_writer_task, "ota_writer", 4096, NULL, uxTaskPriorityGet(NULL), NULL) != pdPASS)
+  {
+    error = "Failed to start writer";
+    Update.abort();
+    ota_release();
+    return false;
+  }
+  return true;
+}
+
+bool ota_write(const uint8_t *data, size_t len)
+{
+  received += len;
+  while (len)
+  {
+    if (writer_failed)
+      return false;
+    if (fill_index < 0)
+    {
+      uint8_t index;
+      xQueueReceive(free_queue, &index, portMAX_DELAY);
+      fill_index = index;
+    }
+    size_t n = OTA_BUF_LEN - fill_len < len ? OTA_BUF_LEN - fill_len : len;
+    memcpy(buffers[fill_index] + fill_len, data, n);
+    fill_len += n;
+    data += n;
+    len -= n;
+    if (fill_len == OTA_BUF_LEN)
+      ota_submit(OTA_BUF_LEN);
+  }
+  return true;
+}
+
+bool ota_finish(const uint8_t *expected, uint8_t sha256[OTA_SHA256_LEN])
+{
+  ota_stop_writer();
+  mbedtls_sha256_finish(&sha, sha256);
+  bool ok = !writer_failed;
+  if (ok && expected && memcmp(expected, sha256, OTA_SHA256_LEN))
+  {
+    error = "SHA-256 mismatch";
+    ok = false;
+  }
+  if (ok && !Update.end(true))
+  {
+    error = Update.errorString();
+    ok = false;
+  }
+  if (!ok)
+    Update.abort();
+  ota_release();
+  return ok;
+}
+
+void ota_abort()
+{
+  ota_stop_writer();
+  Update.abort();
+  ota_release();
+}
+
+const char *ota_error()
+{
+  return error;
+}
+
+size_t ota_received()
+{
+  return received;
+}
@@ -0,0 +1,41 @@
+/*
+  ESP32_CAM_Robot_Car
+  ota_update.h
+  Pipelined firmware writes: sector-sized double buffering with a flash
+  writer task and incremental SHA-256
+
+*/
+
+#ifndef OTA_UPDATE_H
+#define OTA_UPDATE_H
+
+#include "Arduino.h"
+
+// One flash sector per buffer, so every Update.write is sector aligned
+#define OTA_BUF_LEN 4096
+#define OTA_SHA256_LEN 32
+
+// Start an update of image_len bytes (UPDATE_SIZE_UNKNOWN if not known) and
+// the writer task. Returns false if the update could not begin.
+bool ota_begin(size_t image_len);
+
+// Queue image bytes. Full buffers go to the writer task while the caller
+// fills the other one, so network receive overlaps flash erase and write.
+// Returns false once the writer has failed.
+bool ota_write(const uint8_t *data, size_t len);
+
+// Flush, wait for the writer, check the image SHA-256 against expected
+// (skipped when NULL) and finish the update. sha256 receives the digest of
+// everything written.
+bool ota_finish(const uint8_t *expected, uint8_t sha256[OTA_SHA256_LEN]);
+
+// Stop the writer and abort the update
+void ota_abort();
+
+// Why the last update failed
+const char *ota_error();
+
+// Total bytes handed to ota_write so far
+size_t ota_received();
+
+#endif
@@ -0,0 +1,108 @@
+/*
+  ESP32_CAM_Robot_Car
+  telemetry.h
+  Telemetry snapshots and incremental Server-Sent Events encoding
+
+*/
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "Arduino.h"
+
+typedef enum
+{
+  TELEMETRY_MOTION,
+  TELEMETRY_DUTY_LEFT,
+  TELEMETRY_DUTY_RIGHT,
+  TELEMETRY_SPEED,
+  TELEMETRY_FPS,          // frames per second x10
+  TELEMETRY_FRAMESIZE,
+  TELEMETRY_HEAP_KB,
+  TELEMETRY_PSRAM_KB,
+  TELEMETRY_RSSI,         // strongest associated station, 0 with none
+  TELEMETRY_STATIONS,
+  TELEMETRY_STREAM_CLIENTS,
+  TELEMETRY_UDP_RECEIVERS,
+  TELEMETRY_FIELDS
+} telemetry_field_t;
+
+typedef enum
+{
+  TELEMETRY_STOPPED,
+  TELEMETRY_MOVING,   // timed move from car or /control
+  TELEMETRY_DRIVING,  // continuous drive command
+  TELEMETRY_MACRO,
+} telemetry_motion_t;
+
+static const char *const TELEMETRY_MOTION_NAMES[] = {"stopped", "moving", "driving", "macro"};
+
+typedef struct
+{
+  int32_t v[TELEMETRY_FIELDS];
+} telemetry_t;
+
+typedef struct
+{
+  const char *name;
+  uint8_t decimals;            // 1 prints v / 10 with one decimal place
+  const char *const *labels;   // print labels[v] as a string instead of a number
+} telemetry_desc_t;
+
+static const telemetry_desc_t TELEMETRY_DESC[TELEMETRY_FIELDS] = {
+    {"motion", 0, TELEMETRY_MOTION_NAMES},
+    {"duty_left", 0, NULL},
+    {"duty_right", 0, NULL},
+    {"speed", 0, NULL},
+    {"fps", 1, NULL},
+    {"framesize", 0, NULL},
+    {"heap_kb", 0, NULL},
+    {"psram_kb", 0, NULL},
+    {"rssi", 0, NULL},
+    {"stations", 0, NULL},
+    {"stream_clients", 0, NULL},
+    {"udp_receivers", 0, NULL},
+};
+
+// Write one "event: telemetry" SSE event into buf holding only the fields of
+// now that differ from last, or every field when full is set, and copy now
+// into last. Returns the event length, or 0 if nothing changed or buf was
+// too small; last is left untouched in both cases.
+static inline size_t telemetry_encode_event(const telemetry_t *now, telemetry_t *last, bool full,
+                                            char *buf, size_t len)
+{
+  int r = snprintf(buf, len, "event: telemetry\ndata: {");
+  if (r < 0 || (size_t)r >= len)
+    return 0;
+  size_t n = r;
+  size_t fields = 0;
+
+  for (int i = 0; i < TELEMETRY_FIELDS; i++)
+  {
+    int32_t v = now->v[i];
+    if (!full && v == last->v[i])
+      continue;
+    const telemetry_desc_t *d = &TELEMETRY_DESC[i];
+    const char *sep = fields++ ? "," : "";
+    if (d->labels)
+      r = snprintf(buf + n, len - n, "%s\"%s\":\"%s\"", sep, d->name, d->labels[v]);
+    else if (d->decimals)
+      r = snprintf(buf + n, len - n, "%s\"%s\":%s%d.%d", sep, d->name, v < 0 ? "-" : "", (int)abs(v / 10),
+                   (int)abs(v % 10));
+    else
+      r = snprintf(buf + n, len - n, "%s\"%s\":%d", sep, d->name, (int)v);
+    if (r < 0 || (size_t)r >= len - n)
+      return 0;
+    n += r;
+  }
+  if (!fields)
+    return 0;
+
+  r = snprintf(buf + n, len - n, "}\n\n");
+  if (r < 0 || (size_t)r >= len - n)
+    return 0;
+  *last = *now;
+  return n + r;
+}
+
+#endif
@@ -0,0 +1,182 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/app_sim.h
+  The sketch's servers started as setup() starts them, on a frozen clock,
+  and a client that sends them requests over socketpairs and parses the
+  responses. Shared by the tests and benchmarks that link app_httpd.cpp.
+
+*/
+
+#ifndef APP_SIM_H
+#define APP_SIM_H
+
+#include "deferred_log.h"
+#include "esp_camera.h"
+#include "esp_http_server.h"
+#include <string>
+
+extern httpd_handle_t camera_httpd;
+extern httpd_handle_t stream_httpd;
+void robot_setup();
+void startCameraServer();
+
+// Room for a whole response, so handlers never wait on the test to read
+#define APP_SOCKET_BUFFER (1 << 20)
+
+// Camera and servers as setup() in ESP32_CAM_Robot_Car.ino brings them up
+// on a board with PSRAM, on a frozen clock unless frozen is false
+static inline void app_start(bool frozen = true)
+{
+  if (frozen)
+    host_clock_freeze();
+  dlog_start();
+  camera_config_t config = {};
+  config.pixel_format = PIXFORMAT_JPEG;
+  config.frame_size = FRAMESIZE_SVGA;
+  config.jpeg_quality = 10;
+  config.fb_count = 2;
+  esp_camera_init(&config);
+  sensor_t *s = esp_camera_sensor_get();
+  s->set_framesize(s, FRAMESIZE_QVGA);
+  robot_setup();
+  startCameraServer();
+  if (frozen)
+    host_clock_advance(0);
+}
+
+typedef struct
+{
+  int client;   // the test's end
+  int server;   // the end handed to the server
+} app_conn_t;
+
+static inline app_conn_t app_connect()
+{
+  int fds[2];
+  socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+  int size = APP_SOCKET_BUFFER;
+  setsockopt(fds[1], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+  setsockopt(fds[0], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+  return {fds[0], fds[1]};
+}
+
+// The client hangs up, if it has not already, and the server closes its end
+static inline void app_disconnect(httpd_handle_t server, app_conn_t *conn)
+{
+  if (conn->client >= 0)
+    close(conn->client);
+  host_httpd_close(server, conn->server);
+  close(conn->server);
+  conn->client = conn->server = -1;
+}
+
+// Whatever the server has written so far
+static inline std::string app_read(int fd)
+{
+  std::string out;
+  char buf[4096];
+  ssize_t n;
+  while ((n = ::recv(fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+    out.append(buf, n);
+  return out;
+}
+
+typedef struct
+{
+  int status;            // 0 until a status line arrives
+  std::string headers;   // header lines, each ending in \r\n
+  std::string body;      // chunked bodies are decoded, up to the last whole chunk
+  bool complete;         // the body is all there
+  size_t wire_bytes;     // bytes on the socket
+} app_response_t;
+
+static inline void app_parse(const std::string &raw, app_response_t *resp)
+{
+  *resp = {};
+  resp->wire_bytes = raw.size();
+  size_t end = raw.find("\r\n\r\n");
+  if (raw.compare(0, 9, "HTTP/1.1 ") || end == std::string::npos)
+    return;
+  resp->status = atoi(raw.c_str() + 9);
+  size_t line = raw.find("\r\n") + 2;
+  resp->headers = raw.substr(line, end + 2 - line);
+  size_t pos = end + 4;
+
+  if (resp->headers.find("Transfer-Encoding: chunked\r\n") == std::string::npos)
+  {
+    size_t len = 0;
+    size_t field = resp->headers.find("Content-Length: ");
+    if (field != std::string::npos)
+      len = strtoul(resp->headers.c_str() + field + 16, NULL, 10);
+    resp->body = raw.substr(pos, len);
+    resp->complete = raw.size() - pos >= len;
+    return;
+  }
+  for (;;)
+  {
+    size_t eol = raw.find("\r\n", pos);
+    if (eol == std::string::npos)
+      return;
+    size_t len = strtoul(raw.c_str() + pos, NULL, 16);
+    if (raw.size() < eol + 2 + len + 2)
+      return;
+    if (!len)
+    {
+      resp->complete = true;
+      return;
+    }
+    resp->body.append(raw, eol + 2, len);
+    pos = eol + 2 + len + 2;
+  }
+}
+
+// Value of a response header, empty when it is absent
+static inline std::string app_header(const app_response_t &resp, const char *name)
+{
+  std::string field = std::string(name) + ": ";
+  size_t pos = 0;
+  while (pos < resp.headers.size())
+  {
+    size_t eol = resp.headers.find("\r\n", pos);
+    if (!resp.headers.compare(pos, field.size(), field))
+      return resp.headers.substr(pos + field.size(), eol - pos - field.size());
+    pos = eol + 2;
+  }
+  return std::string();
+}
+
+// One request on a connection of its own, read back once the handler returns
+static inline app_response_t app_request(httpd_handle_t server, httpd_method_t method, const char *uri,
+                                  const char *headers = NULL, const std::string &body = std::string(),
+                                  esp_err_t *result = NULL)
+{
+  app_conn_t conn = app_connect();
+  host_httpd_request_t request = {};
+  request.method = method;
+  request.uri = uri;
+  request.headers = headers;
+  request.body = body.data();
+  request.body_len = body.size();
+  esp_err_t res = host_httpd_request(server, conn.server, &request);
+  if (result)
+    *result = res;
+  app_response_t resp;
+  app_parse(app_read(conn.client), &resp);
+  app_disconnect(server, &conn);
+  return resp;
+}
+
+static inline app_response_t app_get(httpd_handle_t server, const char *uri, esp_err_t *result = NULL)
+{
+  return app_request(server, HTTP_GET, uri, NULL, std::string(), result);
+}
+
+// Value of a numeric field in a flat JSON object, -1 when it is missing
+static inline long app_json_int(const std::string &json, const char *key)
+{
+  std::string field = std::string("\"") + key + "\":";
+  size_t pos = json.find(field);
+  return pos == std::string::npos ? -1 : strtol(json.c_str() + pos + field.size(), NULL, 10);
+}
+
+#endif
@@ -0,0 +1,272 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/app_standin.cpp
+  The sketch's two HTTP servers from app_httpd.cpp on loopback TCP, with
+  the fake camera, for running tools/stream_load.py without a car. Each
+  connection gets a thread that reads requests off the socket and hands
+  them to the host server, which runs the firmware's handlers in real
+  time and writes their responses straight back. After a WebSocket
+  handshake the connection carries client frames instead, each handed to
+  the server as a frame on that session, as for the page's /ws channel.
+
+    build/test/app_standin [--port 8080] [--stream-port 8081] [--fps 25] [--serial]
+
+  Port 0 picks a free port. The ports in use are printed on stdout as
+  "control <port>" and "stream <port>" once both are listening.
+
+*/
+
+#include "app_sim.h"
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <thread>
+
+// Time a closed connection's socket is kept before it is reused, so a
+// stream task still sending on it fails rather than writing to the next
+// connection. Sends to a shut-down socket fail at once; this only needs
+// to outlast the next frame.
+#define CLOSE_DELAY_MS 5000
+#define MAX_HEAD 8192
+#define MAX_BODY (4 << 20)
+
+static bool method_from(const std::string &name, httpd_method_t *method)
+{
+  static const struct
+  {
+    const char *name;
+    httpd_method_t method;
+  } METHODS[] = {{"GET", HTTP_GET}, {"POST", HTTP_POST}, {"HEAD", HTTP_HEAD}, {"PUT", HTTP_PUT}, {"DELETE", HTTP_DELETE}};
+  for (const auto &m : METHODS)
+  {
+    if (name == m.name)
+    {
+      *method = m.method;
+      return true;
+    }
+  }
+  return false;
+}
+
+// The socket's own blocking recv, not the firmware's polling lwip_recv, so
+// a request is handed over as soon as it arrives
+static bool read_more(int fd, std::string *buf)
+{
+  char chunk[4096];
+  ssize_t n = (::recv)(fd, chunk, sizeof(chunk), 0);
+  if (n <= 0)
+    return false;
+  buf->append(chunk, n);
+  return true;
+}
+
+static size_t content_length(const std::string &headers)
+{
+  size_t pos = 0;
+  while (pos < headers.size())
+  {
+    size_t eol = headers.find("\r\n", pos);
+    if (!strncasecmp(headers.c_str() + pos, "Content-Length:", 15))
+      return strtoul(headers.c_str() + pos + 15, NULL, 10);
+    pos = eol + 2;
+  }
+  return 0;
+}
+
+static bool header_is(const std::string &headers, const char *name, const char *value)
+{
+  size_t pos = 0, len = strlen(name);
+  while (pos < headers.size())
+  {
+    size_t eol = headers.find("\r\n", pos);
+    if (!strncasecmp(headers.c_str() + pos, name, len) && headers[pos + len] == ':')
+    {
+      size_t start = headers.find_first_not_of(' ', pos + len + 1);
+      return start < eol && !strncasecmp(headers.c_str() + start, value, strlen(value));
+    }
+    pos = eol + 2;
+  }
+  return false;
+}
+
+// Client frames on a WebSocket session opened on uri, unmasked and handed
+// to the server one at a time, until the client closes or sends something
+// malformed
+static void ws_frames(httpd_handle_t server, int fd, const std::string &uri, std::string *buf)
+{
+  for (;;)
+  {
+    while (buf->size() < 2)
+      if (!read_more(fd, buf))
+        return;
+    uint8_t b0 = (*buf)[0], b1 = (*buf)[1];
+    size_t head = 2;
+    uint64_t len = b1 & 0x7f;
+    if (len >= 126)
+    {
+      size_t bytes = len == 126 ? 2 : 8;
+      while (buf->size() < 2 + bytes)
+        if (!read_more(fd, buf))
+          return;
+      len = 0;
+      for (size_t i = 0; i < bytes; i++)
+        len = len << 8 | (uint8_t)(*buf)[2 + i];
+      head += bytes;
+    }
+    // Clients always mask
+    if (!(b1 & 0x80) || len > MAX_BODY)
+      return;
+    head += 4;
+    while (buf->size() < head + len)
+      if (!read_more(fd, buf))
+        return;
+    std::string payload = buf->substr(head, len);
+    for (size_t i = 0; i < len; i++)
+      payload[i] ^= (*buf)[head - 4 + i % 4];
+    buf->erase(0, head + len);
+
+    httpd_ws_type_t type = (httpd_ws_type_t)(b0 & 0x0f);
+    if (type == HTTPD_WS_TYPE_CLOSE)
+      return;
+    if (type == HTTPD_WS_TYPE_PING || type == HTTPD_WS_TYPE_PONG)
+      continue;
+    host_httpd_request_t request = {};
+    request.method = HTTP_GET;
+    request.uri = uri.c_str();
+    request.body = payload.data();
+    request.body_len = payload.size();
+    request.ws_frame = true;
+    request.ws_type = type;
+    host_httpd_request(server, fd, &request);
+  }
+}
+
+static void connection(httpd_handle_t server, int fd)
+{
+  std::string buf;
+  for (;;)
+  {
+    size_t end;
+    while ((end = buf.find("\r\n\r\n")) == std::string::npos && buf.size() < MAX_HEAD)
+      if (!read_more(fd, &buf))
+        goto done;
+    if (end == std::string::npos)
+      break;
+
+    // Request line, then the header lines as the host server takes them
+    size_t eol = buf.find("\r\n");
+    std::string line = buf.substr(0, eol);
+    std::string headers = buf.substr(eol + 2, end + 2 - eol - 2);
+    size_t sp1 = line.find(' '), sp2 = line.rfind(' ');
+    httpd_method_t method;
+    if (sp1 == std::string::npos || sp2 <= sp1 || !method_from(line.substr(0, sp1), &method))
+      break;
+    std::string uri = line.substr(sp1 + 1, sp2 - sp1 - 1);
+
+    size_t body_len = content_length(headers);
+    if (body_len > MAX_BODY)
+      break;
+    while (buf.size() < end + 4 + body_len)
+      if (!read_more(fd, &buf))
+        goto done;
+
+    host_httpd_request_t request = {};
+    request.method = method;
+    request.uri = uri.c_str();
+    request.headers = headers.c_str();
+    request.body = buf.data() + end + 4;
+    request.body_len = body_len;
+    esp_err_t res = host_httpd_request(server, fd, &request);
+    buf.erase(0, end + 4 + body_len);
+    if (res == ESP_OK && header_is(headers, "Upgrade", "websocket"))
+    {
+      ws_frames(server, fd, uri, &buf);
+      break;
+    }
+  }
+done:
+  shutdown(fd, SHUT_RDWR);
+  host_httpd_close(server, fd);
+  std::this_thread::sleep_for(std::chrono::milliseconds(CLOSE_DELAY_MS));
+  close(fd);
+}
+
+static int listen_on(uint16_t port)
+{
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) || listen(fd, 16))
+  {
+    perror("app_standin: listen");
+    exit(1);
+  }
+  return fd;
+}
+
+static uint16_t port_of(int fd)
+{
+  struct sockaddr_in addr = {};
+  socklen_t len = sizeof(addr);
+  getsockname(fd, (struct sockaddr *)&addr, &len);
+  return ntohs(addr.sin_port);
+}
+
+static void accept_loop(httpd_handle_t server, int listener)
+{
+  for (;;)
+  {
+    int fd = accept(listener, NULL, NULL);
+    if (fd < 0)
+      continue;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    std::thread(connection, server, fd).detach();
+  }
+}
+
+int main(int argc, char **argv)
+{
+  uint16_t port = 8080, stream_port = 8081;
+  double fps = 25;
+  bool serial = false;
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--port") && i + 1 < argc)
+      port = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--stream-port") && i + 1 < argc)
+      stream_port = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--fps") && i + 1 < argc)
+      fps = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--serial"))
+      serial = true;
+    else
+    {
+      fprintf(stderr, "usage: %s [--port N] [--stream-port N] [--fps N] [--serial]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (fps <= 0)
+    fps = 25;
+  host_camera.frame_us = 1000000 / fps;
+
+  app_start(false);
+  int control = listen_on(port);
+  int stream = listen_on(stream_port);
+  printf("control %u\nstream %u\n", port_of(control), port_of(stream));
+  fflush(stdout);
+  std::thread(accept_loop, camera_httpd, control).detach();
+  std::thread(accept_loop, stream_httpd, stream).detach();
+
+  // The firmware's Serial output, echoed to stderr with --serial
+  for (;;)
+  {
+    std::string out = host_serial_take();
+    if (serial && !out.empty())
+      fputs(out.c_str(), stderr);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  }
+}
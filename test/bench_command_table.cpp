@@ -0,0 +1,122 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/bench_command_table.cpp
+  Time /control query handling: in-place parse, table lookup and value
+  parse, against the strcmp chain and atoi it replaced
+
+*/
+
+#include "command_table.h"
+#include <chrono>
+
+static volatile int sink;
+
+static esp_err_t record(int val)
+{
+  sink = val;
+  return ESP_OK;
+}
+
+static constexpr command_t TABLE[] = {
+    {"car",        0x01, 1,   5,   record},
+    {"speed",      0x02, 0,   255, record},
+    {"flash",      0x03, 0,   256, record},
+    {"framesize",  0x04, 0,   13,  record},
+    {"quality",    0x05, 0,   63,  record},
+    {"nostop",     0x06, 0,   1,   record},
+    {"flashoff",   0x07, 0,   256, record},
+};
+static constexpr command_index_t INDEX = command_index_build(TABLE);
+static_assert(INDEX.valid, "bench table collides");
+
+static const char *QUERIES[] = {
+    "var=car&val=1", "var=speed&val=200", "var=car&val=3", "var=flashoff&val=0",
+    "var=quality&val=12", "var=car&val=5", "var=nostop&val=1", "var=bogus&val=1",
+};
+#define QUERY_COUNT (sizeof(QUERIES) / sizeof(QUERIES[0]))
+
+static bool table_dispatch(const char *raw)
+{
+  char query[COMMAND_MAX_QUERY];
+  const char *var, *val;
+  int v;
+  strcpy(query, raw);
+  if (!command_parse_query(query, &var, &val))
+    return false;
+  const command_t *cmd = command_find(TABLE, INDEX, var);
+  if (!cmd || !command_parse_int(val, &v) || !command_in_range(cmd, v))
+    return false;
+  return cmd->handler(v) == ESP_OK;
+}
+
+// The old cmd_handler: heap copy, httpd_query_key_value style field
+// extraction into fixed arrays, atoi and a strcmp chain
+static bool find_value(const char *query, const char *key, char *out, size_t len)
+{
+  size_t key_len = strlen(key);
+  for (const char *p = query; p; p = strchr(p, '&'))
+  {
+    if (*p == '&')
+      p++;
+    if (!strncmp(p, key, key_len) && p[key_len] == '=')
+    {
+      const char *v = p + key_len + 1;
+      size_t n = strcspn(v, "&");
+      if (n >= len)
+        return false;
+      memcpy(out, v, n);
+      out[n] = 0;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool strcmp_dispatch(const char *raw)
+{
+  char *buf = (char *)malloc(strlen(raw) + 1);
+  char variable[32], value[32];
+  strcpy(buf, raw);
+  bool ok = find_value(buf, "var", variable, sizeof(variable)) &&
+            find_value(buf, "val", value, sizeof(value));
+  free(buf);
+  if (!ok)
+    return false;
+  int val = atoi(value);
+  if (!strcmp(variable, "framesize"))
+    sink = val;
+  else if (!strcmp(variable, "quality"))
+    sink = val;
+  else if (!strcmp(variable, "flash"))
+    sink = val;
+  else if (!strcmp(variable, "flashoff"))
+    sink = val;
+  else if (!strcmp(variable, "speed"))
+    sink = val;
+  else if (!strcmp(variable, "nostop"))
+    sink = val;
+  else if (!strcmp(variable, "car"))
+    sink = val;
+  else
+    return false;
+  return true;
+}
+
+template <typename F>
+static void run(const char *name, F dispatch, long iterations)
+{
+  long accepted = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < iterations; i++)
+    accepted += dispatch(QUERIES[i % QUERY_COUNT]);
+  auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  printf("%-8s %7.1f ns/query  (%ld of %ld accepted)\n", name, ns / iterations, accepted, iterations);
+}
+
+int main(int argc, char **argv)
+{
+  long iterations = argc > 1 ? atol(argv[1]) : 10000000;
+  run("table", table_dispatch, iterations);
+  run("strcmp", strcmp_dispatch, iterations);
+  return 0;
+}
@@ -0,0 +1,235 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/bench_endpoints.cpp
+  CPU time, heap allocations and response bytes per request for the
+  sketch's /control, /status, /capture, /stream and POST /update handlers,
+  run on the host servers against the fake camera and flash. CPU is the
+  handler thread's own time on this machine; allocations count every task
+  while the request runs, which on the frozen clock is the handler and the
+  tasks it wakes. A no-op handler on the same server gives the host
+  server's own share, which is taken off the other rows.
+
+*/
+
+#include "app_sim.h"
+#include "esp_partition.h"
+#include <atomic>
+#include <time.h>
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+extern "C" void __libc_free(void *ptr);
+
+static std::atomic<uint64_t> alloc_count(0);
+static std::atomic<uint64_t> alloc_bytes(0);
+
+extern "C" void *malloc(size_t size)
+{
+  alloc_count.fetch_add(1, std::memory_order_relaxed);
+  alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t n, size_t size)
+{
+  alloc_count.fetch_add(1, std::memory_order_relaxed);
+  alloc_bytes.fetch_add(n * size, std::memory_order_relaxed);
+  return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+  alloc_count.fetch_add(1, std::memory_order_relaxed);
+  alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+
+extern "C" void free(void *ptr)
+{
+  __libc_free(ptr);
+}
+
+typedef struct
+{
+  const char *name;
+  uint32_t requests;
+  int64_t cpu_ns;
+  uint64_t allocs;
+  uint64_t alloc_bytes;
+  uint64_t resp_bytes;
+} bench_row_t;
+
+static bench_row_t overhead = {"(host server)"};
+
+static esp_err_t noop_handler(httpd_req_t *req)
+{
+  return ESP_OK;
+}
+
+// One request on a fresh connection, added to row
+static void bench_request(bench_row_t *row, httpd_handle_t server, httpd_method_t method, const char *uri,
+                          const char *headers = NULL, const std::string &body = std::string())
+{
+  app_conn_t conn = app_connect();
+  host_httpd_request_t request = {};
+  request.method = method;
+  request.uri = uri;
+  request.headers = headers;
+  request.body = body.data();
+  request.body_len = body.size();
+  uint64_t count = alloc_count, bytes = alloc_bytes;
+  host_httpd_request(server, conn.server, &request);
+  row->allocs += alloc_count - count;
+  row->alloc_bytes += alloc_bytes - bytes;
+  row->cpu_ns += host_httpd_last_cpu_ns();
+  row->resp_bytes += app_read(conn.client).size();
+  row->requests++;
+  app_disconnect(server, &conn);
+}
+
+static void print_row(const bench_row_t *row, bool net)
+{
+  double n = row->requests;
+  double allocs = row->allocs / n, bytes = row->alloc_bytes / n, cpu = row->cpu_ns / n / 1000;
+  if (net)
+  {
+    allocs -= (double)overhead.allocs / overhead.requests;
+    bytes -= (double)overhead.alloc_bytes / overhead.requests;
+    cpu -= overhead.cpu_ns / 1000.0 / overhead.requests;
+  }
+  printf("%-28s %8u %9.1f %8.1f %12.0f %11.0f\n", row->name, row->requests, cpu, allocs, bytes,
+         row->resp_bytes / n);
+}
+
+static std::string firmware_image(size_t len)
+{
+  std::string image(len, 0);
+  for (size_t i = 0; i < len; i++)
+    image[i] = (i * 7919) >> 3;
+  image[0] = (char)0xe9;
+  return image;
+}
+
+static int64_t process_cpu_ns()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Process CPU and allocations over a second of the frozen clock
+static void bench_window(bench_row_t *row)
+{
+  uint64_t count = alloc_count, bytes = alloc_bytes;
+  int64_t cpu = process_cpu_ns();
+  host_clock_advance(1000000);
+  row->cpu_ns += process_cpu_ns() - cpu;
+  row->allocs += alloc_count - count;
+  row->alloc_bytes += alloc_bytes - bytes;
+}
+
+// Per frame for one viewer over a second of stream. The stream task is not
+// the request's handler thread, so CPU is the whole process, capture and
+// sending together, less the same second with nobody watching.
+static void bench_stream(bench_row_t *row)
+{
+  bench_row_t idle = {};
+  bench_window(&idle);
+
+  app_conn_t viewer = app_connect();
+  host_httpd_call(stream_httpd, HTTP_GET, "/stream", viewer.server);
+  host_clock_advance(500000);
+  app_read(viewer.client);
+  bench_window(row);
+  row->cpu_ns -= idle.cpu_ns;
+  row->allocs -= idle.allocs;
+  row->alloc_bytes -= idle.alloc_bytes;
+  std::string raw = app_read(viewer.client);
+  row->resp_bytes += raw.size();
+  for (size_t pos = 0; (pos = raw.find("X-Frame-Seq: ", pos)) != std::string::npos; pos++)
+    row->requests++;
+
+  close(viewer.client);
+  viewer.client = -1;
+  host_clock_advance(200000);
+  app_disconnect(stream_httpd, &viewer);
+}
+
+int main()
+{
+  app_start();
+  httpd_uri_t noop = {"/noop", HTTP_GET, noop_handler, NULL, false};
+  httpd_register_uri_handler(camera_httpd, &noop);
+  host_flash_get();
+
+  // Warm up lazily created state before counting anything
+  bench_row_t warmup = {};
+  bench_request(&warmup, camera_httpd, HTTP_GET, "/status");
+  bench_request(&warmup, camera_httpd, HTTP_GET, "/capture");
+  bench_request(&warmup, camera_httpd, HTTP_GET, "/control?var=car&val=3");
+
+  for (int i = 0; i < 200; i++)
+    bench_request(&overhead, camera_httpd, HTTP_GET, "/noop");
+
+  bench_row_t drive = {"/control car"};
+  for (int i = 0; i < 200; i++)
+    bench_request(&drive, camera_httpd, HTTP_GET, i % 2 ? "/control?var=car&val=3" : "/control?var=car&val=1");
+
+  bench_row_t setting = {"/control speed"};
+  for (int i = 0; i < 200; i++)
+    bench_request(&setting, camera_httpd, HTTP_GET, i % 2 ? "/control?var=speed&val=255" : "/control?var=speed&val=200");
+
+  bench_row_t rejected = {"/control out of range"};
+  for (int i = 0; i < 200; i++)
+    bench_request(&rejected, camera_httpd, HTTP_GET, "/control?var=speed&val=300");
+
+  bench_row_t status = {"/status"};
+  for (int i = 0; i < 200; i++)
+    bench_request(&status, camera_httpd, HTTP_GET, "/status");
+
+  bench_row_t capture = {"/capture from camera"};
+  for (int i = 0; i < 50; i++)
+    bench_request(&capture, camera_httpd, HTTP_GET, "/capture");
+
+  // A viewer keeps the frame hub fresh, so /capture takes its newest frame
+  bench_row_t cached = {"/capture from stream"};
+  app_conn_t viewer = app_connect();
+  host_httpd_call(stream_httpd, HTTP_GET, "/stream", viewer.server);
+  host_clock_advance(500000);
+  for (int i = 0; i < 50; i++)
+  {
+    bench_request(&cached, camera_httpd, HTTP_GET, "/capture");
+    host_clock_advance(20000);
+    app_read(viewer.client);
+  }
+  close(viewer.client);
+  viewer.client = -1;
+  host_clock_advance(200000);
+  app_disconnect(stream_httpd, &viewer);
+
+  bench_row_t stream = {"/stream per frame"};
+  bench_stream(&stream);
+
+  bench_row_t update = {"POST /update 256 KB"};
+  std::string image = firmware_image(256 * 1024);
+  for (int i = 0; i < 3; i++)
+  {
+    bench_request(&update, camera_httpd, HTTP_POST, "/update", "Content-Type: application/octet-stream\r\n", image);
+    host_flash.boot = host_flash.running;
+  }
+
+  printf("QVGA JPEG %u bytes, per request; handler rows net of the host server row\n",
+         host_camera_jpeg_len(FRAMESIZE_QVGA, 10));
+  printf("%-28s %8s %9s %8s %12s %11s\n", "endpoint", "requests", "cpu us", "allocs", "alloc bytes", "resp bytes");
+  print_row(&overhead, false);
+  print_row(&drive, true);
+  print_row(&setting, true);
+  print_row(&rejected, true);
+  print_row(&status, true);
+  print_row(&capture, true);
+  print_row(&cached, true);
+  print_row(&stream, false);
+  print_row(&update, true);
+  return 0;
+}
@@ -0,0 +1,169 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/bench_frame_pipeline.cpp
+  Simulated stream throughput with the capture and encode stages split,
+  against capturing and converting in one loop, over a range of JPEG
+  conversion times. Runs on the frozen host clock, so the figures come
+  from the frame timing model rather than this machine's speed. Then the
+  heap allocations per converted frame: frame2jpg's buffer per frame as
+  /stream used it before the slot pool, against the pooled encode stage,
+  with the fake camera's allocations for each frame grabbed, measured by
+  a capture-only loop, taken off both.
+
+*/
+
+#include "frame_sim.h"
+#include <atomic>
+
+#define SENSOR_FPS 25
+#define RUN_US 20000000
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+extern "C" void __libc_free(void *ptr);
+
+static std::atomic<uint64_t> alloc_count(0);
+static std::atomic<uint64_t> alloc_bytes(0);
+
+extern "C" void *malloc(size_t size)
+{
+  alloc_count.fetch_add(1, std::memory_order_relaxed);
+  alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t n, size_t size)
+{
+  alloc_count.fetch_add(1, std::memory_order_relaxed);
+  alloc_bytes.fetch_add(n * size, std::memory_order_relaxed);
+  return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+  alloc_count.fetch_add(1, std::memory_order_relaxed);
+  alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+
+extern "C" void free(void *ptr)
+{
+  __libc_free(ptr);
+}
+
+typedef struct
+{
+  bool convert;
+  volatile bool stop;
+  uint32_t frames;
+  volatile bool done;
+} alloc_loop_t;
+
+// Capture, and with convert set, frame2jpg into a buffer of its own that
+// is freed once sent
+static void alloc_task(void *arg)
+{
+  alloc_loop_t *l = (alloc_loop_t *)arg;
+  while (!l->stop)
+  {
+    camera_fb_t *fb = esp_camera_fb_get();
+    if (!fb)
+      continue;
+    uint8_t *jpeg;
+    size_t len;
+    if (l->convert && frame2jpg(fb, 80, &jpeg, &len))
+      free(jpeg);
+    esp_camera_fb_return(fb);
+    l->frames++;
+  }
+  l->done = true;
+}
+
+typedef struct
+{
+  uint32_t frames;   // converted frames that reached the consumer
+  uint32_t grabbed;
+  uint64_t allocs;
+  uint64_t bytes;
+} alloc_run_t;
+
+// Counted from before the task starts until it has stopped, so every
+// frame it grabbed is in
+static alloc_run_t run_loop(bool convert)
+{
+  alloc_loop_t l = {convert};
+  uint64_t count = alloc_count, bytes = alloc_bytes;
+  uint32_t grabbed = host_camera.grabbed;
+  xTaskCreate(alloc_task, "alloc", 4096, &l, 5, NULL);
+  host_clock_advance(RUN_US);
+  uint32_t frames = l.frames;
+  l.stop = true;
+  host_clock_advance(2000000);
+  return {frames, host_camera.grabbed - grabbed, alloc_count - count, alloc_bytes - bytes};
+}
+
+static alloc_run_t run_hub()
+{
+  uint64_t count = alloc_count, bytes = alloc_bytes;
+  uint32_t grabbed = host_camera.grabbed;
+  uint32_t frames = sim_pipelined(RUN_US);
+  return {frames, host_camera.grabbed - grabbed, alloc_count - count, alloc_bytes - bytes};
+}
+
+static void print_allocs(const char *name, alloc_run_t run, alloc_run_t base, const frame_hub_stats_t *before)
+{
+  double allocs = (run.allocs - (double)base.allocs / base.grabbed * run.grabbed) / run.frames;
+  double bytes = (run.bytes - (double)base.bytes / base.grabbed * run.grabbed) / run.frames;
+  // Starting the consumer task costs a few bytes more or less a run
+  allocs = allocs < 0 ? 0 : allocs;
+  bytes = bytes < 0 ? 0 : bytes;
+  printf("%-22s  %6u  %10.2f  %11.0f", name, run.frames, allocs, bytes);
+  if (before)
+  {
+    frame_hub_stats_t after;
+    frame_hub_get_stats(&after);
+    printf("  %4u  %6u", after.pool_hits - before->pool_hits, after.pool_misses - before->pool_misses);
+  }
+  printf("\n");
+}
+
+int main()
+{
+  sim_start(SENSOR_FPS, FRAMESIZE_SVGA);
+
+  // JPEG from the sensor: nothing to convert, both stay at the sensor rate
+  printf("sensor %u fps, %u s per run\n", SENSOR_FPS, RUN_US / 1000000);
+  printf("convert ms  pipelined fps  serial fps\n");
+  uint32_t pipelined = sim_pipelined(RUN_US);
+  uint32_t serial = sim_serial(RUN_US);
+  printf("%10s  %13.1f  %10.1f\n", "jpeg", pipelined * 1e6 / RUN_US, serial * 1e6 / RUN_US);
+
+  sensor_t *s = esp_camera_sensor_get();
+  s->set_pixformat(s, PIXFORMAT_RGB565);
+  const uint32_t convert_ms[] = {10, 30, 40, 50, 80, 120};
+  for (uint32_t ms : convert_ms)
+  {
+    host_camera.convert_us = ms * 1000;
+    pipelined = sim_pipelined(RUN_US);
+    serial = sim_serial(RUN_US);
+    printf("%10u  %13.1f  %10.1f\n", ms, pipelined * 1e6 / RUN_US, serial * 1e6 / RUN_US);
+  }
+
+  // The pool is preallocated for SVGA, which the default JPEG size fits;
+  // 200 KB frames grow each slot they land in once
+  host_camera.convert_us = 30000;
+  printf("\nRGB565 at 30 ms a conversion, per frame, net of the camera's own\n");
+  printf("%-22s  %6s  %10s  %11s  %4s  %6s\n", "path", "frames", "allocs", "alloc bytes", "hits", "misses");
+  alloc_run_t base = run_loop(false);
+  print_allocs("(capture only)", base, base, NULL);
+  print_allocs("frame2jpg per frame", run_loop(true), base, NULL);
+  frame_hub_stats_t before;
+  frame_hub_get_stats(&before);
+  print_allocs("hub slot pool", run_hub(), base, &before);
+  host_camera.jpeg_len = 200000;
+  print_allocs("frame2jpg, 200 KB", run_loop(true), base, NULL);
+  frame_hub_get_stats(&before);
+  print_allocs("hub slot pool, 200 KB", run_hub(), base, &before);
+  return 0;
+}
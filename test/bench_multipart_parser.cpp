@@ -0,0 +1,61 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/bench_multipart_parser.cpp
+  Parser throughput on a firmware-sized upload fed in the chunk size
+  handle_update_post receives
+
+*/
+
+#include "multipart_parser.h"
+#include <chrono>
+#include <random>
+#include <string>
+
+static const std::string BOUNDARY = "----WebKitFormBoundaryAbC123";
+
+static bool count(void *ctx, const uint8_t *data, size_t len)
+{
+  *(size_t *)ctx += len;
+  return true;
+}
+
+static void run(const char *name, const std::string &file, size_t chunk, int rounds)
+{
+  std::string body = "--" + BOUNDARY + "\r\n"
+                     "Content-Disposition: form-data; name=\"update\"; filename=\"fw.bin\"\r\n\r\n" +
+                     file + "\r\n--" + BOUNDARY + "--\r\n";
+  std::string type = "multipart/form-data; boundary=" + BOUNDARY;
+  size_t out = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++)
+  {
+    multipart_parser_t p;
+    multipart_init(&p, type.c_str(), count, &out);
+    for (size_t i = 0; i < body.size(); i += chunk)
+      multipart_feed(&p, (const uint8_t *)body.data() + i, std::min(chunk, body.size() - i));
+  }
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("%-12s chunk %5zu  %8.1f MB/s%s\n", name, chunk, body.size() * (double)rounds / s / 1e6,
+         out == file.size() * rounds ? "" : "  (wrong output)");
+}
+
+int main(int argc, char **argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 20;
+  std::mt19937 rng(1);
+  // About the size of the firmware image
+  std::string random(1500000, 0);
+  for (char &c : random)
+    c = rng();
+  // Worst case for the CR scan: every other byte is a CR
+  std::string crs(1500000, '\r');
+  for (size_t i = 1; i < crs.size(); i += 2)
+    crs[i] = 'x';
+
+  for (size_t chunk : {1460, 4096})
+  {
+    run("random", random, chunk, rounds);
+    run("cr-heavy", crs, chunk, rounds);
+  }
+  return 0;
+}
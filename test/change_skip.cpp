@@ -0,0 +1,77 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/change_skip.cpp
+  Estimate what still-scene skipping would save on a recorded stream, by
+  running it through change_detect.h itself
+
+    curl --max-time 60 http://192.168.4.1:81/stream > parked.mjpg
+    build/test/change_skip parked.mjpg
+    build/test/change_skip --threshold 10 --keepalive 1000 saved1.jpg saved2.jpg
+
+  Record with skipping off, or the skipped frames are missing from the
+  input. Thresholds are in tenths of a percent, as for
+  /control?var=change_skip&val=<threshold>.
+
+*/
+
+#include "change_skip.h"
+
+static void usage()
+{
+  fprintf(stderr, "usage: change_skip [--threshold permille]... [--keepalive ms] [--fps fps] file...\n");
+  exit(2);
+}
+
+int main(int argc, char **argv)
+{
+  std::vector<uint16_t> thresholds;
+  uint32_t keepalive_ms = 1000;
+  double fps = 10.0;
+  std::vector<const char *> paths;
+  std::vector<recorded_frame_t> frames;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--threshold") && i + 1 < argc)
+      thresholds.push_back(atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--keepalive") && i + 1 < argc)
+      keepalive_ms = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--fps") && i + 1 < argc)
+      fps = atof(argv[++i]);
+    else if (argv[i][0] == '-')
+      usage();
+    else
+      paths.push_back(argv[i]);
+  }
+  if (paths.empty())
+    usage();
+  for (const char *path : paths)
+    if (!change_skip_read(path, fps, &frames))
+    {
+      fprintf(stderr, "change_skip: cannot read %s\n", path);
+      return 1;
+    }
+  if (thresholds.empty())
+    thresholds = {5, 10, 20, 40};
+  if (frames.empty())
+  {
+    printf("no frames\n");
+    return 0;
+  }
+
+  uint64_t total = 0;
+  for (const recorded_frame_t &f : frames)
+    total += f.len;
+  double span = (frames.back().capture_us - frames.front().capture_us) / 1e6;
+  printf("%zu frames, %llu KB over %.1f s, keepalive %u ms\n", frames.size(), (unsigned long long)(total / 1024),
+         span, keepalive_ms);
+  printf("threshold  sent  skipped  sent KB  saved   max gap\n");
+  for (uint16_t threshold : thresholds)
+  {
+    change_skip_result_t r = change_skip_replay(frames, threshold, keepalive_ms);
+    printf("%7.1f%%  %5u  %7u  %7llu  %4.1f%%  %6.0f ms\n", threshold / 10.0, r.sent, r.skipped,
+           (unsigned long long)(r.sent_bytes / 1024), total ? 100.0 * r.skipped_bytes / total : 0.0,
+           r.max_gap_us / 1000.0);
+  }
+  return 0;
+}
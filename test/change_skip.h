@@ -0,0 +1,164 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/change_skip.h
+  Recorded /stream frames run through change_detect.h on the host: the
+  recording reader and the replay shared by change_skip and its test
+
+*/
+
+#ifndef CHANGE_SKIP_H
+#define CHANGE_SKIP_H
+
+#include "change_detect.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <string>
+#include <vector>
+
+typedef struct
+{
+  int64_t capture_us;
+  uint32_t len;
+} recorded_frame_t;
+
+typedef struct
+{
+  uint32_t sent;
+  uint32_t skipped;
+  uint64_t sent_bytes;
+  uint64_t skipped_bytes;
+  int64_t max_gap_us;   // longest time between two frames sent
+} change_skip_result_t;
+
+// Capture time from the COM segment the firmware writes right after SOI,
+// "seq=<n> capture=<s.us> send=<s.us>". com_len is the segment with its
+// marker; the car adds it while sending, so the detector never sees it.
+static inline bool change_skip_com(const std::string &jpeg, int64_t *capture_us, size_t *com_len)
+{
+  if (jpeg.size() < 6 || jpeg.compare(0, 4, "\xff\xd8\xff\xfe") != 0)
+    return false;
+  size_t seg_len = ((uint8_t)jpeg[4] << 8) | (uint8_t)jpeg[5];
+  if (seg_len < 2 || 4 + seg_len > jpeg.size())
+    return false;
+  std::string com = jpeg.substr(6, seg_len - 2);
+  unsigned seq;
+  double capture, send;
+  if (sscanf(com.c_str(), "seq=%u capture=%lf send=%lf", &seq, &capture, &send) != 3)
+    return false;
+  *capture_us = (int64_t)(capture * 1000000 + 0.5);
+  *com_len = 2 + seg_len;
+  return true;
+}
+
+// Value of a part header, matched case-insensitively, or "" without it
+static inline std::string change_skip_header(const std::string &headers, const char *name)
+{
+  size_t pos = 0;
+  size_t name_len = strlen(name);
+  while (pos < headers.size())
+  {
+    size_t end = headers.find("\r\n", pos);
+    if (end == std::string::npos)
+      end = headers.size();
+    if (end - pos > name_len && headers[pos + name_len] == ':' && !strncasecmp(headers.c_str() + pos, name, name_len))
+    {
+      size_t v = pos + name_len + 1;
+      while (v < end && headers[v] == ' ')
+        v++;
+      return headers.substr(v, end - v);
+    }
+    pos = end + 2;
+  }
+  return "";
+}
+
+// Frames of a recorded multipart stream, or of a single JPEG, in file
+// order, with the lengths the detector saw on the car. Capture times come
+// from X-Timestamp, then the COM segment; frames with neither are spaced
+// at fps.
+static inline void change_skip_parse(const std::string &data, double fps, std::vector<recorded_frame_t> *frames)
+{
+  std::vector<std::pair<std::string, std::string>> parts;
+  bool single = !data.compare(0, 2, "\xff\xd8");
+  if (single)
+    parts.push_back({"", data});
+  size_t pos = 0;
+  while (!single)
+  {
+    size_t start = data.find("Content-Type: image/jpeg", pos);
+    if (start == std::string::npos)
+      break;
+    size_t end = data.find("\r\n\r\n", start);
+    if (end == std::string::npos)
+      break;
+    std::string headers = data.substr(start, end - start);
+    size_t len = strtoul(change_skip_header(headers, "Content-Length").c_str(), NULL, 10);
+    if (end + 4 + len > data.size())
+      break;
+    parts.push_back({headers, data.substr(end + 4, len)});
+    pos = end + 4 + len;
+  }
+
+  for (const auto &part : parts)
+  {
+    recorded_frame_t f;
+    int64_t com_us;
+    size_t com_len = 0;
+    bool com = change_skip_com(part.second, &com_us, &com_len);
+    f.len = part.second.size() - com_len;
+    std::string stamp = change_skip_header(part.first, "X-Timestamp");
+    if (!stamp.empty())
+      f.capture_us = (int64_t)(strtod(stamp.c_str(), NULL) * 1000000 + 0.5);
+    else if (com)
+      f.capture_us = com_us;
+    else
+      f.capture_us = (int64_t)(frames->size() * 1000000 / fps);
+    frames->push_back(f);
+  }
+}
+
+static inline bool change_skip_read(const char *path, double fps, std::vector<recorded_frame_t> *frames)
+{
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return false;
+  std::string data;
+  char buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    data.append(buf, n);
+  fclose(f);
+  change_skip_parse(data, fps, frames);
+  return true;
+}
+
+// Replay frames through the detector /stream uses, as if change_skip were
+// threshold_permille
+static inline change_skip_result_t change_skip_replay(const std::vector<recorded_frame_t> &frames,
+                                                      uint16_t threshold_permille, uint32_t keepalive_ms)
+{
+  change_detect_t detect = {};
+  change_skip_result_t r = {};
+  int64_t last_sent = -1;
+  for (const recorded_frame_t &f : frames)
+  {
+    if (change_detect_send(&detect, f.len, f.capture_us, threshold_permille, keepalive_ms))
+    {
+      r.sent++;
+      r.sent_bytes += f.len;
+      if (last_sent >= 0 && f.capture_us - last_sent > r.max_gap_us)
+        r.max_gap_us = f.capture_us - last_sent;
+      last_sent = f.capture_us;
+    }
+    else
+    {
+      r.skipped++;
+      r.skipped_bytes += f.len;
+    }
+  }
+  return r;
+}
+
+#endif
@@ -0,0 +1,39 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/check.h
+  Minimal assertion helpers for the host tests
+
+*/
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+#include <string.h>
+
+static int check_failures = 0;
+
+// Report and count a failure without stopping the test
+#define CHECK(cond) \
+  do \
+  { \
+    if (!(cond)) \
+    { \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      check_failures++; \
+    } \
+  } while (0)
+
+#define CHECK_STR(a, b) CHECK((a) && !strcmp((a), (b)))
+
+// Exit status for main()
+static inline int check_result(const char *name)
+{
+  if (check_failures)
+    fprintf(stderr, "%s: %d check(s) failed\n", name, check_failures);
+  else
+    printf("%s: ok\n", name);
+  return check_failures ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,134 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/frame_sim.h
+  Viewers and capture loops run against frame_hub.cpp and the fake camera
+  on a frozen clock, shared by test_frame_hub and bench_frame_pipeline
+
+*/
+
+#ifndef FRAME_SIM_H
+#define FRAME_SIM_H
+
+#include "frame_hub.h"
+#include "img_converters.h"
+#include "metrics.h"
+
+histogram_t metric_fb_get = HISTOGRAM_INIT("robot_fb_get", "");
+histogram_t metric_jpeg_encode = HISTOGRAM_INIT("robot_jpeg_encode", "");
+histogram_t metric_send_header = HISTOGRAM_INIT("robot_stream_send_header", "");
+histogram_t metric_send_data = HISTOGRAM_INIT("robot_stream_send_data", "");
+histogram_t metric_send_boundary = HISTOGRAM_INIT("robot_stream_send_boundary", "");
+histogram_t metric_control = HISTOGRAM_INIT("robot_control", "");
+histogram_t metric_cmd_to_pwm = HISTOGRAM_INIT("robot_cmd_to_pwm", "");
+
+typedef struct
+{
+  uint32_t send_us;      // time to put one frame on the wire
+  volatile bool stop;
+  int client;
+  uint32_t frames;
+  uint32_t skipped;      // newer frames that arrived while sending
+  uint32_t out_of_order;
+  volatile bool done;
+} viewer_t;
+
+// A /stream client: the loop of stream_client_task with the socket
+// replaced by a delay
+static void viewer_task(void *arg)
+{
+  viewer_t *v = (viewer_t *)arg;
+  v->client = frame_hub_attach();
+  uint32_t last_seq = 0;
+  while (v->client >= 0 && !v->stop)
+  {
+    hub_frame_t *frame = frame_hub_acquire(last_seq, pdMS_TO_TICKS(1000));
+    if (!frame)
+      continue;
+    if (last_seq && frame->seq <= last_seq)
+      v->out_of_order++;
+    if (last_seq)
+      v->skipped += frame->seq - last_seq - 1;
+    last_seq = frame->seq;
+    host_delay_us(v->send_us);
+    frame_hub_record_send(v->send_us);
+    frame_hub_release(frame);
+    v->frames++;
+  }
+  frame_hub_detach(v->client);
+  v->done = true;
+}
+
+static void viewers_stop(viewer_t *viewers, int n)
+{
+  for (int i = 0; i < n; i++)
+    viewers[i].stop = true;
+  host_clock_advance(2000000);
+}
+
+// Frames one viewer gets in run_us
+static uint32_t sim_pipelined(int64_t run_us)
+{
+  viewer_t v = {1000};
+  xTaskCreate(viewer_task, "viewer", 4096, &v, 5, NULL);
+  host_clock_advance(run_us);
+  uint32_t frames = v.frames;
+  viewers_stop(&v, 1);
+  return frames;
+}
+
+typedef struct
+{
+  volatile bool stop;
+  uint32_t frames;
+  volatile bool done;
+} serial_loop_t;
+
+static size_t sim_discard(void *arg, size_t index, const void *data, size_t len)
+{
+  return len;
+}
+
+// Capture and convert one after the other in a single task, as /stream
+// did before the capture and encode stages were split
+static void serial_task(void *arg)
+{
+  serial_loop_t *s = (serial_loop_t *)arg;
+  while (!s->stop)
+  {
+    camera_fb_t *fb = esp_camera_fb_get();
+    if (!fb)
+      continue;
+    if (fb->format != PIXFORMAT_JPEG)
+      frame2jpg_cb(fb, 80, sim_discard, NULL);
+    esp_camera_fb_return(fb);
+    s->frames++;
+  }
+  s->done = true;
+}
+
+static uint32_t sim_serial(int64_t run_us)
+{
+  serial_loop_t s = {};
+  xTaskCreate(serial_task, "serial", 4096, &s, 5, NULL);
+  host_clock_advance(run_us);
+  uint32_t frames = s.frames;
+  s.stop = true;
+  host_clock_advance(2000000);
+  return frames;
+}
+
+// Start the fake camera and the hub on a frozen clock
+static void sim_start(uint32_t fps, framesize_t framesize)
+{
+  host_clock_freeze();
+  host_camera.frame_us = 1000000 / fps;
+  camera_config_t config = {};
+  config.pixel_format = PIXFORMAT_JPEG;
+  config.frame_size = framesize;
+  config.jpeg_quality = 10;
+  config.fb_count = 2;
+  esp_camera_init(&config);
+  frame_hub_start(framesize);
+}
+
+#endif
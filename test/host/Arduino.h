@@ -0,0 +1,154 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/Arduino.h
+  Host stand-in for the parts of the Arduino core and FreeRTOS the sketch
+  uses, so its modules build and run under test/
+
+*/
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_INVALID_SIZE 0x104
+#define ESP_ERR_NOT_FOUND 0x105
+#define ESP_ERR_TIMEOUT 0x107
+const char *esp_err_to_name(esp_err_t err);
+
+#define PROGMEM
+
+// Time since the test started, or the frozen clock, see host_clock_freeze
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+
+// The clock normally follows real time. Once frozen it only moves through
+// host_clock_advance, which steps to each esp_timer expiry and task wake-up
+// in order, runs due timer callbacks on the calling thread and waits for
+// every task to block again before going on. A test can then check state
+// at exact times.
+void host_clock_freeze(int64_t us = 1000000);
+void host_clock_advance(int64_t us);
+bool host_clock_frozen();
+// Block the calling task for us microseconds of host clock time, for
+// stand-ins that model how long hardware takes
+void host_delay_us(int64_t us);
+
+#define OUTPUT 0x03
+#define LOW 0
+#define HIGH 1
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int host_pin_level(uint8_t pin);
+
+// Serial output is kept in memory; host_serial_take() returns and clears it
+struct HardwareSerial
+{
+  size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+  size_t print(const char *s);
+  size_t println(const char *s = "");
+};
+extern HardwareSerial Serial;
+std::string host_serial_take();
+
+// ESP.restart() is counted instead of rebooting
+struct EspClass
+{
+  void restart();
+};
+extern EspClass ESP;
+extern volatile uint32_t host_restarts;
+
+// PSRAM is present unless a test clears this
+inline bool host_psram = true;
+static inline bool psramFound()
+{
+  return host_psram;
+}
+
+// FreeRTOS. Tasks run as threads with 1 ms ticks. Queues, semaphores and
+// task notifications block on the host clock, so they follow a frozen clock
+// too.
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef struct host_task *TaskHandle_t;
+typedef struct host_queue *QueueHandle_t;
+typedef struct host_queue *SemaphoreHandle_t;
+typedef void (*TaskFunction_t)(void *);
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portTICK_PERIOD_MS 1
+#define portMAX_DELAY ((TickType_t)0xffffffff)
+#define tskIDLE_PRIORITY 0
+#define tskNO_AFFINITY 0x7fffffff
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                       UBaseType_t priority, TaskHandle_t *handle);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core);
+// Only a task deleting itself is supported
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t increment);
+TickType_t xTaskGetTickCount();
+TaskHandle_t xTaskGetCurrentTaskHandle();
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+SemaphoreHandle_t xSemaphoreCreateBinary();
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+
+// Tasks created so far with this name, running or finished
+int host_task_count(const char *name);
+
+// Critical sections are a spinlock, as on the dual-core ESP32
+typedef struct
+{
+  int owner;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(mux) host_critical_enter(mux)
+#define portEXIT_CRITICAL(mux) host_critical_exit(mux)
+
+static inline void host_critical_enter(portMUX_TYPE *mux)
+{
+  while (__atomic_exchange_n(&mux->owner, 1, __ATOMIC_ACQUIRE))
+    ;
+}
+
+static inline void host_critical_exit(portMUX_TYPE *mux)
+{
+  __atomic_store_n(&mux->owner, 0, __ATOMIC_RELEASE);
+}
+
+// As on the board, where the core's headers pull it in
+#include "esp_heap_caps.h"
+
+#endif
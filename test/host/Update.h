@@ -0,0 +1,160 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/Update.h
+  Host stand-in for the Arduino Update library: writes the image into
+  the partition after the running one a sector at a time, checks the
+  first byte is the app image magic and switches the boot partition on
+  end(), with the library's error codes and strings
+
+*/
+
+#ifndef HOST_UPDATE_H
+#define HOST_UPDATE_H
+
+#include "esp_ota_ops.h"
+
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+#define U_FLASH 0
+
+#define UPDATE_ERROR_OK 0
+#define UPDATE_ERROR_WRITE 1
+#define UPDATE_ERROR_ERASE 2
+#define UPDATE_ERROR_READ 3
+#define UPDATE_ERROR_SPACE 4
+#define UPDATE_ERROR_SIZE 5
+#define UPDATE_ERROR_STREAM 6
+#define UPDATE_ERROR_MD5 7
+#define UPDATE_ERROR_MAGIC_BYTE 8
+#define UPDATE_ERROR_ACTIVATE 9
+#define UPDATE_ERROR_NO_PARTITION 10
+#define UPDATE_ERROR_BAD_ARGUMENT 11
+#define UPDATE_ERROR_ABORT 12
+
+#define ESP_IMAGE_HEADER_MAGIC 0xE9
+
+class UpdateClass
+{
+public:
+  bool begin(size_t size = UPDATE_SIZE_UNKNOWN, int command = U_FLASH)
+  {
+    if (_size)
+      return false;
+    _reset();
+    _error = UPDATE_ERROR_OK;
+    if (!size)
+    {
+      _error = UPDATE_ERROR_SIZE;
+      return false;
+    }
+    _partition = esp_ota_get_next_update_partition(NULL);
+    if (!_partition)
+    {
+      _error = UPDATE_ERROR_NO_PARTITION;
+      return false;
+    }
+    if (size == UPDATE_SIZE_UNKNOWN)
+      size = _partition->size;
+    else if (size > _partition->size)
+    {
+      _error = UPDATE_ERROR_SIZE;
+      return false;
+    }
+    _size = size;
+    return true;
+  }
+
+  size_t write(uint8_t *data, size_t len)
+  {
+    if (hasError() || !isRunning())
+      return 0;
+    if (len > _size - _progress)
+    {
+      _abort(UPDATE_ERROR_SPACE);
+      return 0;
+    }
+    if (!_progress && len && data[0] != ESP_IMAGE_HEADER_MAGIC)
+    {
+      _abort(UPDATE_ERROR_MAGIC_BYTE);
+      return 0;
+    }
+    // Erase each sector before the first write into it
+    size_t end = _progress + len;
+    for (size_t sector = (_progress + HOST_FLASH_SECTOR - 1) / HOST_FLASH_SECTOR * HOST_FLASH_SECTOR; sector < end;
+         sector += HOST_FLASH_SECTOR)
+    {
+      if (esp_partition_erase_range(_partition, sector, HOST_FLASH_SECTOR) != ESP_OK)
+      {
+        _abort(UPDATE_ERROR_ERASE);
+        return 0;
+      }
+    }
+    if (esp_partition_write(_partition, _progress, data, len) != ESP_OK)
+    {
+      _abort(UPDATE_ERROR_WRITE);
+      return 0;
+    }
+    _progress = end;
+    return len;
+  }
+
+  bool end(bool evenIfRemaining = false)
+  {
+    if (hasError() || !_size)
+      return false;
+    if (!isFinished() && !evenIfRemaining)
+    {
+      _abort(UPDATE_ERROR_ABORT);
+      return false;
+    }
+    if (esp_ota_set_boot_partition(_partition) != ESP_OK)
+    {
+      _abort(UPDATE_ERROR_ACTIVATE);
+      return false;
+    }
+    _reset();
+    return true;
+  }
+
+  void abort()
+  {
+    _abort(UPDATE_ERROR_ABORT);
+  }
+
+  const char *errorString()
+  {
+    static const char *const ERRORS[] = {
+        "No Error", "Flash Write Failed", "Flash Erase Failed", "Flash Read Failed", "Not Enough Space",
+        "Bad Size Given", "Stream Read Timeout", "MD5 Check Failed", "Wrong Magic Byte",
+        "Could Not Activate The Firmware", "Partition Could Not be Found", "Bad Argument", "Aborted"};
+    return _error < sizeof(ERRORS) / sizeof(ERRORS[0]) ? ERRORS[_error] : "UNKNOWN";
+  }
+
+  uint8_t getError() { return _error; }
+  bool hasError() { return _error != UPDATE_ERROR_OK; }
+  bool isRunning() { return _size > 0; }
+  bool isFinished() { return _progress == _size; }
+  size_t size() { return _size; }
+  size_t progress() { return _progress; }
+
+private:
+  void _reset()
+  {
+    _size = 0;
+    _progress = 0;
+  }
+
+  void _abort(uint8_t err)
+  {
+    _reset();
+    _error = err;
+  }
+
+  const esp_partition_t *_partition = NULL;
+  size_t _size = 0;
+  size_t _progress = 0;
+  uint8_t _error = UPDATE_ERROR_OK;
+};
+
+inline UpdateClass Update;
+
+#endif
@@ -0,0 +1,241 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/camera.cpp
+  The fake sensor and JPEG converters behind test/host/esp_camera.h and
+  test/host/img_converters.h
+
+*/
+
+#include "esp_camera.h"
+#include "esp_timer.h"
+#include "img_converters.h"
+#include <mutex>
+
+// Frame buffer wait before esp_camera_fb_get gives up, as in the driver
+#define FB_GET_TIMEOUT_MS 4000
+#define ENCODER_CHUNK 1024
+
+const resolution_info_t resolution[] = {
+  {96, 96}, {160, 120}, {176, 144}, {240, 176}, {240, 240}, {320, 240}, {400, 296}, {480, 320},
+  {640, 480}, {800, 600}, {1024, 768}, {1280, 720}, {1280, 1024}, {1600, 1200}, {1920, 1080},
+  {720, 1280}, {864, 1536}, {2048, 1536}, {2560, 1440}, {2560, 1600}, {1080, 1920}, {2560, 1920},
+};
+
+host_camera_t host_camera = {40000, 30000, 0, false};
+
+static std::mutex camera_lock;
+static bool initialized = false;
+static sensor_t sensor;
+static QueueHandle_t free_fbs = NULL;
+static int64_t last_frame = 0;   // index of the last frame handed out
+
+static int set_pixformat(sensor_t *s, pixformat_t pixformat)
+{
+  s->pixformat = pixformat;
+  return 0;
+}
+
+static int set_framesize(sensor_t *s, framesize_t framesize)
+{
+  if (framesize >= FRAMESIZE_INVALID)
+    return -1;
+  s->status.framesize = framesize;
+  host_camera.set_framesize_calls++;
+  return 0;
+}
+
+static int set_quality(sensor_t *s, int quality)
+{
+  if (quality < 0 || quality > 63)
+    return -1;
+  s->status.quality = quality;
+  host_camera.set_quality_calls++;
+  return 0;
+}
+
+static int set_brightness(sensor_t *s, int level)
+{
+  s->status.brightness = level;
+  return 0;
+}
+
+static int set_saturation(sensor_t *s, int level)
+{
+  s->status.saturation = level;
+  return 0;
+}
+
+static int set_vflip(sensor_t *s, int enable)
+{
+  s->status.vflip = enable;
+  return 0;
+}
+
+static int set_hmirror(sensor_t *s, int enable)
+{
+  s->status.hmirror = enable;
+  return 0;
+}
+
+esp_err_t esp_camera_init(const camera_config_t *config)
+{
+  std::lock_guard<std::mutex> guard(camera_lock);
+  if (initialized || !config->fb_count)
+    return ESP_ERR_INVALID_STATE;
+  sensor = {};
+  sensor.pixformat = config->pixel_format;
+  sensor.status.framesize = config->frame_size;
+  sensor.status.quality = config->jpeg_quality;
+  sensor.set_pixformat = set_pixformat;
+  sensor.set_framesize = set_framesize;
+  sensor.set_quality = set_quality;
+  sensor.set_brightness = set_brightness;
+  sensor.set_saturation = set_saturation;
+  sensor.set_vflip = set_vflip;
+  sensor.set_hmirror = set_hmirror;
+  free_fbs = xQueueCreate(config->fb_count, sizeof(uint8_t));
+  for (size_t i = 0; i < config->fb_count; i++)
+  {
+    uint8_t token = i;
+    xQueueSend(free_fbs, &token, 0);
+  }
+  initialized = true;
+  return ESP_OK;
+}
+
+sensor_t *esp_camera_sensor_get()
+{
+  return initialized ? &sensor : NULL;
+}
+
+uint32_t host_camera_jpeg_len(framesize_t framesize, int quality)
+{
+  return (uint32_t)resolution[framesize].width * resolution[framesize].height / (quality + 2);
+}
+
+// A JPEG whose scan bytes never form a marker, numbered by frame. A
+// baseline SOF segment after SOI carries the frame size, as the sensor's
+// does, when the JPEG is long enough to hold it. Fills bytes offset to
+// offset + n of a JPEG of len bytes, so encoder output can be made a
+// chunk at a time.
+static void jpeg_fill_range(uint8_t *buf, size_t offset, size_t n, size_t len, uint32_t frame, uint16_t width,
+                            uint16_t height)
+{
+  uint8_t head[4 + HOST_JPEG_SOF_LEN] = {0xff, 0xd8, 0xff, 0xc0, 0x00, 0x11, 0x08, (uint8_t)(height >> 8),
+                                         (uint8_t)height, (uint8_t)(width >> 8), (uint8_t)width, 0x03, 0x01,
+                                         0x21, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01};
+  size_t head_len = len < 4 ? 0 : len < 4 + HOST_JPEG_SOF_LEN ? 2 : 2 + HOST_JPEG_SOF_LEN;
+  for (size_t i = offset; i < offset + n; i++)
+  {
+    uint8_t b = (frame + i) & 0x7f;
+    if (i < head_len)
+      b = head[i];
+    else if (len >= 4 && i >= len - 2)
+      b = i == len - 2 ? 0xff : 0xd9;
+    buf[i - offset] = b;
+  }
+}
+
+static void jpeg_fill(uint8_t *buf, size_t len, uint32_t frame, uint16_t width, uint16_t height)
+{
+  jpeg_fill_range(buf, 0, len, len, frame, width, height);
+}
+
+static size_t jpeg_len()
+{
+  if (host_camera.jpeg_len)
+    return host_camera.jpeg_len;
+  return host_camera_jpeg_len(sensor.status.framesize, sensor.status.quality);
+}
+
+camera_fb_t *esp_camera_fb_get()
+{
+  uint8_t token;
+  if (!initialized || host_camera.fail || !xQueueReceive(free_fbs, &token, pdMS_TO_TICKS(FB_GET_TIMEOUT_MS)))
+    return NULL;
+
+  // The next frame the sensor finishes that nobody has had yet
+  int64_t frame, wait;
+  {
+    std::lock_guard<std::mutex> guard(camera_lock);
+    int64_t now = esp_timer_get_time();
+    frame = now / host_camera.frame_us + 1;
+    if (frame <= last_frame)
+      frame = last_frame + 1;
+    last_frame = frame;
+    wait = frame * host_camera.frame_us - now;
+  }
+  host_delay_us(wait);
+
+  camera_fb_t *fb = new camera_fb_t;
+  fb->format = sensor.pixformat;
+  fb->width = resolution[sensor.status.framesize].width;
+  fb->height = resolution[sensor.status.framesize].height;
+  switch (fb->format)
+  {
+    case PIXFORMAT_JPEG: fb->len = jpeg_len(); break;
+    case PIXFORMAT_GRAYSCALE: fb->len = fb->width * fb->height; break;
+    case PIXFORMAT_RGB888: fb->len = fb->width * fb->height * 3; break;
+    default: fb->len = fb->width * fb->height * 2; break;
+  }
+  fb->buf = (uint8_t *)malloc(fb->len);
+  if (fb->format == PIXFORMAT_JPEG)
+    jpeg_fill(fb->buf, fb->len, frame, fb->width, fb->height);
+  else
+    memset(fb->buf, frame & 0xff, fb->len);
+  int64_t captured = frame * host_camera.frame_us;
+  fb->timestamp.tv_sec = captured / 1000000;
+  fb->timestamp.tv_usec = captured % 1000000;
+  __atomic_fetch_add(&host_camera.grabbed, 1, __ATOMIC_RELAXED);
+  return fb;
+}
+
+void esp_camera_fb_return(camera_fb_t *fb)
+{
+  if (!fb)
+    return;
+  free(fb->buf);
+  delete fb;
+  __atomic_fetch_add(&host_camera.returned, 1, __ATOMIC_RELAXED);
+  uint8_t token = 0;
+  xQueueSend(free_fbs, &token, 0);
+}
+
+bool frame2jpg_cb(camera_fb_t *fb, uint8_t quality, jpg_out_cb cb, void *arg)
+{
+  host_delay_us(host_camera.convert_us);
+  size_t len = host_camera.jpeg_len ? host_camera.jpeg_len : host_camera_jpeg_len(sensor.status.framesize, quality);
+  // Made a chunk at a time, so the encoder allocates nothing of its own
+  uint8_t chunk[ENCODER_CHUNK];
+  uint32_t frame = fb->timestamp.tv_sec * 1000000 + fb->timestamp.tv_usec;
+  bool ok = true;
+  for (size_t index = 0; ok && index < len; index += ENCODER_CHUNK)
+  {
+    size_t n = len - index < ENCODER_CHUNK ? len - index : ENCODER_CHUNK;
+    jpeg_fill_range(chunk, index, n, len, frame, fb->width, fb->height);
+    ok = cb(arg, index, chunk, n) == n;
+  }
+  __atomic_fetch_add(&host_camera.converted, 1, __ATOMIC_RELAXED);
+  return ok;
+}
+
+static size_t copy_out(void *arg, size_t index, const void *data, size_t len)
+{
+  memcpy((uint8_t *)arg + index, data, len);
+  return len;
+}
+
+// One buffer for the whole output, malloc'd as the library's is
+bool frame2jpg(camera_fb_t *fb, uint8_t quality, uint8_t **out, size_t *out_len)
+{
+  size_t len = host_camera.jpeg_len ? host_camera.jpeg_len : host_camera_jpeg_len(sensor.status.framesize, quality);
+  uint8_t *jpeg = (uint8_t *)malloc(len);
+  if (!frame2jpg_cb(fb, quality, copy_out, jpeg))
+  {
+    free(jpeg);
+    return false;
+  }
+  *out = jpeg;
+  *out_len = len;
+  return true;
+}
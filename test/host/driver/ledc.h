@@ -0,0 +1,131 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/driver/ledc.h
+  Host stand-in for the LEDC driver: keeps the configuration, pending and
+  latched duty per channel, and counts register calls
+
+*/
+
+#ifndef HOST_DRIVER_LEDC_H
+#define HOST_DRIVER_LEDC_H
+
+#include "Arduino.h"
+
+typedef enum
+{
+  LEDC_LOW_SPEED_MODE,
+} ledc_mode_t;
+
+typedef enum
+{
+  LEDC_CHANNEL_0,
+  LEDC_CHANNEL_1,
+  LEDC_CHANNEL_2,
+  LEDC_CHANNEL_3,
+  LEDC_CHANNEL_4,
+  LEDC_CHANNEL_5,
+  LEDC_CHANNEL_6,
+  LEDC_CHANNEL_7,
+  LEDC_CHANNEL_MAX,
+} ledc_channel_t;
+
+typedef enum
+{
+  LEDC_TIMER_0,
+  LEDC_TIMER_1,
+  LEDC_TIMER_2,
+  LEDC_TIMER_3,
+  LEDC_TIMER_MAX,
+} ledc_timer_t;
+
+typedef enum
+{
+  LEDC_TIMER_8_BIT = 8,
+} ledc_timer_bit_t;
+
+typedef enum
+{
+  LEDC_AUTO_CLK,
+} ledc_clk_cfg_t;
+
+typedef enum
+{
+  LEDC_INTR_DISABLE,
+} ledc_intr_type_t;
+
+typedef struct
+{
+  ledc_mode_t speed_mode;
+  ledc_timer_bit_t duty_resolution;
+  ledc_timer_t timer_num;
+  uint32_t freq_hz;
+  ledc_clk_cfg_t clk_cfg;
+} ledc_timer_config_t;
+
+typedef struct
+{
+  int gpio_num;
+  ledc_mode_t speed_mode;
+  ledc_channel_t channel;
+  ledc_intr_type_t intr_type;
+  ledc_timer_t timer_sel;
+  uint32_t duty;
+  int hpoint;
+  struct
+  {
+    unsigned int output_invert : 1;
+  } flags;
+} ledc_channel_config_t;
+
+typedef struct
+{
+  bool timer_configured[LEDC_TIMER_MAX];
+  ledc_timer_config_t timers[LEDC_TIMER_MAX];
+  bool channel_configured[LEDC_CHANNEL_MAX];
+  ledc_channel_config_t channels[LEDC_CHANNEL_MAX];
+  uint32_t pending[LEDC_CHANNEL_MAX];  // set by ledc_set_duty
+  uint32_t duty[LEDC_CHANNEL_MAX];     // latched by ledc_update_duty
+  uint32_t set_calls;
+  uint32_t update_calls;
+} host_ledc_t;
+
+inline host_ledc_t host_ledc;
+
+static inline esp_err_t ledc_timer_config(const ledc_timer_config_t *config)
+{
+  if (config->timer_num >= LEDC_TIMER_MAX)
+    return ESP_ERR_INVALID_ARG;
+  host_ledc.timer_configured[config->timer_num] = true;
+  host_ledc.timers[config->timer_num] = *config;
+  return ESP_OK;
+}
+
+static inline esp_err_t ledc_channel_config(const ledc_channel_config_t *config)
+{
+  if (config->channel >= LEDC_CHANNEL_MAX)
+    return ESP_ERR_INVALID_ARG;
+  host_ledc.channel_configured[config->channel] = true;
+  host_ledc.channels[config->channel] = *config;
+  host_ledc.pending[config->channel] = host_ledc.duty[config->channel] = config->duty;
+  return ESP_OK;
+}
+
+static inline esp_err_t ledc_set_duty(ledc_mode_t mode, ledc_channel_t channel, uint32_t duty)
+{
+  if (channel >= LEDC_CHANNEL_MAX || !host_ledc.channel_configured[channel])
+    return ESP_ERR_INVALID_STATE;
+  host_ledc.pending[channel] = duty;
+  host_ledc.set_calls++;
+  return ESP_OK;
+}
+
+static inline esp_err_t ledc_update_duty(ledc_mode_t mode, ledc_channel_t channel)
+{
+  if (channel >= LEDC_CHANNEL_MAX || !host_ledc.channel_configured[channel])
+    return ESP_ERR_INVALID_STATE;
+  host_ledc.duty[channel] = host_ledc.pending[channel];
+  host_ledc.update_calls++;
+  return ESP_OK;
+}
+
+#endif
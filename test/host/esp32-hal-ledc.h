@@ -0,0 +1,12 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/esp32-hal-ledc.h
+  Host stand-in for esp32-hal-ledc.h. The sketch drives the LEDC
+  through driver/ledc.h.
+
+*/
+
+#ifndef HOST_ESP32_HAL_LEDC_H
+#define HOST_ESP32_HAL_LEDC_H
+
+#endif
@@ -0,0 +1,158 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/esp_camera.h
+  Host stand-in for the esp32-camera driver: a sensor that finishes a
+  frame every frame_us of host clock time, in JPEG or a raw format, with
+  a limited number of frame buffers. Each esp_camera_fb_get waits for the
+  next frame to finish that nobody has had yet, as with
+  CAMERA_GRAB_LATEST; frames are not queued up while nobody asks.
+
+*/
+
+#ifndef HOST_ESP_CAMERA_H
+#define HOST_ESP_CAMERA_H
+
+#include "Arduino.h"
+#include <sys/time.h>
+
+typedef enum
+{
+  PIXFORMAT_RGB565,
+  PIXFORMAT_YUV422,
+  PIXFORMAT_YUV420,
+  PIXFORMAT_GRAYSCALE,
+  PIXFORMAT_JPEG,
+  PIXFORMAT_RGB888,
+  PIXFORMAT_RAW,
+  PIXFORMAT_RGB444,
+  PIXFORMAT_RGB555,
+} pixformat_t;
+
+typedef enum
+{
+  FRAMESIZE_96X96,
+  FRAMESIZE_QQVGA,
+  FRAMESIZE_QCIF,
+  FRAMESIZE_HQVGA,
+  FRAMESIZE_240X240,
+  FRAMESIZE_QVGA,
+  FRAMESIZE_CIF,
+  FRAMESIZE_HVGA,
+  FRAMESIZE_VGA,
+  FRAMESIZE_SVGA,
+  FRAMESIZE_XGA,
+  FRAMESIZE_HD,
+  FRAMESIZE_SXGA,
+  FRAMESIZE_UXGA,
+  FRAMESIZE_FHD,
+  FRAMESIZE_P_HD,
+  FRAMESIZE_P_3MP,
+  FRAMESIZE_QXGA,
+  FRAMESIZE_QHD,
+  FRAMESIZE_WQXGA,
+  FRAMESIZE_P_FHD,
+  FRAMESIZE_QSXGA,
+  FRAMESIZE_INVALID
+} framesize_t;
+
+typedef struct
+{
+  uint16_t width;
+  uint16_t height;
+} resolution_info_t;
+
+extern const resolution_info_t resolution[];
+
+typedef enum
+{
+  CAMERA_GRAB_WHEN_EMPTY,
+  CAMERA_GRAB_LATEST,
+} camera_grab_mode_t;
+
+typedef enum
+{
+  CAMERA_FB_IN_PSRAM,
+  CAMERA_FB_IN_DRAM,
+} camera_fb_location_t;
+
+typedef struct
+{
+  int pin_pwdn, pin_reset, pin_xclk, pin_sscb_sda, pin_sscb_scl;
+  int pin_d7, pin_d6, pin_d5, pin_d4, pin_d3, pin_d2, pin_d1, pin_d0;
+  int pin_vsync, pin_href, pin_pclk;
+  int xclk_freq_hz;
+  int ledc_timer;
+  int ledc_channel;
+  pixformat_t pixel_format;
+  framesize_t frame_size;
+  int jpeg_quality;
+  size_t fb_count;
+  camera_fb_location_t fb_location;
+  camera_grab_mode_t grab_mode;
+} camera_config_t;
+
+typedef struct
+{
+  uint8_t *buf;
+  size_t len;
+  size_t width;
+  size_t height;
+  pixformat_t format;
+  struct timeval timestamp;
+} camera_fb_t;
+
+typedef struct
+{
+  framesize_t framesize;
+  uint8_t quality;
+  int8_t brightness;
+  int8_t saturation;
+  uint8_t vflip;
+  uint8_t hmirror;
+} camera_status_t;
+
+typedef struct _sensor sensor_t;
+struct _sensor
+{
+  pixformat_t pixformat;
+  camera_status_t status;
+  int (*set_pixformat)(sensor_t *sensor, pixformat_t pixformat);
+  int (*set_framesize)(sensor_t *sensor, framesize_t framesize);
+  int (*set_quality)(sensor_t *sensor, int quality);
+  int (*set_brightness)(sensor_t *sensor, int level);
+  int (*set_saturation)(sensor_t *sensor, int level);
+  int (*set_vflip)(sensor_t *sensor, int enable);
+  int (*set_hmirror)(sensor_t *sensor, int enable);
+};
+
+esp_err_t esp_camera_init(const camera_config_t *config);
+camera_fb_t *esp_camera_fb_get();
+void esp_camera_fb_return(camera_fb_t *fb);
+sensor_t *esp_camera_sensor_get();
+
+// How the fake sensor behaves. Set the fields before esp_camera_init, or
+// between frames.
+typedef struct
+{
+  uint32_t frame_us;     // sensor frame period
+  uint32_t convert_us;   // time frame2jpg takes for one frame
+  uint32_t jpeg_len;     // JPEG size, 0 for width * height / (quality + 2)
+  bool fail;             // esp_camera_fb_get returns NULL
+  // Counters
+  uint32_t grabbed;
+  uint32_t returned;
+  uint32_t converted;
+  uint32_t set_framesize_calls;
+  uint32_t set_quality_calls;
+} host_camera_t;
+
+extern host_camera_t host_camera;
+
+// Bytes of the SOF segment the fake JPEGs carry after SOI; the pattern
+// numbered by frame starts after it
+#define HOST_JPEG_SOF_LEN 19
+
+// JPEG size for a frame of this size at this quality
+uint32_t host_camera_jpeg_len(framesize_t framesize, int quality);
+
+#endif
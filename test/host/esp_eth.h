@@ -0,0 +1,11 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/esp_eth.h
+  Host stand-in for esp_eth.h. The car has no Ethernet.
+
+*/
+
+#ifndef HOST_ESP_ETH_H
+#define HOST_ESP_ETH_H
+
+#endif
@@ -0,0 +1,11 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/esp_event.h
+  Host stand-in for esp_event.h. The sketch registers no event handlers.
+
+*/
+
+#ifndef HOST_ESP_EVENT_H
+#define HOST_ESP_EVENT_H
+
+#endif
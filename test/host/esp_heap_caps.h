@@ -0,0 +1,88 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/esp_heap_caps.h
+  Host stand-in for esp_heap_caps.h. The free heap and PSRAM figures are
+  variables that allocations here move, and that tests can move too to
+  simulate allocations elsewhere.
+
+*/
+
+#ifndef HOST_ESP_HEAP_CAPS_H
+#define HOST_ESP_HEAP_CAPS_H
+
+#include "Arduino.h"
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+inline size_t host_free_heap = 200000;
+inline size_t host_free_psram = 4 * 1024 * 1024;
+// Lowest host_free_heap an allocation here has left
+inline size_t host_min_free_heap = SIZE_MAX;
+
+static inline size_t heap_caps_get_free_size(uint32_t caps)
+{
+  return __atomic_load_n(caps & MALLOC_CAP_SPIRAM ? &host_free_psram : &host_free_heap, __ATOMIC_RELAXED);
+}
+
+// Each block carries its size and caps in front, so free and realloc can
+// give the bytes back to the right figure
+typedef struct
+{
+  size_t size;
+  uint32_t caps;
+  uint32_t pad;
+} host_heap_block_t;
+
+static inline void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+  size_t *free_bytes = caps & MALLOC_CAP_SPIRAM ? &host_free_psram : &host_free_heap;
+  size_t avail = __atomic_load_n(free_bytes, __ATOMIC_RELAXED);
+  do
+  {
+    if (size > avail)
+      return NULL;
+  } while (!__atomic_compare_exchange_n(free_bytes, &avail, avail - size, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+  size_t low = __atomic_load_n(&host_min_free_heap, __ATOMIC_RELAXED);
+  while (free_bytes == &host_free_heap && avail - size < low &&
+         !__atomic_compare_exchange_n(&host_min_free_heap, &low, avail - size, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    ;
+  host_heap_block_t *block = (host_heap_block_t *)malloc(sizeof(host_heap_block_t) + size);
+  block->size = size;
+  block->caps = caps;
+  return block + 1;
+}
+
+static inline void heap_caps_free(void *ptr)
+{
+  if (!ptr)
+    return;
+  host_heap_block_t *block = (host_heap_block_t *)ptr - 1;
+  __atomic_fetch_add(block->caps & MALLOC_CAP_SPIRAM ? &host_free_psram : &host_free_heap, block->size,
+                     __ATOMIC_RELAXED);
+  free(block);
+}
+
+static inline void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+  void *ptr = heap_caps_malloc(n * size, caps);
+  if (ptr)
+    memset(ptr, 0, n * size);
+  return ptr;
+}
+
+static inline void *heap_caps_realloc(void *ptr, size_t size, uint32_t caps)
+{
+  void *grown = heap_caps_malloc(size, caps);
+  if (!grown || !ptr)
+    return grown;
+  host_heap_block_t *block = (host_heap_block_t *)ptr - 1;
+  memcpy(grown, ptr, block->size < size ? block->size : size);
+  heap_caps_free(ptr);
+  return grown;
+}
+
+#endif
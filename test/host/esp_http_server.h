@@ -0,0 +1,254 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/esp_http_server.h
+  Host stand-in for esp_http_server.h. Servers started with httpd_start
+  run their handlers on a server task with the configured priority and
+  stack, one request at a time, and write real HTTP/1.1 responses (plain,
+  chunked or WebSocket frames) to the request's socket through the
+  session's send function. Tests hand requests in with host_httpd_request
+  on a socket of their own, usually one end of a socketpair, and read the
+  response from the other end. Handlers registered on a handle that was
+  never started are called on the caller's thread.
+
+*/
+
+#ifndef HOST_ESP_HTTP_SERVER_H
+#define HOST_ESP_HTTP_SERVER_H
+
+#include "Arduino.h"
+#include "lwip/sockets.h"
+#include <vector>
+
+#define HTTPD_SOCK_ERR_FAIL -1
+#define HTTPD_SOCK_ERR_INVALID -2
+#define HTTPD_SOCK_ERR_TIMEOUT -3
+
+#define ESP_ERR_HTTPD_BASE 0xb000
+#define ESP_ERR_HTTPD_HANDLERS_FULL (ESP_ERR_HTTPD_BASE + 1)
+#define ESP_ERR_HTTPD_HANDLER_EXISTS (ESP_ERR_HTTPD_BASE + 2)
+#define ESP_ERR_HTTPD_INVALID_REQ (ESP_ERR_HTTPD_BASE + 3)
+#define ESP_ERR_HTTPD_RESULT_TRUNC (ESP_ERR_HTTPD_BASE + 4)
+#define ESP_ERR_HTTPD_RESP_HDR (ESP_ERR_HTTPD_BASE + 5)
+#define ESP_ERR_HTTPD_RESP_SEND (ESP_ERR_HTTPD_BASE + 6)
+#define ESP_ERR_HTTPD_ALLOC_MEM (ESP_ERR_HTTPD_BASE + 7)
+#define ESP_ERR_HTTPD_TASK (ESP_ERR_HTTPD_BASE + 8)
+
+#define HTTPD_RESP_USE_STRLEN -1
+
+typedef void *httpd_handle_t;
+
+// http_parser's method numbering. WebSocket data frames reach the handler
+// with method 0, which is how handlers tell them from the handshake.
+typedef enum
+{
+  HTTP_DELETE = 0,
+  HTTP_GET = 1,
+  HTTP_HEAD = 2,
+  HTTP_POST = 3,
+  HTTP_PUT = 4,
+} httpd_method_t;
+
+typedef enum
+{
+  HTTPD_500_INTERNAL_SERVER_ERROR = 0,
+  HTTPD_501_METHOD_NOT_IMPLEMENTED,
+  HTTPD_505_VERSION_NOT_SUPPORTED,
+  HTTPD_400_BAD_REQUEST,
+  HTTPD_401_UNAUTHORIZED,
+  HTTPD_403_FORBIDDEN,
+  HTTPD_404_NOT_FOUND,
+  HTTPD_405_METHOD_NOT_ALLOWED,
+  HTTPD_408_REQ_TIMEOUT,
+  HTTPD_411_LENGTH_REQUIRED,
+  HTTPD_414_URI_TOO_LONG,
+  HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE,
+  HTTPD_ERR_CODE_MAX
+} httpd_err_code_t;
+
+struct host_httpd_exchange;
+
+typedef struct
+{
+  httpd_handle_t handle;
+  int method;
+  const char *uri;
+  size_t content_len;
+  void *user_ctx;
+  int sockfd;                         // host only, see httpd_req_to_sockfd
+  struct host_httpd_exchange *host;   // host only: request data and response state
+} httpd_req_t;
+
+typedef struct
+{
+  const char *uri;
+  httpd_method_t method;
+  esp_err_t (*handler)(httpd_req_t *req);
+  void *user_ctx;
+  bool is_websocket;
+} httpd_uri_t;
+
+typedef struct
+{
+  unsigned task_priority;
+  size_t stack_size;
+  BaseType_t core_id;
+  uint16_t server_port;
+  uint16_t ctrl_port;
+  uint16_t max_open_sockets;
+  uint16_t max_uri_handlers;
+  uint16_t max_resp_headers;
+  uint16_t backlog_conn;
+  bool lru_purge_enable;
+  uint16_t recv_wait_timeout;
+  uint16_t send_wait_timeout;
+  bool keep_alive_enable;
+  int keep_alive_idle;
+  int keep_alive_interval;
+  int keep_alive_count;
+} httpd_config_t;
+
+static inline httpd_config_t host_httpd_default_config()
+{
+  httpd_config_t config = {};
+  config.task_priority = tskIDLE_PRIORITY + 5;
+  config.stack_size = 4096;
+  config.core_id = tskNO_AFFINITY;
+  config.server_port = 80;
+  config.ctrl_port = 32768;
+  config.max_open_sockets = 7;
+  config.max_uri_handlers = 8;
+  config.max_resp_headers = 8;
+  config.backlog_conn = 5;
+  config.recv_wait_timeout = 5;
+  config.send_wait_timeout = 5;
+  return config;
+}
+#define HTTPD_DEFAULT_CONFIG() host_httpd_default_config()
+
+typedef enum
+{
+  HTTPD_WS_TYPE_CONTINUE = 0x0,
+  HTTPD_WS_TYPE_TEXT = 0x1,
+  HTTPD_WS_TYPE_BINARY = 0x2,
+  HTTPD_WS_TYPE_CLOSE = 0x8,
+  HTTPD_WS_TYPE_PING = 0x9,
+  HTTPD_WS_TYPE_PONG = 0xA,
+} httpd_ws_type_t;
+
+typedef struct
+{
+  bool final;
+  bool fragmented;
+  httpd_ws_type_t type;
+  uint8_t *payload;
+  size_t len;
+} httpd_ws_frame_t;
+
+typedef int (*httpd_send_func_t)(httpd_handle_t hd, int sockfd, const char *buf, size_t len, int flags);
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config);
+esp_err_t httpd_stop(httpd_handle_t handle);
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri);
+esp_err_t httpd_get_client_list(httpd_handle_t handle, size_t *fds, int *client_fds);
+esp_err_t httpd_sess_set_send_override(httpd_handle_t hd, int sockfd, httpd_send_func_t fn);
+int httpd_req_to_sockfd(httpd_req_t *req);
+
+size_t httpd_req_get_url_query_len(httpd_req_t *req);
+esp_err_t httpd_req_get_url_query_str(httpd_req_t *req, char *buf, size_t buf_len);
+esp_err_t httpd_query_key_value(const char *qry, const char *key, char *val, size_t val_size);
+size_t httpd_req_get_hdr_value_len(httpd_req_t *req, const char *field);
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *req, const char *field, char *val, size_t val_size);
+int httpd_req_recv(httpd_req_t *req, char *buf, size_t buf_len);
+
+esp_err_t httpd_resp_set_status(httpd_req_t *req, const char *status);
+esp_err_t httpd_resp_set_type(httpd_req_t *req, const char *type);
+esp_err_t httpd_resp_set_hdr(httpd_req_t *req, const char *field, const char *value);
+esp_err_t httpd_resp_send(httpd_req_t *req, const char *buf, ssize_t buf_len);
+esp_err_t httpd_resp_send_chunk(httpd_req_t *req, const char *buf, ssize_t buf_len);
+esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *message);
+
+static inline esp_err_t httpd_resp_sendstr(httpd_req_t *req, const char *str)
+{
+  return httpd_resp_send(req, str, str ? (ssize_t)strlen(str) : 0);
+}
+
+static inline esp_err_t httpd_resp_sendstr_chunk(httpd_req_t *req, const char *str)
+{
+  return httpd_resp_send_chunk(req, str, str ? (ssize_t)strlen(str) : 0);
+}
+
+static inline esp_err_t httpd_resp_send_404(httpd_req_t *req)
+{
+  return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, NULL);
+}
+
+static inline esp_err_t httpd_resp_send_500(httpd_req_t *req)
+{
+  return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+}
+
+// Keep the request after the handler returns, for a task that goes on
+// sending on it; complete releases the copy
+esp_err_t httpd_req_async_handler_begin(httpd_req_t *req, httpd_req_t **out);
+esp_err_t httpd_req_async_handler_complete(httpd_req_t *req);
+
+esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *frame, size_t max_len);
+esp_err_t httpd_ws_send_frame(httpd_req_t *req, httpd_ws_frame_t *frame);
+
+// Host side
+
+typedef struct
+{
+  httpd_handle_t server;
+  httpd_uri_t uri;
+} host_httpd_route_t;
+
+typedef struct
+{
+  std::vector<host_httpd_route_t> routes;
+  httpd_send_func_t send_override[64];
+  uint32_t purged;     // sessions closed by LRU purge
+  uint32_t refused;    // requests turned away with every socket taken
+} host_httpd_t;
+
+extern host_httpd_t host_httpd;
+
+// A request as it arrives from a client
+typedef struct
+{
+  httpd_method_t method;
+  const char *uri;          // path, optionally followed by ?query
+  const char *headers;      // "Name: value\r\n" lines, or NULL
+  const void *body;
+  size_t body_len;
+  bool ws_frame;            // a data frame on a WebSocket session instead
+  httpd_ws_type_t ws_type;
+} host_httpd_request_t;
+
+// Handle request on sockfd as the server would: open a session for the
+// socket (purging the least recently used one or refusing the request
+// when the server is full), route it and run the handler. On a started
+// server this hands the request to the server task and waits for it,
+// moving a frozen clock on in 1 ms steps while it does. Returns what the
+// handler returned, or ESP_ERR_NOT_FOUND without a matching handler.
+esp_err_t host_httpd_request(httpd_handle_t server, int sockfd, const host_httpd_request_t *request);
+
+// Handler CPU time of the last request host_httpd_request completed
+int64_t host_httpd_last_cpu_ns();
+
+static inline esp_err_t host_httpd_call(httpd_handle_t server, httpd_method_t method, const char *uri, int sockfd)
+{
+  host_httpd_request_t request = {};
+  request.method = method;
+  request.uri = uri;
+  return host_httpd_request(server, sockfd, &request);
+}
+
+// The peer of sockfd went away; its session is closed
+void host_httpd_close(httpd_handle_t server, int sockfd);
+
+// Everything the server writes to a socket, response helpers and async
+// senders alike, goes through the session's send function
+int host_httpd_send(httpd_handle_t hd, int sockfd, const char *buf, size_t len);
+
+#endif
@@ -0,0 +1,12 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/esp_log.h
+  Host stand-in for esp_log.h. The sketch logs through Serial and
+  deferred_log instead.
+
+*/
+
+#ifndef HOST_ESP_LOG_H
+#define HOST_ESP_LOG_H
+
+#endif
@@ -0,0 +1,12 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/esp_netif.h
+  Host stand-in for esp_netif.h. Networking on the host is plain
+  POSIX sockets, see lwip/sockets.h.
+
+*/
+
+#ifndef HOST_ESP_NETIF_H
+#define HOST_ESP_NETIF_H
+
+#endif
@@ -0,0 +1,46 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/esp_ota_ops.h
+  Host stand-in for the esp_ota_ops.h calls that pick partitions, over
+  the two app partitions in esp_partition.h
+
+*/
+
+#ifndef HOST_ESP_OTA_OPS_H
+#define HOST_ESP_OTA_OPS_H
+
+#include "esp_partition.h"
+
+static inline const esp_partition_t *esp_ota_get_running_partition()
+{
+  host_flash_t *flash = host_flash_get();
+  return &flash->app[flash->running];
+}
+
+static inline const esp_partition_t *esp_ota_get_boot_partition()
+{
+  host_flash_t *flash = host_flash_get();
+  return &flash->app[flash->boot];
+}
+
+static inline const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from)
+{
+  host_flash_t *flash = host_flash_get();
+  return &flash->app[1 - flash->running];
+}
+
+static inline esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition)
+{
+  host_flash_t *flash = host_flash_get();
+  for (int i = 0; i < 2; i++)
+  {
+    if (partition == &flash->app[i])
+    {
+      flash->boot = i;
+      return ESP_OK;
+    }
+  }
+  return ESP_ERR_NOT_FOUND;
+}
+
+#endif
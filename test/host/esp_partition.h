@@ -0,0 +1,131 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/esp_partition.h
+  Host stand-in for esp_partition.h: two OTA app partitions, each backed
+  by a temporary file that starts out erased. Tests load the running
+  image with host_flash_load and read what an update wrote back out of
+  the file.
+
+*/
+
+#ifndef HOST_ESP_PARTITION_H
+#define HOST_ESP_PARTITION_H
+
+#include "Arduino.h"
+#include <unistd.h>
+
+// The ota_0 and ota_1 sizes of the sketch's partition table
+#define HOST_FLASH_APP_SIZE 0x140000
+#define HOST_FLASH_SECTOR 4096
+
+typedef enum
+{
+  ESP_PARTITION_TYPE_APP = 0x00,
+  ESP_PARTITION_TYPE_DATA = 0x01,
+} esp_partition_type_t;
+
+typedef enum
+{
+  ESP_PARTITION_SUBTYPE_APP_OTA_0 = 0x10,
+  ESP_PARTITION_SUBTYPE_APP_OTA_1 = 0x11,
+} esp_partition_subtype_t;
+
+typedef struct
+{
+  esp_partition_type_t type;
+  esp_partition_subtype_t subtype;
+  uint32_t address;
+  uint32_t size;
+  char label[17];
+  int fd;              // host only: the file behind the partition
+} esp_partition_t;
+
+typedef struct
+{
+  esp_partition_t app[2];
+  int running;             // index into app
+  int boot;                // partition the next restart boots
+  uint32_t sector_write_us;  // host clock time one sector write takes
+  size_t fail_write_at;    // writes reaching this offset fail, SIZE_MAX for never
+  uint32_t writes;
+} host_flash_t;
+
+inline host_flash_t host_flash = {{}, 0, 0, 0, SIZE_MAX, 0};
+
+// Create the partition files on first use. Not static, so every
+// translation unit shares the one set.
+inline host_flash_t *host_flash_get()
+{
+  static bool ready = [] {
+    uint8_t erased[HOST_FLASH_SECTOR];
+    memset(erased, 0xff, sizeof(erased));
+    for (int i = 0; i < 2; i++)
+    {
+      esp_partition_t *p = &host_flash.app[i];
+      p->type = ESP_PARTITION_TYPE_APP;
+      p->subtype = (esp_partition_subtype_t)(ESP_PARTITION_SUBTYPE_APP_OTA_0 + i);
+      p->address = 0x10000 + i * HOST_FLASH_APP_SIZE;
+      p->size = HOST_FLASH_APP_SIZE;
+      snprintf(p->label, sizeof(p->label), "app%d", i);
+      FILE *f = tmpfile();
+      p->fd = f ? fileno(f) : -1;
+      for (uint32_t pos = 0; p->fd >= 0 && pos < p->size; pos += HOST_FLASH_SECTOR)
+        if (pwrite(p->fd, erased, HOST_FLASH_SECTOR, pos) != HOST_FLASH_SECTOR)
+          p->fd = -1;
+    }
+    return true;
+  }();
+  (void)ready;
+  return &host_flash;
+}
+
+static inline esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+  if (!partition || partition->fd < 0 || src_offset + size > partition->size)
+    return ESP_ERR_INVALID_ARG;
+  return pread(partition->fd, dst, size, src_offset) == (ssize_t)size ? ESP_OK : ESP_FAIL;
+}
+
+// Flash can only clear bits; write over erased sectors
+static inline esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src,
+                                            size_t size)
+{
+  if (!partition || partition->fd < 0 || dst_offset + size > partition->size)
+    return ESP_ERR_INVALID_ARG;
+  if (dst_offset + size > host_flash.fail_write_at)
+    return ESP_FAIL;
+  if (host_flash.sector_write_us)
+    host_delay_us((int64_t)host_flash.sector_write_us * ((size + HOST_FLASH_SECTOR - 1) / HOST_FLASH_SECTOR));
+  __atomic_fetch_add(&host_flash.writes, 1, __ATOMIC_RELAXED);
+  return pwrite(partition->fd, src, size, dst_offset) == (ssize_t)size ? ESP_OK : ESP_FAIL;
+}
+
+static inline esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+  if (!partition || partition->fd < 0 || offset + size > partition->size || offset % HOST_FLASH_SECTOR ||
+      size % HOST_FLASH_SECTOR)
+    return ESP_ERR_INVALID_ARG;
+  uint8_t sector[HOST_FLASH_SECTOR];
+  memset(sector, 0xff, sizeof(sector));
+  for (size_t pos = offset; pos < offset + size; pos += HOST_FLASH_SECTOR)
+    if (pwrite(partition->fd, sector, HOST_FLASH_SECTOR, pos) != HOST_FLASH_SECTOR)
+      return ESP_FAIL;
+  return ESP_OK;
+}
+
+// Put image at the start of the running partition, as if it had been flashed
+static inline bool host_flash_load(const uint8_t *image, size_t len)
+{
+  host_flash_t *flash = host_flash_get();
+  const esp_partition_t *p = &flash->app[flash->running];
+  return len <= p->size && pwrite(p->fd, image, len, 0) == (ssize_t)len;
+}
+
+// Restart into the boot partition
+static inline void host_flash_reboot()
+{
+  host_flash_t *flash = host_flash_get();
+  flash->running = flash->boot;
+}
+
+#endif
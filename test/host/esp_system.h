@@ -0,0 +1,25 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/esp_system.h
+  Host stand-in for esp_system.h: heap figures from esp_heap_caps.h
+
+*/
+
+#ifndef HOST_ESP_SYSTEM_H
+#define HOST_ESP_SYSTEM_H
+
+#include "Arduino.h"
+
+static inline uint32_t esp_get_free_heap_size()
+{
+  return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+static inline uint32_t esp_get_minimum_free_heap_size()
+{
+  size_t now = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  size_t low = __atomic_load_n(&host_min_free_heap, __ATOMIC_RELAXED);
+  return low < now ? low : now;
+}
+
+#endif
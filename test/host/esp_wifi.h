@@ -0,0 +1,38 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/esp_wifi.h
+  Host stand-in for the soft AP station list in esp_wifi.h. Tests fill
+  host_wifi_stations with the stations they want connected.
+
+*/
+
+#ifndef HOST_ESP_WIFI_H
+#define HOST_ESP_WIFI_H
+
+#include "Arduino.h"
+
+#define ESP_WIFI_MAX_CONN_NUM 15
+
+typedef struct
+{
+  uint8_t mac[6];
+  int8_t rssi;
+} wifi_sta_info_t;
+
+typedef struct
+{
+  wifi_sta_info_t sta[ESP_WIFI_MAX_CONN_NUM];
+  int num;
+} wifi_sta_list_t;
+
+inline wifi_sta_list_t host_wifi_stations;
+
+static inline esp_err_t esp_wifi_ap_get_sta_list(wifi_sta_list_t *sta)
+{
+  if (!sta)
+    return ESP_ERR_INVALID_ARG;
+  *sta = host_wifi_stations;
+  return ESP_OK;
+}
+
+#endif
@@ -0,0 +1,11 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/fb_gfx.h
+  Host stand-in for fb_gfx.h. Nothing in the sketch draws on frames.
+
+*/
+
+#ifndef HOST_FB_GFX_H
+#define HOST_FB_GFX_H
+
+#endif
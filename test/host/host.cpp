@@ -0,0 +1,640 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/host.cpp
+  Host implementations of the Arduino, FreeRTOS and esp_timer calls
+  declared in test/host/Arduino.h and test/host/esp_timer.h
+
+*/
+
+#include "Arduino.h"
+#include "esp_timer.h"
+#include <stdarg.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+HardwareSerial Serial;
+EspClass ESP;
+volatile uint32_t host_restarts = 0;
+
+static const auto started = std::chrono::steady_clock::now();
+static std::mutex serial_lock;
+static std::string serial_output;
+
+const char *esp_err_to_name(esp_err_t err)
+{
+  switch (err)
+  {
+    case ESP_OK: return "ESP_OK";
+    case ESP_FAIL: return "ESP_FAIL";
+    case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+    default: return "UNKNOWN ERROR";
+  }
+}
+
+size_t HardwareSerial::printf(const char *fmt, ...)
+{
+  char buf[512];
+  va_list args;
+  va_start(args, fmt);
+  int len = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  print(buf);
+  return len;
+}
+
+size_t HardwareSerial::print(const char *s)
+{
+  std::lock_guard<std::mutex> guard(serial_lock);
+  serial_output += s;
+  return strlen(s);
+}
+
+size_t HardwareSerial::println(const char *s)
+{
+  std::lock_guard<std::mutex> guard(serial_lock);
+  serial_output += s;
+  serial_output += '\n';
+  return strlen(s) + 1;
+}
+
+std::string host_serial_take()
+{
+  std::lock_guard<std::mutex> guard(serial_lock);
+  std::string out;
+  out.swap(serial_output);
+  return out;
+}
+
+void EspClass::restart()
+{
+  host_restarts++;
+}
+
+static uint8_t pin_level[64];
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  if (pin < 64)
+    pin_level[pin] = value;
+}
+
+int host_pin_level(uint8_t pin)
+{
+  return pin < 64 ? pin_level[pin] : LOW;
+}
+
+// Kernel. Every task, queue, semaphore and timer shares one lock. A waiter
+// blocks on `changed` and rechecks its condition whenever anything it could
+// be waiting for changes. Tasks created with xTaskCreate count as running
+// until they block, so host_clock_advance can wait on `settled` for all of
+// them to block before it moves the clock again.
+
+#define NO_DEADLINE INT64_MAX
+#define REAL_WAIT std::chrono::milliseconds(10)
+#define SETTLE_LIMIT std::chrono::seconds(5)
+
+struct host_task
+{
+  std::string name;
+  UBaseType_t priority;
+  uint32_t stack;
+  bool tracked;      // created with xTaskCreate, counted by the clock
+  bool blocked;      // waiting in the kernel until woken
+  bool finished;
+  int64_t wake_us;   // blocked until this time, or NO_DEADLINE
+  uint32_t notify;
+};
+
+enum host_queue_kind
+{
+  HOST_QUEUE,
+  HOST_MUTEX,
+  HOST_BINARY,
+};
+
+struct host_queue
+{
+  host_queue_kind kind;
+  UBaseType_t length;
+  UBaseType_t item_size;
+  // Queues keep length items in a ring allocated up front, as FreeRTOS
+  // does, so sending and receiving allocate nothing
+  std::vector<uint8_t> ring;
+  UBaseType_t head;
+  UBaseType_t count;   // items waiting, or the semaphore count
+};
+
+struct esp_timer
+{
+  esp_timer_cb_t callback;
+  void *arg;
+  const char *name;
+  int64_t expiry_us;   // -1 while stopped
+  uint64_t period_us;  // 0 for one-shot
+  bool deleted;
+};
+
+// Leaked on purpose, so detached tasks can still use them during exit
+static std::mutex &kernel = *new std::mutex;
+static std::condition_variable &changed = *new std::condition_variable;
+static std::condition_variable &settled = *new std::condition_variable;
+static std::vector<host_task *> &tasks = *new std::vector<host_task *>;
+static std::vector<esp_timer *> &timers = *new std::vector<esp_timer *>;
+static std::mutex &threads_lock = *new std::mutex;
+static std::vector<host_task *> &threads = *new std::vector<host_task *>;
+static int running = 0;
+static bool frozen = false;
+static int64_t virtual_us = 0;
+static bool dispatcher_started = false;
+static thread_local host_task *current = NULL;
+
+struct host_task_exit
+{
+};
+
+static int64_t real_us()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count();
+}
+
+static int64_t now_us()
+{
+  std::lock_guard<std::mutex> guard(kernel);
+  return frozen ? virtual_us : real_us();
+}
+
+static int64_t now_locked()
+{
+  return frozen ? virtual_us : real_us();
+}
+
+static host_task *current_task()
+{
+  if (!current)
+  {
+    // Threads the kernel did not start: the test's main thread, httpd
+    // sessions, the timer dispatcher. They wait but the clock ignores them.
+    // Kept for good, as handles to them may outlive the thread.
+    current = new host_task{"thread", 1, 0, false, false, false, NO_DEADLINE, 0};
+    std::lock_guard<std::mutex> guard(threads_lock);
+    threads.push_back(current);
+  }
+  return current;
+}
+
+// Wake every waiter to recheck its condition. Called with the kernel lock.
+static void kernel_changed()
+{
+  for (host_task *t : tasks)
+    if (t->blocked)
+    {
+      t->blocked = false;
+      running++;
+    }
+  changed.notify_all();
+}
+
+static int64_t deadline_after(TickType_t ticks)
+{
+  if (ticks == portMAX_DELAY)
+    return NO_DEADLINE;
+  return now_locked() + (int64_t)ticks * 1000;
+}
+
+// How long a waiter sleeps before it rechecks: REAL_WAIT, or on a running
+// clock until its deadline if that comes sooner
+static std::chrono::microseconds recheck_after(int64_t deadline_us)
+{
+  std::chrono::microseconds wait = REAL_WAIT;
+  if (!frozen && deadline_us - real_us() < wait.count())
+    wait = std::chrono::microseconds(std::max<int64_t>(deadline_us - real_us(), 0));
+  return wait;
+}
+
+// Block until ready() or deadline_us. Returns ready(). Called with the
+// kernel lock, which is released while blocked.
+template <typename F> static bool kernel_wait(std::unique_lock<std::mutex> &lock, int64_t deadline_us, F ready)
+{
+  host_task *t = current_task();
+  for (;;)
+  {
+    if (ready())
+      return true;
+    if (now_locked() >= deadline_us)
+      return false;
+    t->wake_us = deadline_us;
+    if (!t->tracked)
+    {
+      changed.wait_for(lock, recheck_after(deadline_us));
+      continue;
+    }
+    t->blocked = true;
+    running--;
+    settled.notify_all();
+    if (frozen)
+      changed.wait(lock, [t] { return !t->blocked; });
+    else
+      changed.wait_for(lock, recheck_after(deadline_us), [t] { return !t->blocked; });
+    if (t->blocked)
+    {
+      t->blocked = false;
+      running++;
+    }
+  }
+}
+
+unsigned long millis()
+{
+  return now_us() / 1000;
+}
+
+unsigned long micros()
+{
+  return now_us();
+}
+
+int64_t esp_timer_get_time()
+{
+  return now_us();
+}
+
+void delay(uint32_t ms)
+{
+  vTaskDelay(ms);
+}
+
+bool host_clock_frozen()
+{
+  std::lock_guard<std::mutex> guard(kernel);
+  return frozen;
+}
+
+void host_clock_freeze(int64_t us)
+{
+  std::lock_guard<std::mutex> guard(kernel);
+  frozen = true;
+  virtual_us = us;
+  kernel_changed();
+}
+
+// Wait until every task is blocked. A task stuck outside the kernel would
+// hang the test, so give up after a while and say which tasks are running.
+static void settle(std::unique_lock<std::mutex> &lock)
+{
+  if (settled.wait_for(lock, SETTLE_LIMIT, [] { return running == 0; }))
+    return;
+  fprintf(stderr, "host_clock_advance: tasks still running at %lld us:", (long long)virtual_us);
+  for (host_task *t : tasks)
+    if (t->tracked && !t->blocked && !t->finished)
+      fprintf(stderr, " %s", t->name.c_str());
+  fprintf(stderr, "\n");
+  abort();
+}
+
+static esp_timer *next_timer()
+{
+  esp_timer *next = NULL;
+  for (esp_timer *timer : timers)
+    if (timer->expiry_us >= 0 && (!next || timer->expiry_us < next->expiry_us))
+      next = timer;
+  return next;
+}
+
+// Disarm or re-arm a due timer and run its callback without the lock
+static void fire(std::unique_lock<std::mutex> &lock, esp_timer *timer)
+{
+  if (timer->period_us)
+    timer->expiry_us += timer->period_us;
+  else
+    timer->expiry_us = -1;
+  lock.unlock();
+  timer->callback(timer->arg);
+  lock.lock();
+  kernel_changed();
+}
+
+void host_clock_advance(int64_t us)
+{
+  std::unique_lock<std::mutex> lock(kernel);
+  if (!frozen)
+  {
+    fprintf(stderr, "host_clock_advance: the clock is not frozen\n");
+    abort();
+  }
+  int64_t target = virtual_us + us;
+  for (;;)
+  {
+    settle(lock);
+    esp_timer *timer = next_timer();
+    if (timer && timer->expiry_us <= virtual_us)
+    {
+      fire(lock, timer);
+      continue;
+    }
+    if (virtual_us >= target)
+      break;
+    int64_t next = target;
+    if (timer && timer->expiry_us < next)
+      next = timer->expiry_us;
+    for (host_task *t : tasks)
+      if (t->blocked && t->wake_us < next)
+        next = t->wake_us;
+    virtual_us = next > virtual_us ? next : virtual_us + 1;
+    kernel_changed();
+  }
+}
+
+// Fires timers in real time; does nothing while the clock is frozen
+static void timer_dispatcher()
+{
+  std::unique_lock<std::mutex> lock(kernel);
+  for (;;)
+  {
+    esp_timer *timer = next_timer();
+    if (!frozen && timer && timer->expiry_us <= real_us())
+    {
+      fire(lock, timer);
+      continue;
+    }
+    auto wait = REAL_WAIT;
+    if (!frozen && timer)
+      wait = std::min(wait, std::chrono::duration_cast<std::chrono::milliseconds>(
+                                std::chrono::microseconds(timer->expiry_us - real_us() + 999)));
+    changed.wait_for(lock, wait);
+  }
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle)
+{
+  std::lock_guard<std::mutex> guard(kernel);
+  if (!args || !args->callback || !handle)
+    return ESP_ERR_INVALID_ARG;
+  esp_timer *timer = new esp_timer{args->callback, args->arg, args->name, -1, 0, false};
+  timers.push_back(timer);
+  *handle = timer;
+  if (!dispatcher_started)
+  {
+    dispatcher_started = true;
+    std::thread(timer_dispatcher).detach();
+  }
+  return ESP_OK;
+}
+
+static esp_err_t timer_start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us)
+{
+  std::lock_guard<std::mutex> guard(kernel);
+  if (!timer || timer->deleted)
+    return ESP_ERR_INVALID_ARG;
+  if (timer->expiry_us >= 0)
+    return ESP_ERR_INVALID_STATE;
+  timer->expiry_us = now_locked() + timeout_us;
+  timer->period_us = period_us;
+  kernel_changed();
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+  return timer_start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+  return timer_start(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+  std::lock_guard<std::mutex> guard(kernel);
+  if (!timer || timer->deleted)
+    return ESP_ERR_INVALID_ARG;
+  if (timer->expiry_us < 0)
+    return ESP_ERR_INVALID_STATE;
+  timer->expiry_us = -1;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+  std::lock_guard<std::mutex> guard(kernel);
+  if (!timer || timer->deleted)
+    return ESP_ERR_INVALID_ARG;
+  if (timer->expiry_us >= 0)
+    return ESP_ERR_INVALID_STATE;
+  // Kept allocated, the dispatcher may still be looking at it
+  timer->deleted = true;
+  return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+  std::lock_guard<std::mutex> guard(kernel);
+  return timer && timer->expiry_us >= 0;
+}
+
+int64_t host_esp_timer_due(esp_timer_handle_t timer)
+{
+  std::lock_guard<std::mutex> guard(kernel);
+  return timer ? timer->expiry_us : -1;
+}
+
+static void task_main(host_task *t, TaskFunction_t fn, void *arg)
+{
+  current = t;
+  try
+  {
+    fn(arg);
+  }
+  catch (host_task_exit &)
+  {
+  }
+  std::lock_guard<std::mutex> guard(kernel);
+  t->finished = true;
+  running--;
+  settled.notify_all();
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                       UBaseType_t priority, TaskHandle_t *handle)
+{
+  host_task *t = new host_task{name ? name : "", priority, stack, true, false, false, NO_DEADLINE, 0};
+  {
+    std::lock_guard<std::mutex> guard(kernel);
+    tasks.push_back(t);
+    running++;
+  }
+  if (handle)
+    *handle = t;
+  std::thread(task_main, t, fn, arg).detach();
+  return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core)
+{
+  return xTaskCreate(fn, name, stack, arg, priority, handle);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+  if (task && task != current_task())
+  {
+    fprintf(stderr, "vTaskDelete: only a task deleting itself is supported\n");
+    abort();
+  }
+  throw host_task_exit();
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+  std::unique_lock<std::mutex> lock(kernel);
+  kernel_wait(lock, deadline_after(ticks), [] { return false; });
+}
+
+void host_delay_us(int64_t us)
+{
+  std::unique_lock<std::mutex> lock(kernel);
+  kernel_wait(lock, now_locked() + us, [] { return false; });
+}
+
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t increment)
+{
+  std::unique_lock<std::mutex> lock(kernel);
+  *previous_wake += increment;
+  kernel_wait(lock, (int64_t)*previous_wake * 1000, [] { return false; });
+}
+
+TickType_t xTaskGetTickCount()
+{
+  return now_us() / 1000;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+  return current_task();
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task)
+{
+  return (task ? task : current_task())->priority;
+}
+
+// No stack to measure on the host; report half the requested size
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+  return (task ? task : current_task())->stack / 2;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+  std::lock_guard<std::mutex> guard(kernel);
+  task->notify++;
+  kernel_changed();
+  return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+  host_task *t = current_task();
+  std::unique_lock<std::mutex> lock(kernel);
+  if (!kernel_wait(lock, deadline_after(ticks), [t] { return t->notify > 0; }))
+    return 0;
+  uint32_t value = t->notify;
+  t->notify = clear ? 0 : value - 1;
+  return value;
+}
+
+int host_task_count(const char *name)
+{
+  std::lock_guard<std::mutex> guard(kernel);
+  int count = 0;
+  for (host_task *t : tasks)
+    count += t->name == name;
+  return count;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+  return new host_queue{HOST_QUEUE, length, item_size, std::vector<uint8_t>(length * item_size), 0, 0};
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+  delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+  std::unique_lock<std::mutex> lock(kernel);
+  if (!kernel_wait(lock, deadline_after(ticks), [queue] { return queue->count < queue->length; }))
+    return pdFALSE;
+  UBaseType_t tail = (queue->head + queue->count) % queue->length;
+  memcpy(queue->ring.data() + tail * queue->item_size, item, queue->item_size);
+  queue->count++;
+  kernel_changed();
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+  std::unique_lock<std::mutex> lock(kernel);
+  if (!kernel_wait(lock, deadline_after(ticks), [queue] { return queue->count > 0; }))
+    return pdFALSE;
+  memcpy(item, queue->ring.data() + queue->head * queue->item_size, queue->item_size);
+  queue->head = (queue->head + 1) % queue->length;
+  queue->count--;
+  kernel_changed();
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+  std::lock_guard<std::mutex> guard(kernel);
+  return queue->count;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+  return new host_queue{HOST_MUTEX, 1, 0, {}, 0, 1};
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+  return new host_queue{HOST_BINARY, 1, 0, {}, 0, 0};
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+  delete sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+  std::unique_lock<std::mutex> lock(kernel);
+  if (!kernel_wait(lock, deadline_after(ticks), [sem] { return sem->count > 0; }))
+    return pdFALSE;
+  sem->count--;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+  std::lock_guard<std::mutex> guard(kernel);
+  if (sem->count >= sem->length)
+    return pdFALSE;
+  sem->count++;
+  kernel_changed();
+  return pdTRUE;
+}
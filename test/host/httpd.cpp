@@ -0,0 +1,642 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/httpd.cpp
+  The HTTP server behind test/host/esp_http_server.h: server tasks,
+  sessions with LRU purge, routing, request accessors and response
+  writers
+
+*/
+
+#include "esp_http_server.h"
+#include <strings.h>
+#include <time.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+
+#define REQUEST_STEP_US 1000
+
+host_httpd_t host_httpd;
+
+struct host_httpd_exchange
+{
+  std::string path;
+  std::string query;
+  bool has_query;
+  std::string headers;
+  std::string body;
+  size_t body_pos;
+  bool ws_frame;
+  httpd_ws_type_t ws_type;
+  // Response
+  uint16_t max_resp_headers;
+  std::string status;
+  std::string type;
+  std::vector<std::pair<std::string, std::string>> resp_headers;
+  bool chunked;     // headers went out with Transfer-Encoding: chunked
+};
+
+typedef struct
+{
+  int fd;
+  uint64_t used;
+} session_t;
+
+typedef struct
+{
+  httpd_config_t config;
+  QueueHandle_t jobs;
+  std::vector<session_t> sessions;
+  uint64_t uses;
+  size_t handlers;
+} server_t;
+
+typedef struct
+{
+  httpd_handle_t server;
+  httpd_req_t req;
+  host_httpd_exchange exchange;
+  esp_err_t result;
+  int64_t cpu_ns;
+  std::atomic<bool> done;
+  SemaphoreHandle_t finished;
+} job_t;
+
+// Leaked on purpose, async senders may outlive main
+static std::mutex &httpd_lock = *new std::mutex;
+static std::vector<server_t *> &servers = *new std::vector<server_t *>;
+static std::atomic<int64_t> last_cpu_ns(0);
+
+// Started server behind handle, or NULL for a handle tests made up
+static server_t *find_server(httpd_handle_t handle)
+{
+  for (server_t *s : servers)
+    if (s == handle)
+      return s;
+  return NULL;
+}
+
+static int64_t thread_cpu_ns()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Same behaviour as the httpd default send function
+static int default_send(httpd_handle_t hd, int sockfd, const char *buf, size_t len, int flags)
+{
+  if (!buf)
+    return HTTPD_SOCK_ERR_INVALID;
+  int ret = send(sockfd, buf, len, flags);
+  if (ret < 0)
+    return errno == EAGAIN || errno == EINTR ? HTTPD_SOCK_ERR_TIMEOUT : HTTPD_SOCK_ERR_FAIL;
+  return ret;
+}
+
+int host_httpd_send(httpd_handle_t hd, int sockfd, const char *buf, size_t len)
+{
+  httpd_send_func_t fn = default_send;
+  if (sockfd >= 0 && sockfd < 64)
+  {
+    httpd_send_func_t override = __atomic_load_n(&host_httpd.send_override[sockfd], __ATOMIC_ACQUIRE);
+    if (override)
+      fn = override;
+  }
+  size_t sent = 0;
+  while (sent < len)
+  {
+    int ret = fn(hd, sockfd, buf + sent, len - sent, 0);
+    if (ret < 0)
+      return ret;
+    sent += ret;
+  }
+  return len;
+}
+
+static esp_err_t send_all(httpd_req_t *req, const char *buf, size_t len)
+{
+  return host_httpd_send(req->handle, req->sockfd, buf, len) < 0 ? ESP_ERR_HTTPD_RESP_SEND : ESP_OK;
+}
+
+static void session_drop(server_t *s, size_t i, bool shut)
+{
+  int fd = s->sessions[i].fd;
+  s->sessions.erase(s->sessions.begin() + i);
+  if (fd >= 0 && fd < 64)
+    __atomic_store_n(&host_httpd.send_override[fd], (httpd_send_func_t)NULL, __ATOMIC_RELEASE);
+  if (shut)
+    shutdown(fd, SHUT_RDWR);
+}
+
+// Find or open the session for fd. With every socket taken the least
+// recently used session is closed for it, or without LRU purge the new
+// connection is. Called with httpd_lock held.
+static bool session_open(server_t *s, int fd)
+{
+  s->uses++;
+  for (session_t &session : s->sessions)
+  {
+    if (session.fd == fd)
+    {
+      session.used = s->uses;
+      return true;
+    }
+  }
+  if (s->sessions.size() >= s->config.max_open_sockets)
+  {
+    if (!s->config.lru_purge_enable)
+    {
+      host_httpd.refused++;
+      shutdown(fd, SHUT_RDWR);
+      return false;
+    }
+    size_t oldest = 0;
+    for (size_t i = 1; i < s->sessions.size(); i++)
+      if (s->sessions[i].used < s->sessions[oldest].used)
+        oldest = i;
+    session_drop(s, oldest, true);
+    host_httpd.purged++;
+  }
+  s->sessions.push_back({fd, s->uses});
+  if (fd >= 0 && fd < 64)
+    __atomic_store_n(&host_httpd.send_override[fd], (httpd_send_func_t)NULL, __ATOMIC_RELEASE);
+  struct timeval send_timeout = {s->config.send_wait_timeout, 0};
+  struct timeval recv_timeout = {s->config.recv_wait_timeout, 0};
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &recv_timeout, sizeof(recv_timeout));
+  return true;
+}
+
+// The server closes a session whose handler failed
+static void session_close(httpd_handle_t handle, int fd, bool shut)
+{
+  std::lock_guard<std::mutex> guard(httpd_lock);
+  server_t *s = find_server(handle);
+  if (!s)
+    return;
+  for (size_t i = 0; i < s->sessions.size(); i++)
+  {
+    if (s->sessions[i].fd == fd)
+    {
+      session_drop(s, i, shut);
+      return;
+    }
+  }
+}
+
+void host_httpd_close(httpd_handle_t server, int sockfd)
+{
+  session_close(server, sockfd, false);
+}
+
+static bool route(httpd_handle_t server, const httpd_req_t *req, httpd_uri_t *uri)
+{
+  std::lock_guard<std::mutex> guard(httpd_lock);
+  for (const host_httpd_route_t &r : host_httpd.routes)
+  {
+    if (r.server != server || r.uri.uri != req->host->path)
+      continue;
+    if (r.uri.is_websocket ? req->host->ws_frame || req->method == HTTP_GET
+                           : !req->host->ws_frame && r.uri.method == req->method)
+    {
+      *uri = r.uri;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Route and run one request on the calling thread
+static esp_err_t run(httpd_handle_t server, httpd_req_t *req, int64_t *cpu_ns)
+{
+  httpd_uri_t uri;
+  if (!route(server, req, &uri))
+  {
+    httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Nothing matches the given URI");
+    return ESP_ERR_NOT_FOUND;
+  }
+  if (uri.is_websocket && !req->host->ws_frame)
+  {
+    // The server answers the handshake before the handler sees it
+    static const char upgrade[] = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n\r\n";
+    send_all(req, upgrade, sizeof(upgrade) - 1);
+  }
+  req->user_ctx = uri.user_ctx;
+  int64_t start = thread_cpu_ns();
+  esp_err_t res = uri.handler(req);
+  *cpu_ns = thread_cpu_ns() - start;
+  if (res != ESP_OK)
+    session_close(server, req->sockfd, true);
+  return res;
+}
+
+static void server_task(void *arg)
+{
+  server_t *s = (server_t *)arg;
+  job_t *job;
+  while (xQueueReceive(s->jobs, &job, portMAX_DELAY) == pdTRUE && job)
+  {
+    job->result = run(job->server, &job->req, &job->cpu_ns);
+    job->done = true;
+    xSemaphoreGive(job->finished);
+  }
+  vTaskDelete(NULL);
+}
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config)
+{
+  server_t *s = new server_t{*config, xQueueCreate(4, sizeof(job_t *)), {}, 0, 0};
+  {
+    std::lock_guard<std::mutex> guard(httpd_lock);
+    servers.push_back(s);
+  }
+  if (xTaskCreatePinnedToCore(server_task, "httpd", config->stack_size, s, config->task_priority, NULL,
+                              config->core_id) != pdPASS)
+    return ESP_ERR_HTTPD_TASK;
+  *handle = s;
+  return ESP_OK;
+}
+
+// The server task finishes its current request and exits. Its state is kept,
+// async senders may still hold requests on it.
+esp_err_t httpd_stop(httpd_handle_t handle)
+{
+  server_t *s;
+  {
+    std::lock_guard<std::mutex> guard(httpd_lock);
+    s = find_server(handle);
+  }
+  if (!s)
+    return ESP_ERR_INVALID_ARG;
+  job_t *stop = NULL;
+  xQueueSend(s->jobs, &stop, portMAX_DELAY);
+  return ESP_OK;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri)
+{
+  std::lock_guard<std::mutex> guard(httpd_lock);
+  for (const host_httpd_route_t &r : host_httpd.routes)
+    if (r.server == handle && r.uri.method == uri->method && !strcmp(r.uri.uri, uri->uri))
+      return ESP_ERR_HTTPD_HANDLER_EXISTS;
+  server_t *s = find_server(handle);
+  if (s && s->handlers >= s->config.max_uri_handlers)
+    return ESP_ERR_HTTPD_HANDLERS_FULL;
+  if (s)
+    s->handlers++;
+  host_httpd.routes.push_back({handle, *uri});
+  return ESP_OK;
+}
+
+esp_err_t httpd_get_client_list(httpd_handle_t handle, size_t *fds, int *client_fds)
+{
+  std::lock_guard<std::mutex> guard(httpd_lock);
+  server_t *s = find_server(handle);
+  if (!s || !fds || !client_fds || *fds < s->sessions.size())
+    return ESP_ERR_INVALID_ARG;
+  *fds = s->sessions.size();
+  for (size_t i = 0; i < s->sessions.size(); i++)
+    client_fds[i] = s->sessions[i].fd;
+  return ESP_OK;
+}
+
+esp_err_t httpd_sess_set_send_override(httpd_handle_t hd, int sockfd, httpd_send_func_t fn)
+{
+  if (sockfd < 0 || sockfd >= 64)
+    return ESP_ERR_INVALID_ARG;
+  __atomic_store_n(&host_httpd.send_override[sockfd], fn, __ATOMIC_RELEASE);
+  return ESP_OK;
+}
+
+int httpd_req_to_sockfd(httpd_req_t *req)
+{
+  return req->sockfd;
+}
+
+esp_err_t host_httpd_request(httpd_handle_t server, int sockfd, const host_httpd_request_t *request)
+{
+  job_t *job = new job_t{};
+  job->server = server;
+  host_httpd_exchange &ex = job->exchange;
+  const char *query = strchr(request->uri, '?');
+  ex.path = query ? std::string(request->uri, query - request->uri) : request->uri;
+  ex.has_query = query != NULL;
+  ex.query = query ? query + 1 : "";
+  ex.headers = request->headers ? request->headers : "";
+  if (request->body_len)
+    ex.body.assign((const char *)request->body, request->body_len);
+  ex.ws_frame = request->ws_frame;
+  ex.ws_type = request->ws_type;
+  ex.max_resp_headers = 8;
+  ex.status = "200 OK";
+  ex.type = "text/html";
+
+  httpd_req_t &req = job->req;
+  req.handle = server;
+  req.method = request->ws_frame ? HTTP_DELETE : request->method;
+  req.uri = request->uri;
+  req.content_len = request->body_len;
+  req.sockfd = sockfd;
+  req.host = &ex;
+
+  server_t *s;
+  {
+    std::lock_guard<std::mutex> guard(httpd_lock);
+    s = find_server(server);
+    if (s && !session_open(s, sockfd))
+    {
+      delete job;
+      return ESP_FAIL;
+    }
+  }
+  if (s)
+    ex.max_resp_headers = s->config.max_resp_headers;
+
+  esp_err_t res;
+  if (!s)
+  {
+    res = run(server, &req, &job->cpu_ns);
+  }
+  else
+  {
+    job->finished = xSemaphoreCreateBinary();
+    xQueueSend(s->jobs, &job, portMAX_DELAY);
+    if (host_clock_frozen())
+    {
+      host_clock_advance(0);
+      while (!job->done)
+        host_clock_advance(REQUEST_STEP_US);
+    }
+    else
+    {
+      xSemaphoreTake(job->finished, portMAX_DELAY);
+    }
+    vSemaphoreDelete(job->finished);
+    res = job->result;
+  }
+  last_cpu_ns = job->cpu_ns;
+  delete job;
+  return res;
+}
+
+int64_t host_httpd_last_cpu_ns()
+{
+  return last_cpu_ns;
+}
+
+size_t httpd_req_get_url_query_len(httpd_req_t *req)
+{
+  return req->host->has_query ? req->host->query.size() : 0;
+}
+
+// Copy src into buf, truncating to fit
+static esp_err_t copy_out(const std::string &src, char *buf, size_t len)
+{
+  if (!buf || !len)
+    return ESP_ERR_INVALID_ARG;
+  size_t n = src.size() < len - 1 ? src.size() : len - 1;
+  memcpy(buf, src.data(), n);
+  buf[n] = 0;
+  return n < src.size() ? ESP_ERR_HTTPD_RESULT_TRUNC : ESP_OK;
+}
+
+esp_err_t httpd_req_get_url_query_str(httpd_req_t *req, char *buf, size_t buf_len)
+{
+  if (!req->host->has_query)
+    return ESP_ERR_NOT_FOUND;
+  return copy_out(req->host->query, buf, buf_len);
+}
+
+esp_err_t httpd_query_key_value(const char *qry, const char *key, char *val, size_t val_size)
+{
+  if (!qry || !key || !val)
+    return ESP_ERR_INVALID_ARG;
+  size_t key_len = strlen(key);
+  const char *p = qry;
+  while (*p)
+  {
+    const char *end = strchr(p, '&');
+    if (!end)
+      end = p + strlen(p);
+    const char *eq = (const char *)memchr(p, '=', end - p);
+    if (eq && (size_t)(eq - p) == key_len && !strncmp(p, key, key_len))
+      return copy_out(std::string(eq + 1, end), val, val_size);
+    p = *end ? end + 1 : end;
+  }
+  return ESP_ERR_NOT_FOUND;
+}
+
+// Value of the first header named field, ignoring case
+static bool header_value(httpd_req_t *req, const char *field, std::string *value)
+{
+  const std::string &headers = req->host->headers;
+  size_t field_len = strlen(field);
+  size_t pos = 0;
+  while (pos < headers.size())
+  {
+    size_t end = headers.find("\r\n", pos);
+    if (end == std::string::npos)
+      end = headers.size();
+    size_t colon = headers.find(':', pos);
+    if (colon < end && colon - pos == field_len && !strncasecmp(headers.c_str() + pos, field, field_len))
+    {
+      size_t start = colon + 1;
+      while (start < end && headers[start] == ' ')
+        start++;
+      *value = headers.substr(start, end - start);
+      return true;
+    }
+    pos = end + 2;
+  }
+  return false;
+}
+
+size_t httpd_req_get_hdr_value_len(httpd_req_t *req, const char *field)
+{
+  std::string value;
+  return header_value(req, field, &value) ? value.size() : 0;
+}
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *req, const char *field, char *val, size_t val_size)
+{
+  std::string value;
+  if (!header_value(req, field, &value))
+    return ESP_ERR_NOT_FOUND;
+  return copy_out(value, val, val_size);
+}
+
+int httpd_req_recv(httpd_req_t *req, char *buf, size_t buf_len)
+{
+  host_httpd_exchange *ex = req->host;
+  size_t n = ex->body.size() - ex->body_pos;
+  n = n < buf_len ? n : buf_len;
+  memcpy(buf, ex->body.data() + ex->body_pos, n);
+  ex->body_pos += n;
+  return n;
+}
+
+esp_err_t httpd_resp_set_status(httpd_req_t *req, const char *status)
+{
+  req->host->status = status;
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *req, const char *type)
+{
+  req->host->type = type;
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *req, const char *field, const char *value)
+{
+  host_httpd_exchange *ex = req->host;
+  if (ex->resp_headers.size() >= ex->max_resp_headers)
+    return ESP_ERR_HTTPD_RESP_HDR;
+  ex->resp_headers.emplace_back(field, value);
+  return ESP_OK;
+}
+
+// Status line and headers, with either the body length or chunked encoding
+static esp_err_t send_headers(httpd_req_t *req, ssize_t content_len)
+{
+  host_httpd_exchange *ex = req->host;
+  std::string head = "HTTP/1.1 " + ex->status + "\r\nContent-Type: " + ex->type + "\r\n";
+  if (content_len < 0)
+    head += "Transfer-Encoding: chunked\r\n";
+  else
+    head += "Content-Length: " + std::to_string(content_len) + "\r\n";
+  for (auto &h : ex->resp_headers)
+    head += h.first + ": " + h.second + "\r\n";
+  head += "\r\n";
+  return send_all(req, head.data(), head.size());
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *req, const char *buf, ssize_t buf_len)
+{
+  if (!req || !req->host)
+    return ESP_ERR_HTTPD_INVALID_REQ;
+  if (buf_len == HTTPD_RESP_USE_STRLEN)
+    buf_len = buf ? strlen(buf) : 0;
+  if (!buf)
+    buf_len = 0;
+  if (send_headers(req, buf_len) != ESP_OK)
+    return ESP_ERR_HTTPD_RESP_SEND;
+  return buf_len ? send_all(req, buf, buf_len) : ESP_OK;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *req, const char *buf, ssize_t buf_len)
+{
+  if (!req || !req->host)
+    return ESP_ERR_HTTPD_INVALID_REQ;
+  host_httpd_exchange *ex = req->host;
+  if (buf_len == HTTPD_RESP_USE_STRLEN)
+    buf_len = buf ? strlen(buf) : 0;
+  if (!buf)
+    buf_len = 0;
+  if (!ex->chunked)
+  {
+    if (send_headers(req, -1) != ESP_OK)
+      return ESP_ERR_HTTPD_RESP_SEND;
+    ex->chunked = true;
+  }
+  char size[16];
+  int n = snprintf(size, sizeof(size), "%zx\r\n", (size_t)buf_len);
+  if (send_all(req, size, n) != ESP_OK || (buf_len && send_all(req, buf, buf_len) != ESP_OK) ||
+      send_all(req, "\r\n", 2) != ESP_OK)
+    return ESP_ERR_HTTPD_RESP_SEND;
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *message)
+{
+  static const struct
+  {
+    const char *status;
+    const char *message;
+  } ERRORS[HTTPD_ERR_CODE_MAX] = {
+      {"500 Internal Server Error", "Server has encountered an unexpected error"},
+      {"501 Method Not Implemented", "Request method is not supported by server"},
+      {"505 Version Not Supported", "HTTP version not supported by server"},
+      {"400 Bad Request", "Bad request syntax"},
+      {"401 Unauthorized", "No permission -- see authorization schemes"},
+      {"403 Forbidden", "Request forbidden -- authorization will not help"},
+      {"404 Not Found", "This URI does not exist"},
+      {"405 Method Not Allowed", "Specified method is invalid for this resource"},
+      {"408 Request Timeout", "Server closed this connection"},
+      {"411 Length Required", "Client must specify Content-Length"},
+      {"414 URI Too Long", "URI is too long"},
+      {"431 Request Header Fields Too Large", "Header fields are too long"},
+  };
+  if (error >= HTTPD_ERR_CODE_MAX)
+    return ESP_ERR_INVALID_ARG;
+  httpd_resp_set_status(req, ERRORS[error].status);
+  httpd_resp_set_type(req, "text/html");
+  return httpd_resp_sendstr(req, message ? message : ERRORS[error].message);
+}
+
+esp_err_t httpd_req_async_handler_begin(httpd_req_t *req, httpd_req_t **out)
+{
+  if (!req || !out)
+    return ESP_ERR_INVALID_ARG;
+  httpd_req_t *copy = new httpd_req_t(*req);
+  copy->host = new host_httpd_exchange(*req->host);
+  *out = copy;
+  return ESP_OK;
+}
+
+esp_err_t httpd_req_async_handler_complete(httpd_req_t *req)
+{
+  if (!req)
+    return ESP_ERR_INVALID_ARG;
+  delete req->host;
+  delete req;
+  return ESP_OK;
+}
+
+esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *frame, size_t max_len)
+{
+  host_httpd_exchange *ex = req->host;
+  if (!ex->ws_frame)
+    return ESP_ERR_INVALID_STATE;
+  frame->type = ex->ws_type;
+  frame->final = true;
+  frame->fragmented = false;
+  frame->len = ex->body.size();
+  if (!max_len)
+    return ESP_OK;
+  if (ex->body.size() > max_len || !frame->payload)
+    return ESP_ERR_INVALID_SIZE;
+  memcpy(frame->payload, ex->body.data(), ex->body.size());
+  return ESP_OK;
+}
+
+// Server to client frames are unmasked
+esp_err_t httpd_ws_send_frame(httpd_req_t *req, httpd_ws_frame_t *frame)
+{
+  uint8_t header[10];
+  size_t n = 2;
+  header[0] = 0x80 | (frame->type & 0x0f);
+  if (frame->len < 126)
+  {
+    header[1] = frame->len;
+  }
+  else if (frame->len <= 0xffff)
+  {
+    header[1] = 126;
+    header[2] = frame->len >> 8;
+    header[3] = frame->len;
+    n = 4;
+  }
+  else
+  {
+    header[1] = 127;
+    for (int i = 0; i < 8; i++)
+      header[2 + i] = (uint64_t)frame->len >> (56 - 8 * i);
+    n = 10;
+  }
+  if (send_all(req, (const char *)header, n) != ESP_OK ||
+      (frame->len && send_all(req, (const char *)frame->payload, frame->len) != ESP_OK))
+    return ESP_ERR_HTTPD_RESP_SEND;
+  return ESP_OK;
+}
@@ -0,0 +1,20 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/img_converters.h
+  Host stand-in for the esp32-camera JPEG converters. Output is a JPEG of
+  host_camera.jpeg_len bytes, produced in encoder-sized chunks after
+  host_camera.convert_us of host clock time.
+
+*/
+
+#ifndef HOST_IMG_CONVERTERS_H
+#define HOST_IMG_CONVERTERS_H
+
+#include "esp_camera.h"
+
+typedef size_t (*jpg_out_cb)(void *arg, size_t index, const void *data, size_t len);
+
+bool frame2jpg_cb(camera_fb_t *fb, uint8_t quality, jpg_out_cb cb, void *arg);
+bool frame2jpg(camera_fb_t *fb, uint8_t quality, uint8_t **out, size_t *out_len);
+
+#endif
@@ -0,0 +1,84 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/lwip/sockets.h
+  Host stand-in for lwip/sockets.h: POSIX sockets, numbered from 0. As in
+  lwIP, send and receive calls go through lwip_* functions; blocking ones
+  wait on the host clock in short polls, up to SO_SNDTIMEO or SO_RCVTIMEO,
+  so a task blocked on a socket lets a frozen clock move on.
+
+*/
+
+#ifndef HOST_LWIP_SOCKETS_H
+#define HOST_LWIP_SOCKETS_H
+
+#include "Arduino.h"
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define LWIP_SOCKET_OFFSET 0
+#define HOST_SOCKET_POLL_US 1000
+
+// Socket timeout in us, 0 for none
+static inline int64_t host_socket_timeout_us(int s, int option)
+{
+  struct timeval tv = {};
+  socklen_t len = sizeof(tv);
+  if (getsockopt(s, SOL_SOCKET, option, &tv, &len))
+    return 0;
+  return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+// Retry a non-blocking call until it makes progress, fails for another
+// reason than EAGAIN, or the socket timeout passes
+template <typename F> static inline ssize_t host_socket_wait(int s, int flags, int option, F call)
+{
+  int64_t timeout = host_socket_timeout_us(s, option);
+  int64_t waited = 0;
+  for (;;)
+  {
+    ssize_t n = call(flags | MSG_DONTWAIT);
+    if (n >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK) || (flags & MSG_DONTWAIT))
+      return n;
+    if (timeout && waited >= timeout)
+    {
+      errno = EAGAIN;
+      return -1;
+    }
+    host_delay_us(HOST_SOCKET_POLL_US);
+    waited += HOST_SOCKET_POLL_US;
+  }
+}
+
+static inline ssize_t lwip_send(int s, const void *data, size_t size, int flags)
+{
+  return host_socket_wait(s, flags, SO_SNDTIMEO,
+                          [&](int f) { return ::send(s, data, size, f | MSG_NOSIGNAL); });
+}
+
+static inline ssize_t lwip_sendto(int s, const void *data, size_t size, int flags, const struct sockaddr *to,
+                                  socklen_t tolen)
+{
+  return host_socket_wait(s, flags, SO_SNDTIMEO,
+                          [&](int f) { return ::sendto(s, data, size, f | MSG_NOSIGNAL, to, tolen); });
+}
+
+static inline ssize_t lwip_recv(int s, void *mem, size_t len, int flags)
+{
+  return host_socket_wait(s, flags, SO_RCVTIMEO, [&](int f) { return ::recv(s, mem, len, f); });
+}
+
+static inline ssize_t lwip_recvfrom(int s, void *mem, size_t len, int flags, struct sockaddr *from,
+                                    socklen_t *fromlen)
+{
+  return host_socket_wait(s, flags, SO_RCVTIMEO,
+                          [&](int f) { return ::recvfrom(s, mem, len, f, from, fromlen); });
+}
+
+#define send(s, dataptr, size, flags) lwip_send(s, dataptr, size, flags)
+#define sendto(s, dataptr, size, flags, to, tolen) lwip_sendto(s, dataptr, size, flags, to, tolen)
+#define recv(s, mem, len, flags) lwip_recv(s, mem, len, flags)
+#define recvfrom(s, mem, len, flags, from, fromlen) lwip_recvfrom(s, mem, len, flags, from, fromlen)
+
+#endif
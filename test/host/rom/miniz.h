@@ -0,0 +1,115 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/host/rom/miniz.h
+  Host stand-in for the tinfl inflater in the ESP32 ROM, built on zlib.
+  Output goes to the caller's circular window the same way; zlib keeps
+  its own history, so the window is only written to. zlib's state is
+  carved out of the decompressor itself, so a caller that frees the
+  decompressor without tearing it down, as the ROM API allows, leaks
+  nothing.
+
+*/
+
+#ifndef HOST_ROM_MINIZ_H
+#define HOST_ROM_MINIZ_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <zlib.h>
+
+#define TINFL_LZ_DICT_SIZE 32768
+#define TINFL_FLAG_PARSE_ZLIB_HEADER 1
+#define TINFL_FLAG_HAS_MORE_INPUT 2
+#define TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF 4
+
+typedef enum
+{
+  TINFL_STATUS_BAD_PARAM = -3,
+  TINFL_STATUS_ADLER32_MISMATCH = -2,
+  TINFL_STATUS_FAILED = -1,
+  TINFL_STATUS_DONE = 0,
+  TINFL_STATUS_NEEDS_MORE_INPUT = 1,
+  TINFL_STATUS_HAS_MORE_OUTPUT = 2,
+} tinfl_status;
+
+// Room for zlib's inflate state and its 32 KB window
+#define HOST_TINFL_ARENA (48 * 1024)
+
+typedef struct
+{
+  uint32_t m_state;      // 0 until the first tinfl_decompress call
+  z_stream stream;
+  size_t arena_used;
+  alignas(16) uint8_t arena[HOST_TINFL_ARENA];
+} tinfl_decompressor;
+
+#define tinfl_init(r) \
+  do \
+  { \
+    (r)->m_state = 0; \
+  } while (0)
+
+static inline voidpf host_tinfl_alloc(voidpf opaque, uInt items, uInt size)
+{
+  tinfl_decompressor *r = (tinfl_decompressor *)opaque;
+  size_t len = ((size_t)items * size + 15) & ~(size_t)15;
+  if (r->arena_used + len > sizeof(r->arena))
+    return Z_NULL;
+  voidpf p = r->arena + r->arena_used;
+  r->arena_used += len;
+  return p;
+}
+
+static inline void host_tinfl_free(voidpf opaque, voidpf address)
+{
+}
+
+static inline tinfl_status tinfl_decompress(tinfl_decompressor *r, const uint8_t *pIn_buf_next, size_t *pIn_buf_size,
+                                            uint8_t *pOut_buf_start, uint8_t *pOut_buf_next, size_t *pOut_buf_size,
+                                            const uint32_t decomp_flags)
+{
+  if (!r->m_state)
+  {
+    r->arena_used = 0;
+    r->stream = z_stream{};
+    r->stream.zalloc = host_tinfl_alloc;
+    r->stream.zfree = host_tinfl_free;
+    r->stream.opaque = r;
+    int window_bits = decomp_flags & TINFL_FLAG_PARSE_ZLIB_HEADER ? 15 : -15;
+    if (inflateInit2(&r->stream, window_bits) != Z_OK)
+      return TINFL_STATUS_BAD_PARAM;
+    r->m_state = 1;
+  }
+  if (r->m_state == 2)
+  {
+    *pIn_buf_size = 0;
+    *pOut_buf_size = 0;
+    return TINFL_STATUS_DONE;
+  }
+
+  r->stream.next_in = (Bytef *)pIn_buf_next;
+  r->stream.avail_in = *pIn_buf_size;
+  r->stream.next_out = pOut_buf_next;
+  r->stream.avail_out = *pOut_buf_size;
+  int ret = inflate(&r->stream, Z_NO_FLUSH);
+  *pIn_buf_size -= r->stream.avail_in;
+  *pOut_buf_size -= r->stream.avail_out;
+
+  if (ret == Z_STREAM_END)
+  {
+    r->m_state = 2;
+    return TINFL_STATUS_DONE;
+  }
+  if (ret == Z_DATA_ERROR && r->stream.msg && !strcmp(r->stream.msg, "incorrect data check"))
+    return TINFL_STATUS_ADLER32_MISMATCH;
+  if (ret != Z_OK && ret != Z_BUF_ERROR)
+    return TINFL_STATUS_FAILED;
+  if (!r->stream.avail_out)
+    return TINFL_STATUS_HAS_MORE_OUTPUT;
+  if (!r->stream.avail_in && (decomp_flags & TINFL_FLAG_HAS_MORE_INPUT))
+    return TINFL_STATUS_NEEDS_MORE_INPUT;
+  return TINFL_STATUS_FAILED;
+}
+
+#endif
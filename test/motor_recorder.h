@@ -0,0 +1,59 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/motor_recorder.h
+  Recording motor driver for host tests: keeps every duty vector applied
+  and counts driver calls
+
+*/
+
+#ifndef MOTOR_RECORDER_H
+#define MOTOR_RECORDER_H
+
+#include "motor_output.h"
+#include <vector>
+
+typedef struct
+{
+  uint32_t duty[MOTOR_OUTPUTS];
+} motor_vector_t;
+
+typedef struct
+{
+  uint32_t setup_calls;
+  std::vector<motor_vector_t> applied;
+} motor_recorder_t;
+
+inline motor_recorder_t motor_recorder;
+
+static void motor_recorder_setup()
+{
+  motor_recorder.setup_calls++;
+}
+
+static void motor_recorder_apply(const uint32_t duty[MOTOR_OUTPUTS])
+{
+  motor_vector_t v;
+  memcpy(v.duty, duty, sizeof(v.duty));
+  motor_recorder.applied.push_back(v);
+}
+
+static const motor_driver_t motor_recorder_driver = {motor_recorder_setup, motor_recorder_apply};
+
+// Select the recorder and clear what it has seen
+static inline void motor_recorder_reset()
+{
+  motor_recorder.setup_calls = 0;
+  motor_recorder.applied.clear();
+  motor_output_set_driver(&motor_recorder_driver);
+}
+
+static inline bool motor_recorder_last_is(uint32_t right_m0, uint32_t right_m1, uint32_t left_m0, uint32_t left_m1)
+{
+  if (motor_recorder.applied.empty())
+    return false;
+  const uint32_t *d = motor_recorder.applied.back().duty;
+  return d[MOTOR_RIGHT_M0] == right_m0 && d[MOTOR_RIGHT_M1] == right_m1 &&
+         d[MOTOR_LEFT_M0] == left_m0 && d[MOTOR_LEFT_M1] == left_m1;
+}
+
+#endif
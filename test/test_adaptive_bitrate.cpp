@@ -0,0 +1,204 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/test_adaptive_bitrate.cpp
+  The adaptive bitrate controller: the 4:3 frame size ladder and its
+  limits, hysteresis, and a replay of a link throughput trace through
+  abr_step with a model of frame sizes and send times, checking where it
+  settles and that it only ever picks sizes on the ladder
+
+*/
+
+#include "adaptive_bitrate.h"
+#include "check.h"
+#include <vector>
+
+static const abr_config_t CONFIG = {15, 250, 10, 40, FRAMESIZE_QQVGA, FRAMESIZE_SVGA};
+
+static bool on_ladder(framesize_t framesize)
+{
+  for (framesize_t rung : ABR_FRAMESIZES)
+    if (rung == framesize)
+      return true;
+  return false;
+}
+
+static void test_ladder()
+{
+  // Every rung is 4:3
+  static const struct
+  {
+    framesize_t framesize;
+    int width, height;
+  } sizes[] = {{FRAMESIZE_QQVGA, 160, 120}, {FRAMESIZE_QVGA, 320, 240}, {FRAMESIZE_VGA, 640, 480},
+               {FRAMESIZE_SVGA, 800, 600},  {FRAMESIZE_XGA, 1024, 768}, {FRAMESIZE_UXGA, 1600, 1200}};
+  CHECK(sizeof(sizes) / sizeof(sizes[0]) == sizeof(ABR_FRAMESIZES) / sizeof(ABR_FRAMESIZES[0]));
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+  {
+    CHECK(ABR_FRAMESIZES[i] == sizes[i].framesize);
+    CHECK(sizes[i].width * 3 == sizes[i].height * 4);
+    CHECK(i == 0 || ABR_FRAMESIZES[i] > ABR_FRAMESIZES[i - 1]);
+  }
+
+  CHECK(abr_next_framesize(&CONFIG, FRAMESIZE_SVGA, -1) == FRAMESIZE_VGA);
+  CHECK(abr_next_framesize(&CONFIG, FRAMESIZE_VGA, -1) == FRAMESIZE_QVGA);
+  CHECK(abr_next_framesize(&CONFIG, FRAMESIZE_QVGA, -1) == FRAMESIZE_QQVGA);
+  CHECK(abr_next_framesize(&CONFIG, FRAMESIZE_QQVGA, -1) == FRAMESIZE_QQVGA);
+  CHECK(abr_next_framesize(&CONFIG, FRAMESIZE_QQVGA, 1) == FRAMESIZE_QVGA);
+  CHECK(abr_next_framesize(&CONFIG, FRAMESIZE_QVGA, 1) == FRAMESIZE_VGA);
+  CHECK(abr_next_framesize(&CONFIG, FRAMESIZE_SVGA, 1) == FRAMESIZE_SVGA);
+
+  // Sizes set by hand off the ladder join it at the next rung that way
+  CHECK(abr_next_framesize(&CONFIG, FRAMESIZE_HVGA, -1) == FRAMESIZE_QVGA);
+  CHECK(abr_next_framesize(&CONFIG, FRAMESIZE_HVGA, 1) == FRAMESIZE_VGA);
+  CHECK(abr_next_framesize(&CONFIG, FRAMESIZE_240X240, -1) == FRAMESIZE_QQVGA);
+  CHECK(abr_next_framesize(&CONFIG, FRAMESIZE_HQVGA, 1) == FRAMESIZE_QVGA);
+  CHECK(abr_next_framesize(&CONFIG, FRAMESIZE_96X96, -1) == FRAMESIZE_96X96);
+
+  // Limits: without PSRAM the sketch caps the ladder at QVGA
+  abr_config_t small = CONFIG;
+  small.max_framesize = FRAMESIZE_QVGA;
+  CHECK(abr_next_framesize(&small, FRAMESIZE_QVGA, 1) == FRAMESIZE_QVGA);
+  CHECK(abr_next_framesize(&small, FRAMESIZE_QQVGA, 1) == FRAMESIZE_QVGA);
+  small.min_framesize = FRAMESIZE_QVGA;
+  CHECK(abr_next_framesize(&small, FRAMESIZE_QVGA, -1) == FRAMESIZE_QVGA);
+  // A limit between rungs stops at the rung inside it
+  abr_config_t odd = CONFIG;
+  odd.min_framesize = FRAMESIZE_QCIF;
+  odd.max_framesize = FRAMESIZE_HVGA;
+  CHECK(abr_next_framesize(&odd, FRAMESIZE_QVGA, -1) == FRAMESIZE_QVGA);
+  CHECK(abr_next_framesize(&odd, FRAMESIZE_QVGA, 1) == FRAMESIZE_QVGA);
+}
+
+static void test_steps()
+{
+  const abr_sample_t bad = {50, 400, 300}, good = {250, 50, 8000}, middle = {140, 150, 2000};
+  abr_state_t state = {10, FRAMESIZE_SVGA, 0, 0, ABR_HOLD};
+
+  // Quality first, in ABR_DEGRADE_WINDOWS, then frame size down the ladder
+  CHECK(abr_step(&CONFIG, &state, &bad) == ABR_HOLD);
+  CHECK(abr_step(&CONFIG, &state, &bad) == ABR_DEGRADE_QUALITY && state.quality == 15);
+  std::vector<abr_action_t> actions;
+  std::vector<framesize_t> framesizes;
+  for (int i = 0; i < 40; i++)
+  {
+    abr_action_t action = abr_step(&CONFIG, &state, &bad);
+    if (action != ABR_HOLD)
+      actions.push_back(action);
+    if (action == ABR_DEGRADE_FRAMESIZE)
+      framesizes.push_back(state.framesize);
+  }
+  CHECK(state.quality == CONFIG.worst_quality && state.framesize == FRAMESIZE_QQVGA);
+  CHECK(actions.size() == 8);
+  CHECK(framesizes == std::vector<framesize_t>({FRAMESIZE_VGA, FRAMESIZE_QVGA, FRAMESIZE_QQVGA}));
+
+  // A window in the dead band restarts the count
+  for (int i = 0; i < ABR_IMPROVE_WINDOWS - 1; i++)
+    CHECK(abr_step(&CONFIG, &state, &good) == ABR_HOLD);
+  CHECK(abr_step(&CONFIG, &state, &middle) == ABR_HOLD);
+  for (int i = 0; i < ABR_IMPROVE_WINDOWS - 1; i++)
+    CHECK(abr_step(&CONFIG, &state, &good) == ABR_HOLD);
+  CHECK(abr_step(&CONFIG, &state, &good) == ABR_IMPROVE_FRAMESIZE && state.framesize == FRAMESIZE_QVGA);
+
+  // Back up the ladder, then quality
+  framesizes.clear();
+  for (int i = 0; i < 60; i++)
+    if (abr_step(&CONFIG, &state, &good) == ABR_IMPROVE_FRAMESIZE)
+      framesizes.push_back(state.framesize);
+  CHECK(framesizes == std::vector<framesize_t>({FRAMESIZE_VGA, FRAMESIZE_SVGA}));
+  CHECK(state.quality == CONFIG.best_quality && state.framesize == FRAMESIZE_SVGA);
+
+  // Started off the ladder, the first step joins it
+  state = {40, FRAMESIZE_HVGA, 0, 0, ABR_HOLD};
+  abr_step(&CONFIG, &state, &bad);
+  CHECK(abr_step(&CONFIG, &state, &bad) == ABR_DEGRADE_FRAMESIZE && state.framesize == FRAMESIZE_QVGA);
+}
+
+// Link model for the replay. JPEG size grows with pixels and falls with
+// the quality number; sizes are in the range the OV2640 gives for a room scene
+// (SVGA at quality 10 is about 43 KB). The sensor delivers at most 25 fps,
+// and a frame takes its bytes over the link's throughput to send.
+static uint32_t pixels(framesize_t framesize)
+{
+  switch (framesize)
+  {
+  case FRAMESIZE_QQVGA: return 160 * 120;
+  case FRAMESIZE_QVGA: return 320 * 240;
+  case FRAMESIZE_VGA: return 640 * 480;
+  case FRAMESIZE_SVGA: return 800 * 600;
+  default: return 0;
+  }
+}
+
+static abr_sample_t window(const abr_state_t *state, uint32_t link_kbps)
+{
+  uint32_t bytes = pixels(state->framesize) * (64 - state->quality) / 600;
+  uint32_t send_ms = bytes * 8 / link_kbps;
+  uint32_t fps_x10 = 250;
+  if (bytes * 8 * 25 > link_kbps * 1000)
+    fps_x10 = link_kbps * 10000 / (bytes * 8);
+  // Capture to end of send: a frame interval of queueing at most, plus the send
+  uint32_t latency_ms = 40 + send_ms + (fps_x10 < 250 ? 10000 / fps_x10 : 0);
+  return {fps_x10, latency_ms, link_kbps};
+}
+
+// Link throughput each second, in kbps: close to the access point, driving
+// away until frames queue, a stretch at the edge of range, and back
+static std::vector<uint32_t> link_trace()
+{
+  std::vector<uint32_t> kbps;
+  for (int i = 0; i < 20; i++)
+    kbps.push_back(8000);
+  for (int i = 0; i < 20; i++)
+    kbps.push_back(8000 - i * 370);
+  for (int i = 0; i < 40; i++)
+    kbps.push_back(600 + (i % 3) * 40);
+  for (int i = 0; i < 10; i++)
+    kbps.push_back(600 + i * 740);
+  for (int i = 0; i < 60; i++)
+    kbps.push_back(8000);
+  return kbps;
+}
+
+static void test_replay()
+{
+  std::vector<uint32_t> trace = link_trace();
+  abr_state_t state = {10, FRAMESIZE_SVGA, 0, 0, ABR_HOLD};
+  bool ladder = true;
+  int changes = 0, edge_windows = 0, edge_short = 0;
+  framesize_t smallest = state.framesize;
+  for (size_t t = 0; t < trace.size(); t++)
+  {
+    abr_sample_t sample = window(&state, trace[t]);
+    if (t >= 50 && t < 80)
+    {
+      // At the edge of range, once the controller has had time to settle
+      edge_windows++;
+      edge_short += sample.fps_x10 < CONFIG.target_fps * 8;
+    }
+    if (abr_step(&CONFIG, &state, &sample) != ABR_HOLD)
+      changes++;
+    ladder = ladder && on_ladder(state.framesize);
+    if (state.framesize < smallest)
+      smallest = state.framesize;
+  }
+
+  CHECK(ladder);
+  // Quality alone is not enough at 600 kbps, and QVGA at the worst quality is
+  CHECK(smallest == FRAMESIZE_QVGA);
+  // Probing a larger size after ABR_IMPROVE_WINDOWS good windows costs
+  // ABR_DEGRADE_WINDOWS short ones at the edge, and nothing else does
+  CHECK(edge_short * (ABR_IMPROVE_WINDOWS + ABR_DEGRADE_WINDOWS) <= edge_windows * ABR_DEGRADE_WINDOWS + 2);
+  // Back where it started once the link is
+  CHECK(state.framesize == FRAMESIZE_SVGA && state.quality == CONFIG.best_quality);
+  CHECK(changes < 40);
+  printf("test_adaptive_bitrate: replay of %zu s, %d changes, %d of %d edge windows short\n", trace.size(),
+         changes, edge_short, edge_windows);
+}
+
+int main()
+{
+  test_ladder();
+  test_steps();
+  test_replay();
+  return check_result("test_adaptive_bitrate");
+}
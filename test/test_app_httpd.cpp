@@ -0,0 +1,475 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/test_app_httpd.cpp
+  The sketch's /control, /status, /capture, /stream and POST /update
+  handlers from app_httpd.cpp, run on the host servers against the fake
+  camera, LEDC and flash, /capture reusing the stream's newest frame,
+  and the pages from web_assets.h with and without gzip and ETag
+  revalidation
+
+*/
+
+#include "app_sim.h"
+#include "esp_partition.h"
+#include "frame_hub.h"
+#include "mbedtls/sha256.h"
+#include "command_table.h"
+#include "motor_output.h"
+#include "esp_timer.h"
+#include "web_assets.h"
+#include "check.h"
+#include <zlib.h>
+
+static void test_control()
+{
+  esp_err_t res;
+  app_response_t resp = app_get(camera_httpd, "/control?var=car&val=1", &res);
+  CHECK(res == ESP_OK);
+  CHECK(resp.status == 200 && resp.complete && resp.body.empty());
+  CHECK(app_header(resp, "Access-Control-Allow-Origin") == "*");
+  int fwd_left, fwd_right, left, right;
+  motor_output_get_sides(&fwd_left, &fwd_right);
+  CHECK(abs(fwd_left) == 255 && fwd_left == fwd_right);
+
+  // Stops on its own move_interval + MOTION_RUN_ON_MS after the command
+  host_clock_advance(2200000);
+  motor_output_get_sides(&left, &right);
+  CHECK(left == fwd_left && right == fwd_right);
+  host_clock_advance(100000);
+  motor_output_get_sides(&left, &right);
+  CHECK(left == 0 && right == 0);
+
+  app_get(camera_httpd, "/control?var=car&val=5");
+  motor_output_get_sides(&left, &right);
+  CHECK(left == -fwd_left && right == -fwd_right);
+  resp = app_get(camera_httpd, "/control?var=car&val=3");
+  CHECK(resp.status == 200);
+  motor_output_get_sides(&left, &right);
+  CHECK(left == 0 && right == 0);
+
+  resp = app_get(camera_httpd, "/control?var=speed&val=300", &res);
+  CHECK(res == ESP_FAIL);
+  CHECK(resp.status == 400 && resp.body == "Value out of range");
+  resp = app_get(camera_httpd, "/control?var=speed&val=fast");
+  CHECK(resp.status == 400 && resp.body == "Invalid value");
+  resp = app_get(camera_httpd, "/control?var=warp&val=1");
+  CHECK(resp.status == 404);
+  resp = app_get(camera_httpd, "/control?val=1");
+  CHECK(resp.status == 404);
+  resp = app_get(camera_httpd, "/control");
+  CHECK(resp.status == 404);
+  std::string uri = "/control?var=speed&val=100&pad=" + std::string(COMMAND_MAX_QUERY, 'x');
+  resp = app_get(camera_httpd, uri.c_str());
+  CHECK(resp.status == 400 && resp.body == "Query too long");
+
+  resp = app_get(camera_httpd, "/control?var=speed&val=128");
+  CHECK(resp.status == 200);
+  app_get(camera_httpd, "/control?var=car&val=1");
+  motor_output_get_sides(&left, &right);
+  CHECK(abs(left) == 128 && abs(right) == 128);
+  app_get(camera_httpd, "/control?var=car&val=3");
+  app_get(camera_httpd, "/control?var=speed&val=255");
+}
+
+static void test_status()
+{
+  app_response_t resp = app_get(camera_httpd, "/status");
+  CHECK(resp.status == 200 && resp.complete);
+  CHECK(app_header(resp, "Content-Type") == "application/json");
+  CHECK(resp.body.front() == '{' && resp.body.back() == '}');
+  CHECK(app_json_int(resp.body, "framesize") == FRAMESIZE_QVGA);
+  CHECK(app_json_int(resp.body, "quality") == 10);
+  CHECK(app_json_int(resp.body, "stream_clients") == 0);
+  // The request asking is the one open session
+  CHECK(app_json_int(resp.body, "control_sockets") == 1);
+  CHECK(app_json_int(resp.body, "control_stack_free") > 0);
+  CHECK(app_json_int(resp.body, "heap_min_free") <= app_json_int(resp.body, "heap_free"));
+  CHECK(resp.body.find("\"macro\":\"idle\"") != std::string::npos);
+
+  app_get(camera_httpd, "/control?var=quality&val=20");
+  resp = app_get(camera_httpd, "/status");
+  CHECK(app_json_int(resp.body, "quality") == 20);
+  app_get(camera_httpd, "/control?var=quality&val=10");
+}
+
+static void check_jpeg(const std::string &jpeg, size_t len)
+{
+  CHECK(jpeg.size() == len);
+  CHECK(jpeg.size() >= 4 && (uint8_t)jpeg[0] == 0xff && (uint8_t)jpeg[1] == 0xd8);
+  CHECK(jpeg.size() >= 4 && (uint8_t)jpeg[len - 2] == 0xff && (uint8_t)jpeg[len - 1] == 0xd9);
+}
+
+static void test_capture()
+{
+  size_t len = host_camera_jpeg_len(FRAMESIZE_QVGA, 10);
+  uint32_t grabbed = host_camera.grabbed;
+  app_response_t resp = app_get(camera_httpd, "/capture");
+  CHECK(resp.status == 200 && resp.complete);
+  CHECK(app_header(resp, "Content-Type") == "image/jpeg");
+  CHECK(app_header(resp, "X-Frame-Age-Ms") == "0");
+  check_jpeg(resp.body, len);
+  CHECK(host_camera.grabbed == grabbed + 1);
+  CHECK(host_camera.returned == host_camera.grabbed);
+
+  esp_err_t res;
+  host_camera.fail = true;
+  resp = app_get(camera_httpd, "/capture", &res);
+  host_camera.fail = false;
+  CHECK(res == ESP_FAIL && resp.status == 500);
+
+  resp = app_get(camera_httpd, "/status");
+  CHECK(app_json_int(resp.body, "capture_grabbed") == 2);
+  CHECK(app_json_int(resp.body, "capture_cached") == 0);
+}
+
+typedef struct
+{
+  uint32_t parts;
+  uint32_t bad;        // parts whose length or JPEG markers are wrong
+  uint32_t last_seq;
+  bool in_order;
+} stream_parts_t;
+
+// Walk the multipart body of a /stream response
+static stream_parts_t stream_parse(const std::string &body)
+{
+  stream_parts_t out = {0, 0, 0, true};
+  const std::string boundary = "\r\n--123456789000000000000987654321\r\n";
+  size_t pos = 0;
+  for (;;)
+  {
+    size_t head_end = body.find("\r\n\r\n", pos);
+    size_t field = body.find("Content-Length: ", pos);
+    size_t seq_field = body.find("X-Frame-Seq: ", pos);
+    if (head_end == std::string::npos || field > head_end || seq_field > head_end)
+      break;
+    size_t len = strtoul(body.c_str() + field + 16, NULL, 10);
+    uint32_t seq = strtoul(body.c_str() + seq_field + 13, NULL, 10);
+    size_t data = head_end + 4;
+    if (body.size() < data + len + boundary.size())
+      break;
+    std::string jpeg = body.substr(data, len);
+    // SOI, then the COM segment carrying the frame number
+    if ((uint8_t)jpeg[0] != 0xff || (uint8_t)jpeg[1] != 0xd8 || (uint8_t)jpeg[2] != 0xff ||
+        (uint8_t)jpeg[3] != 0xfe || (uint8_t)jpeg[len - 1] != 0xd9 ||
+        jpeg.find("seq=" + std::to_string(seq) + " ") != 6 || body.compare(data + len, boundary.size(), boundary))
+      out.bad++;
+    if (out.last_seq && seq <= out.last_seq)
+      out.in_order = false;
+    out.last_seq = seq;
+    out.parts++;
+    pos = data + len + boundary.size();
+  }
+  return out;
+}
+
+static void test_stream()
+{
+  app_conn_t viewers[FRAME_HUB_MAX_CLIENTS];
+  std::string raw[FRAME_HUB_MAX_CLIENTS];
+  for (int i = 0; i < FRAME_HUB_MAX_CLIENTS; i++)
+  {
+    viewers[i] = app_connect();
+    CHECK(host_httpd_call(stream_httpd, HTTP_GET, "/stream", viewers[i].server) == ESP_OK);
+  }
+  host_clock_advance(0);
+  CHECK(host_task_count("stream_client") == FRAME_HUB_MAX_CLIENTS);
+
+  // One more socket fits the stream server, and is turned away rather
+  // than purging a viewer
+  uint32_t purged = host_httpd.purged;
+  app_response_t resp = app_get(stream_httpd, "/stream");
+  CHECK(resp.status == 503 && resp.body == "Too many stream clients");
+  CHECK(host_httpd.purged == purged);
+
+  // A second at 25 fps
+  host_clock_advance(1000000);
+  for (int i = 0; i < FRAME_HUB_MAX_CLIENTS; i++)
+  {
+    raw[i] = app_read(viewers[i].client);
+    app_parse(raw[i], &resp);
+    CHECK(resp.status == 200 && !resp.complete);
+    CHECK(app_header(resp, "Content-Type") == "multipart/x-mixed-replace;boundary=123456789000000000000987654321");
+    stream_parts_t parts = stream_parse(resp.body);
+    CHECK(parts.parts >= 20 && parts.parts <= 26);
+    CHECK(parts.bad == 0);
+    CHECK(parts.in_order);
+  }
+
+  // /capture now takes the newest streamed frame instead of the camera
+  resp = app_get(camera_httpd, "/capture");
+  CHECK(resp.status == 200);
+  CHECK(atoi(app_header(resp, "X-Frame-Age-Ms").c_str()) <= 200);
+  check_jpeg(resp.body, host_camera_jpeg_len(FRAMESIZE_QVGA, 10));
+  resp = app_get(camera_httpd, "/status");
+  CHECK(app_json_int(resp.body, "capture_cached") == 1);
+  CHECK(app_json_int(resp.body, "stream_clients") == FRAME_HUB_MAX_CLIENTS);
+  CHECK(app_json_int(resp.body, "stream_sockets") == FRAME_HUB_MAX_CLIENTS);
+
+  // Viewers that hang up free their hub clients on the next send
+  for (int i = 0; i < FRAME_HUB_MAX_CLIENTS; i++)
+  {
+    close(viewers[i].client);
+    viewers[i].client = -1;
+  }
+  host_clock_advance(200000);
+  for (int i = 0; i < FRAME_HUB_MAX_CLIENTS; i++)
+    app_disconnect(stream_httpd, &viewers[i]);
+  resp = app_get(camera_httpd, "/status");
+  CHECK(app_json_int(resp.body, "stream_clients") == 0);
+  CHECK(app_json_int(resp.body, "stream_client_stack_free") > 0);
+}
+
+// Whether jpeg is the fake camera's frame number frame, byte for byte
+static bool is_camera_frame(const std::string &jpeg, int64_t frame, size_t len)
+{
+  if (jpeg.size() != len || (uint8_t)jpeg[0] != 0xff || (uint8_t)jpeg[1] != 0xd8)
+    return false;
+  for (size_t i = 2 + HOST_JPEG_SOF_LEN; i < len - 2; i++)
+    if ((uint8_t)jpeg[i] != ((frame + i) & 0x7f))
+      return false;
+  return true;
+}
+
+static app_response_t capture_at_age(int max_age_ms)
+{
+  std::string uri = "/control?var=capture_age&val=" + std::to_string(max_age_ms);
+  CHECK(app_get(camera_httpd, uri.c_str()).status == 200);
+  return app_get(camera_httpd, "/capture");
+}
+
+// While a stream keeps the frame hub fresh, /capture sends the newest
+// frame from it: the camera's bytes, no camera buffer of its own, and the
+// frame's reference handed back so the stream never runs out of slots
+static void test_capture_reuse()
+{
+  const int64_t frame_us = host_camera.frame_us;
+  size_t len = host_camera_jpeg_len(FRAMESIZE_QVGA, 10);
+  app_conn_t viewer = app_connect();
+  CHECK(host_httpd_call(stream_httpd, HTTP_GET, "/stream", viewer.server) == ESP_OK);
+  host_clock_advance(500000);
+  app_read(viewer.client);
+  app_response_t resp = app_get(camera_httpd, "/status");
+  long cached = app_json_int(resp.body, "capture_cached");
+  long grabbed = app_json_int(resp.body, "capture_grabbed");
+
+  // Half a frame after the newest one, at exactly the age limit
+  host_clock_advance(frame_us - esp_timer_get_time() % frame_us + frame_us / 2);
+  int64_t newest = esp_timer_get_time() / frame_us;
+  uint32_t camera_grabs = host_camera.grabbed;
+  resp = capture_at_age(frame_us / 2000);
+  CHECK(resp.status == 200 && app_header(resp, "Content-Type") == "image/jpeg");
+  CHECK(app_header(resp, "X-Frame-Age-Ms") == std::to_string(frame_us / 2000));
+  CHECK(is_camera_frame(resp.body, newest, len));
+  CHECK(host_camera.grabbed == camera_grabs);
+
+  // A millisecond over it, a frame of its own from the camera
+  resp = capture_at_age(frame_us / 2000 - 1);
+  CHECK(resp.status == 200 && app_header(resp, "X-Frame-Age-Ms") == "0");
+  check_jpeg(resp.body, len);
+  CHECK(!is_camera_frame(resp.body, newest, len));
+  CHECK(host_camera.grabbed > camera_grabs);
+
+  // Frame after frame, each one the newest, with the stream still at full
+  // rate afterwards
+  app_read(viewer.client);
+  host_clock_advance(frame_us - esp_timer_get_time() % frame_us + frame_us / 2);
+  bool fresh = true;
+  for (int i = 0; i < 20; i++)
+  {
+    resp = capture_at_age(200);
+    fresh = fresh && is_camera_frame(resp.body, esp_timer_get_time() / frame_us, len);
+    host_clock_advance(frame_us);
+    app_read(viewer.client);
+  }
+  CHECK(fresh);
+  host_clock_advance(1000000);
+  std::string raw = app_read(viewer.client);
+  int parts = 0;
+  for (size_t pos = 0; (pos = raw.find("X-Frame-Seq: ", pos)) != std::string::npos; pos++)
+    parts++;
+  CHECK(parts >= 24);
+  resp = app_get(camera_httpd, "/status");
+  CHECK(app_json_int(resp.body, "capture_cached") == cached + 21);
+  CHECK(app_json_int(resp.body, "capture_grabbed") == grabbed + 1);
+
+  // With nobody watching there is no newest frame to reuse
+  close(viewer.client);
+  viewer.client = -1;
+  host_clock_advance(200000);
+  app_disconnect(stream_httpd, &viewer);
+  resp = app_get(camera_httpd, "/capture");
+  CHECK(resp.status == 200 && app_header(resp, "X-Frame-Age-Ms") == "0");
+  resp = app_get(camera_httpd, "/status");
+  CHECK(app_json_int(resp.body, "capture_grabbed") == grabbed + 2);
+}
+
+static std::string firmware_image(size_t len, uint32_t seed)
+{
+  std::string image(len, 0);
+  for (size_t i = 0; i < len; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    image[i] = seed >> 16;
+  }
+  image[0] = (char)0xe9;
+  return image;
+}
+
+static std::string sha256_hex(const std::string &data)
+{
+  mbedtls_sha256_context ctx;
+  uint8_t sha[32];
+  mbedtls_sha256_init(&ctx);
+  mbedtls_sha256_starts(&ctx, 0);
+  mbedtls_sha256_update(&ctx, (const uint8_t *)data.data(), data.size());
+  mbedtls_sha256_finish(&ctx, sha);
+  mbedtls_sha256_free(&ctx);
+  char hex[65];
+  for (int i = 0; i < 32; i++)
+    sprintf(hex + i * 2, "%02x", sha[i]);
+  return hex;
+}
+
+static std::string partition_read(int index, size_t len)
+{
+  std::string data(len, 0);
+  CHECK(pread(host_flash_get()->app[index].fd, &data[0], len, 0) == (ssize_t)len);
+  return data;
+}
+
+static void test_update()
+{
+  host_flash_get();
+  uint32_t restarts = host_restarts;
+
+  // A raw image with its digest lands in the other slot and is booted next
+  std::string image = firmware_image(100000, 1);
+  std::string headers = "Content-Type: application/octet-stream\r\nX-Update-SHA256: " + sha256_hex(image) + "\r\n";
+  esp_err_t res;
+  app_response_t resp = app_request(camera_httpd, HTTP_POST, "/update", headers.c_str(), image, &res);
+  CHECK(res == ESP_OK);
+  CHECK(resp.status == 200);
+  CHECK(resp.body == "Update successful! sha256 " + sha256_hex(image) + ". Rebooting...");
+  CHECK(host_restarts == restarts + 1);
+  CHECK(host_flash.boot == 1);
+  CHECK(partition_read(1, image.size()) == image);
+  host_flash.boot = 0;
+
+  // A digest that does not match refuses the image and keeps the boot slot
+  std::string other = firmware_image(50000, 2);
+  headers = "X-Update-SHA256: " + sha256_hex(image) + "\r\n";
+  resp = app_request(camera_httpd, HTTP_POST, "/update", headers.c_str(), other, &res);
+  CHECK(res == ESP_FAIL && resp.status == 500);
+  CHECK(host_restarts == restarts + 1);
+  CHECK(host_flash.boot == 0);
+
+  resp = app_request(camera_httpd, HTTP_POST, "/update", "X-Update-SHA256: 1234\r\n", other, &res);
+  CHECK(resp.status == 400 && resp.body == "Invalid X-Update-SHA256");
+
+  // Not an ESP32 image
+  std::string junk(8192, 'x');
+  resp = app_request(camera_httpd, HTTP_POST, "/update", NULL, junk, &res);
+  CHECK(res == ESP_FAIL && resp.status == 500);
+  CHECK(host_flash.boot == 0);
+
+  // A browser form upload: only the file part is written
+  std::string form = "--XyZ\r\nContent-Disposition: form-data; name=\"update\"; filename=\"fw.bin\"\r\n"
+                     "Content-Type: application/octet-stream\r\n\r\n" +
+                     other + "\r\n--XyZ--\r\n";
+  resp = app_request(camera_httpd, HTTP_POST, "/update", "Content-Type: multipart/form-data; boundary=XyZ\r\n",
+                     form, &res);
+  CHECK(res == ESP_OK && resp.status == 200);
+  CHECK(host_restarts == restarts + 2);
+  CHECK(host_flash.boot == 1);
+  CHECK(partition_read(1, other.size()) == other);
+  host_flash.boot = 0;
+}
+
+static std::string gunzip(const std::string &data)
+{
+  z_stream z = {};
+  std::string out(1 << 20, 0);
+  if (inflateInit2(&z, 16 + MAX_WBITS) != Z_OK)
+    return "";
+  z.next_in = (Bytef *)data.data();
+  z.avail_in = data.size();
+  z.next_out = (Bytef *)&out[0];
+  z.avail_out = out.size();
+  int ret = inflate(&z, Z_FINISH);
+  out.resize(z.total_out);
+  inflateEnd(&z);
+  return ret == Z_STREAM_END ? out : "";
+}
+
+static app_response_t get_page(const char *uri, const std::string &headers)
+{
+  return app_request(camera_httpd, HTTP_GET, uri, headers.c_str());
+}
+
+static void test_page(const char *uri, const web_asset_t *asset)
+{
+  // A browser gets the gzipped bytes as embedded
+  app_response_t gz = get_page(uri, "Accept-Encoding: gzip, deflate\r\n");
+  CHECK(gz.status == 200 && gz.complete);
+  CHECK(app_header(gz, "Content-Type") == asset->content_type);
+  CHECK(app_header(gz, "Content-Encoding") == "gzip");
+  CHECK(app_header(gz, "Vary") == "Accept-Encoding");
+  CHECK(app_header(gz, "Cache-Control") == "no-cache");
+  CHECK(app_header(gz, "ETag") == asset->etag);
+  CHECK(gz.body == std::string((const char *)asset->data, asset->len));
+
+  // A client without gzip gets the same page inflated, under its own tag
+  app_response_t id = get_page(uri, "");
+  CHECK(id.status == 200 && id.complete);
+  CHECK(app_header(id, "Content-Type") == asset->content_type);
+  CHECK(app_header(id, "Content-Encoding").empty());
+  CHECK(app_header(id, "Vary") == "Accept-Encoding");
+  std::string id_tag = app_header(id, "ETag");
+  CHECK(!id_tag.empty() && id_tag != asset->etag);
+  CHECK(id.body.size() == asset->raw_len && id.body == gunzip(gz.body));
+  CHECK(id.body.find("</html>") != std::string::npos);
+  // Tokens past gzip, and gzip refused with q=0
+  CHECK(app_header(get_page(uri, "Accept-Encoding: br, GZIP;q=0.5\r\n"), "Content-Encoding") == "gzip");
+  CHECK(app_header(get_page(uri, "Accept-Encoding: gzip;q=0, deflate\r\n"), "Content-Encoding").empty());
+  CHECK(app_header(get_page(uri, "Accept-Encoding: x-gzip\r\n"), "Content-Encoding").empty());
+  CHECK(app_header(get_page(uri, "Accept-Encoding: identity\r\n"), "Content-Encoding").empty());
+
+  // A matching tag revalidates with no body; another tag, or the other
+  // encoding's, gets the page
+  std::string gz_headers = "Accept-Encoding: gzip\r\n";
+  app_response_t resp = get_page(uri, gz_headers + "If-None-Match: " + asset->etag + "\r\n");
+  CHECK(resp.status == 304 && resp.complete && resp.body.empty());
+  CHECK(app_header(resp, "ETag") == asset->etag && app_header(resp, "Content-Encoding").empty());
+  resp = get_page(uri, "If-None-Match: " + id_tag + "\r\n");
+  CHECK(resp.status == 304 && resp.body.empty() && app_header(resp, "ETag") == id_tag);
+  resp = get_page(uri, gz_headers + "If-None-Match: \"0000000000000000\"\r\n");
+  CHECK(resp.status == 200 && resp.body.size() == asset->len);
+  resp = get_page(uri, "If-None-Match: " + std::string(asset->etag) + "\r\n");
+  CHECK(resp.status == 200 && resp.body.size() == asset->raw_len);
+  resp = get_page(uri, gz_headers + "If-None-Match: " + id_tag + "\r\n");
+  CHECK(resp.status == 200 && resp.body.size() == asset->len);
+
+  // Bytes on the wire: gzip at least halves the page
+  CHECK(gz.body.size() * 2 < id.body.size());
+  printf("test_app_httpd: %s %zu bytes gzipped, %zu inflated\n", uri, gz.body.size(), id.body.size());
+}
+
+static void test_pages()
+{
+  test_page("/", &INDEX_HTML_ASSET);
+  test_page("/update", &UPDATE_HTML_ASSET);
+}
+
+int main()
+{
+  app_start();
+  test_control();
+  test_status();
+  test_capture();
+  test_stream();
+  test_capture_reuse();
+  test_update();
+  test_pages();
+  return check_result("test_app_httpd");
+}
@@ -0,0 +1,359 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/test_blackbox.cpp
+  The black-box recorder on the fake camera: eviction when the video ring
+  wraps and at the frame cap, the record, freeze, download and resume
+  cycle through /blackbox, the AVI it downloads parsed back, and JPEG size
+  lookup on truncated input
+
+*/
+
+#include "app_sim.h"
+#include "blackbox.h"
+#include "mjpeg_avi.h"
+#include "check.h"
+#include <vector>
+
+// Slower than BLACKBOX_FPS, so every frame is recorded, and longer than the
+// recorder's acquire timeout, so a freeze lands before the next frame
+#define FRAME_US 150000
+#define STEP_US 50000
+
+static blackbox_stats_t stats()
+{
+  blackbox_stats_t s;
+  blackbox_get_stats(&s);
+  return s;
+}
+
+// Frames recorded since the last resume, kept or not
+static uint32_t recorded()
+{
+  blackbox_stats_t s = stats();
+  return s.frames + s.overwritten;
+}
+
+// Run the clock until the recorder has taken n frames since the last resume
+static bool record_until(uint32_t n)
+{
+  for (int64_t t = 0; t < (int64_t)(n + 10) * FRAME_US; t += STEP_US)
+  {
+    if (recorded() >= n)
+      return true;
+    host_clock_advance(STEP_US);
+  }
+  return false;
+}
+
+// Freeze now and let the recorder see it
+static void freeze()
+{
+  blackbox_freeze("test", 0);
+  host_clock_advance(2 * STEP_US);
+  CHECK(stats().state == BLACKBOX_FROZEN);
+}
+
+static uint32_t read_u32(const std::string &s, size_t pos)
+{
+  const uint8_t *p = (const uint8_t *)s.data() + pos;
+  return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// Every frame of the frozen recording: whole, in order, in the ring, not
+// overlapping another, and holding the camera frame its timestamp names
+static void check_ring(uint32_t len)
+{
+  blackbox_stats_t s = stats();
+  blackbox_frame_t frame, prev = {};
+  const uint8_t *jpeg;
+  std::vector<blackbox_frame_t> kept;
+  uint32_t bytes = 0;
+  for (uint16_t i = 0; blackbox_frame(i, &frame, &jpeg); i++)
+  {
+    CHECK(!len || frame.len == len);
+    CHECK(frame.offset + frame.len <= BLACKBOX_VIDEO_BYTES);
+    if (i)
+    {
+      CHECK(frame.seq > prev.seq);
+      CHECK(frame.timestamp == prev.timestamp + FRAME_US);
+    }
+    uint32_t n = frame.timestamp / FRAME_US;
+    bool same = jpeg[0] == 0xff && jpeg[1] == 0xd8 && jpeg[frame.len - 1] == 0xd9;
+    for (uint32_t j = 2 + HOST_JPEG_SOF_LEN; j < frame.len - 2; j++)
+      same = same && jpeg[j] == ((n + j) & 0x7f);
+    CHECK(same);
+    for (const blackbox_frame_t &other : kept)
+      CHECK(frame.offset >= other.offset + other.len || other.offset >= frame.offset + frame.len);
+    kept.push_back(frame);
+    bytes += frame.len;
+    prev = frame;
+  }
+  CHECK(kept.size() == s.frames);
+  CHECK(bytes == s.bytes);
+}
+
+static void test_wrap()
+{
+  // 15 frames of 100000 bytes fill the ring to 1500000, past where a
+  // 200000-byte frame fits, so the next one wraps to the start
+  host_camera.jpeg_len = 100000;
+  blackbox_record(true);
+  CHECK(record_until(15));
+  CHECK(recorded() == 15);
+  host_camera.jpeg_len = 200000;
+
+  // Each of the next 7 takes two small frames' room at the start; the 8th
+  // wraps again with the last small frame, at 1400000, still oldest and
+  // past the new write position, so it goes before the frame at 0
+  CHECK(record_until(23));
+  CHECK(recorded() == 23);
+  freeze();
+  blackbox_stats_t s = stats();
+  CHECK(s.frames == 7);
+  CHECK(s.overwritten == 16);
+  CHECK(s.bytes == 7 * 200000);
+  CHECK(s.span_ms == 6 * FRAME_US / 1000);
+  check_ring(200000);
+}
+
+static void test_frame_cap()
+{
+  // Small frames run out of index slots long before the ring fills
+  host_camera.jpeg_len = 1000;
+  blackbox_resume();
+  CHECK(stats().state == BLACKBOX_RECORDING);
+  CHECK(record_until(BLACKBOX_MAX_FRAMES + 44));
+  freeze();
+  blackbox_stats_t s = stats();
+  CHECK(s.frames == BLACKBOX_MAX_FRAMES);
+  CHECK(s.overwritten == recorded() - BLACKBOX_MAX_FRAMES);
+  check_ring(0);
+
+  // Frames over a quarter of the ring are skipped and counted
+  host_camera.jpeg_len = BLACKBOX_VIDEO_BYTES / 4 + 1;
+  blackbox_resume();
+  host_clock_advance(10 * FRAME_US);
+  s = stats();
+  CHECK(s.too_large >= 8);
+  CHECK(s.bytes <= 1000);
+  freeze();
+  blackbox_record(false);
+  blackbox_resume();
+  CHECK(stats().state == BLACKBOX_IDLE);
+}
+
+static std::string blackbox_json(const char *uri = "/blackbox")
+{
+  app_response_t resp = app_get(camera_httpd, uri);
+  CHECK(resp.status == 200);
+  return resp.body;
+}
+
+static bool json_state(const std::string &json, const char *state)
+{
+  return json.find(std::string("\"state\":\"") + state + "\"") != std::string::npos;
+}
+
+// The AVI from ?get=video against the frozen recording it was made from
+static void check_avi(const std::string &avi)
+{
+  blackbox_stats_t s = stats();
+  uint32_t count = s.frames;
+  CHECK(count > 1);
+  CHECK(avi.size() >= AVI_HEADER_LEN);
+  if (avi.size() < AVI_HEADER_LEN || count < 2)
+    return;
+
+  blackbox_frame_t frame, first, last;
+  const uint8_t *jpeg;
+  uint32_t movi_len = 0, max_frame = 0;
+  bool odd = false;
+  for (uint16_t i = 0; blackbox_frame(i, &frame, &jpeg); i++)
+  {
+    if (!i)
+      first = frame;
+    last = frame;
+    movi_len += avi_chunk_len(frame.len);
+    max_frame = frame.len > max_frame ? frame.len : max_frame;
+    odd = odd || (frame.len & 1);
+  }
+  CHECK(odd);
+  uint32_t idx_len = count * AVI_INDEX_ENTRY_LEN;
+
+  CHECK(!avi.compare(0, 4, "RIFF"));
+  CHECK(read_u32(avi, 4) == 4 + 200 + 12 + movi_len + 8 + idx_len);
+  CHECK(read_u32(avi, 4) == avi.size() - 8);
+  CHECK(!avi.compare(8, 4, "AVI "));
+  CHECK(!avi.compare(12, 4, "LIST") && read_u32(avi, 16) == 192 && !avi.compare(20, 4, "hdrl"));
+  CHECK(!avi.compare(24, 4, "avih"));
+  CHECK(read_u32(avi, 32) == (last.timestamp - first.timestamp) / (count - 1));
+  CHECK(read_u32(avi, 48) == count);
+  CHECK(read_u32(avi, 60) == max_frame);
+  CHECK(read_u32(avi, 64) == 320 && read_u32(avi, 68) == 240);
+  CHECK(!avi.compare(100, 4, "strh") && !avi.compare(108, 8, "vidsMJPG"));
+  CHECK(!avi.compare(212, 4, "LIST") && read_u32(avi, 216) == 4 + movi_len);
+  size_t movi = 220;
+  CHECK(!avi.compare(movi, 4, "movi"));
+
+  // Frame chunks, each padded to an even length
+  size_t pos = AVI_HEADER_LEN;
+  std::vector<size_t> chunks;
+  for (uint16_t i = 0; blackbox_frame(i, &frame, &jpeg) && pos + 8 <= avi.size(); i++)
+  {
+    chunks.push_back(pos);
+    CHECK(!avi.compare(pos, 4, "00dc"));
+    CHECK(read_u32(avi, pos + 4) == frame.len);
+    CHECK(!avi.compare(pos + 8, frame.len, (const char *)jpeg, frame.len));
+    if (frame.len & 1)
+      CHECK(avi[pos + 8 + frame.len] == 0);
+    pos += avi_chunk_len(frame.len);
+  }
+  CHECK(chunks.size() == count);
+  CHECK(pos == movi + 4 + movi_len);
+
+  // The index, with offsets from the "movi" fourcc to each chunk
+  CHECK(!avi.compare(pos, 4, "idx1") && read_u32(avi, pos + 4) == idx_len);
+  pos += 8;
+  CHECK(pos + idx_len == avi.size());
+  for (uint16_t i = 0; i < chunks.size() && pos + AVI_INDEX_ENTRY_LEN <= avi.size(); i++)
+  {
+    blackbox_frame(i, &frame, &jpeg);
+    CHECK(!avi.compare(pos, 4, "00dc"));
+    CHECK(read_u32(avi, pos + 4) == 0x10);
+    CHECK(read_u32(avi, pos + 8) == chunks[i] - movi);
+    CHECK(read_u32(avi, pos + 12) == frame.len);
+    pos += AVI_INDEX_ENTRY_LEN;
+  }
+}
+
+static void test_freeze_download_resume()
+{
+  // Nothing to download or freeze while idle, and commands are not kept
+  CHECK(json_state(blackbox_json(), "idle"));
+  CHECK(app_get(camera_httpd, "/blackbox?get=video").status == 400);
+  CHECK(json_state(blackbox_json("/blackbox?freeze=1"), "idle"));
+  CHECK(app_get(camera_httpd, "/control?var=speed&val=200").status == 200);
+
+  // Odd lengths, so chunks need padding
+  host_camera.jpeg_len = 6401;
+  std::string json = blackbox_json("/blackbox?record=1");
+  CHECK(json_state(json, "recording"));
+  CHECK(app_json_int(json, "commands") == 0);
+  host_clock_advance(1000000);
+  CHECK(app_get(camera_httpd, "/control?var=speed&val=255").status == 200);
+  CHECK(app_get(camera_httpd, "/control?var=speed&val=300").status == 400);
+  host_clock_advance(500000);
+  CHECK(app_json_int(blackbox_json(), "commands") == 2);
+
+  // Frozen once the post-trigger time is up; a second trigger is ignored
+  json = blackbox_json("/blackbox?freeze=1");
+  CHECK(json_state(json, "triggered"));
+  CHECK(json.find("\"reason\":\"manual\"") != std::string::npos);
+  blackbox_freeze("drive timeout", BLACKBOX_POST_MS);
+  host_clock_advance(2 * STEP_US);
+  json = blackbox_json();
+  CHECK(json_state(json, "frozen"));
+  CHECK(json.find("\"reason\":\"manual\"") != std::string::npos);
+  long frames = app_json_int(json, "frames");
+  CHECK(frames >= 8);
+
+  // Nothing changes while frozen, even with recording switched off
+  host_clock_advance(1000000);
+  CHECK(app_get(camera_httpd, "/control?var=speed&val=200").status == 200);
+  json = blackbox_json("/blackbox?record=0");
+  CHECK(json_state(json, "frozen"));
+  CHECK(app_json_int(json, "frames") == frames);
+  CHECK(app_json_int(json, "commands") == 2);
+
+  app_response_t resp = app_get(camera_httpd, "/blackbox?get=video");
+  CHECK(resp.status == 200 && resp.complete);
+  CHECK(app_header(resp, "Content-Type") == "video/x-msvideo");
+  check_avi(resp.body);
+
+  // Frames and commands on one timeline
+  resp = app_get(camera_httpd, "/blackbox?get=commands");
+  CHECK(resp.status == 200 && resp.complete);
+  CHECK(!resp.body.compare(0, 19, "# trigger: manual, "));
+  size_t lines = 0;
+  for (char c : resp.body)
+    lines += c == '\n';
+  CHECK(lines == 2 + (size_t)frames + 2);
+  CHECK(resp.body.find(",command,,,,speed,255,ESP_OK\n") != std::string::npos);
+  CHECK(resp.body.find(",command,,,,speed,300,ESP_ERR_INVALID_ARG\n") != std::string::npos);
+  CHECK(resp.body.find(",frame,0,") != std::string::npos);
+  CHECK(app_get(camera_httpd, "/blackbox?get=audio").status == 404);
+
+  // Resume with recording off goes idle and drops the recording
+  json = blackbox_json("/blackbox?resume=1");
+  CHECK(json_state(json, "idle"));
+  CHECK(app_json_int(json, "frames") == 0 && app_json_int(json, "commands") == 0);
+  CHECK(app_get(camera_httpd, "/blackbox?get=commands").status == 400);
+
+  // With recording on it starts over
+  blackbox_json("/blackbox?record=1");
+  host_clock_advance(1000000);
+  blackbox_json("/blackbox?freeze=1");
+  host_clock_advance(2 * STEP_US);
+  CHECK(json_state(blackbox_json(), "frozen"));
+  json = blackbox_json("/blackbox?resume=1");
+  CHECK(json_state(json, "recording"));
+  CHECK(app_json_int(json, "frames") == 0 && app_json_int(json, "overwritten") == 0);
+  CHECK(json.find("\"reason\":\"\"") != std::string::npos);
+  blackbox_json("/blackbox?record=0");
+}
+
+static void test_jpeg_dimensions()
+{
+  // SOI, an APP0, a DHT that is not a frame header, then SOF0 at 640x480
+  const uint8_t jpeg[] = {0xff, 0xd8,
+                          0xff, 0xe0, 0x00, 0x06, 'J', 'F', 'I', 'F',
+                          0xff, 0xc4, 0x00, 0x04, 0x00, 0x00,
+                          0xff, 0xc0, 0x00, 0x0b, 0x08, 0x01, 0xe0, 0x02, 0x80, 0x01, 0x01, 0x11, 0x00,
+                          0xff, 0xda};
+  const size_t sof = 16;
+  uint16_t width, height;
+  CHECK(jpeg_dimensions(jpeg, sizeof(jpeg), &width, &height));
+  CHECK(width == 640 && height == 480);
+
+  // Cut at every length, in a buffer of exactly that size so reading past
+  // the end is caught
+  for (size_t len = 0; len <= sizeof(jpeg); len++)
+  {
+    std::vector<uint8_t> cut(jpeg, jpeg + len);
+    width = height = 0;
+    bool ok = jpeg_dimensions(cut.data(), len, &width, &height);
+    CHECK(ok == (len > sof + 9));
+    CHECK(!ok || (width == 640 && height == 480));
+  }
+
+  // Progressive frames too; garbage and lengths past the end are not read
+  std::vector<uint8_t> progressive(jpeg, jpeg + sizeof(jpeg));
+  progressive[sof + 1] = 0xc2;
+  CHECK(jpeg_dimensions(progressive.data(), progressive.size(), &width, &height) && width == 640);
+  std::vector<uint8_t> garbage(jpeg, jpeg + sizeof(jpeg));
+  garbage[10] = 0x12;
+  CHECK(!jpeg_dimensions(garbage.data(), garbage.size(), &width, &height));
+  std::vector<uint8_t> overrun(jpeg, jpeg + sizeof(jpeg));
+  overrun[5] = 0xf0;
+  CHECK(!jpeg_dimensions(overrun.data(), overrun.size(), &width, &height));
+
+  // The fake camera's frames carry their size the same way
+  host_camera.jpeg_len = 0;
+  app_response_t resp = app_get(camera_httpd, "/capture");
+  CHECK(resp.status == 200);
+  CHECK(jpeg_dimensions((const uint8_t *)resp.body.data(), resp.body.size(), &width, &height));
+  CHECK(width == 320 && height == 240);
+}
+
+int main()
+{
+  host_camera.frame_us = FRAME_US;
+  app_start();
+  CHECK(stats().state == BLACKBOX_IDLE);
+
+  test_wrap();
+  test_frame_cap();
+  test_freeze_download_resume();
+  test_jpeg_dimensions();
+  return check_result("test_blackbox");
+}
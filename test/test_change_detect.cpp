@@ -0,0 +1,205 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/test_change_detect.cpp
+  change_detect.h on size sequences, and through change_skip.h on a
+  recording in the stream's own framing
+
+*/
+
+#include "change_skip.h"
+#include "check.h"
+#include <random>
+
+#define FRAME_US 100000   // 10 fps
+#define KEEPALIVE_MS 1000
+
+// Noise around len, within +-spread_permille
+static uint32_t jitter(std::mt19937 &rng, uint32_t len, uint32_t spread_permille)
+{
+  int32_t spread = len * spread_permille / 1000;
+  return len + (int32_t)(rng() % (2 * spread + 1)) - spread;
+}
+
+static void test_differs()
+{
+  // Strictly more than the threshold, relative to the reference
+  CHECK(!change_detect_differs(10010, 10000, 1));
+  CHECK(change_detect_differs(10011, 10000, 1));
+  CHECK(!change_detect_differs(9990, 10000, 1));
+  CHECK(change_detect_differs(9989, 10000, 1));
+  CHECK(!change_detect_differs(5000, 5000, 0));
+  CHECK(change_detect_differs(5001, 5000, 0));
+  // No overflow at the largest sizes
+  CHECK(!change_detect_differs(UINT32_MAX, UINT32_MAX - 1000, 1));
+  CHECK(change_detect_differs(UINT32_MAX, UINT32_MAX / 2, 10));
+}
+
+static void test_still_scene()
+{
+  change_detect_t d = {};
+  int64_t t = 1000000;
+  // The first frame always goes out, then the settle frames
+  CHECK(change_detect_send(&d, 20000, t, 10, KEEPALIVE_MS));
+  for (int i = 0; i < CHANGE_SETTLE_FRAMES; i++)
+    CHECK(change_detect_send(&d, 20000, t += FRAME_US, 10, KEEPALIVE_MS));
+
+  // Identical frames are skipped until the keepalive is due
+  int64_t sent_at = t;
+  while (t + FRAME_US - sent_at < KEEPALIVE_MS * 1000)
+    CHECK(!change_detect_send(&d, 20000, t += FRAME_US, 10, KEEPALIVE_MS));
+  CHECK(change_detect_send(&d, 20000, t += FRAME_US, 10, KEEPALIVE_MS));
+  CHECK(!change_detect_send(&d, 20000, t += FRAME_US, 10, KEEPALIVE_MS));
+}
+
+static void test_change_and_settle()
+{
+  change_detect_t d = {};
+  int64_t t = 0;
+  for (int i = 0; i < 10; i++)
+    change_detect_send(&d, 20000, t += FRAME_US, 10, KEEPALIVE_MS);
+  CHECK(!change_detect_send(&d, 20000, t += FRAME_US, 10, KEEPALIVE_MS));
+
+  // A jump goes out, then the next frames settle even when they match it
+  CHECK(change_detect_send(&d, 24000, t += FRAME_US, 10, KEEPALIVE_MS));
+  for (int i = 0; i < CHANGE_SETTLE_FRAMES; i++)
+    CHECK(change_detect_send(&d, 24000, t += FRAME_US, 10, KEEPALIVE_MS));
+  CHECK(!change_detect_send(&d, 24000, t += FRAME_US, 10, KEEPALIVE_MS));
+
+  // A jump back is a change from both references
+  CHECK(change_detect_send(&d, 20000, t += FRAME_US, 10, KEEPALIVE_MS));
+}
+
+static void test_slow_drift()
+{
+  // 0.5% per frame never differs from the previous frame at 1%, but drifts
+  // away from the last frame sent
+  change_detect_t d = {};
+  int64_t t = 0;
+  uint32_t len = 20000;
+  for (int i = 0; i <= CHANGE_SETTLE_FRAMES; i++)
+    change_detect_send(&d, len, t += FRAME_US, 10, KEEPALIVE_MS);
+  CHECK(!change_detect_send(&d, len += 100, t += FRAME_US, 10, KEEPALIVE_MS));
+  CHECK(!change_detect_send(&d, len += 100, t += FRAME_US, 10, KEEPALIVE_MS));
+  CHECK(change_detect_send(&d, len += 100, t += FRAME_US, 10, KEEPALIVE_MS));
+}
+
+static void test_threshold_zero()
+{
+  // With no tolerance only byte-identical sizes are skipped
+  change_detect_t d = {};
+  int64_t t = 0;
+  for (int i = 0; i <= CHANGE_SETTLE_FRAMES; i++)
+    change_detect_send(&d, 1000, t += FRAME_US, 0, KEEPALIVE_MS);
+  CHECK(!change_detect_send(&d, 1000, t += FRAME_US, 0, KEEPALIVE_MS));
+  CHECK(change_detect_send(&d, 1001, t += FRAME_US, 0, KEEPALIVE_MS));
+}
+
+// One /stream part as stream_part and stream_client_task send it: part
+// headers, SOI and the COM segment, the rest of the JPEG, the boundary
+static std::string stream_part(uint32_t seq, int64_t capture_us, uint32_t len)
+{
+  uint32_t cap_s = capture_us / 1000000, cap_us = capture_us % 1000000;
+  int64_t send_us = capture_us + 3000;
+  uint32_t send_s = send_us / 1000000, send_frac = send_us % 1000000;
+  char com[64];
+  int com_len = snprintf(com, sizeof(com), "seq=%u capture=%u.%06u send=%u.%06u", seq, cap_s, cap_us, send_s,
+                         send_frac);
+  char headers[256];
+  snprintf(headers, sizeof(headers),
+           "Content-Type: image/jpeg\r\nContent-Length: %u\r\n"
+           "X-Frame-Seq: %u\r\nX-Timestamp: %u.%06u\r\nX-Send-Timestamp: %u.%06u\r\n\r\n",
+           len + 4 + com_len, seq, cap_s, cap_us, send_s, send_frac);
+  std::string part = headers;
+  uint16_t seg_len = com_len + 2;
+  part += std::string("\xff\xd8\xff\xfe", 4) + (char)(seg_len >> 8) + (char)seg_len + com;
+  // The hub frame after its SOI: filler standing in for the scan, with the
+  // boundary's own bytes in it, then EOI
+  std::string body(len - 4, 'x');
+  body.replace(len / 2, 8, "\r\n--1234");
+  part += body + "\xff\xd9";
+  return part + "\r\n--123456789000000000000987654321\r\n";
+}
+
+// Ten seconds parked, three driving, ten parked again, at 10 fps
+static std::vector<recorded_frame_t> drive_and_park(std::mt19937 &rng)
+{
+  std::vector<recorded_frame_t> frames;
+  int64_t t = 5000000;
+  for (int i = 0; i < 100; i++)
+    frames.push_back({t += FRAME_US, jitter(rng, 20000, 3)});
+  for (int i = 0; i < 30; i++)
+    frames.push_back({t += FRAME_US, jitter(rng, 26000, 100)});
+  for (int i = 0; i < 100; i++)
+    frames.push_back({t += FRAME_US, jitter(rng, 23000, 3)});
+  return frames;
+}
+
+static void test_recording()
+{
+  std::mt19937 rng(5);
+  std::vector<recorded_frame_t> sizes = drive_and_park(rng);
+  std::string recording = "HTTP/1.1 200 OK\r\n\r\n";
+  for (size_t i = 0; i < sizes.size(); i++)
+    recording += stream_part(i + 1, sizes[i].capture_us, sizes[i].len);
+
+  // The reader gets back the hub frames' lengths and capture times
+  std::vector<recorded_frame_t> frames;
+  change_skip_parse(recording, 10.0, &frames);
+  CHECK(frames.size() == sizes.size());
+  bool same = frames.size() == sizes.size();
+  for (size_t i = 0; same && i < frames.size(); i++)
+    same = frames[i].len == sizes[i].len && frames[i].capture_us == sizes[i].capture_us;
+  CHECK(same);
+
+  // At 1% the parked stretches go out once per keepalive and the drive in
+  // full; nothing is ever held back longer than the keepalive
+  change_skip_result_t r = change_skip_replay(frames, 10, KEEPALIVE_MS);
+  CHECK(r.sent + r.skipped == frames.size());
+  CHECK(r.max_gap_us <= KEEPALIVE_MS * 1000);
+  CHECK(r.sent >= 30 && r.sent <= 30 + 2 * (10 + 1 + CHANGE_SETTLE_FRAMES));
+  CHECK(r.skipped_bytes * 100 / (r.sent_bytes + r.skipped_bytes) >= 60);
+  change_detect_t d = {};
+  size_t driving_sent = 0;
+  for (size_t i = 0; i < frames.size(); i++)
+    if (change_detect_send(&d, frames[i].len, frames[i].capture_us, 10, KEEPALIVE_MS) && i >= 100 && i < 130)
+      driving_sent++;
+  CHECK(driving_sent >= 25);
+
+  // Below the sensor noise nothing is skipped
+  change_skip_result_t strict = change_skip_replay(frames, 1, KEEPALIVE_MS);
+  CHECK(strict.sent > r.sent);
+  CHECK(strict.max_gap_us <= r.max_gap_us);
+}
+
+static void test_single_frames()
+{
+  // A saved frame keeps its COM segment; one without takes the fps spacing
+  std::string part = stream_part(7, 12345678, 4000);
+  std::string jpeg = part.substr(part.find("\r\n\r\n") + 4);
+  jpeg.resize(jpeg.find("\r\n--123456789000000000000987654321"));
+  std::vector<recorded_frame_t> frames;
+  change_skip_parse(jpeg, 10.0, &frames);
+  change_skip_parse(std::string("\xff\xd8", 2) + std::string(998, 'x'), 10.0, &frames);
+  CHECK(frames.size() == 2);
+  CHECK(frames[0].capture_us == 12345678 && frames[0].len == 4000);
+  CHECK(frames[1].capture_us == 100000 && frames[1].len == 1000);
+
+  // A truncated last part is dropped
+  frames.clear();
+  std::string recording = stream_part(1, 1000000, 5000) + stream_part(2, 1100000, 5000);
+  recording.resize(recording.size() - 100);
+  change_skip_parse(recording, 10.0, &frames);
+  CHECK(frames.size() == 1);
+}
+
+int main()
+{
+  test_differs();
+  test_still_scene();
+  test_change_and_settle();
+  test_slow_drift();
+  test_threshold_zero();
+  test_recording();
+  test_single_frames();
+  return check_result("test_change_detect");
+}
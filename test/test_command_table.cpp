@@ -0,0 +1,215 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/test_command_table.cpp
+  Query parsing, value parsing and table lookup from command_table.h
+
+*/
+
+#include "command_table.h"
+#include "check.h"
+
+static int last_val = -1;
+
+static esp_err_t record(int val)
+{
+  last_val = val;
+  return ESP_OK;
+}
+
+static constexpr command_t TABLE[] = {
+    {"car",        0x01, 1,   5,   record},
+    {"speed",      0x02, 0,   255, record},
+    {"framesize",  0x04, 0,   13,  record},
+    {"drive",      0x0C, INT16_MIN, INT16_MAX, record},
+};
+static constexpr command_index_t INDEX = command_index_build(TABLE);
+static_assert(INDEX.valid, "test table collides");
+
+// The parser works in place, so every case gets its own copy
+static bool parse(const char *query, const char **var, const char **val,
+                  const char **seq = NULL, const char **ts = NULL)
+{
+  static char buf[512];
+  snprintf(buf, sizeof(buf), "%s", query);
+  return command_parse_query(buf, var, val, seq, ts);
+}
+
+static void test_valid_queries()
+{
+  const char *var, *val, *seq, *ts;
+  CHECK(parse("var=speed&val=200", &var, &val));
+  CHECK_STR(var, "speed");
+  CHECK_STR(val, "200");
+
+  // Field order does not matter and unknown fields are ignored
+  CHECK(parse("val=3&cache=123&var=car", &var, &val));
+  CHECK_STR(var, "car");
+  CHECK_STR(val, "3");
+
+  CHECK(parse("var=car&val=1&seq=42&t=123456", &var, &val, &seq, &ts));
+  CHECK_STR(seq, "42");
+  CHECK_STR(ts, "123456");
+
+  // seq and t are only looked for when asked for
+  CHECK(parse("var=car&val=1&seq=42&t=123456", &var, &val));
+}
+
+static void test_without_trace_fields()
+{
+  // Legacy clients send no seq or t; both outputs must come back NULL
+  // whatever the caller left in them
+  const char *var, *val;
+  const char *seq = "stale", *ts = "stale";
+  CHECK(parse("var=car&val=1", &var, &val, &seq, &ts));
+  CHECK(seq == NULL);
+  CHECK(ts == NULL);
+
+  seq = ts = "stale";
+  CHECK(parse("var=car&val=1&seq=7", &var, &val, &seq, &ts));
+  CHECK_STR(seq, "7");
+  CHECK(ts == NULL);
+
+  seq = ts = "stale";
+  CHECK(!parse("", &var, &val, &seq, &ts));
+  CHECK(seq == NULL);
+  CHECK(ts == NULL);
+}
+
+static void test_missing_and_empty()
+{
+  const char *var, *val;
+  CHECK(!command_parse_query(NULL, &var, &val));
+  CHECK(var == NULL && val == NULL);
+  CHECK(!parse("", &var, &val));
+  CHECK(!parse("var=speed", &var, &val));
+  CHECK(!parse("val=10", &var, &val));
+  CHECK(!parse("var=&val=10", &var, &val));
+  CHECK(!parse("var=speed&val=", &var, &val));
+  CHECK(!parse("&&&", &var, &val));
+}
+
+static void test_malformed()
+{
+  const char *var, *val;
+  CHECK(!parse("var", &var, &val));
+  CHECK(!parse("varspeed&val10", &var, &val));
+  CHECK(!parse("=speed&=10", &var, &val));
+  CHECK(!parse("VAR=speed&VAL=10", &var, &val));
+
+  // Only the first '=' splits a field, so the value keeps the rest, which
+  // command_parse_int then rejects
+  CHECK(parse("var=speed&val=1=2", &var, &val));
+  CHECK_STR(val, "1=2");
+  int v;
+  CHECK(!command_parse_int(val, &v));
+
+  // A repeated field takes the last value
+  CHECK(parse("var=car&val=1&val=2", &var, &val));
+  CHECK_STR(val, "2");
+}
+
+static void test_oversized()
+{
+  // control_request rejects queries of COMMAND_MAX_QUERY bytes or more
+  // before parsing; everything a client legitimately sends fits
+  static_assert(sizeof("var=change_keepalive&val=-32768&seq=65535&t=4294967295") <= COMMAND_MAX_QUERY,
+                "COMMAND_MAX_QUERY too small for a full traced command");
+
+  // The parser itself never writes past the terminator, whatever the length
+  char query[4 * COMMAND_MAX_QUERY];
+  memset(query, 'x', sizeof(query));
+  memcpy(query, "var=", 4);
+  memcpy(query + sizeof(query) - 8, "&val=12", 8);
+  const char *var, *val;
+  CHECK(command_parse_query(query, &var, &val));
+  CHECK(strlen(var) == sizeof(query) - 4 - 8);
+  CHECK_STR(val, "12");
+  CHECK(command_find(TABLE, INDEX, var) == NULL);
+}
+
+static void test_parse_int()
+{
+  int v = 99;
+  CHECK(command_parse_int("0", &v) && v == 0);
+  CHECK(command_parse_int("-1", &v) && v == -1);
+  CHECK(command_parse_int("+7", &v) && v == 7);
+  CHECK(command_parse_int("32767", &v) && v == 32767);
+  CHECK(command_parse_int("-32768", &v) && v == -32768);
+
+  // Overflow, including values that overflow long
+  v = 99;
+  CHECK(!command_parse_int("32768", &v));
+  CHECK(!command_parse_int("-32769", &v));
+  CHECK(!command_parse_int("4294967296", &v));
+  CHECK(!command_parse_int("99999999999999999999999", &v));
+  CHECK(!command_parse_int("-99999999999999999999999", &v));
+
+  // Trailing junk and empty input
+  CHECK(!command_parse_int("", &v));
+  CHECK(!command_parse_int("-", &v));
+  CHECK(!command_parse_int("12abc", &v));
+  CHECK(!command_parse_int("12 ", &v));
+  CHECK(!command_parse_int("1.5", &v));
+  CHECK(!command_parse_int("0x10", &v));
+  CHECK(!command_parse_int("abc", &v));
+  CHECK(v == 99);
+}
+
+static void test_lookup()
+{
+  const command_t *cmd = command_find(TABLE, INDEX, "speed");
+  CHECK(cmd && cmd->opcode == 0x02);
+  CHECK(command_find(TABLE, INDEX, "Speed") == NULL);
+  CHECK(command_find(TABLE, INDEX, "spee") == NULL);
+  CHECK(command_find(TABLE, INDEX, "") == NULL);
+
+  CHECK(command_find(TABLE, INDEX, (uint8_t)0x0C) == &TABLE[3]);
+  CHECK(command_find(TABLE, INDEX, (uint8_t)0x03) == NULL);
+  CHECK(command_find(TABLE, INDEX, (uint8_t)(COMMAND_MAX_OPCODE + 1)) == NULL);
+  CHECK(command_find(TABLE, INDEX, (uint8_t)0xFF) == NULL);
+
+  // Every name hashing into a used bucket must still be rejected
+  for (const command_t &row : TABLE)
+    for (char c = 'a'; c <= 'z'; c++)
+    {
+      char name[32];
+      snprintf(name, sizeof(name), "%s%c", row.name, c);
+      CHECK(command_find(TABLE, INDEX, name) == NULL);
+    }
+
+  cmd = command_find(TABLE, INDEX, "car");
+  CHECK(command_in_range(cmd, 1) && command_in_range(cmd, 5));
+  CHECK(!command_in_range(cmd, 0) && !command_in_range(cmd, 6));
+  CHECK(cmd->handler(4) == ESP_OK && last_val == 4);
+}
+
+static void test_collisions()
+{
+  static constexpr command_t same_opcode[] = {
+      {"a", 0x01, 0, 1, record},
+      {"b", 0x01, 0, 1, record},
+  };
+  static constexpr command_t same_name[] = {
+      {"a", 0x01, 0, 1, record},
+      {"a", 0x02, 0, 1, record},
+  };
+  static constexpr command_t opcode_too_big[] = {
+      {"a", COMMAND_MAX_OPCODE + 1, 0, 1, record},
+  };
+  static_assert(!command_index_build(same_opcode).valid, "duplicate opcode accepted");
+  static_assert(!command_index_build(same_name).valid, "duplicate name accepted");
+  static_assert(!command_index_build(opcode_too_big).valid, "out of range opcode accepted");
+}
+
+int main()
+{
+  test_valid_queries();
+  test_without_trace_fields();
+  test_missing_and_empty();
+  test_malformed();
+  test_oversized();
+  test_parse_int();
+  test_lookup();
+  test_collisions();
+  return check_result("test_command_table");
+}
@@ -0,0 +1,198 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/test_command_trace.cpp
+  Latency traces: the ring and its wrap, stale marks, the seq and t query
+  fields on /control with and without them, and the /trace export, on the
+  sketch's servers with a frozen clock so every time is exact
+
+*/
+
+#include "app_sim.h"
+#include "command_trace.h"
+#include "esp_timer.h"
+#include "check.h"
+#include <vector>
+
+static std::vector<trace_t> snapshot()
+{
+  std::vector<trace_t> out(TRACE_RING_SIZE);
+  out.resize(trace_snapshot(out.data(), out.size()));
+  return out;
+}
+
+static void test_ring()
+{
+  // Off until enabled, and nothing is allocated or recorded
+  CHECK(!trace_enabled);
+  CHECK(trace_begin(0x02, 1, 1, 1, 0) == 0);
+  trace_dispatch(0, 1);
+  trace_actuate(0, 1);
+  CHECK(snapshot().empty());
+
+  CHECK(trace_set_enabled(true) == ESP_OK);
+  uint32_t first = trace_begin(0x02, 100, 1, 5000, 1000);
+  CHECK(first != 0);
+  trace_dispatch(first, 1250);
+  std::vector<trace_t> traces = snapshot();
+  CHECK(traces.size() == 1);
+  CHECK(traces[0].id == first && traces[0].seq == 1 && traces[0].opcode == 0x02 && traces[0].value == 100);
+  CHECK(traces[0].client_ms == 5000 && traces[0].received_us == 1000);
+  CHECK(traces[0].dispatch_us == 250);
+  CHECK(traces[0].actuate_us == 0);   // still pending
+
+  // Actuation at receipt still reads as done; marks before receipt clamp to 0
+  trace_actuate(first, 1000);
+  CHECK(snapshot()[0].actuate_us == 1);
+  trace_dispatch(first, 900);
+  CHECK(snapshot()[0].dispatch_us == 0);
+
+  // Past the ring size the oldest go, and the rest stay oldest first
+  for (int i = 2; i <= TRACE_RING_SIZE + 5; i++)
+    trace_begin(0x02, i, i, 0, i * 1000);
+  traces = snapshot();
+  CHECK(traces.size() == TRACE_RING_SIZE);
+  CHECK(traces.front().seq == 6 && traces.back().seq == TRACE_RING_SIZE + 5);
+  bool ordered = true;
+  for (size_t i = 1; i < traces.size(); i++)
+    ordered = ordered && traces[i].id == traces[i - 1].id + 1 && traces[i].seq == traces[i - 1].seq + 1;
+  CHECK(ordered);
+
+  // A mark for a trace whose slot was reused leaves the new one alone
+  trace_actuate(first, 999999);
+  for (const trace_t &t : snapshot())
+    CHECK(t.actuate_us == 0);
+
+  // Snapshots stop at max
+  trace_t few[3];
+  CHECK(trace_snapshot(few, 3) == 3 && few[0].seq == 6 && few[2].seq == 8);
+
+  // Turning tracing off keeps the ring for reading; back on clears it
+  CHECK(trace_set_enabled(false) == ESP_OK);
+  CHECK(trace_begin(0x02, 1, 1, 1, 0) == 0);
+  CHECK(snapshot().size() == TRACE_RING_SIZE);
+  CHECK(trace_set_enabled(true) == ESP_OK);
+  CHECK(snapshot().empty());
+  CHECK(trace_set_enabled(false) == ESP_OK);
+}
+
+static std::string trace_json(const trace_t &t, const char *cmd)
+{
+  char buf[200];
+  snprintf(buf, sizeof(buf),
+           "{\"seq\":%u,\"t\":%u,\"cmd\":\"%s\",\"val\":%d,\"received_us\":%lld,\"dispatch_us\":%u,\"actuate_us\":%u}",
+           t.seq, t.client_ms, cmd, t.value, (long long)t.received_us, t.dispatch_us, t.actuate_us);
+  return buf;
+}
+
+static bool control(const char *uri)
+{
+  return app_get(camera_httpd, uri).status == 200;
+}
+
+static void test_query_fields()
+{
+  CHECK(control("/control?var=latency_trace&val=1"));
+  CHECK(trace_enabled);
+  // Enabling does not trace itself
+  CHECK(snapshot().empty());
+
+  int64_t now = esp_timer_get_time();
+  CHECK(control("/control?var=speed&val=200"));
+  CHECK(control("/control?var=speed&val=201&seq=7&t=123456"));
+  CHECK(control("/control?seq=8&t=4000000000&var=speed&val=202"));
+  CHECK(control("/control?var=speed&val=203&seq=9"));
+  CHECK(control("/control?var=speed&val=204&t=55"));
+  // Malformed trace fields are recorded as absent, not rejected
+  CHECK(control("/control?var=speed&val=205&seq=abc&t="));
+  // seq is 16 bits, as on /ws
+  CHECK(control("/control?var=speed&val=206&seq=65537"));
+  // A rejected command is not traced
+  CHECK(app_get(camera_httpd, "/control?var=speed&val=300&seq=10").status == 400);
+
+  const struct
+  {
+    int value;
+    uint16_t seq;
+    uint32_t client_ms;
+  } expected[] = {{200, 0, 0}, {201, 7, 123456}, {202, 8, 4000000000u}, {203, 9, 0},
+                  {204, 0, 55}, {205, 0, 0}, {206, 1, 0}};
+  std::vector<trace_t> traces = snapshot();
+  CHECK(traces.size() == sizeof(expected) / sizeof(expected[0]));
+  for (size_t i = 0; i < traces.size() && i < sizeof(expected) / sizeof(expected[0]); i++)
+  {
+    CHECK(traces[i].value == expected[i].value);
+    CHECK(traces[i].seq == expected[i].seq);
+    CHECK(traces[i].client_ms == expected[i].client_ms);
+    // The clock is frozen, so dispatch and actuation land at receipt
+    CHECK(traces[i].received_us == now);
+    CHECK(traces[i].dispatch_us == 0 && traces[i].actuate_us == 1);
+  }
+}
+
+static void test_drive_actuation()
+{
+  CHECK(trace_set_enabled(false) == ESP_OK);
+  CHECK(trace_set_enabled(true) == ESP_OK);
+  // Line up with a drive_task tick, so the next one is a whole period away
+  host_clock_advance(20000 - esp_timer_get_time() % 20000);
+
+  // Stepped drive reaches the outputs inside the handler
+  CHECK(control("/control?var=car&val=1&seq=1"));
+  // Continuous drive waits for the next tick
+  CHECK(control("/control?var=drive&val=100&seq=2"));
+  std::vector<trace_t> traces = snapshot();
+  CHECK(traces.size() == 2 && traces[0].actuate_us == 1 && traces[1].actuate_us == 0);
+  host_clock_advance(20000);
+  traces = snapshot();
+  CHECK(traces.size() == 2 && traces[1].actuate_us == 20000);
+  CHECK(control("/control?var=car&val=3"));
+}
+
+static void test_export()
+{
+  CHECK(trace_set_enabled(false) == ESP_OK);
+  CHECK(control("/control?var=latency_trace&val=1"));
+  for (int i = 1; i <= TRACE_RING_SIZE + 3; i++)
+  {
+    char uri[80];
+    snprintf(uri, sizeof(uri), "/control?var=speed&val=%d&seq=%d&t=%d", i, i, i * 10);
+    CHECK(control(uri));
+    host_clock_advance(1000);
+  }
+
+  app_response_t resp = app_get(camera_httpd, "/trace");
+  CHECK(resp.status == 200 && resp.complete);
+  CHECK(app_header(resp, "Content-Type") == "application/json");
+  CHECK(app_header(resp, "Access-Control-Allow-Origin") == "*");
+  std::vector<trace_t> traces = snapshot();
+  CHECK(traces.size() == TRACE_RING_SIZE && traces[0].seq == 4);
+  std::string body = "{\"enabled\":1,\"traces\":[";
+  for (size_t i = 0; i < traces.size(); i++)
+    body += (i ? "," : "") + trace_json(traces[i], "speed");
+  body += "]}";
+  CHECK(resp.body == body);
+  CHECK(resp.body.find(",{\"seq\":67,\"t\":670,\"cmd\":\"speed\",\"val\":67,\"received_us\":" +
+                       std::to_string(traces.back().received_us) + ",\"dispatch_us\":0,\"actuate_us\":1}]}") !=
+        std::string::npos);
+
+  // Still readable once tracing is off
+  CHECK(control("/control?var=latency_trace&val=0"));
+  resp = app_get(camera_httpd, "/trace");
+  CHECK(!resp.body.compare(0, 24, "{\"enabled\":0,\"traces\":[{"));
+  CHECK(resp.body.find(trace_json(traces.back(), "speed")) != std::string::npos);
+
+  // Empty ring
+  CHECK(trace_set_enabled(true) == ESP_OK);
+  CHECK(app_get(camera_httpd, "/trace").body == "{\"enabled\":1,\"traces\":[]}");
+  CHECK(trace_set_enabled(false) == ESP_OK);
+}
+
+int main()
+{
+  app_start();
+  test_ring();
+  test_query_fields();
+  test_drive_actuation();
+  test_export();
+  return check_result("test_command_trace");
+}
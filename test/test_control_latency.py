@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+"""Run the control_latency.py paths against app_standin.
+
+app_standin serves the firmware's own handlers from app_httpd.cpp on
+loopback; its path is the first argument. Checks that every command on
+each path is answered, that the firmware counted each GET /control, and
+that a /ws record reaches the handler the same as its GET.
+"""
+
+import json
+import os
+import re
+import subprocess
+import sys
+import urllib.request
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "tools"))
+
+import control_latency  # noqa: E402
+
+COUNT = 50
+RATE = 200.0
+
+failures = 0
+
+
+def check(cond, what):
+    global failures
+    if not cond:
+        print("FAIL: %s" % what)
+        failures += 1
+
+
+def start_standin(path):
+    proc = subprocess.Popen([path, "--port", "0", "--stream-port", "0"], stdout=subprocess.PIPE, text=True)
+    ports = {}
+    for _ in range(2):
+        name, port = proc.stdout.readline().split()
+        ports[name] = int(port)
+    return proc, ports["control"]
+
+
+def get(base, path):
+    with urllib.request.urlopen(base + path, timeout=5) as r:
+        return r.read().decode()
+
+
+def endpoint_requests(base, endpoint):
+    m = re.search(r'^robot_http_requests_total\{endpoint="%s"\} (\d+)$' % re.escape(endpoint),
+                  get(base, "/metrics"), re.M)
+    return int(m.group(1)) if m else -1
+
+
+def main():
+    proc, port = start_standin(sys.argv[1])
+    try:
+        return run(port)
+    finally:
+        proc.kill()
+        proc.wait()
+
+
+def run(port):
+    base = "http://127.0.0.1:%d" % port
+
+    results = control_latency.run_all("127.0.0.1", port, "speed", 200, COUNT, RATE)
+    check([r.name for r in results] == ["get-new", "get-reuse", "ws"], "paths %s" % [r.name for r in results])
+    for r in results:
+        check(r.failures == 0 and len(r.latencies) == COUNT, "%s %d ok %d failed" % (
+            r.name, len(r.latencies), r.failures))
+        print("%-9s %s" % (r.name, control_latency.fmt_ms(r.latencies)))
+    commands = endpoint_requests(base, "GET /control")
+    check(commands == 2 * COUNT, "firmware counted %d /control requests" % commands)
+
+    # A setting sent down /ws shows in /status, as the GET would leave it
+    for quality in (12, 20):
+        ws = control_latency.run_ws("127.0.0.1", port, control_latency.OPCODES["quality"], quality, 1, RATE)
+        check(ws.failures == 0 and len(ws.latencies) == 1, "quality %d on /ws not acked" % quality)
+        status = json.loads(get(base, "/status"))
+        check(status.get("quality") == quality, "quality %s after /ws set %d" % (status.get("quality"), quality))
+
+    # A record the handler refuses is acked with a non-zero status, and counted as a failure
+    ws = control_latency.run_ws("127.0.0.1", port, control_latency.OPCODES["quality"], 99, 1, RATE)
+    check(ws.failures == 1 and not ws.latencies, "refused /ws record counted as ok")
+
+    print("test_control_latency: %s" % ("ok" if not failures else "%d check(s) failed" % failures))
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
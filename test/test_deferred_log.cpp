@@ -0,0 +1,154 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/test_deferred_log.cpp
+  Concurrency stress test of the deferred log ring: several producer
+  threads against the real drain task, checking that nothing is lost,
+  duplicated, torn or reordered, and that drops are counted. Records
+  written before the drain task starts are kept.
+
+*/
+
+#include "deferred_log.h"
+#include "check.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define PRODUCERS 4
+#define RECORDS_PER_PRODUCER 1500
+
+static std::atomic<uint32_t> rejected(0);
+
+// Every record carries its producer, a per-producer sequence and a check
+// word, so a record torn between two writers shows up as a mismatch
+static uint32_t check_word(uint32_t producer, uint32_t seq)
+{
+  return (seq * 2654435761u) ^ (producer << 24);
+}
+
+static void producer(uint32_t id)
+{
+  for (uint32_t seq = 0; seq < RECORDS_PER_PRODUCER; seq++)
+  {
+    // A full ring drops the record; try again until it is accepted so
+    // every sequence number should arrive exactly once
+    while (!dlog_write(DLOG_MJPG_FRAME, id, seq, check_word(id, seq) & 0xffff, check_word(id, seq) >> 16, seq & 7))
+    {
+      rejected.fetch_add(1);
+      std::this_thread::yield();
+    }
+  }
+}
+
+// Records written before dlog_start wait in the ring; once it is full the
+// rest are dropped and counted
+static void test_before_start()
+{
+  for (uint32_t i = 0; i < DLOG_RING_SIZE + 3; i++)
+    CHECK(dlog_write(DLOG_COMMAND, (uintptr_t)"early", i) == (i < DLOG_RING_SIZE));
+  CHECK(dlog_dropped() == 3);
+
+  dlog_start();
+  std::string out;
+  for (int waited = 0; out.find("[log] 3 records dropped") == std::string::npos && waited < 40; waited++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(25));
+    out += host_serial_take();
+  }
+  uint32_t next = 0;
+  size_t pos = 0;
+  unsigned ms, value;
+  while ((pos = out.find('[', pos)) != std::string::npos)
+  {
+    if (sscanf(out.c_str() + pos, "[%u] Command early=%u", &ms, &value) == 2 && value == next)
+      next++;
+    pos++;
+  }
+  CHECK(next == DLOG_RING_SIZE);
+  CHECK(out.find("[log] 3 records dropped") != std::string::npos);
+}
+
+static void test_level_filter()
+{
+  uint32_t dropped = dlog_dropped();
+  dlog_set_level(DLOG_LEVEL_INFO);
+  CHECK(dlog_get_level() == DLOG_LEVEL_INFO);
+  CHECK(!dlog_write(DLOG_MJPG_FRAME, 0, 0, 0, 0, 0));
+  CHECK(!dlog_write(DLOG_FORMAT_COUNT));
+  // Filtered records are not drops
+  CHECK(dlog_dropped() == dropped);
+}
+
+static void test_stress()
+{
+  dlog_set_level(DLOG_LEVEL_DEBUG);
+  uint32_t dropped_before = dlog_dropped();
+
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < PRODUCERS; i++)
+    threads.emplace_back(producer, i);
+  for (std::thread &t : threads)
+    t.join();
+
+  // Wait for the drain task to catch up
+  uint32_t expected = PRODUCERS * RECORDS_PER_PRODUCER;
+  uint32_t next[PRODUCERS] = {};
+  uint32_t received = 0, torn = 0, out_of_order = 0, garbage = 0;
+  std::string pending;
+  for (int waited = 0; received < expected && waited < 200; waited++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(25));
+    pending += host_serial_take();
+    size_t start = 0, end;
+    while ((end = pending.find('\n', start)) != std::string::npos)
+    {
+      std::string line = pending.substr(start, end - start);
+      start = end + 1;
+      unsigned ms, id, seq, lo, hi, low_bits;
+      if (sscanf(line.c_str(), "[%u] MJPG[%u]: %uB %ums (%ufps) skipped %u",
+                 &ms, &id, &seq, &lo, &hi, &low_bits) != 6)
+      {
+        // Drop reports are the only other output
+        if (line.find("records dropped") == std::string::npos)
+          garbage++;
+        continue;
+      }
+      received++;
+      if (id >= PRODUCERS)
+      {
+        garbage++;
+        continue;
+      }
+      if (lo != (check_word(id, seq) & 0xffff) || hi != check_word(id, seq) >> 16 || low_bits != (seq & 7))
+        torn++;
+      if (seq != next[id])
+        out_of_order++;
+      next[id] = seq + 1;
+    }
+    pending.erase(0, start);
+  }
+
+  CHECK(received == expected);
+  CHECK(torn == 0);
+  CHECK(out_of_order == 0);
+  CHECK(garbage == 0);
+  for (uint32_t i = 0; i < PRODUCERS; i++)
+    CHECK(next[i] == RECORDS_PER_PRODUCER);
+  // Every rejected write was counted as a drop, and nothing else was
+  CHECK(dlog_dropped() - dropped_before == rejected.load());
+  printf("%u records from %d producers, %u drops while the ring was full\n",
+         received, PRODUCERS, rejected.load());
+}
+
+int main()
+{
+  test_before_start();
+  test_level_filter();
+  test_stress();
+  // The drain task never returns; leave without running static destructors
+  // under it
+  int result = check_result("test_deferred_log");
+  fflush(stdout);
+  _Exit(result);
+}
@@ -0,0 +1,214 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/test_delta_patch.cpp
+  Patches made by tools/delta_ota.py, applied through ota_delta.cpp into
+  the file-backed OTA partitions: the target digest and contents, patches
+  for another image refused before anything is written, and damaged or
+  short patches failing without switching the boot partition
+
+*/
+
+#include "ota_delta.h"
+#include "delta_patch.h"
+#include "esp_partition.h"
+#include "mbedtls/sha256.h"
+#include "check.h"
+#include <string>
+#include <vector>
+
+typedef std::vector<uint8_t> bytes_t;
+
+static char dir[] = "/tmp/test_delta_XXXXXX";
+
+// Random bytes standing in for code, 0xE9 first like an ESP32 image
+static bytes_t old_image(size_t len)
+{
+  bytes_t image(len);
+  uint32_t seed = 7;
+  for (size_t i = 0; i < len; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    image[i] = seed >> 16;
+  }
+  image[0] = 0xe9;
+  return image;
+}
+
+// A rebuild: a function grows, another shrinks, and code after them calls
+// through addresses that all moved
+static bytes_t new_image(const bytes_t &old)
+{
+  bytes_t image(old.begin(), old.begin() + 100000);
+  for (int i = 0; i < 3000; i++)
+    image.push_back(i * 31);
+  image.insert(image.end(), old.begin() + 100000, old.begin() + 200000);
+  image.insert(image.end(), old.begin() + 202000, old.end());
+  for (size_t pos = 120000; pos + 4 <= image.size(); pos += 4096)
+    image[pos + 1] += 0x0b;
+  return image;
+}
+
+static std::string sha256(const bytes_t &data)
+{
+  mbedtls_sha256_context ctx;
+  uint8_t sha[OTA_SHA256_LEN];
+  mbedtls_sha256_init(&ctx);
+  mbedtls_sha256_starts(&ctx, 0);
+  mbedtls_sha256_update(&ctx, data.data(), data.size());
+  mbedtls_sha256_finish(&ctx, sha);
+  return std::string((const char *)sha, sizeof(sha));
+}
+
+static void write_file(const std::string &path, const bytes_t &data)
+{
+  FILE *f = fopen(path.c_str(), "wb");
+  CHECK(f && fwrite(data.data(), 1, data.size(), f) == data.size());
+  if (f)
+    fclose(f);
+}
+
+static bytes_t read_file(const std::string &path)
+{
+  bytes_t data;
+  FILE *f = fopen(path.c_str(), "rb");
+  int c;
+  while (f && (c = fgetc(f)) != EOF)
+    data.push_back(c);
+  if (f)
+    fclose(f);
+  return data;
+}
+
+// The patch from old to new as the tool makes it
+static bytes_t make_patch(const bytes_t &old, const bytes_t &image)
+{
+  std::string base = dir;
+  write_file(base + "/old.bin", old);
+  write_file(base + "/new.bin", image);
+  std::string cmd = std::string(PYTHON) + " " + DELTA_OTA_PY + " make " + base + "/old.bin " + base +
+                    "/new.bin -o " + base + "/update.rvdp > /dev/null";
+  CHECK(system(cmd.c_str()) == 0);
+  return read_file(base + "/update.rvdp");
+}
+
+// Feed patch in slices the size the /update/delta handler receives
+static bool apply(const bytes_t &patch, size_t slice, uint8_t sha[OTA_SHA256_LEN])
+{
+  if (!ota_delta_begin())
+    return false;
+  for (size_t pos = 0; pos < patch.size(); pos += slice)
+  {
+    size_t n = patch.size() - pos < slice ? patch.size() - pos : slice;
+    if (!ota_delta_write(patch.data() + pos, n))
+    {
+      ota_delta_abort();
+      return false;
+    }
+  }
+  return ota_delta_finish(sha);
+}
+
+static bytes_t partition(int index, size_t len)
+{
+  bytes_t data(len);
+  CHECK(pread(host_flash_get()->app[index].fd, data.data(), len, 0) == (ssize_t)len);
+  return data;
+}
+
+static void test_apply(const bytes_t &old, const bytes_t &image, const bytes_t &patch)
+{
+  // Small against the image, as most of it only moved
+  CHECK(patch.size() > sizeof(delta_header_t));
+  CHECK(patch.size() < image.size() / 20);
+
+  const size_t slices[] = {1460, 1, 97, 65536};
+  for (size_t slice : slices)
+  {
+    host_flash.boot = host_flash.running;
+    uint8_t sha[OTA_SHA256_LEN];
+    CHECK(apply(patch, slice, sha));
+    CHECK(std::string((const char *)sha, sizeof(sha)) == sha256(image));
+    CHECK(host_flash.boot != host_flash.running);
+    CHECK(partition(host_flash.boot, image.size()) == image);
+    // The running image is only read
+    CHECK(partition(host_flash.running, old.size()) == old);
+  }
+  host_flash.boot = host_flash.running;
+}
+
+static void test_wrong_source(const bytes_t &old, const bytes_t &patch)
+{
+  // One byte of the running image differs from the patch's source
+  bytes_t running = old;
+  running[50000] ^= 1;
+  host_flash_load(running.data(), running.size());
+  uint32_t writes = host_flash.writes;
+  uint8_t sha[OTA_SHA256_LEN];
+  CHECK(ota_delta_begin());
+  CHECK(!ota_delta_write(patch.data(), patch.size()));
+  CHECK_STR(ota_delta_error(), "Patch is not for the running firmware");
+  ota_delta_abort();
+  CHECK(host_flash.writes == writes);
+  CHECK(host_flash.boot == host_flash.running);
+
+  // Refused from the header alone, before any of the operations arrive
+  CHECK(ota_delta_begin());
+  CHECK(!ota_delta_write(patch.data(), sizeof(delta_header_t)));
+  CHECK_STR(ota_delta_error(), "Patch is not for the running firmware");
+  ota_delta_abort();
+
+  bytes_t bad = patch;
+  memcpy(bad.data(), "RVDQ", 4);
+  CHECK(!apply(bad, 1460, sha));
+  CHECK(host_flash.writes == writes);
+  host_flash_load(old.data(), old.size());
+}
+
+static void test_damaged(const bytes_t &image, const bytes_t &patch)
+{
+  uint8_t sha[OTA_SHA256_LEN];
+
+  // Cut short: every slice is accepted, finish is not
+  bytes_t cut(patch.begin(), patch.end() - 16);
+  CHECK(!apply(cut, 1460, sha));
+  CHECK_STR(ota_delta_error(), "Incomplete patch");
+  CHECK(host_flash.boot == host_flash.running);
+
+  // A flipped bit in the compressed operations
+  bytes_t corrupt = patch;
+  corrupt[sizeof(delta_header_t) + (patch.size() - sizeof(delta_header_t)) / 2] ^= 0x10;
+  CHECK(!apply(corrupt, 1460, sha));
+  CHECK(host_flash.boot == host_flash.running);
+
+  // Operations intact but the target digest names another image
+  bytes_t retarget = patch;
+  delta_header_t *header = (delta_header_t *)retarget.data();
+  header->target_sha256[0] ^= 1;
+  CHECK(!apply(retarget, 1460, sha));
+  CHECK_STR(ota_delta_error(), "SHA-256 mismatch");
+  CHECK(std::string((const char *)sha, sizeof(sha)) == sha256(image));
+  CHECK(host_flash.boot == host_flash.running);
+
+  bytes_t extra = patch;
+  extra.push_back(0);
+  CHECK(!apply(extra, 1460, sha));
+  CHECK_STR(ota_delta_error(), "Data after end of patch");
+  CHECK(host_flash.boot == host_flash.running);
+}
+
+int main()
+{
+  CHECK(mkdtemp(dir) != NULL);
+  bytes_t old = old_image(400000);
+  bytes_t image = new_image(old);
+  bytes_t patch = make_patch(old, image);
+  host_flash_load(old.data(), old.size());
+
+  test_apply(old, image, patch);
+  test_wrong_source(old, patch);
+  test_damaged(image, patch);
+
+  std::string cmd = std::string("rm -rf ") + dir;
+  system(cmd.c_str());
+  return check_result("test_delta_patch");
+}
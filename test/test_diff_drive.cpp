@@ -0,0 +1,283 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/test_diff_drive.cpp
+  Continuous drive: diff_drive_mix over the whole command range and
+  diff_drive_slew, the linear/angular byte pair packed into the drive
+  value on /control and /ws, and drive_task's per-tick ramp on the
+  sketch's control server with a frozen clock
+
+*/
+
+#include "app_sim.h"
+#include "diff_drive.h"
+#include "motor_output.h"
+#include "esp_timer.h"
+#include "check.h"
+#include <vector>
+
+#define TICK_US 20000   // DRIVE_PERIOD_MS
+
+static void test_mix()
+{
+  int left, right;
+  diff_drive_mix(100, 0, 255, &left, &right);
+  CHECK(left == 255 && right == 255);
+  diff_drive_mix(-50, 0, 200, &left, &right);
+  CHECK(left == -100 && right == -100);
+  // Positive angular turns left: the left side slows
+  diff_drive_mix(50, 20, 100, &left, &right);
+  CHECK(left == 30 && right == 70);
+  diff_drive_mix(0, -100, 255, &left, &right);
+  CHECK(left == 255 && right == -255);
+  // Saturating scales both sides, keeping their ratio
+  diff_drive_mix(100, 50, 255, &left, &right);
+  CHECK(left == 84 && right == 255);
+  diff_drive_mix(-100, -100, 200, &left, &right);
+  CHECK(left == 0 && right == -200);
+
+  bool bounded = true, symmetric = true, ratio = true;
+  const int max_duties[] = {0, 1, 128, 255};
+  for (int max_duty : max_duties)
+  {
+    for (int linear = -DIFF_DRIVE_SCALE; linear <= DIFF_DRIVE_SCALE; linear++)
+    {
+      for (int angular = -DIFF_DRIVE_SCALE; angular <= DIFF_DRIVE_SCALE; angular++)
+      {
+        diff_drive_mix(linear, angular, max_duty, &left, &right);
+        bounded = bounded && abs(left) <= max_duty && abs(right) <= max_duty;
+        // Reversing both mirrors the output; reversing the turn swaps the sides
+        int l, r;
+        diff_drive_mix(-linear, -angular, max_duty, &l, &r);
+        symmetric = symmetric && l == -left && r == -right;
+        diff_drive_mix(linear, -angular, max_duty, &l, &r);
+        symmetric = symmetric && l == right && r == left;
+        // Scaling never makes the slower side the faster one
+        if (abs(linear - angular) < abs(linear + angular))
+          ratio = ratio && abs(left) <= abs(right);
+        else if (abs(linear - angular) > abs(linear + angular))
+          ratio = ratio && abs(left) >= abs(right);
+      }
+    }
+  }
+  CHECK(bounded);
+  CHECK(symmetric);
+  CHECK(ratio);
+}
+
+static void test_slew()
+{
+  CHECK(diff_drive_slew(0, 255, 20) == 20);
+  CHECK(diff_drive_slew(240, 255, 20) == 255);
+  CHECK(diff_drive_slew(0, -255, 20) == -20);
+  CHECK(diff_drive_slew(10, -10, 20) == -10);
+  CHECK(diff_drive_slew(10, -11, 20) == -10);
+  CHECK(diff_drive_slew(-50, -50, 1) == -50);
+
+  // Stepping from one extreme to the other never overshoots and arrives
+  // in as many steps as the distance needs
+  const int steps[] = {1, 7, 20, 100, 510};
+  for (int step : steps)
+  {
+    int current = 255, ticks = 0;
+    bool limited = true;
+    while (current != -255 && ticks < 1000)
+    {
+      int next = diff_drive_slew(current, -255, step);
+      limited = limited && current - next <= step && next >= -255;
+      current = next;
+      ticks++;
+    }
+    CHECK(limited);
+    CHECK(ticks == (510 + step - 1) / step);
+  }
+}
+
+// The drive value: linear in the high byte, angular in the low byte, both
+// two's complement, as a signed 16-bit integer
+static int pack(int linear, int angular)
+{
+  return (int16_t)(((linear & 0xff) << 8) | (angular & 0xff));
+}
+
+static int control(const char *var, int val)
+{
+  std::string uri = std::string("/control?var=") + var + "&val=" + std::to_string(val);
+  return app_get(camera_httpd, uri.c_str()).status;
+}
+
+// Send one /ws record and return its ack status, 0 for accepted
+static int ws_record(app_conn_t *ws, uint8_t opcode, int val)
+{
+  uint8_t record[3] = {opcode, (uint8_t)(val & 0xff), (uint8_t)((val >> 8) & 0xff)};
+  host_httpd_request_t request = {};
+  request.method = HTTP_GET;
+  request.uri = "/ws";
+  request.body = record;
+  request.body_len = sizeof(record);
+  request.ws_frame = true;
+  request.ws_type = HTTPD_WS_TYPE_BINARY;
+  CHECK(host_httpd_request(camera_httpd, ws->server, &request) == ESP_OK);
+  std::string reply = app_read(ws->client);
+  // Unmasked binary frame of one opcode/status pair
+  CHECK(reply.size() == 4 && (uint8_t)reply[0] == 0x82 && reply[1] == 2 && (uint8_t)reply[2] == opcode);
+  return reply.size() == 4 ? reply[3] : -1;
+}
+
+static bool sides_are(int left, int right)
+{
+  int l, r;
+  motor_output_get_sides(&l, &r);
+  return l == left && r == right;
+}
+
+// Stop, and run the drive task until it lets go
+static void drive_stop()
+{
+  CHECK(control("car", 3) == 200);
+  host_clock_advance(TICK_US);
+}
+
+static void test_packing()
+{
+  app_conn_t ws = app_connect();
+  CHECK(host_httpd_call(camera_httpd, HTTP_GET, "/ws", ws.server) == ESP_OK);
+  app_read(ws.client);
+  CHECK(control("ramp_rate", 5000) == 200);
+
+  // Every sign combination, near zero and at the ends, reaches the outputs
+  // as diff_drive_mix gives it, whether sent on /control or /ws
+  const int values[] = {-100, -99, -50, -1, 0, 1, 50, 99, 100};
+  for (int linear : values)
+  {
+    for (int angular : values)
+    {
+      int left, right;
+      diff_drive_mix(linear, angular, 255, &left, &right);
+      int val = pack(linear, angular);
+      CHECK(control("drive", val) == 200);
+      // 5000/s ramps 100 a tick, so three ticks cover any change
+      host_clock_advance(3 * TICK_US);
+      if (!sides_are(left, right))
+      {
+        printf("drive linear %d angular %d as /control val %d: wrong outputs\n", linear, angular, val);
+        CHECK(false);
+      }
+      drive_stop();
+
+      CHECK(ws_record(&ws, 0x0C, val) == 0);
+      host_clock_advance(3 * TICK_US);
+      if (!sides_are(left, right))
+      {
+        printf("drive linear %d angular %d on /ws: wrong outputs\n", linear, angular);
+        CHECK(false);
+      }
+      drive_stop();
+    }
+  }
+
+  // Either byte past +-100 is refused, on both
+  const int refused[][2] = {{101, 0}, {0, 101}, {-101, 0}, {0, -101}, {127, 127}, {-128, -128}};
+  for (const auto &r : refused)
+  {
+    CHECK(control("drive", pack(r[0], r[1])) == 400);
+    CHECK(ws_record(&ws, 0x0C, pack(r[0], r[1])) == 1);
+  }
+  CHECK(sides_are(0, 0));
+
+  // The angular byte is not added to the linear one: a negative turn packed
+  // as 50 * 256 - 20 borrows from the high byte and drives at 49%
+  int left, right;
+  diff_drive_mix(49, -20, 255, &left, &right);
+  CHECK(control("drive", 50 * 256 - 20) == 200);
+  host_clock_advance(3 * TICK_US);
+  CHECK(sides_are(left, right));
+  drive_stop();
+
+  CHECK(control("ramp_rate", 1000) == 200);
+  app_disconnect(camera_httpd, &ws);
+}
+
+// Side outputs at each of the next ticks
+static std::vector<int> run_ticks(int ticks)
+{
+  std::vector<int> out;
+  for (int i = 0; i < ticks; i++)
+  {
+    host_clock_advance(TICK_US);
+    int left, right;
+    motor_output_get_sides(&left, &right);
+    CHECK(left == right);
+    out.push_back(left);
+  }
+  return out;
+}
+
+static void test_ramp()
+{
+  // Line up with a drive_task tick
+  host_clock_advance(TICK_US - esp_timer_get_time() % TICK_US);
+
+  // 1000/s at 50 Hz: 20 a tick from rest to full ahead, the last step short
+  CHECK(control("drive", pack(100, 0)) == 200);
+  CHECK(sides_are(0, 0));
+  std::vector<int> sides = run_ticks(13);
+  for (int i = 0; i < 12; i++)
+    CHECK(sides[i] == 20 * (i + 1));
+  CHECK(sides[12] == 255);
+
+  // Full reverse: through zero at the same rate, refreshed before the
+  // command times out
+  CHECK(control("drive", pack(-100, 0)) == 200);
+  sides = run_ticks(20);
+  CHECK(control("drive", pack(-100, 0)) == 200);
+  std::vector<int> more = run_ticks(10);
+  sides.insert(sides.end(), more.begin(), more.end());
+  int prev = 255;
+  bool limited = true;
+  for (int s : sides)
+  {
+    limited = limited && prev - s <= 20 && s <= prev;
+    prev = s;
+  }
+  CHECK(limited);
+  CHECK(sides[12] == -5 && sides[25] == -255 && sides.back() == -255);
+
+  // Without a fresh command the target drops to zero after DRIVE_TIMEOUT_MS,
+  // and the sides ramp down from there
+  sides = run_ticks(40);
+  size_t first = 0;
+  while (first < sides.size() && sides[first] == -255)
+    first++;
+  CHECK(first > 0 && first < sides.size() && sides[first] == -235);
+  CHECK(sides.back() == 0);
+
+  // The slowest and fastest rates the command takes
+  CHECK(control("ramp_rate", 50) == 200);
+  CHECK(control("drive", pack(100, 0)) == 200);
+  sides = run_ticks(5);
+  CHECK(sides[0] == 1 && sides[4] == 5);
+  drive_stop();
+  host_clock_advance(TICK_US * 10);
+  CHECK(control("ramp_rate", 5000) == 200);
+  CHECK(control("drive", pack(0, -100)) == 200);
+  int left, right;
+  host_clock_advance(TICK_US);
+  motor_output_get_sides(&left, &right);
+  CHECK(left == 100 && right == -100);
+  host_clock_advance(2 * TICK_US);
+  CHECK(sides_are(255, -255));
+  drive_stop();
+  CHECK(control("ramp_rate", 49) == 400);
+  CHECK(control("ramp_rate", 5001) == 400);
+  CHECK(control("ramp_rate", 1000) == 200);
+}
+
+int main()
+{
+  test_mix();
+  test_slew();
+  app_start();
+  test_packing();
+  test_ramp();
+  return check_result("test_diff_drive");
+}
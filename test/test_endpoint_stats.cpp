@@ -0,0 +1,169 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/test_endpoint_stats.cpp
+  Per-endpoint accounting: wrapped handlers, byte counting through the
+  send override, heap figures, Prometheus output and a full table
+
+*/
+
+#include "endpoint_stats.h"
+#include "esp_heap_caps.h"
+#include "check.h"
+#include <sys/socket.h>
+#include <unistd.h>
+
+static httpd_handle_t control = (httpd_handle_t)1;
+static httpd_handle_t stream = (httpd_handle_t)2;
+static int client[2];
+
+static esp_err_t ok_handler(httpd_req_t *req)
+{
+  host_httpd_send(req->handle, httpd_req_to_sockfd(req), "HTTP/1.1 200 OK\r\n\r\nok", 21);
+  return ESP_OK;
+}
+
+static esp_err_t failing_handler(httpd_req_t *req)
+{
+  return ESP_FAIL;
+}
+
+// Holds 3000 bytes of heap while it sends
+static esp_err_t allocating_handler(httpd_req_t *req)
+{
+  host_free_heap -= 3000;
+  host_httpd_send(req->handle, httpd_req_to_sockfd(req), "0123456789", 10);
+  host_free_heap += 3000;
+  return ESP_OK;
+}
+
+static esp_err_t plain_handler(httpd_req_t *req)
+{
+  return req->user_ctx == (void *)0x1234 ? ESP_OK : ESP_FAIL;
+}
+
+static size_t drain(int fd)
+{
+  char buf[256];
+  size_t total = 0;
+  ssize_t n;
+  while ((n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+    total += n;
+  return total;
+}
+
+static std::string format_family(size_t family)
+{
+  char buf[4096];
+  size_t n = endpoint_stats_format(family, buf, sizeof(buf));
+  return std::string(buf, n);
+}
+
+static void test_register_and_count()
+{
+  httpd_uri_t status = {"/status", HTTP_GET, ok_handler, NULL, false};
+  httpd_uri_t control_uri = {"/control", HTTP_GET, failing_handler, NULL, false};
+  httpd_uri_t update = {"/update", HTTP_POST, allocating_handler, NULL, false};
+  httpd_uri_t stream_uri = {"/stream", HTTP_GET, ok_handler, NULL, false};
+  CHECK(endpoint_register(control, &status) == ESP_OK);
+  CHECK(endpoint_register(control, &control_uri) == ESP_OK);
+  CHECK(endpoint_register(control, &update) == ESP_OK);
+  CHECK(endpoint_register(stream, &stream_uri) == ESP_OK);
+  // The handler is wrapped in place
+  CHECK(status.handler != ok_handler);
+  CHECK(status.user_ctx != NULL);
+
+  for (int i = 0; i < 3; i++)
+    CHECK(host_httpd_call(control, HTTP_GET, "/status", client[0]) == ESP_OK);
+  CHECK(host_httpd_call(control, HTTP_GET, "/control", client[0]) == ESP_FAIL);
+  CHECK(host_httpd_call(control, HTTP_POST, "/update", client[0]) == ESP_OK);
+  CHECK(host_httpd_call(stream, HTTP_GET, "/stream", client[0]) == ESP_OK);
+  CHECK(drain(client[1]) == 3 * 21 + 10 + 21);
+
+  std::string requests = format_family(0);
+  CHECK(requests.find("# TYPE robot_http_requests_total counter\n") != std::string::npos);
+  CHECK(requests.find("robot_http_requests_total{endpoint=\"GET /status\"} 3\n") != std::string::npos);
+  CHECK(requests.find("robot_http_requests_total{endpoint=\"GET /control\"} 1\n") != std::string::npos);
+  CHECK(requests.find("robot_http_requests_total{endpoint=\"POST /update\"} 1\n") != std::string::npos);
+
+  std::string errors = format_family(1);
+  CHECK(errors.find("robot_http_errors_total{endpoint=\"GET /control\"} 1\n") != std::string::npos);
+  CHECK(errors.find("robot_http_errors_total{endpoint=\"GET /status\"} 0\n") != std::string::npos);
+
+  // Memory released before the handler returns is not counted
+  std::string heap = format_family(5);
+  CHECK(heap.find("robot_http_heap_max_bytes{endpoint=\"POST /update\"} 0\n") != std::string::npos);
+}
+
+static void test_sent_bytes_follow_socket()
+{
+  // Bytes sent after the handler returned, as the async /stream client
+  // does, land on the endpoint that last handled the socket
+  int other[2];
+  CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, other) == 0);
+  CHECK(host_httpd_call(stream, HTTP_GET, "/stream", other[0]) == ESP_OK);
+  for (int i = 0; i < 10; i++)
+    host_httpd_send(stream, other[0], "frame-data", 10);
+  drain(other[1]);
+
+  std::string sent = format_family(4);
+  CHECK(sent.find("robot_http_sent_bytes_total{endpoint=\"GET /stream\"} 142\n") != std::string::npos);
+  CHECK(sent.find("robot_http_sent_bytes_total{endpoint=\"GET /status\"} 63\n") != std::string::npos);
+  close(other[0]);
+  close(other[1]);
+}
+
+static void test_heap_drop()
+{
+  // A handler that returns still holding memory shows up as its net drop
+  httpd_uri_t leak = {"/leak", HTTP_GET, [](httpd_req_t *req) {
+                        host_free_heap -= 512;
+                        return ESP_OK;
+                      }, NULL, false};
+  CHECK(endpoint_register(control, &leak) == ESP_OK);
+  CHECK(host_httpd_call(control, HTTP_GET, "/leak", client[0]) == ESP_OK);
+  CHECK(format_family(5).find("robot_http_heap_max_bytes{endpoint=\"GET /leak\"} 512\n") != std::string::npos);
+}
+
+static void test_format_limits()
+{
+  char buf[64];
+  CHECK(endpoint_stats_format(endpoint_stats_families(), buf, sizeof(buf)) == 0);
+  // Too small for the endpoint lines: nothing partial
+  CHECK(endpoint_stats_format(0, buf, sizeof(buf)) == 0);
+  CHECK(endpoint_stats_families() == 6);
+}
+
+static void test_table_full()
+{
+  static char names[ENDPOINT_MAX][16];
+  host_serial_take();
+  size_t registered = host_httpd.routes.size();
+  for (int i = 0; registered + i < ENDPOINT_MAX; i++)
+  {
+    snprintf(names[i], sizeof(names[i]), "/filler%d", i);
+    httpd_uri_t filler = {names[i], HTTP_GET, ok_handler, NULL, false};
+    CHECK(endpoint_register(control, &filler) == ESP_OK);
+  }
+  CHECK(host_serial_take().empty());
+
+  // One past the table is still served, unwrapped and with its own context,
+  // and the miss is logged
+  httpd_uri_t extra = {"/extra", HTTP_GET, plain_handler, (void *)0x1234, false};
+  CHECK(endpoint_register(control, &extra) == ESP_OK);
+  CHECK(extra.handler == plain_handler);
+  CHECK(host_httpd_call(control, HTTP_GET, "/extra", client[0]) == ESP_OK);
+  CHECK(host_serial_take() == "Endpoint stats full, GET /extra is not counted\n");
+  CHECK(format_family(0).find("/extra") == std::string::npos);
+}
+
+int main()
+{
+  CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, client) == 0);
+  CHECK(client[0] < ENDPOINT_MAX_SOCKETS);
+  test_register_and_count();
+  test_sent_bytes_follow_socket();
+  test_heap_drop();
+  test_format_limits();
+  test_table_full();
+  return check_result("test_endpoint_stats");
+}
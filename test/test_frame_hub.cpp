@@ -0,0 +1,243 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/test_frame_hub.cpp
+  frame_hub.cpp fanning one fake camera out to several viewers on a
+  frozen clock: each viewer's frame rate at its own send speed, the
+  client limit, capture pausing with nobody attached, and the JPEG slot
+  pool's hits and misses through frame_hub_encode
+
+*/
+
+#include "frame_sim.h"
+#include "check.h"
+#include <vector>
+
+#define SENSOR_FPS 25
+#define RUN_S 10
+
+static void stop_viewers(viewer_t *viewers, int n)
+{
+  viewers_stop(viewers, n);
+  for (int i = 0; i < n; i++)
+    CHECK(viewers[i].done);
+}
+
+// Four viewers from a fast LAN client down to one on a weak link. Each
+// gets the newest frame as soon as it is free, so the slow ones skip
+// frames but never hold back the others.
+static void test_fan_out()
+{
+  viewer_t viewers[FRAME_HUB_MAX_CLIENTS] = {{5000}, {12000}, {60000}, {250000}};
+  frame_hub_stats_t before, after;
+  frame_hub_get_stats(&before);
+  for (viewer_t &v : viewers)
+    xTaskCreate(viewer_task, "viewer", 4096, &v, 5, NULL);
+  host_clock_advance(RUN_S * 1000000);
+  frame_hub_get_stats(&after);
+
+  CHECK(after.clients == FRAME_HUB_MAX_CLIENTS);
+  uint32_t produced = after.produced - before.produced;
+  printf("  %u frames produced in %u s, %u dropped\n", produced, RUN_S, after.dropped - before.dropped);
+  printf("  send ms   fps  skipped\n");
+  for (viewer_t &v : viewers)
+  {
+    double fps = (double)v.frames / RUN_S;
+    printf("  %7.1f  %4.1f  %7u\n", v.send_us / 1000.0, fps, v.skipped);
+    CHECK(v.client >= 0);
+    CHECK(v.out_of_order == 0);
+    // Never slower than one frame per send plus the wait for the next one
+    uint32_t period_us = 1000000 / SENSOR_FPS;
+    uint32_t worst_us = v.send_us + period_us;
+    CHECK(v.frames >= (uint32_t)RUN_S * 1000000 / worst_us - 1);
+  }
+  CHECK(produced >= (RUN_S - 1) * SENSOR_FPS && produced <= RUN_S * SENSOR_FPS + 1);
+  // Clients faster than the sensor see every frame
+  CHECK(viewers[0].frames >= produced - 2 && viewers[0].skipped == 0);
+  CHECK(viewers[1].frames >= produced - 2 && viewers[1].skipped == 0);
+  CHECK(viewers[3].frames <= RUN_S * 1000000 / viewers[3].send_us + 1);
+  CHECK(after.send_us > 0);
+
+  // A fifth viewer is turned away; the internal clients have their own room
+  CHECK(frame_hub_attach() == -1);
+  int internal = frame_hub_attach_internal();
+  CHECK(internal >= FRAME_HUB_MAX_CLIENTS);
+  frame_hub_detach(internal);
+
+  stop_viewers(viewers, FRAME_HUB_MAX_CLIENTS);
+  frame_hub_get_stats(&after);
+  CHECK(after.clients == 0 && after.internal_clients == 0);
+}
+
+// With nobody attached the capture task stops grabbing frames, and the
+// next viewer starts from a new frame rather than the last one seen
+static void test_idle()
+{
+  host_clock_advance(100000);
+  uint32_t grabbed = host_camera.grabbed;
+  host_clock_advance(2000000);
+  CHECK(host_camera.grabbed == grabbed);
+  CHECK(host_camera.returned == host_camera.grabbed);
+  CHECK(frame_hub_acquire_latest(INT64_MAX) == NULL);
+
+  viewer_t v = {20000};
+  xTaskCreate(viewer_task, "viewer", 4096, &v, 5, NULL);
+  host_clock_advance(1000000);
+  CHECK(v.frames >= SENSOR_FPS - 2);
+  CHECK(host_camera.grabbed > grabbed);
+  stop_viewers(&v, 1);
+}
+
+// Raw frames converted in the encode stage while the next one is
+// captured, against the same work done one after the other
+static void test_pipeline()
+{
+  sensor_t *s = esp_camera_sensor_get();
+  s->set_pixformat(s, PIXFORMAT_RGB565);
+  host_camera.convert_us = 50000;
+  uint32_t converted = host_camera.converted;
+  frame_hub_stats_t before, after;
+  frame_hub_get_stats(&before);
+  uint32_t pipelined = sim_pipelined(RUN_S * 1000000);
+  frame_hub_get_stats(&after);
+  uint32_t serial = sim_serial(RUN_S * 1000000);
+  printf("  50 ms conversions at %u fps: %.1f fps pipelined, %.1f fps serial\n", SENSOR_FPS,
+         (double)pipelined / RUN_S, (double)serial / RUN_S);
+
+  // Bound by the conversion alone, not conversion plus capture
+  CHECK(pipelined >= RUN_S * 1000000 / host_camera.convert_us - 2);
+  CHECK(serial <= RUN_S * SENSOR_FPS / 2 + 1);
+  CHECK(host_camera.converted - converted >= pipelined + serial);
+  CHECK(after.produced - before.produced >= pipelined);
+  CHECK(after.queue_max == FRAME_HUB_QUEUE_DEPTH);
+  CHECK(after.encode_us >= host_camera.convert_us);
+  s->set_pixformat(s, PIXFORMAT_JPEG);
+}
+
+// A 640x480 camera frame in the given format, encoded to jpeg_len bytes
+static hub_frame_t *encode(pixformat_t format, uint32_t jpeg_len, std::vector<uint8_t> &raw)
+{
+  camera_fb_t fb = {};
+  fb.buf = raw.data();
+  fb.len = format == PIXFORMAT_JPEG ? jpeg_len : raw.size();
+  fb.width = 640;
+  fb.height = 480;
+  fb.format = format;
+  fb.timestamp.tv_sec = 1;
+  host_camera.jpeg_len = jpeg_len;
+  return frame_hub_encode(&fb);
+}
+
+static bool is_jpeg(const hub_frame_t *frame, size_t len)
+{
+  return frame && frame->len == len && frame->buf[0] == 0xff && frame->buf[1] == 0xd8 &&
+         frame->buf[len - 2] == 0xff && frame->buf[len - 1] == 0xd9;
+}
+
+// Hit and miss counts since the last call
+static void pool_delta(uint32_t *hits, uint32_t *misses)
+{
+  static frame_hub_stats_t last;
+  frame_hub_stats_t stats;
+  frame_hub_get_stats(&stats);
+  *hits = stats.pool_hits - last.pool_hits;
+  *misses = stats.pool_misses - last.pool_misses;
+  last = stats;
+}
+
+// Frames that fit a slot count as hits and use it as it is; a bigger one
+// grows the slot, however far, and counts one miss
+static void test_pool()
+{
+  uint32_t hits, misses;
+  frame_hub_stats_t stats;
+  frame_hub_get_stats(&stats);
+  pool_delta(&hits, &misses);
+  // A quarter of the VGA pixel count, plus slot_reserve's headroom
+  CHECK(stats.pool_slot_bytes == 96000);
+  host_camera.convert_us = 0;
+  std::vector<uint8_t> raw(640 * 480 * 2), jpeg(300000);
+
+  hub_frame_t *frame = encode(PIXFORMAT_RGB565, 50000, raw);
+  CHECK(is_jpeg(frame, 50000) && frame->cap == 96000);
+  frame_hub_release(frame);
+  frame = encode(PIXFORMAT_RGB565, 96000, raw);
+  CHECK(is_jpeg(frame, 96000) && frame->cap == 96000);
+  frame_hub_release(frame);
+  pool_delta(&hits, &misses);
+  CHECK(hits == 2 && misses == 0);
+
+  // One byte over grows the slot once, and the next frame that size fits
+  hub_frame_t *grown = encode(PIXFORMAT_RGB565, 96001, raw);
+  CHECK(is_jpeg(grown, 96001) && grown->cap > 96001);
+  pool_delta(&hits, &misses);
+  CHECK(hits == 0 && misses == 1);
+  frame_hub_release(grown);
+  frame = encode(PIXFORMAT_RGB565, 96001, raw);
+  CHECK(frame == grown && is_jpeg(frame, 96001));
+  pool_delta(&hits, &misses);
+  CHECK(hits == 1 && misses == 0);
+
+  // More than twice the slot still gets through, in a slot of its own
+  hub_frame_t *big = encode(PIXFORMAT_RGB565, 250000, raw);
+  CHECK(big != frame && is_jpeg(big, 250000) && big->cap >= 250000);
+  pool_delta(&hits, &misses);
+  CHECK(hits == 0 && misses == 1);
+  frame_hub_release(big);
+  frame_hub_release(frame);
+
+  // Growth stops at the size of the raw frame, so an encoder that never
+  // fits gives up and the slot goes back
+  CHECK(encode(PIXFORMAT_RGB565, raw.size() * 4, raw) == NULL);
+  pool_delta(&hits, &misses);
+  CHECK(hits == 0 && misses == 1);
+
+  // JPEG from the sensor is copied, a hit when it fits
+  for (size_t i = 0; i < jpeg.size(); i++)
+    jpeg[i] = i;
+  hub_frame_t *held[FRAME_HUB_SLOTS];
+  for (int i = 0; i < FRAME_HUB_SLOTS; i++)
+  {
+    held[i] = encode(PIXFORMAT_JPEG, 20000, jpeg);
+    CHECK(held[i] && held[i]->len == 20000 && !memcmp(held[i]->buf, jpeg.data(), 20000));
+  }
+  pool_delta(&hits, &misses);
+  CHECK(hits == FRAME_HUB_SLOTS && misses == 0);
+  // Every slot claimed: nothing to encode into, and nothing counted
+  CHECK(encode(PIXFORMAT_RGB565, 1000, raw) == NULL);
+  pool_delta(&hits, &misses);
+  CHECK(hits == 0 && misses == 0);
+  for (hub_frame_t *h : held)
+  {
+    CHECK(h->refs == 1);
+    frame_hub_release(h);
+    CHECK(h->refs == 0);
+  }
+
+  // Slots are claimed in order, so with the two grown ones held the next
+  // is still at 96000 bytes, and a bigger sensor JPEG grows it
+  hub_frame_t *a = encode(PIXFORMAT_JPEG, 100000, jpeg);
+  hub_frame_t *b = encode(PIXFORMAT_JPEG, 100000, jpeg);
+  CHECK(a == grown && b == big);
+  pool_delta(&hits, &misses);
+  CHECK(hits == 2 && misses == 0);
+  frame = encode(PIXFORMAT_JPEG, 100000, jpeg);
+  CHECK(frame && frame->len == 100000 && !memcmp(frame->buf, jpeg.data(), 100000));
+  pool_delta(&hits, &misses);
+  CHECK(hits == 0 && misses == 1);
+  frame_hub_release(frame);
+  frame_hub_release(b);
+  frame_hub_release(a);
+
+  host_camera.jpeg_len = 0;
+}
+
+int main()
+{
+  sim_start(SENSOR_FPS, FRAMESIZE_VGA);
+
+  test_fan_out();
+  test_idle();
+  test_pipeline();
+  test_pool();
+  return check_result("test_frame_hub");
+}
@@ -0,0 +1,155 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/test_histogram.cpp
+  Bucket edges, +Inf, sum and count, and Prometheus rendering from
+  histogram.h
+
+*/
+
+#include "histogram.h"
+#include "check.h"
+#include <thread>
+#include <vector>
+
+static int bucket_of(uint32_t us)
+{
+  histogram_t h = HISTOGRAM_INIT("t", "t");
+  histogram_observe(&h, us);
+  for (int i = 0; i <= HISTOGRAM_BUCKETS; i++)
+    if (h.counts[i])
+      return i;
+  return -1;
+}
+
+static void test_bucket_edges()
+{
+  CHECK(bucket_of(0) == 0);
+  // Bounds are inclusive, as Prometheus "le" requires
+  for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+  {
+    CHECK(bucket_of(HISTOGRAM_BOUNDS_US[i]) == i);
+    CHECK(bucket_of(HISTOGRAM_BOUNDS_US[i] + 1) == i + 1);
+    if (i > 0)
+      CHECK(bucket_of(HISTOGRAM_BOUNDS_US[i - 1] + 1) == i);
+  }
+}
+
+static void test_inf()
+{
+  CHECK(bucket_of(1000001) == HISTOGRAM_BUCKETS);
+  CHECK(bucket_of(UINT32_MAX) == HISTOGRAM_BUCKETS);
+}
+
+static void test_labels_match_bounds()
+{
+  for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+  {
+    double seconds = strtod(HISTOGRAM_LABELS[i], NULL);
+    CHECK((uint32_t)(seconds * 1e6 + 0.5) == HISTOGRAM_BOUNDS_US[i]);
+    if (i > 0)
+      CHECK(HISTOGRAM_BOUNDS_US[i] > HISTOGRAM_BOUNDS_US[i - 1]);
+  }
+}
+
+static void test_sum_and_count()
+{
+  histogram_t h = HISTOGRAM_INIT("t", "t");
+  histogram_observe(&h, 10);
+  histogram_observe(&h, 700);
+  histogram_observe(&h, 2000000);
+  CHECK(h.count == 3);
+  CHECK(h.sum_us == 2000710);
+
+  // The sum is 64-bit, so it keeps counting past 2^32 us (about 71 minutes)
+  histogram_t big = HISTOGRAM_INIT("t", "t");
+  histogram_observe(&big, UINT32_MAX);
+  histogram_observe(&big, UINT32_MAX);
+  CHECK(big.sum_us == 2ull * UINT32_MAX);
+  CHECK(big.counts[HISTOGRAM_BUCKETS] == 2);
+
+  histogram_t since = HISTOGRAM_INIT("t", "t");
+  histogram_observe_since(&since, esp_timer_get_time() - 3000);
+  CHECK(since.count == 1);
+  CHECK(since.sum_us >= 3000 && since.sum_us < 1000000);
+}
+
+static void test_format()
+{
+  histogram_t h = HISTOGRAM_INIT("robot_fb_get", "Time waiting for a camera frame");
+  histogram_observe(&h, 50);
+  histogram_observe(&h, 120);
+  histogram_observe(&h, 120);
+  histogram_observe(&h, 3000000);
+
+  const char *expected =
+      "# HELP robot_fb_get_seconds Time waiting for a camera frame\n"
+      "# TYPE robot_fb_get_seconds histogram\n"
+      "robot_fb_get_seconds_bucket{le=\"0.00005\"} 1\n"
+      "robot_fb_get_seconds_bucket{le=\"0.0001\"} 1\n"
+      "robot_fb_get_seconds_bucket{le=\"0.00025\"} 3\n"
+      "robot_fb_get_seconds_bucket{le=\"0.0005\"} 3\n"
+      "robot_fb_get_seconds_bucket{le=\"0.001\"} 3\n"
+      "robot_fb_get_seconds_bucket{le=\"0.0025\"} 3\n"
+      "robot_fb_get_seconds_bucket{le=\"0.005\"} 3\n"
+      "robot_fb_get_seconds_bucket{le=\"0.01\"} 3\n"
+      "robot_fb_get_seconds_bucket{le=\"0.025\"} 3\n"
+      "robot_fb_get_seconds_bucket{le=\"0.05\"} 3\n"
+      "robot_fb_get_seconds_bucket{le=\"0.1\"} 3\n"
+      "robot_fb_get_seconds_bucket{le=\"0.25\"} 3\n"
+      "robot_fb_get_seconds_bucket{le=\"1\"} 3\n"
+      "robot_fb_get_seconds_bucket{le=\"+Inf\"} 4\n"
+      "robot_fb_get_seconds_sum 3.000290\n"
+      "robot_fb_get_seconds_count 4\n";
+
+  char buf[2048];
+  size_t n = histogram_format(&h, buf, sizeof(buf));
+  CHECK(n == strlen(expected));
+  CHECK_STR(buf, expected);
+
+  // Too small a buffer at any point gives 0, never a partial metric; the
+  // exact length needs room for the terminator
+  for (size_t len = 0; len <= n; len++)
+    CHECK(histogram_format(&h, buf, len) == 0);
+  CHECK(histogram_format(&h, buf, n + 1) == n);
+}
+
+static void test_format_empty()
+{
+  histogram_t h = HISTOGRAM_INIT("robot_idle", "Nothing yet");
+  char buf[2048];
+  CHECK(histogram_format(&h, buf, sizeof(buf)) > 0);
+  CHECK(strstr(buf, "robot_idle_seconds_bucket{le=\"+Inf\"} 0\n") != NULL);
+  CHECK(strstr(buf, "robot_idle_seconds_sum 0.000000\nrobot_idle_seconds_count 0\n") != NULL);
+}
+
+static void test_concurrent_observe()
+{
+  // Both cores observe into the same histograms on the car
+  histogram_t h = HISTOGRAM_INIT("t", "t");
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++)
+    threads.emplace_back([&h, t]() {
+      for (uint32_t i = 0; i < 50000; i++)
+        histogram_observe(&h, (i * 37 + t) % 2000000);
+    });
+  for (std::thread &t : threads)
+    t.join();
+
+  uint32_t total = 0;
+  for (int i = 0; i <= HISTOGRAM_BUCKETS; i++)
+    total += h.counts[i];
+  CHECK(h.count == 200000);
+  CHECK(total == h.count);
+}
+
+int main()
+{
+  test_bucket_edges();
+  test_inf();
+  test_labels_match_bounds();
+  test_sum_and_count();
+  test_format();
+  test_format_empty();
+  test_concurrent_observe();
+  return check_result("test_histogram");
+}
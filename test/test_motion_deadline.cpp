@@ -0,0 +1,149 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/test_motion_deadline.cpp
+  Auto-stop deadlines from motion_deadline.h on the host esp_timer with a
+  frozen clock, scheduled the way motion_run and motion_stop do it
+
+*/
+
+#include "motion_deadline.h"
+#include "check.h"
+#include <thread>
+
+#define RUN_MS 2000   // move_interval + MOTION_RUN_ON_MS at the defaults
+
+static SemaphoreHandle_t motion_lock;
+static motion_deadline_t deadline;
+static int stops = 0;
+static int64_t stopped_at = 0;
+static uint32_t stop_late_us = 0;
+
+static void motion_timer_cb(void *arg)
+{
+  xSemaphoreTake(motion_lock, portMAX_DELAY);
+  int64_t expired = motion_deadline_expired(&deadline);
+  if (expired)
+  {
+    stops++;
+    stopped_at = esp_timer_get_time();
+    stop_late_us = stopped_at - expired;
+  }
+  xSemaphoreGive(motion_lock);
+}
+
+static void motion_run()
+{
+  xSemaphoreTake(motion_lock, portMAX_DELAY);
+  motion_deadline_arm(&deadline, (uint64_t)RUN_MS * 1000);
+  xSemaphoreGive(motion_lock);
+}
+
+static void motion_stop()
+{
+  xSemaphoreTake(motion_lock, portMAX_DELAY);
+  motion_deadline_cancel(&deadline);
+  xSemaphoreGive(motion_lock);
+}
+
+static void reset()
+{
+  motion_stop();
+  stops = 0;
+  stopped_at = 0;
+}
+
+static void test_expiry()
+{
+  reset();
+  int64_t start = esp_timer_get_time();
+  motion_run();
+  CHECK(host_esp_timer_due(deadline.timer) == start + RUN_MS * 1000);
+  host_clock_advance(RUN_MS * 1000 - 1);
+  CHECK(stops == 0);
+  host_clock_advance(1);
+  CHECK(stops == 1 && stopped_at == start + RUN_MS * 1000 && stop_late_us == 0);
+  CHECK(deadline.deadline_us == 0);
+  host_clock_advance(10 * RUN_MS * 1000);
+  CHECK(stops == 1);
+}
+
+static void test_rearm_replaces()
+{
+  reset();
+  motion_run();
+  host_clock_advance(1500000);
+  int64_t second = esp_timer_get_time();
+  motion_run();
+  CHECK(deadline.deadline_us == second + RUN_MS * 1000);
+  CHECK(host_esp_timer_due(deadline.timer) == second + RUN_MS * 1000);
+
+  // Past the first deadline the car keeps moving
+  host_clock_advance(1000000);
+  CHECK(stops == 0);
+  host_clock_advance(RUN_MS * 1000 - 1000000);
+  CHECK(stops == 1 && stopped_at == second + RUN_MS * 1000);
+}
+
+static void test_stale_expiry()
+{
+  reset();
+  motion_run();
+  int64_t first = deadline.deadline_us;
+
+  // The timer fires for the first deadline while a newer move holds the
+  // lock; its callback only gets the lock after the re-arm
+  xSemaphoreTake(motion_lock, portMAX_DELAY);
+  std::thread clock([] { host_clock_advance(RUN_MS * 1000); });
+  while (host_esp_timer_due(deadline.timer) != -1)
+    std::this_thread::yield();
+  CHECK(esp_timer_get_time() == first);
+  motion_deadline_arm(&deadline, (uint64_t)RUN_MS * 1000);
+  xSemaphoreGive(motion_lock);
+  clock.join();
+
+  CHECK(stops == 0);
+  CHECK(deadline.deadline_us == first + RUN_MS * 1000);
+  host_clock_advance(RUN_MS * 1000);
+  CHECK(stops == 1 && stopped_at == first + RUN_MS * 1000);
+}
+
+static void test_cancel()
+{
+  // car=3 goes through motion_stop
+  reset();
+  motion_run();
+  host_clock_advance(500000);
+  motion_stop();
+  CHECK(deadline.deadline_us == 0);
+  CHECK(host_esp_timer_due(deadline.timer) == -1);
+  host_clock_advance(10 * RUN_MS * 1000);
+  CHECK(stops == 0);
+
+  // A stop that wins the lock over an expiry already dispatched
+  motion_run();
+  xSemaphoreTake(motion_lock, portMAX_DELAY);
+  std::thread clock([] { host_clock_advance(RUN_MS * 1000); });
+  while (host_esp_timer_due(deadline.timer) != -1)
+    std::this_thread::yield();
+  motion_deadline_cancel(&deadline);
+  xSemaphoreGive(motion_lock);
+  clock.join();
+  CHECK(stops == 0);
+}
+
+int main()
+{
+  host_clock_freeze();
+  motion_lock = xSemaphoreCreateMutex();
+  esp_timer_create_args_t args = {};
+  args.callback = motion_timer_cb;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "motion_stop";
+  esp_timer_create(&args, &deadline.timer);
+
+  test_expiry();
+  test_rearm_replaces();
+  test_stale_expiry();
+  test_cancel();
+  return check_result("test_motion_deadline");
+}
@@ -0,0 +1,216 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/test_motion_macro.cpp
+  Motion macros: what macro_parse accepts and the first error it reports,
+  then /macro on the sketch's control server with a frozen clock for the
+  motor outputs at each step boundary, completion, and cancellation by
+  /macro?cancel=1 and by manual /control commands
+
+*/
+
+#include "app_sim.h"
+#include "motion_macro.h"
+#include "motor_output.h"
+#include "esp_timer.h"
+#include "check.h"
+
+static const char *parse(const char *text, macro_t *macro = NULL)
+{
+  static macro_t scratch;
+  return macro_parse(text, macro ? macro : &scratch);
+}
+
+static void check_error(const char *text, const char *error)
+{
+  const char *got = parse(text);
+  if (!got || strcmp(got, error))
+  {
+    printf("macro_parse(\"%s\"): %s, expected %s\n", text, got ? got : "ok", error);
+    CHECK(false);
+  }
+}
+
+static void test_parse()
+{
+  macro_t macro;
+  CHECK(parse("f200:1000,r180:350,s0:200", &macro) == NULL);
+  CHECK(macro.count == 3 && macro.total_ms == 1550);
+  CHECK(macro.steps[0].motion == MOTION_FWD && macro.steps[0].duty == 200 && macro.steps[0].duration_ms == 1000);
+  CHECK(macro.steps[1].motion == MOTION_RIGHT && macro.steps[1].duty == 180 && macro.steps[1].duration_ms == 350);
+  CHECK(macro.steps[2].motion == MOTION_STOP && macro.steps[2].duty == 0 && macro.steps[2].duration_ms == 200);
+  CHECK(parse("b255:10000,l0:1", &macro) == NULL);
+  CHECK(macro.count == 2 && macro.steps[0].motion == MOTION_BACK && macro.steps[1].motion == MOTION_LEFT);
+
+  check_error("", "No steps");
+
+  // Motion letters are lower case and one of sfbrl
+  check_error("x100:100", "Unknown motion");
+  check_error("F100:100", "Unknown motion");
+  check_error("f100:100,,f100:100", "Unknown motion");
+  check_error("f100:100,r100:100,q1:1", "Unknown motion");
+
+  // Duty: digits, 0-255, then ':'
+  check_error("f100", "Invalid duty");
+  check_error("f100,r100:100", "Invalid duty");
+  check_error("f:100", "Invalid duty");
+  check_error("f100-100", "Invalid duty");
+  check_error("f256:100", "Invalid duty");
+  check_error("f-1:100", "Invalid duty");
+  check_error("f99999999999999999999:100", "Invalid duty");
+  check_error("f4294967296:100", "Invalid duty");
+
+  // Duration: 1-MACRO_MAX_STEP_MS ms, then ',' or the end
+  check_error("f100:", "Invalid duration");
+  check_error("f100:0", "Invalid duration");
+  check_error("f100:-5", "Invalid duration");
+  check_error("f100:10001", "Invalid duration");
+  check_error("f100:99999999999999999999", "Invalid duration");
+  check_error("f100:4294967297", "Invalid duration");
+  check_error("f100:100;r100:100", "Invalid duration");
+  check_error("f100:100 ", "Invalid duration");
+
+  // MACRO_MAX_STEPS of the longest step, and one more
+  std::string text;
+  for (int i = 0; i < MACRO_MAX_STEPS; i++)
+    text += std::string(i ? "," : "") + "f255:10000";
+  CHECK(parse(text.c_str(), &macro) == NULL);
+  CHECK(macro.count == MACRO_MAX_STEPS && macro.total_ms == MACRO_MAX_STEPS * 10000u);
+  check_error((text + ",s0:1").c_str(), "Too many steps");
+  // The step count is checked before the step is read
+  check_error((text + ",x").c_str(), "Too many steps");
+}
+
+// Signed side duty a motion primitive gives at this duty
+static void motion_sides(int motion, int duty, int *left, int *right)
+{
+  const uint8_t *active = MOTIONS[motion].active;
+  *left = (active[MOTOR_LEFT_M1] - active[MOTOR_LEFT_M0]) * duty;
+  *right = (active[MOTOR_RIGHT_M1] - active[MOTOR_RIGHT_M0]) * duty;
+}
+
+static bool sides_are(int motion, int duty)
+{
+  int left, right, want_left, want_right;
+  motor_output_get_sides(&left, &right);
+  motion_sides(motion, duty, &want_left, &want_right);
+  return left == want_left && right == want_right;
+}
+
+static std::string macro(const char *query)
+{
+  std::string uri = std::string("/macro") + query;
+  app_response_t resp = app_get(camera_httpd, uri.c_str());
+  CHECK(resp.status == 200);
+  CHECK(app_header(resp, "Content-Type") == "application/json");
+  return resp.body;
+}
+
+static std::string state(const std::string &json)
+{
+  size_t pos = json.find("\"state\":\"");
+  return pos == std::string::npos ? "" : json.substr(pos + 9, json.find('"', pos + 9) - pos - 9);
+}
+
+static void test_steps()
+{
+  std::string json = macro("");
+  CHECK(state(json) == "idle" && app_json_int(json, "elapsed_ms") == 0);
+
+  // Each step holds its outputs until exactly its end, counted from the start
+  const char *steps = "f200:1000,r180:350,s0:200,b90:5";
+  const struct
+  {
+    int motion, duty, ms;
+  } expected[] = {{MOTION_FWD, 200, 1000}, {MOTION_RIGHT, 180, 350}, {MOTION_STOP, 0, 200}, {MOTION_BACK, 90, 5}};
+  json = macro((std::string("?run=") + steps).c_str());
+  CHECK(state(json) == "running");
+  CHECK(app_json_int(json, "step") == 0 && app_json_int(json, "steps") == 4);
+  CHECK(app_json_int(json, "elapsed_ms") == 0 && app_json_int(json, "total_ms") == 1555);
+  int elapsed = 0;
+  for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++)
+  {
+    CHECK(sides_are(expected[i].motion, expected[i].duty));
+    host_clock_advance(expected[i].ms * 1000 - 1);
+    CHECK(sides_are(expected[i].motion, expected[i].duty));
+    json = macro("");
+    CHECK(state(json) == "running" && app_json_int(json, "step") == (long)i);
+    CHECK(app_json_int(json, "elapsed_ms") == elapsed + expected[i].ms - 1);
+    host_clock_advance(1);
+    elapsed += expected[i].ms;
+  }
+
+  // Done: stopped, with the elapsed time frozen at the end
+  CHECK(sides_are(MOTION_STOP, 0));
+  host_clock_advance(1000000);
+  json = macro("");
+  CHECK(state(json) == "done" && app_json_int(json, "step") == 4 && app_json_int(json, "elapsed_ms") == 1555);
+  CHECK(app_get(camera_httpd, "/status").body.find("\"macro\":\"done\"") != std::string::npos);
+
+  // Errors answer 400 with the parser's message and leave the state alone
+  app_response_t resp = app_get(camera_httpd, "/macro?run=f100:0");
+  CHECK(resp.status == 400 && resp.body == "Invalid duration");
+  resp = app_get(camera_httpd, "/macro?run=q1:1");
+  CHECK(resp.status == 400 && resp.body == "Unknown motion");
+  CHECK(state(macro("")) == "done");
+}
+
+static void test_cancel()
+{
+  // /macro?cancel=1 stops where it is
+  CHECK(state(macro("?run=f200:1000,r180:350")) == "running");
+  host_clock_advance(1200000);
+  CHECK(sides_are(MOTION_RIGHT, 180));
+  std::string json = macro("?cancel=1");
+  CHECK(state(json) == "cancelled" && app_json_int(json, "step") == 1 && app_json_int(json, "elapsed_ms") == 1200);
+  CHECK(sides_are(MOTION_STOP, 0));
+  // and its timer no longer fires
+  host_clock_advance(1000000);
+  CHECK(sides_are(MOTION_STOP, 0));
+  CHECK(state(macro("")) == "cancelled");
+
+  // A stepped drive command takes over at once; the macro's remaining
+  // steps never reach the outputs
+  CHECK(app_get(camera_httpd, "/control?var=speed&val=128").status == 200);
+  CHECK(state(macro("?run=f200:500,b200:500,l200:500")) == "running");
+  host_clock_advance(100000);
+  CHECK(app_get(camera_httpd, "/control?var=car&val=1").status == 200);
+  CHECK(sides_are(MOTION_FWD, 128));
+  json = macro("");
+  CHECK(state(json) == "cancelled" && app_json_int(json, "step") == 0 && app_json_int(json, "elapsed_ms") == 100);
+  host_clock_advance(450000);
+  CHECK(sides_are(MOTION_FWD, 128));
+  CHECK(app_get(camera_httpd, "/control?var=car&val=3").status == 200);
+  host_clock_advance(2000000);
+  CHECK(sides_are(MOTION_STOP, 0));
+
+  // So does continuous drive
+  CHECK(state(macro("?run=l200:500,r200:500")) == "running");
+  host_clock_advance(300000);
+  CHECK(app_get(camera_httpd, "/control?var=drive&val=100").status == 200);
+  json = macro("");
+  CHECK(state(json) == "cancelled" && app_json_int(json, "elapsed_ms") == 300);
+  host_clock_advance(400000);
+  CHECK(!sides_are(MOTION_RIGHT, 200));
+  CHECK(app_get(camera_httpd, "/control?var=car&val=3").status == 200);
+  host_clock_advance(1000000);
+  CHECK(sides_are(MOTION_STOP, 0));
+  CHECK(app_get(camera_httpd, "/control?var=speed&val=255").status == 200);
+
+  // A new macro replaces a running one from its first step
+  CHECK(state(macro("?run=f200:1000")) == "running");
+  host_clock_advance(500000);
+  json = macro("?run=b100:200");
+  CHECK(state(json) == "running" && app_json_int(json, "steps") == 1 && app_json_int(json, "elapsed_ms") == 0);
+  CHECK(sides_are(MOTION_BACK, 100));
+  host_clock_advance(200000);
+  CHECK(sides_are(MOTION_STOP, 0) && state(macro("")) == "done");
+}
+
+int main()
+{
+  test_parse();
+  app_start();
+  test_steps();
+  test_cancel();
+  return check_result("test_motion_macro");
+}
@@ -0,0 +1,159 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/test_motor_output.cpp
+  Motion primitives and side duty through the recording driver, and the
+  LEDC driver's channel map and register calls
+
+*/
+
+#include "motor_output.h"
+#include "motor_recorder.h"
+#include "esp_timer.h"
+#include "check.h"
+
+#define DUTY 200
+
+// Runs first, while the LEDC driver still holds its power-on duty of 0
+static void test_ledc_setup()
+{
+  motor_output_set_driver(&motor_ledc_driver);
+  motor_output_setup();
+
+  const ledc_timer_config_t *timer = &host_ledc.timers[MOTOR_PWM_TIMER];
+  CHECK(host_ledc.timer_configured[MOTOR_PWM_TIMER]);
+  CHECK(timer->freq_hz == MOTOR_PWM_FREQ);
+  CHECK(timer->duty_resolution == MOTOR_PWM_RESOLUTION);
+  // Timer 0 drives the camera XCLK and timer 1 the flash LED
+  CHECK(!host_ledc.timer_configured[LEDC_TIMER_0]);
+  CHECK(!host_ledc.timer_configured[LEDC_TIMER_1]);
+
+  const int pins[MOTOR_OUTPUTS] = {RIGHT_M0, RIGHT_M1, LEFT_M0, LEFT_M1};
+  for (int i = 0; i < MOTOR_OUTPUTS; i++)
+  {
+    ledc_channel_t ch = MOTOR_CHANNELS[i].channel;
+    CHECK(host_ledc.channel_configured[ch]);
+    CHECK(host_ledc.channels[ch].gpio_num == pins[i]);
+    CHECK(host_ledc.channels[ch].timer_sel == MOTOR_PWM_TIMER);
+    CHECK(host_ledc.duty[ch] == 0);
+  }
+  CHECK(!host_ledc.channel_configured[LEDC_CHANNEL_0]);
+  CHECK(!host_ledc.channel_configured[LEDC_CHANNEL_7]);
+  CHECK(host_ledc.set_calls == 0 && host_ledc.update_calls == 0);
+}
+
+static bool ledc_outputs_are(uint32_t right_m0, uint32_t right_m1, uint32_t left_m0, uint32_t left_m1)
+{
+  return host_ledc.duty[MOTOR_CHANNELS[MOTOR_RIGHT_M0].channel] == right_m0 &&
+         host_ledc.duty[MOTOR_CHANNELS[MOTOR_RIGHT_M1].channel] == right_m1 &&
+         host_ledc.duty[MOTOR_CHANNELS[MOTOR_LEFT_M0].channel] == left_m0 &&
+         host_ledc.duty[MOTOR_CHANNELS[MOTOR_LEFT_M1].channel] == left_m1;
+}
+
+static void test_ledc_register_calls()
+{
+  // The old robot_* functions made eight register calls per move. Only
+  // changed channels are written now.
+  motor_output_motion(MOTION_FWD, DUTY);
+  CHECK(ledc_outputs_are(0, DUTY, 0, DUTY));
+  CHECK(host_ledc.set_calls == 2 && host_ledc.update_calls == 2);
+
+  motor_output_motion(MOTION_FWD, DUTY);
+  CHECK(host_ledc.set_calls == 2 && host_ledc.update_calls == 2);
+
+  motor_output_motion(MOTION_BACK, DUTY);
+  CHECK(ledc_outputs_are(DUTY, 0, DUTY, 0));
+  CHECK(host_ledc.set_calls == 6 && host_ledc.update_calls == 6);
+
+  motor_output_motion(MOTION_RIGHT, DUTY);
+  CHECK(ledc_outputs_are(0, DUTY, DUTY, 0));
+  CHECK(host_ledc.set_calls == 8 && host_ledc.update_calls == 8);
+
+  motor_output_motion(MOTION_STOP, DUTY);
+  CHECK(ledc_outputs_are(0, 0, 0, 0));
+  CHECK(host_ledc.set_calls == 10 && host_ledc.update_calls == 10);
+
+  // All duty is set before any of it is latched, so both sides change together
+  for (int i = 0; i < LEDC_CHANNEL_MAX; i++)
+    CHECK(host_ledc.pending[i] == host_ledc.duty[i]);
+}
+
+static void test_motions()
+{
+  motor_recorder_reset();
+  motor_output_setup();
+  CHECK(motor_recorder.setup_calls == 1);
+
+  // The duty vectors the original robot_* functions wrote
+  motor_output_motion(MOTION_FWD, DUTY);
+  CHECK(motor_recorder_last_is(0, DUTY, 0, DUTY));
+  motor_output_motion(MOTION_BACK, DUTY);
+  CHECK(motor_recorder_last_is(DUTY, 0, DUTY, 0));
+  motor_output_motion(MOTION_RIGHT, DUTY);
+  CHECK(motor_recorder_last_is(0, DUTY, DUTY, 0));
+  motor_output_motion(MOTION_LEFT, DUTY);
+  CHECK(motor_recorder_last_is(DUTY, 0, 0, DUTY));
+  motor_output_motion(MOTION_STOP, DUTY);
+  CHECK(motor_recorder_last_is(0, 0, 0, 0));
+
+  // One driver call per motion
+  CHECK(motor_recorder.applied.size() == 5);
+
+  // Only stop has no nominal move time
+  for (int m = 0; m < MOTION_COUNT; m++)
+    CHECK((MOTIONS[m].interval_ms == 0) == (m == MOTION_STOP));
+}
+
+static void test_sides()
+{
+  motor_recorder_reset();
+  int left, right;
+
+  motor_output_sides(120, -80);
+  CHECK(motor_recorder_last_is(80, 0, 0, 120));
+  motor_output_get_sides(&left, &right);
+  CHECK(left == 120 && right == -80);
+
+  motor_output_sides(-255, 255);
+  CHECK(motor_recorder_last_is(0, 255, 255, 0));
+  motor_output_get_sides(&left, &right);
+  CHECK(left == -255 && right == 255);
+
+  motor_output_sides(0, 0);
+  CHECK(motor_recorder_last_is(0, 0, 0, 0));
+  motor_output_get_sides(&left, &right);
+  CHECK(left == 0 && right == 0);
+
+  // Primitives report through the same signed view
+  motor_output_motion(MOTION_FWD, DUTY);
+  motor_output_get_sides(&left, &right);
+  CHECK(left == DUTY && right == DUTY);
+  motor_output_motion(MOTION_BACK, DUTY);
+  motor_output_get_sides(&left, &right);
+  CHECK(left == -DUTY && right == -DUTY);
+
+  const uint32_t raw[MOTOR_OUTPUTS] = {1, 2, 3, 4};
+  motor_output_apply(raw);
+  CHECK(motor_recorder_last_is(1, 2, 3, 4));
+  CHECK(motor_recorder.applied.size() == 6);
+}
+
+static void test_applied_time()
+{
+  motor_recorder_reset();
+  int64_t before = esp_timer_get_time();
+  motor_output_motion(MOTION_FWD, DUTY);
+  int64_t first = motor_output_applied_us();
+  CHECK(first >= before && first <= esp_timer_get_time());
+  motor_output_motion(MOTION_STOP, 0);
+  CHECK(motor_output_applied_us() >= first);
+}
+
+int main()
+{
+  test_ledc_setup();
+  test_ledc_register_calls();
+  test_motions();
+  test_sides();
+  test_applied_time();
+  return check_result("test_motor_output");
+}
@@ -0,0 +1,231 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/test_multipart_parser.cpp
+  multipart_parser.h against form uploads fed in every possible split,
+  with file contents built to look like the delimiter
+
+*/
+
+#include "multipart_parser.h"
+#include "check.h"
+#include <random>
+#include <string>
+#include <vector>
+
+static const std::string BOUNDARY = "----WebKitFormBoundaryAbC123";
+
+static bool collect(void *ctx, const uint8_t *data, size_t len)
+{
+  ((std::string *)ctx)->append((const char *)data, len);
+  return true;
+}
+
+static bool refuse(void *ctx, const uint8_t *data, size_t len)
+{
+  return false;
+}
+
+// The body the update page's form sends: a plain field, then the file
+static std::string form_body(const std::string &file, const std::string &boundary = BOUNDARY)
+{
+  return "--" + boundary + "\r\n"
+         "Content-Disposition: form-data; name=\"note\"\r\n\r\n"
+         "hello\r\n"
+         "--" + boundary + "\r\n"
+         "Content-Disposition: form-data; name=\"update\"; filename=\"fw.bin\"\r\n"
+         "Content-Type: application/octet-stream\r\n\r\n" +
+         file + "\r\n--" + boundary + "--\r\n";
+}
+
+static multipart_status_t parse_split(const std::string &body, const std::vector<size_t> &cuts, std::string *out,
+                                      const std::string &boundary = BOUNDARY)
+{
+  multipart_parser_t p;
+  std::string type = "multipart/form-data; boundary=" + boundary;
+  if (!multipart_init(&p, type.c_str(), collect, out))
+    return MULTIPART_ERROR;
+  multipart_status_t status = MULTIPART_OK;
+  size_t pos = 0;
+  for (size_t i = 0; i <= cuts.size() && status == MULTIPART_OK; i++)
+  {
+    size_t end = i < cuts.size() ? cuts[i] : body.size();
+    status = multipart_feed(&p, (const uint8_t *)body.data() + pos, end - pos);
+    pos = end;
+  }
+  return status;
+}
+
+// Binary content heavy in CR, LF and '-', optionally ending in a partial
+// delimiter
+static std::string nasty_file(std::mt19937 &rng, size_t len, bool partial_delim)
+{
+  std::string file;
+  for (size_t i = 0; i < len; i++)
+  {
+    int r = rng() % 10;
+    file += r == 0 ? '\r' : r == 1 ? '\n' : r == 2 ? '-' : (char)(rng() % 256);
+  }
+  if (partial_delim)
+    file += "\r\n--" + BOUNDARY.substr(0, rng() % BOUNDARY.size());
+  return file;
+}
+
+static void test_init()
+{
+  multipart_parser_t p;
+  CHECK(multipart_init(&p, "multipart/form-data; boundary=abc", collect, NULL));
+  CHECK(!strcmp(p.delim, "\r\n--abc"));
+  CHECK(multipart_init(&p, "multipart/form-data; boundary=\"a b;c\"", collect, NULL));
+  CHECK(!strcmp(p.delim, "\r\n--a b;c"));
+  CHECK(multipart_init(&p, "multipart/form-data; boundary=abc; charset=utf-8", collect, NULL));
+  CHECK(!strcmp(p.delim, "\r\n--abc"));
+
+  CHECK(!multipart_init(&p, "application/octet-stream", collect, NULL));
+  CHECK(!multipart_init(&p, "text/plain; boundary=abc", collect, NULL));
+  CHECK(!multipart_init(&p, "multipart/form-data", collect, NULL));
+  CHECK(!multipart_init(&p, "multipart/form-data; boundary=", collect, NULL));
+
+  std::string longest = "multipart/form-data; boundary=" + std::string(MULTIPART_MAX_BOUNDARY, 'x');
+  CHECK(multipart_init(&p, longest.c_str(), collect, NULL));
+  std::string too_long = longest + "x";
+  CHECK(!multipart_init(&p, too_long.c_str(), collect, NULL));
+}
+
+static void test_every_two_way_split()
+{
+  // A file with CRLF-dash runs, a delimiter wrong only in its last byte,
+  // and the start of one at the very end
+  std::string almost = BOUNDARY.substr(0, BOUNDARY.size() - 1) + "Y";
+  std::string file = "\r\n-\r\n--" + BOUNDARY.substr(0, 10) + "X\r\r\n--" + almost + "\r\n--";
+  std::string body = form_body(file);
+  for (size_t cut = 0; cut <= body.size(); cut++)
+  {
+    std::string out;
+    multipart_status_t status = parse_split(body, {cut}, &out);
+    CHECK(status == MULTIPART_DONE);
+    CHECK(out == file);
+    if (status != MULTIPART_DONE || out != file)
+    {
+      fprintf(stderr, "  split at %zu\n", cut);
+      break;
+    }
+  }
+}
+
+static void test_every_three_way_split()
+{
+  // Both cuts inside the closing delimiter region covers a match carried
+  // across two chunk edges
+  std::string file = "payload\r\n--" + BOUNDARY.substr(0, 5);
+  std::string body = form_body(file);
+  size_t tail = body.size() - BOUNDARY.size() - 12;
+  for (size_t a = tail - 20; a <= body.size(); a++)
+    for (size_t b = a; b <= body.size(); b++)
+    {
+      std::string out;
+      if (parse_split(body, {a, b}, &out) != MULTIPART_DONE || out != file)
+      {
+        CHECK(!"three way split");
+        fprintf(stderr, "  split at %zu, %zu\n", a, b);
+        return;
+      }
+    }
+}
+
+static void test_random_splits()
+{
+  std::mt19937 rng(7);
+  int failed = 0;
+  for (int t = 0; t < 2000; t++)
+  {
+    std::string file = nasty_file(rng, rng() % 5000, t % 3 == 0);
+    std::string body = form_body(file);
+    std::vector<size_t> cuts;
+    // Alternate tiny slices with TCP-sized ones
+    size_t max_step = t % 2 ? 7 : 1500;
+    for (size_t pos = 1 + rng() % max_step; pos < body.size(); pos += 1 + rng() % max_step)
+      cuts.push_back(pos);
+    std::string out;
+    if (parse_split(body, cuts, &out) != MULTIPART_DONE || out != file)
+      failed++;
+  }
+  CHECK(failed == 0);
+}
+
+static void test_byte_at_a_time()
+{
+  std::mt19937 rng(11);
+  std::string file = nasty_file(rng, 3000, true);
+  std::string body = form_body(file);
+  std::vector<size_t> cuts;
+  for (size_t i = 1; i < body.size(); i++)
+    cuts.push_back(i);
+  std::string out;
+  CHECK(parse_split(body, cuts, &out) == MULTIPART_DONE);
+  CHECK(out == file);
+}
+
+static void test_structure()
+{
+  std::string out;
+  // Preamble before the first boundary is ignored
+  std::string body = "this is a preamble\r\n" + form_body("abc");
+  CHECK(parse_split(body, {}, &out) == MULTIPART_DONE);
+  CHECK(out == "abc");
+
+  // Only the first part with a filename is the upload
+  out.clear();
+  body = "--" + BOUNDARY + "\r\nContent-Disposition: form-data; name=\"a\"; filename=\"one\"\r\n\r\nfirst\r\n"
+         "--" + BOUNDARY + "\r\nContent-Disposition: form-data; name=\"b\"; filename=\"two\"\r\n\r\nsecond\r\n"
+         "--" + BOUNDARY + "--\r\n";
+  CHECK(parse_split(body, {}, &out) == MULTIPART_DONE);
+  CHECK(out == "first");
+
+  // An empty file
+  out.clear();
+  CHECK(parse_split(form_body(""), {}, &out) == MULTIPART_DONE);
+  CHECK(out.empty());
+
+  // A body that stops before the closing boundary is not done
+  out.clear();
+  body = form_body("abcdef");
+  body.resize(body.size() - 8);
+  CHECK(parse_split(body, {}, &out) == MULTIPART_OK);
+
+  // Everything after the closing boundary is ignored
+  out.clear();
+  body = form_body("abc") + "epilogue\r\n--" + BOUNDARY + "\r\n";
+  CHECK(parse_split(body, {}, &out) == MULTIPART_DONE);
+  CHECK(out == "abc");
+}
+
+static void test_malformed()
+{
+  std::string out;
+  // A delimiter followed by neither CRLF nor "--"
+  std::string body = "--" + BOUNDARY + "XX\r\n";
+  CHECK(parse_split(body, {}, &out) == MULTIPART_ERROR);
+
+  // Part headers that never end
+  body = "--" + BOUNDARY + "\r\n" + std::string(MULTIPART_MAX_HEADERS + 10, 'h');
+  CHECK(parse_split(body, {}, &out) == MULTIPART_ERROR);
+
+  // The data callback aborts the parse
+  multipart_parser_t p;
+  std::string type = "multipart/form-data; boundary=" + BOUNDARY;
+  CHECK(multipart_init(&p, type.c_str(), refuse, NULL));
+  body = form_body("data");
+  CHECK(multipart_feed(&p, (const uint8_t *)body.data(), body.size()) == MULTIPART_ERROR);
+}
+
+int main()
+{
+  test_init();
+  test_every_two_way_split();
+  test_every_three_way_split();
+  test_random_splits();
+  test_byte_at_a_time();
+  test_structure();
+  test_malformed();
+  return check_result("test_multipart_parser");
+}
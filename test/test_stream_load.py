@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""Run the stream_load.py viewers and request mix against app_standin.
+
+app_standin serves the firmware's own handlers from app_httpd.cpp on
+loopback with the fake camera; its path is the first argument. Checks that
+the load tool parses the stream at the rate it is produced, that a viewer
+past the frame hub limit is refused, that every /control request reached
+the firmware, and that stream_meta.py finds every part's metadata.
+"""
+
+import os
+import re
+import socket
+import subprocess
+import sys
+import time
+import urllib.request
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "tools"))
+
+import stream_load  # noqa: E402
+import stream_meta  # noqa: E402
+
+FPS = 25.0
+DURATION = 3.0
+MAX_VIEWERS = 4  # FRAME_HUB_MAX_CLIENTS
+
+failures = 0
+
+
+def check(cond, what):
+    global failures
+    if not cond:
+        print("FAIL: %s" % what)
+        failures += 1
+
+
+def record_stream(port, seconds):
+    sock = socket.create_connection(("127.0.0.1", port), timeout=5)
+    sock.sendall(b"GET /stream HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n")
+    f = sock.makefile("rb")
+    f.readline()
+    for line in iter(f.readline, b"\r\n"):
+        pass
+    body = stream_load.ChunkedReader(f)
+    data = b""
+    deadline = time.monotonic() + seconds
+    while time.monotonic() < deadline:
+        body.fill()
+        data, body.buf = data + body.buf, b""
+    sock.close()
+    return data
+
+
+def start_standin(path):
+    proc = subprocess.Popen([path, "--port", "0", "--stream-port", "0", "--fps", str(FPS)],
+                            stdout=subprocess.PIPE, text=True)
+    ports = {}
+    for _ in range(2):
+        name, port = proc.stdout.readline().split()
+        ports[name] = int(port)
+    return proc, ports["control"], ports["stream"]
+
+
+def endpoint_requests(base, endpoint):
+    with urllib.request.urlopen(base + "/metrics", timeout=5) as r:
+        text = r.read().decode()
+    m = re.search(r'^robot_http_requests_total\{endpoint="%s"\} (\d+)$' % re.escape(endpoint), text, re.M)
+    return int(m.group(1)) if m else -1
+
+
+def main():
+    proc, control_port, stream_port = start_standin(sys.argv[1])
+    try:
+        return run(control_port, stream_port)
+    finally:
+        proc.kill()
+        proc.wait()
+
+
+def run(control_port, stream_port):
+    base = "http://127.0.0.1:%d" % control_port
+
+    deadline = time.monotonic() + DURATION
+    clients = [stream_load.StreamClient(i, "127.0.0.1", stream_port, deadline)
+               for i in range(MAX_VIEWERS)]
+    for c in clients:
+        c.start()
+    time.sleep(0.5)
+    extra = stream_load.StreamClient(99, "127.0.0.1", stream_port, deadline)
+    extra.start()
+    control_mix = stream_load.RequestMix(base + "/control?var=speed&val=200", 10, deadline)
+    capture_mix = stream_load.RequestMix(base + "/capture", 2, deadline)
+    status = stream_load.StatusPoller(base + "/status", deadline)
+    threads = clients + [extra, control_mix, capture_mix, status]
+    for t in [control_mix, capture_mix, status]:
+        t.start()
+    for t in threads:
+        t.join(DURATION + 10)
+
+    for c in clients:
+        check(c.error is None, "viewer %d error %s" % (c.index, c.error))
+        span = c.arrivals[-1] - c.arrivals[0] if len(c.arrivals) > 1 else 0
+        fps = (len(c.arrivals) - 1) / span if span else 0.0
+        check(abs(fps - FPS) < FPS * 0.2, "viewer %d at %.1f fps" % (c.index, fps))
+        check(c.bytes > 0, "viewer %d received no bytes" % c.index)
+    check(extra.error is not None and " 503 " in extra.error, "fifth viewer not refused: %s" % extra.error)
+    check(not extra.arrivals, "fifth viewer got frames")
+    check(control_mix.failures == 0 and len(control_mix.latencies) >= 20, "control mix %d ok %d failed" % (
+        len(control_mix.latencies), control_mix.failures))
+    check(capture_mix.failures == 0 and capture_mix.latencies, "capture mix failed")
+    commands = endpoint_requests(base, "GET /control")
+    check(commands == len(control_mix.latencies), "firmware counted %d /control requests" % commands)
+    check(status.heap_free, "no /status samples")
+
+    # Viewers have gone once their sockets close
+    time.sleep(0.5)
+    data = record_stream(stream_port, 1.0)
+    frames = list(stream_meta.multipart_frames(data))
+    check(len(frames) >= FPS * 0.8, "recorded %d frames" % len(frames))
+    seqs = []
+    for headers, jpeg in frames:
+        meta = stream_meta.jpeg_meta(jpeg)
+        check(meta is not None, "frame without COM metadata")
+        check(meta and meta[0] == int(headers["x-frame-seq"]), "COM and header sequence differ")
+        check(jpeg.endswith(b"\xff\xd9"), "frame truncated")
+        seqs.append(int(headers["x-frame-seq"]))
+    check(seqs == list(range(seqs[0], seqs[0] + len(seqs))) if seqs else False, "sequence gaps %s" % seqs)
+
+    print("test_stream_load: %s" % ("ok" if not failures else "%d check(s) failed" % failures))
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,302 @@
+/*
+  ESP32_CAM_Robot_Car
+  test/test_telemetry.cpp
+  Telemetry events: the SSE framing telemetry_encode_event writes, deltas
+  and short buffers, then /events on the sketch's control server with a
+  frozen clock for the per-client rate limit and keepalive, and the control
+  server's socket budget with the event stream and /ws open
+
+*/
+
+#include "app_sim.h"
+#include "telemetry.h"
+#include "esp_timer.h"
+#include "check.h"
+#include <vector>
+
+#define STEP_US 10000
+#define EVENTS_PAGES 2
+
+static telemetry_t sample()
+{
+  telemetry_t t = {};
+  t.v[TELEMETRY_MOTION] = TELEMETRY_DRIVING;
+  t.v[TELEMETRY_DUTY_LEFT] = -120;
+  t.v[TELEMETRY_DUTY_RIGHT] = 255;
+  t.v[TELEMETRY_SPEED] = 200;
+  t.v[TELEMETRY_FPS] = 249;
+  t.v[TELEMETRY_FRAMESIZE] = 8;
+  t.v[TELEMETRY_HEAP_KB] = 151;
+  t.v[TELEMETRY_PSRAM_KB] = 3900;
+  t.v[TELEMETRY_RSSI] = -61;
+  t.v[TELEMETRY_STATIONS] = 1;
+  t.v[TELEMETRY_STREAM_CLIENTS] = 2;
+  t.v[TELEMETRY_UDP_RECEIVERS] = 0;
+  return t;
+}
+
+static std::string encode(const telemetry_t &now, telemetry_t *last, bool full, size_t len = 512)
+{
+  std::vector<char> buf(len);
+  size_t n = telemetry_encode_event(&now, last, full, buf.data(), len);
+  return std::string(buf.data(), n);
+}
+
+static void test_encode()
+{
+  telemetry_t now = sample(), last = {};
+  std::string full = encode(now, &last, true);
+  CHECK_STR(full.c_str(),
+            "event: telemetry\ndata: {\"motion\":\"driving\",\"duty_left\":-120,\"duty_right\":255,\"speed\":200,"
+            "\"fps\":24.9,\"framesize\":8,\"heap_kb\":151,\"psram_kb\":3900,\"rssi\":-61,\"stations\":1,"
+            "\"stream_clients\":2,\"udp_receivers\":0}\n\n");
+  CHECK(!memcmp(&last, &now, sizeof(now)));
+
+  // Nothing changed: no event, and a full one still lists every field
+  CHECK(encode(now, &last, false).empty());
+  CHECK(encode(now, &last, true) == full);
+
+  // Only what changed, in field order; one decimal keeps its sign
+  now.v[TELEMETRY_FPS] = -5;
+  now.v[TELEMETRY_MOTION] = TELEMETRY_STOPPED;
+  std::string event = encode(now, &last, false);
+  CHECK_STR(event.c_str(), "event: telemetry\ndata: {\"motion\":\"stopped\",\"fps\":-0.5}\n\n");
+  now.v[TELEMETRY_FPS] = -123;
+  event = encode(now, &last, false);
+  CHECK_STR(event.c_str(), "event: telemetry\ndata: {\"fps\":-12.3}\n\n");
+  now.v[TELEMETRY_FPS] = 7;
+  event = encode(now, &last, false);
+  CHECK_STR(event.c_str(), "event: telemetry\ndata: {\"fps\":0.7}\n\n");
+
+  // One event per write: a single data line and a blank line only at the end
+  std::string delta = encode(sample(), &last, false);
+  CHECK(delta.find("\n\n") == delta.size() - 2);
+  CHECK(delta.find('\n') == strlen("event: telemetry"));
+  CHECK(delta.find('\n', 17) == delta.size() - 2);
+
+  // Too small a buffer at any length gives nothing and leaves last alone
+  now = sample();
+  for (size_t len = 0; len <= full.size(); len++)
+  {
+    telemetry_t before = last = {};
+    CHECK(encode(now, &last, true, len).empty());
+    CHECK(!memcmp(&last, &before, sizeof(last)));
+  }
+  CHECK(encode(now, &last, true, full.size() + 1) == full);
+}
+
+typedef struct
+{
+  int64_t at_us;
+  std::string text;   // without the blank line
+} sse_event_t;
+
+// An /events connection, read as the clock moves
+typedef struct
+{
+  app_conn_t conn;
+  std::string raw;
+  size_t used;        // body bytes already split into events
+  std::vector<sse_event_t> events;
+} sse_client_t;
+
+static void sse_poll(sse_client_t *c)
+{
+  c->raw += app_read(c->conn.client);
+  app_response_t resp;
+  app_parse(c->raw, &resp);
+  size_t end;
+  while ((end = resp.body.find("\n\n", c->used)) != std::string::npos)
+  {
+    c->events.push_back({esp_timer_get_time(), resp.body.substr(c->used, end - c->used)});
+    c->used = end + 2;
+  }
+}
+
+// Move the clock in small steps, noting when each event arrives
+static void sse_run(sse_client_t *c, int64_t us)
+{
+  for (int64_t t = 0; t < us; t += STEP_US)
+  {
+    host_clock_advance(STEP_US);
+    sse_poll(c);
+  }
+}
+
+static void sse_open(sse_client_t *c)
+{
+  *c = {};
+  c->conn = app_connect();
+  CHECK(host_httpd_call(camera_httpd, HTTP_GET, "/events", c->conn.server) == ESP_OK);
+  host_clock_advance(0);
+  sse_poll(c);
+}
+
+static void sse_close(sse_client_t *c)
+{
+  app_disconnect(camera_httpd, &c->conn);
+}
+
+static bool is_event(const sse_event_t &e)
+{
+  return !e.text.compare(0, 23, "event: telemetry\ndata: ");
+}
+
+static void test_events()
+{
+  // Line up on a whole STEP_US so event times are exact
+  host_clock_advance(STEP_US - esp_timer_get_time() % STEP_US);
+  int64_t start = esp_timer_get_time();
+  sse_client_t sse;
+  sse_open(&sse);
+  app_response_t resp;
+  app_parse(sse.raw, &resp);
+  CHECK(resp.status == 200);
+  CHECK(app_header(resp, "Content-Type") == "text/event-stream");
+  CHECK(app_header(resp, "Cache-Control") == "no-cache");
+  CHECK(sse.events.size() == 1 && sse.events[0].text == "retry: 2000");
+
+  // The first event carries every field, one interval in
+  sse_run(&sse, 600000);
+  CHECK(sse.events.size() == 2);
+  if (sse.events.size() != 2)
+    return;
+  CHECK(is_event(sse.events[1]) && sse.events[1].at_us - start == 500000);
+  for (int i = 0; i < TELEMETRY_FIELDS; i++)
+    CHECK(sse.events[1].text.find(std::string("\"") + TELEMETRY_DESC[i].name + "\":") != std::string::npos);
+
+  // Speed changes ten times a second; events still come one interval apart
+  // and carry the value at the time, alone
+  size_t first = sse.events.size();
+  for (int i = 0; i < 30; i++)
+  {
+    std::string uri = "/control?var=speed&val=" + std::to_string(100 + i);
+    CHECK(app_get(camera_httpd, uri.c_str()).status == 200);
+    sse_run(&sse, 100000 - esp_timer_get_time() % 100000);
+  }
+  size_t events = sse.events.size() - first;
+  CHECK(events == 6);
+  for (size_t i = first; i < sse.events.size(); i++)
+  {
+    const sse_event_t &e = sse.events[i];
+    CHECK(is_event(e));
+    CHECK(e.text.find("{\"speed\":") != std::string::npos && e.text.find(',') == std::string::npos);
+    CHECK(e.at_us - sse.events[i - 1].at_us == 500000);
+  }
+
+  // Nothing changes: silence, then a keepalive comment
+  first = sse.events.size();
+  sse_run(&sse, 15000000);
+  CHECK(sse.events.size() == first);
+  sse_run(&sse, 1000000);
+  CHECK(sse.events.size() == first + 1 && sse.events.back().text == ": keepalive");
+
+  // A slower interval spaces events further apart
+  first = sse.events.size();
+  CHECK(app_get(camera_httpd, "/control?var=event_ms&val=1000").status == 200);
+  for (int i = 0; i < 10; i++)
+  {
+    std::string uri = "/control?var=speed&val=" + std::to_string(200 + i);
+    CHECK(app_get(camera_httpd, uri.c_str()).status == 200);
+    sse_run(&sse, 300000);
+  }
+  CHECK(sse.events.size() - first >= 2);
+  for (size_t i = first + 1; i < sse.events.size(); i++)
+    CHECK(sse.events[i].at_us - sse.events[i - 1].at_us == 1000000);
+  CHECK(app_get(camera_httpd, "/control?var=event_ms&val=500").status == 200);
+
+  // One stream at a time: a reloaded page's stream displaces the old one,
+  // which ends after asking its browser to hold off reconnecting
+  sse_client_t reload;
+  sse_open(&reload);
+  sse_run(&reload, 600000);
+  sse_poll(&sse);
+  app_parse(sse.raw, &resp);
+  CHECK(resp.complete && sse.events.back().text == "retry: 30000");
+  CHECK(reload.events.size() == 2 && reload.events[0].text == "retry: 2000" && is_event(reload.events[1]));
+  // and the new one starts with every field again
+  CHECK(reload.events.size() == 2 && reload.events[1].text.find("\"udp_receivers\":") != std::string::npos);
+  sse_close(&sse);
+
+  // A client that left without closing is displaced just the same
+  close(reload.conn.client);
+  reload.conn.client = -1;
+  sse_open(&sse);
+  sse_run(&sse, 600000);
+  CHECK(sse.events.size() == 2 && is_event(sse.events.back()));
+  app_disconnect(camera_httpd, &reload.conn);
+  sse_close(&sse);
+}
+
+static bool session_open(int fd)
+{
+  int fds[16];
+  size_t count = 16;
+  httpd_get_client_list(camera_httpd, &count, fds);
+  for (size_t i = 0; i < count; i++)
+    if (fds[i] == fd)
+      return true;
+  return false;
+}
+
+static void test_socket_budget()
+{
+  // A driver holding still: /ws opened first and idle since, and two pages
+  // opening event streams, of which only the newest stays
+  uint32_t purged = host_httpd.purged;
+  app_conn_t ws = app_connect();
+  CHECK(host_httpd_call(camera_httpd, HTTP_GET, "/ws", ws.server) == ESP_OK);
+  std::vector<sse_client_t> streams(EVENTS_PAGES);
+  for (sse_client_t &sse : streams)
+  {
+    sse_open(&sse);
+    sse_run(&sse, 600000);
+  }
+  for (int i = 0; i < EVENTS_PAGES - 1; i++)
+  {
+    app_response_t resp;
+    sse_poll(&streams.front());
+    app_parse(streams.front().raw, &resp);
+    CHECK(resp.complete);
+    sse_close(&streams.front());
+    streams.erase(streams.begin());
+  }
+
+  // The page's keep-alive connections polling and sending commands
+  std::vector<app_conn_t> requests;
+  for (int i = 0; i < 4; i++)
+    requests.push_back(app_connect());
+  for (int round = 0; round < 3; round++)
+  {
+    for (app_conn_t &conn : requests)
+    {
+      CHECK(host_httpd_call(camera_httpd, HTTP_GET, round % 2 ? "/status" : "/control?var=speed&val=255",
+                            conn.server) == ESP_OK);
+      app_read(conn.client);
+    }
+    host_clock_advance(500000);
+  }
+  CHECK(host_httpd.purged == purged);
+  CHECK(session_open(ws.server));
+  for (sse_client_t &sse : streams)
+  {
+    CHECK(session_open(sse.conn.server));
+    sse_poll(&sse);
+    CHECK(sse.events.size() >= 2);
+  }
+
+  for (app_conn_t &conn : requests)
+    app_disconnect(camera_httpd, &conn);
+  for (sse_client_t &sse : streams)
+    sse_close(&sse);
+  app_disconnect(camera_httpd, &ws);
+}
+
+int main()
+{
+  test_encode();
+  app_start();
+  test_events();
+  test_socket_budget();
+  return check_result("test_telemetry");
+}
@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+"""Receive udp_stream.cpp's datagrams from app_standin and reassemble them
+with udp_view.py after dropping and reordering some.
+
+app_standin runs the firmware's UDP sender on UDP_STREAM_PORT with the fake
+camera; its path is the first argument. What arrives on loopback is kept as
+the reference: every frame must split into frag_count fragments of the
+expected sizes and join back into the camera's JPEG. The same datagrams
+then go through a lossy, reordering channel into udp_view.Reassembler,
+which must hand back exactly the frames that arrived whole and were not
+overtaken by a newer complete frame, each byte-identical to the reference,
+and nothing of the frames that lost a fragment.
+"""
+
+import os
+import random
+import socket
+import subprocess
+import sys
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "tools"))
+
+import udp_view  # noqa: E402
+
+FPS = 25.0
+DURATION = 2.0
+PAYLOAD = 1400  # UDP_STREAM_PAYLOAD
+SOF_LEN = 19    # HOST_JPEG_SOF_LEN, the fake camera's SOF segment
+DROP = 0.05
+REORDER_WINDOW = 6
+SEEDS = range(5)
+
+failures = 0
+
+
+def check(cond, what):
+    global failures
+    if not cond:
+        print("FAIL: %s" % what)
+        failures += 1
+
+
+def start_standin(path):
+    proc = subprocess.Popen([path, "--port", "0", "--stream-port", "0", "--fps", str(FPS)],
+                            stdout=subprocess.PIPE, text=True)
+    for _ in range(2):
+        proc.stdout.readline()
+    return proc
+
+
+def receive(seconds):
+    """Every datagram the sender sends one subscriber for this long."""
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4 << 20)
+    sock.settimeout(0.1)
+    car = ("127.0.0.1", udp_view.PORT)
+    datagrams = []
+    start = time.monotonic()
+    next_renew = start
+    while time.monotonic() - start < seconds:
+        if time.monotonic() >= next_renew:
+            sock.sendto(udp_view.SUBSCRIBE, car)
+            next_renew += udp_view.RENEW_S
+        try:
+            datagrams.append(sock.recv(2048))
+        except socket.timeout:
+            pass
+    sock.sendto(udp_view.UNSUBSCRIBE, car)
+    sock.close()
+    return datagrams
+
+
+def reference_frames(datagrams):
+    """Frames whose fragments all arrived, joined in fragment order."""
+    parts = {}
+    for d in datagrams:
+        _, _, _, frame_id, frag, count, length = udp_view.HEADER.unpack_from(d)
+        parts.setdefault(frame_id, (count, length, {}))[2][frag] = d[udp_view.HEADER.size:]
+    frames = {}
+    for frame_id, (count, length, frags) in parts.items():
+        if len(frags) < count:
+            continue
+        sizes = [len(frags[i]) for i in range(count)]
+        check(sizes[:-1] == [PAYLOAD] * (count - 1) and 0 < sizes[-1] <= PAYLOAD,
+              "frame %d fragment sizes %s" % (frame_id, sizes))
+        frames[frame_id] = b"".join(frags[i] for i in range(count))
+        check(len(frames[frame_id]) == length, "frame %d is %d bytes, header says %d" % (
+            frame_id, len(frames[frame_id]), length))
+    return frames
+
+
+def fake_jpeg(jpeg):
+    """The fake camera's frame: SOI, SOF, bytes counting up from the frame number, EOI."""
+    if len(jpeg) < 4 + SOF_LEN or jpeg[:3] != b"\xff\xd8\xff" or jpeg[-2:] != b"\xff\xd9":
+        return False
+    start = 2 + SOF_LEN
+    n = jpeg[start] - start
+    return all(jpeg[i] == (n + i) & 0x7f for i in range(start, len(jpeg) - 2))
+
+
+def impair(datagrams, rng):
+    """Drop some datagrams and shuffle the rest within short windows."""
+    kept = [d for d in datagrams if rng.random() >= DROP]
+    out = []
+    for i in range(0, len(kept), REORDER_WINDOW):
+        window = kept[i:i + REORDER_WINDOW]
+        rng.shuffle(window)
+        out.extend(window)
+    return out
+
+
+def expected_frames(channel, max_pending):
+    """Frames that complete before any newer frame has, and before more than
+    max_pending newer frames are waiting, in completion order."""
+    seen = {}
+    last = 0
+    out = []
+    for d in channel:
+        _, _, _, frame_id, frag, count, _ = udp_view.HEADER.unpack_from(d)
+        if frame_id <= last:
+            continue
+        seen.setdefault(frame_id, set()).add(frag)
+        if len(seen[frame_id]) == count:
+            out.append(frame_id)
+            last = frame_id
+            seen = {f: s for f, s in seen.items() if f > frame_id}
+        elif len(seen) > max_pending:
+            oldest_kept = sorted(seen)[-max_pending]
+            seen = {f: s for f, s in seen.items() if f >= oldest_kept}
+    return out
+
+
+def run_channel(datagrams, reference, seed):
+    rng = random.Random(seed)
+    channel = impair(datagrams, rng)
+    arrived = {}
+    for d in channel:
+        frame_id = udp_view.HEADER.unpack_from(d)[3]
+        arrived[frame_id] = arrived.get(frame_id, 0) + 1
+    lost = set(f for f in reference if arrived.get(f, 0) < -(-len(reference[f]) // PAYLOAD))
+
+    frames = udp_view.Reassembler()
+    got = []
+    for d in channel:
+        frame = frames.feed(d)
+        if frame:
+            got.append(frame)
+
+    ids = [frame_id for frame_id, _ in got]
+    expected = expected_frames(channel, frames.max_pending)
+    check(ids == expected, "seed %d: reassembled %s, expected %s" % (seed, ids, expected))
+    check(not lost & set(ids), "seed %d: incomplete frames %s handed back" % (seed, sorted(lost & set(ids))))
+    for frame_id, jpeg in got:
+        check(jpeg == reference.get(frame_id), "seed %d: frame %d differs from what was sent" % (seed, frame_id))
+    check(frames.invalid == 0, "seed %d: %d invalid datagrams" % (seed, frames.invalid))
+    return len(lost), len(got)
+
+
+def main():
+    proc = start_standin(sys.argv[1])
+    try:
+        time.sleep(0.3)
+        datagrams = receive(DURATION)
+    finally:
+        proc.kill()
+        proc.wait()
+
+    reference = reference_frames(datagrams)
+    check(len(reference) >= FPS * DURATION * 0.7, "received %d whole frames" % len(reference))
+    for frame_id, jpeg in reference.items():
+        check(fake_jpeg(jpeg), "frame %d does not join back into the camera's JPEG" % frame_id)
+
+    # Drop only the frames that lose a datagram, for a few different channels
+    lost = got = 0
+    for seed in SEEDS:
+        n_lost, n_got = run_channel(datagrams, reference, seed)
+        lost += n_lost
+        got += n_got
+    check(lost > 0 and got > 0, "channels lost %d frames and delivered %d" % (lost, got))
+
+    print("test_udp_stream: %d frames, %d datagrams; %s" % (
+        len(reference), len(datagrams), "ok" if not failures else "%d check(s) failed" % failures))
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+"""Compare command round trips over GET /control and the /ws channel.
+
+    python3 tools/control_latency.py 192.168.4.1 --count 200
+    python3 tools/control_latency.py 192.168.4.1 --var car --val 3
+
+Sends the same command --count times down each path, one at a time and
+--rate per second, and times each from the first byte sent to the last
+byte of the answer:
+
+  get-new    GET /control on a new connection per command
+  get-reuse  GET /control on one keep-alive connection
+  ws         a 3 byte record on an open /ws, answered by [opcode, status]
+
+Then prints the latency percentiles of each. Run it with the car idle, and
+again with tools/stream_load.py viewers, to see the paths under load.
+"""
+
+import argparse
+import base64
+import os
+import socket
+import struct
+import time
+
+# Opcodes of the /ws records, as in WS_OPS in web/index.html
+OPCODES = {"car": 1, "speed": 2, "flash": 3, "framesize": 4, "quality": 5, "nostop": 6, "flashoff": 7,
+           "loglevel": 8, "adaptive": 9, "target_fps": 10, "capture_age": 11, "drive": 12, "ramp_rate": 13,
+           "latency_trace": 14, "event_ms": 16, "change_skip": 17, "change_keepalive": 18}
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+
+def fmt_ms(values):
+    return "p50 %6.2f  p90 %6.2f  p99 %6.2f  max %6.2f ms" % (
+        percentile(values, 50), percentile(values, 90), percentile(values, 99), max(values, default=0.0))
+
+
+def read_response(f):
+    """Status code of one HTTP response read off f, with its body skipped."""
+    status = int(f.readline().split()[1])
+    length = 0
+    chunked = False
+    for line in iter(f.readline, b"\r\n"):
+        name, _, value = line.partition(b":")
+        if name.strip().lower() == b"content-length":
+            length = int(value)
+        elif name.strip().lower() == b"transfer-encoding" and b"chunked" in value.lower():
+            chunked = True
+    if chunked:
+        while True:
+            size = int(f.readline().split(b";")[0], 16)
+            f.read(size + 2)
+            if not size:
+                break
+    else:
+        f.read(length)
+    return status
+
+
+class Result:
+    def __init__(self, name):
+        self.name = name
+        self.latencies = []
+        self.failures = 0
+
+
+def paced(count, rate):
+    """Yield count times, rate per second."""
+    start = time.monotonic()
+    for i in range(count):
+        delay = start + i / rate - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+        yield i
+
+
+def run_get(host, port, query, count, rate, reuse):
+    result = Result("get-reuse" if reuse else "get-new")
+    request = ("GET /control?%s HTTP/1.1\r\nHost: %s\r\n\r\n" % (query, host)).encode()
+    sock = f = None
+    for _ in paced(count, rate):
+        try:
+            start = time.perf_counter()
+            if not sock:
+                sock = socket.create_connection((host, port), timeout=5)
+                sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+                f = sock.makefile("rb")
+            sock.sendall(request)
+            status = read_response(f)
+            elapsed = (time.perf_counter() - start) * 1000
+            if status == 200:
+                result.latencies.append(elapsed)
+            else:
+                result.failures += 1
+        except (OSError, ValueError, IndexError):
+            result.failures += 1
+            sock.close()
+            sock = f = None
+        if not reuse and sock:
+            sock.close()
+            sock = f = None
+    if sock:
+        sock.close()
+    return result
+
+
+def ws_connect(host, port):
+    sock = socket.create_connection((host, port), timeout=5)
+    sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    key = base64.b64encode(os.urandom(16)).decode()
+    sock.sendall(("GET /ws HTTP/1.1\r\nHost: %s\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                  "Sec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n\r\n" % (host, key)).encode())
+    f = sock.makefile("rb")
+    status = int(f.readline().split()[1])
+    for _ in iter(f.readline, b"\r\n"):
+        pass
+    if status != 101:
+        raise ValueError("/ws answered %d" % status)
+    return sock, f
+
+
+def ws_frame(payload):
+    """A masked binary frame, as a client must send it."""
+    mask = os.urandom(4)
+    return bytes([0x82, 0x80 | len(payload)]) + mask + bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+
+
+def ws_read(f):
+    """Payload of the next server frame."""
+    head = f.read(2)
+    if len(head) < 2:
+        raise ValueError("/ws closed")
+    length = head[1] & 0x7f
+    if length == 126:
+        length = struct.unpack(">H", f.read(2))[0]
+    elif length == 127:
+        length = struct.unpack(">Q", f.read(8))[0]
+    return f.read(length)
+
+
+def run_ws(host, port, opcode, value, count, rate):
+    result = Result("ws")
+    frame = ws_frame(struct.pack("<Bh", opcode, value))
+    sock, f = ws_connect(host, port)
+    try:
+        for _ in paced(count, rate):
+            start = time.perf_counter()
+            sock.sendall(frame)
+            ack = ws_read(f)
+            elapsed = (time.perf_counter() - start) * 1000
+            if ack == bytes([opcode, 0]):
+                result.latencies.append(elapsed)
+            else:
+                result.failures += 1
+    except (OSError, ValueError):
+        result.failures += count - len(result.latencies) - result.failures
+    finally:
+        sock.close()
+    return result
+
+
+def run_all(host, port, var, val, count, rate):
+    query = "var=%s&val=%d" % (var, val)
+    return [run_get(host, port, query, count, rate, False),
+            run_get(host, port, query, count, rate, True),
+            run_ws(host, port, OPCODES[var], val, count, rate)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host")
+    parser.add_argument("--port", type=int, default=80, help="control server port")
+    parser.add_argument("--count", type=int, default=200, help="commands per path")
+    parser.add_argument("--rate", type=float, default=20, help="commands per second")
+    parser.add_argument("--var", default="speed", choices=sorted(OPCODES), help="command to send")
+    parser.add_argument("--val", type=int, default=200, help="its value")
+    args = parser.parse_args()
+
+    for result in run_all(args.host, args.port, args.var, args.val, args.count, args.rate):
+        print("%-9s %4d ok %3d failed  %s" % (result.name, len(result.latencies), result.failures,
+                                             fmt_ms(result.latencies)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,207 @@
+#!/usr/bin/env python3
+"""Make, check and send delta firmware patches.
+
+    python3 tools/delta_ota.py make old.bin new.bin -o update.rvdp
+    python3 tools/delta_ota.py apply old.bin update.rvdp -o check.bin
+    python3 tools/delta_ota.py send 192.168.4.1 update.rvdp
+
+old.bin must be the image the car is running, byte for byte as it was
+flashed. The header records SHA-256 over all of old.bin and its length;
+before it touches flash the car hashes that many bytes from the start of
+its running partition and refuses the patch unless the digests match. This
+is not the digest esptool appends to the image, which covers everything
+but itself. new.bin is the freshly built sketch .bin, and the header's
+second digest, over all of new.bin, is checked before the car boots it.
+
+A patch is an 80-byte header (see delta_patch.h) and a zlib stream of
+operations. Matches between the images are found through an index of
+8-byte strings in old.bin, then stretched over nearby changed bytes, so a
+relinked function that differs only in a few addresses becomes one ADD
+whose bytes are mostly zero. Everything else is inserted as literals.
+"""
+
+import argparse
+import hashlib
+import http.client
+import struct
+import zlib
+
+MAGIC = b"RVDP"
+VERSION = 1
+HEADER = struct.Struct("<4sB3xII32s32s")
+OP_END, OP_ADD, OP_INSERT = 0, 1, 2
+
+KEY = 8           # length of the strings indexed in the old image
+STRIDE = 4        # index every STRIDE-th offset of the old image
+MIN_MATCH = 24    # shorter matches are cheaper as literals
+GIVE_UP = 64      # stop stretching a match this far below its best score
+
+
+def build_index(old):
+    index = {}
+    for pos in range(0, len(old) - KEY + 1, STRIDE):
+        index.setdefault(old[pos:pos + KEY], pos)
+    return index
+
+
+def stretch(new, i, old, p):
+    """Length of the approximate match at new[i:], old[p:], bsdiff style:
+    the prefix where matching bytes most outnumber differing ones."""
+    limit = min(len(new) - i, len(old) - p)
+    score = best = best_len = j = 0
+    while j < limit:
+        if j + 64 <= limit and new[i + j:i + j + 64] == old[p + j:p + j + 64]:
+            score += 64
+            j += 64
+        else:
+            score += 1 if new[i + j] == old[p + j] else -1
+            j += 1
+        if score > best:
+            best, best_len = score, j
+        elif score < best - GIVE_UP:
+            break
+    return best_len
+
+
+def diff_ops(old, new):
+    """Yield (op, fields, data) turning old into new."""
+    index = build_index(old)
+    literal = i = 0
+    while i <= len(new) - KEY:
+        p = index.get(new[i:i + KEY])
+        if p is None:
+            i += 1
+            continue
+        # Pull the match back over literal bytes that also match
+        back = 0
+        while i - back > literal and p - back > 0 and new[i - back - 1] == old[p - back - 1]:
+            back += 1
+        start, src = i - back, p - back
+        length = stretch(new, start, old, src)
+        if length < MIN_MATCH:
+            i += 1
+            continue
+        if start > literal:
+            yield OP_INSERT, (start - literal,), new[literal:start]
+        added = bytes((a - b) & 0xFF for a, b in zip(new[start:start + length], old[src:src + length]))
+        yield OP_ADD, (src, length), added
+        i = literal = start + length
+    if literal < len(new):
+        yield OP_INSERT, (len(new) - literal,), new[literal:]
+    yield OP_END, (), b""
+
+
+def make_patch(old, new):
+    ops = bytearray()
+    counts = {OP_ADD: 0, OP_INSERT: 0}
+    inserted = 0
+    for op, fields, data in diff_ops(old, new):
+        ops.append(op)
+        ops += struct.pack("<%dI" % len(fields), *fields)
+        ops += data
+        if op != OP_END:
+            counts[op] += 1
+        if op == OP_INSERT:
+            inserted += len(data)
+    header = HEADER.pack(MAGIC, VERSION, len(old), len(new),
+                         hashlib.sha256(old).digest(), hashlib.sha256(new).digest())
+    return header + zlib.compress(bytes(ops), 9), counts, inserted
+
+
+def apply_patch(old, patch):
+    """Apply patch to old the way the car does and return the new image."""
+    magic, version, source_len, target_len, source_sha, target_sha = HEADER.unpack_from(patch)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("not a version %d delta patch" % VERSION)
+    if len(old) != source_len or hashlib.sha256(old).digest() != source_sha:
+        raise ValueError("patch is not for this source image")
+    ops = zlib.decompress(patch[HEADER.size:])
+    out = bytearray()
+    pos = 0
+    while True:
+        op = ops[pos]
+        pos += 1
+        if op == OP_END:
+            break
+        if op == OP_ADD:
+            src, length = struct.unpack_from("<II", ops, pos)
+            pos += 8
+            if src + length > source_len:
+                raise ValueError("patch reads past source")
+            out += bytes((a + b) & 0xFF for a, b in zip(old[src:src + length], ops[pos:pos + length]))
+        elif op == OP_INSERT:
+            (length,) = struct.unpack_from("<I", ops, pos)
+            pos += 4
+            out += ops[pos:pos + length]
+        else:
+            raise ValueError("unknown operation %d" % op)
+        pos += length
+    if pos != len(ops):
+        raise ValueError("data after end of patch")
+    if len(out) != target_len or hashlib.sha256(out).digest() != target_sha:
+        raise ValueError("patched image does not match the target hash")
+    return bytes(out)
+
+
+def read(path):
+    with open(path, "rb") as f:
+        return f.read()
+
+
+def cmd_make(args):
+    old, new = read(args.old), read(args.new)
+    patch, counts, inserted = make_patch(old, new)
+    if apply_patch(old, patch) != new:
+        raise SystemExit("internal error: patch does not reproduce %s" % args.new)
+    with open(args.output, "wb") as f:
+        f.write(patch)
+    print("%s: %d bytes for a %d byte image (%.1f%%), %d adds, %d inserts of %d bytes" % (
+        args.output, len(patch), len(new), 100.0 * len(patch) / len(new),
+        counts[OP_ADD], counts[OP_INSERT], inserted))
+
+
+def cmd_apply(args):
+    new = apply_patch(read(args.old), read(args.patch))
+    with open(args.output, "wb") as f:
+        f.write(new)
+    print("%s: %d bytes, sha256 %s" % (args.output, len(new), hashlib.sha256(new).hexdigest()))
+
+
+def cmd_send(args):
+    patch = read(args.patch)
+    conn = http.client.HTTPConnection(args.host, args.port, timeout=120)
+    conn.request("POST", "/update/delta", body=patch, headers={"Content-Type": "application/octet-stream"})
+    resp = conn.getresponse()
+    print(resp.status, resp.read().decode(errors="replace").strip())
+    if resp.status != 200:
+        raise SystemExit(1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("make", help="build a patch from old.bin to new.bin")
+    p.add_argument("old")
+    p.add_argument("new")
+    p.add_argument("-o", "--output", required=True)
+    p.set_defaults(func=cmd_make)
+
+    p = sub.add_parser("apply", help="apply a patch to a file, as the car would")
+    p.add_argument("old")
+    p.add_argument("patch")
+    p.add_argument("-o", "--output", required=True)
+    p.set_defaults(func=cmd_apply)
+
+    p = sub.add_parser("send", help="upload a patch to the car")
+    p.add_argument("host")
+    p.add_argument("patch")
+    p.add_argument("--port", type=int, default=80)
+    p.set_defaults(func=cmd_send)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""Minify and gzip the web UI in web/ into web_assets.h.
+
+Run from the sketch directory after editing anything under web/:
+
+    python3 tools/embed_assets.py
+
+The minifier only strips indentation, blank lines and HTML comments, so
+inline JavaScript keeps its line structure and // comments stay safe.
+"""
+
+import gzip
+import hashlib
+import os
+import re
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# (source file, C identifier, content type)
+ASSETS = [
+    ("web/index.html", "INDEX_HTML", "text/html"),
+    ("web/update.html", "UPDATE_HTML", "text/html"),
+]
+
+HEADER = """/*
+  ESP32_CAM_Robot_Car
+  web_assets.h
+  Generated by tools/embed_assets.py from web/, do not edit
+
+*/
+
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include "Arduino.h"
+
+typedef struct
+{
+  const uint8_t *data;  // gzip compressed
+  size_t len;
+  size_t raw_len;
+  const char *content_type;
+  const char *etag;
+} web_asset_t;
+"""
+
+
+def minify(text):
+    text = re.sub(r"<!--.*?-->", "", text, flags=re.S)
+    lines = (line.strip() for line in text.splitlines())
+    return "\n".join(line for line in lines if line) + "\n"
+
+
+def c_array(data):
+    rows = []
+    for i in range(0, len(data), 16):
+        rows.append("    " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    return "\n".join(rows)
+
+
+def main():
+    out = [HEADER]
+    for path, name, content_type in ASSETS:
+        with open(os.path.join(ROOT, path), "rb") as f:
+            raw = f.read()
+        small = minify(raw.decode("utf-8")).encode("utf-8")
+        packed = gzip.compress(small, 9, mtime=0)
+        etag = '"%s"' % hashlib.sha1(packed).hexdigest()[:16]
+        out.append("// %s: %d bytes, %d minified, %d gzipped" % (path, len(raw), len(small), len(packed)))
+        out.append("static const uint8_t %s_GZ[] PROGMEM = {\n%s\n};" % (name, c_array(packed)))
+        out.append("static const web_asset_t %s_ASSET = {%s_GZ, sizeof(%s_GZ), %d, \"%s\", \"%s\"};\n"
+                   % (name, name, name, len(small), content_type, etag.replace('"', '\\"')))
+        print("%s: %d -> %d -> %d bytes" % (path, len(raw), len(small), len(packed)))
+    out.append("#endif")
+    with open(os.path.join(ROOT, "web_assets.h"), "w") as f:
+        f.write("\n".join(out) + "\n")
+
+
+if __name__ == "__main__":
+    main()
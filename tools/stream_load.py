@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+"""Soak the car with several /stream viewers plus a /control and /capture mix.
+
+    python3 tools/stream_load.py 192.168.4.1 --clients 3 --duration 60
+
+Each viewer is a raw socket reading the multipart stream on port 81, so frame
+arrival times are not smoothed by any client library. At the end it prints
+per-client fps, inter-frame jitter percentiles and stalls, the latency of the
+/control and /capture requests, and the free heap reported by /status.
+"""
+
+import argparse
+import json
+import socket
+import threading
+import time
+import urllib.request
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+
+def fmt_ms(values):
+    return "p50 %6.1f  p90 %6.1f  p99 %6.1f  max %6.1f ms" % (
+        percentile(values, 50), percentile(values, 90), percentile(values, 99), max(values, default=0.0))
+
+
+class ChunkedReader:
+    """readline()/read() over the body of a chunked HTTP response."""
+
+    def __init__(self, f):
+        self.f = f
+        self.buf = b""
+
+    def fill(self):
+        size = int(self.f.readline().split(b";")[0], 16)
+        if size == 0:
+            raise ValueError("stream ended by server")
+        data = self.f.read(size)
+        self.f.readline()
+        if len(data) != size:
+            raise ValueError("short chunk")
+        self.buf += data
+
+    def readline(self):
+        while b"\n" not in self.buf:
+            self.fill()
+        line, _, self.buf = self.buf.partition(b"\n")
+        return line + b"\n"
+
+    def read(self, n):
+        while len(self.buf) < n:
+            self.fill()
+        data, self.buf = self.buf[:n], self.buf[n:]
+        return data
+
+
+class StreamClient(threading.Thread):
+    """Read /stream and record the arrival time of every complete frame."""
+
+    def __init__(self, index, host, port, deadline):
+        super().__init__(daemon=True)
+        self.index = index
+        self.host = host
+        self.port = port
+        self.deadline = deadline
+        self.arrivals = []
+        self.bytes = 0
+        self.error = None
+
+    def run(self):
+        try:
+            self.read_stream()
+        except (OSError, ValueError) as e:
+            self.error = str(e)
+
+    def read_stream(self):
+        sock = socket.create_connection((self.host, self.port), timeout=5)
+        sock.sendall(b"GET /stream HTTP/1.1\r\nHost: %s\r\n\r\n" % self.host.encode())
+        f = sock.makefile("rb")
+        status = f.readline()
+        if b" 200 " not in status:
+            raise ValueError("stream refused: %s" % status.decode(errors="replace").strip())
+        chunked = False
+        for line in iter(f.readline, b"\r\n"):
+            if not line:
+                raise ValueError("stream closed by server")
+            chunked |= line.lower().startswith(b"transfer-encoding:") and b"chunked" in line.lower()
+        body = ChunkedReader(f) if chunked else f
+        while time.monotonic() < self.deadline:
+            # Skip boundaries and other part headers until one gives the
+            # JPEG length
+            line = body.readline()
+            if not line:
+                raise ValueError("stream closed by server")
+            if not line.lower().startswith(b"content-length:"):
+                continue
+            length = int(line.split(b":")[1])
+            # Rest of the part headers, up to the blank line
+            while body.readline().strip():
+                pass
+            jpeg = body.read(length)
+            if len(jpeg) != length:
+                raise ValueError("short frame")
+            self.arrivals.append(time.monotonic())
+            self.bytes += length
+        sock.close()
+
+
+class RequestMix(threading.Thread):
+    """Issue GET requests to one path at a fixed rate and time each one."""
+
+    def __init__(self, url, rate, deadline):
+        super().__init__(daemon=True)
+        self.url = url
+        self.period = 1.0 / rate
+        self.deadline = deadline
+        self.latencies = []
+        self.failures = 0
+
+    def run(self):
+        next_at = time.monotonic()
+        while next_at < self.deadline:
+            start = time.monotonic()
+            try:
+                with urllib.request.urlopen(self.url, timeout=5) as r:
+                    r.read()
+                self.latencies.append((time.monotonic() - start) * 1000)
+            except OSError:
+                self.failures += 1
+            next_at += self.period
+            time.sleep(max(0.0, next_at - time.monotonic()))
+
+
+class StatusPoller(threading.Thread):
+    """Sample heap figures from /status once per second."""
+
+    def __init__(self, url, deadline):
+        super().__init__(daemon=True)
+        self.url = url
+        self.deadline = deadline
+        self.heap_free = []
+        self.heap_min_free = None
+        self.frames_dropped = None
+
+    def run(self):
+        while time.monotonic() < self.deadline:
+            try:
+                with urllib.request.urlopen(self.url, timeout=5) as r:
+                    status = json.load(r)
+                self.heap_free.append(status.get("heap_free", 0))
+                self.heap_min_free = status.get("heap_min_free")
+                self.frames_dropped = status.get("frames_dropped")
+            except (OSError, ValueError):
+                pass
+            time.sleep(1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("host", help="car address, e.g. 192.168.4.1")
+    parser.add_argument("--port", type=int, default=80, help="control server port")
+    parser.add_argument("--stream-port", type=int, default=81, help="stream server port")
+    parser.add_argument("--clients", type=int, default=2, help="concurrent /stream viewers")
+    parser.add_argument("--duration", type=float, default=30, help="test length in seconds")
+    parser.add_argument("--control-rate", type=float, default=5, help="/control requests per second, 0 to disable")
+    parser.add_argument("--control", default="var=speed&val=200", help="/control query to send")
+    parser.add_argument("--capture-rate", type=float, default=0.5, help="/capture requests per second, 0 to disable")
+    parser.add_argument("--stall-ms", type=float, default=500, help="inter-frame gap counted as a stall")
+    args = parser.parse_args()
+
+    base = "http://%s:%d" % (args.host, args.port)
+    deadline = time.monotonic() + args.duration
+    clients = [StreamClient(i, args.host, args.stream_port, deadline) for i in range(args.clients)]
+    mixes = []
+    if args.control_rate > 0:
+        mixes.append(("/control", RequestMix("%s/control?%s" % (base, args.control), args.control_rate, deadline)))
+    if args.capture_rate > 0:
+        mixes.append(("/capture", RequestMix("%s/capture" % base, args.capture_rate, deadline)))
+    status = StatusPoller("%s/status" % base, deadline)
+
+    for t in clients + [m for _, m in mixes] + [status]:
+        t.start()
+    for t in clients + [m for _, m in mixes] + [status]:
+        t.join(args.duration + 10)
+
+    print("%d viewers for %.0f s" % (args.clients, args.duration))
+    for c in clients:
+        gaps = [(b - a) * 1000 for a, b in zip(c.arrivals, c.arrivals[1:])]
+        span = c.arrivals[-1] - c.arrivals[0] if len(c.arrivals) > 1 else 0
+        fps = (len(c.arrivals) - 1) / span if span else 0.0
+        stalls = sum(1 for g in gaps if g >= args.stall_ms)
+        print("stream %d: %5d frames %6.2f fps %7.1f kB/s  stalls %d" % (
+            c.index, len(c.arrivals), fps, c.bytes / 1024 / args.duration, stalls))
+        print("          interval %s" % fmt_ms(gaps))
+        if c.error:
+            print("          error: %s" % c.error)
+    for path, m in mixes:
+        print("%-9s %5d ok %3d failed  %s" % (path, len(m.latencies), m.failures, fmt_ms(m.latencies)))
+    if status.heap_free:
+        print("heap free: min %d  max %d  low water %s  frames dropped %s" % (
+            min(status.heap_free), max(status.heap_free), status.heap_min_free, status.frames_dropped))
+
+
+if __name__ == "__main__":
+    main()
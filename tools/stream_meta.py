@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""Check a recorded /stream for dropped, duplicated and late frames.
+
+    curl --max-time 60 http://192.168.4.1:81/stream > drive.mjpg
+    python3 tools/stream_meta.py drive.mjpg
+    python3 tools/stream_meta.py frames/*.jpg
+
+Every stream part carries X-Frame-Seq, X-Timestamp (sensor capture) and
+X-Send-Timestamp headers, and the JPEG itself starts with a COM segment
+holding the same fields, so single saved frames can be checked too. All
+timestamps are on the car's clock in seconds since boot.
+
+Reports sequence gaps (frames the viewer never got), duplicates and
+reordering, the capture-to-send latency distribution on the car, and the
+capture interval.
+"""
+
+import argparse
+import re
+
+COM_RE = re.compile(rb"seq=(\d+) capture=([\d.]+) send=([\d.]+)")
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+
+def fmt_ms(values):
+    return "p50 %7.1f  p90 %7.1f  p99 %7.1f  max %7.1f ms" % (
+        percentile(values, 50), percentile(values, 90), percentile(values, 99), max(values, default=0.0))
+
+
+def jpeg_meta(jpeg):
+    """(seq, capture, send) from the COM segment right after SOI, or None."""
+    if jpeg[:4] != b"\xff\xd8\xff\xfe" or len(jpeg) < 6:
+        return None
+    seg_len = int.from_bytes(jpeg[4:6], "big")
+    m = COM_RE.match(jpeg[6:4 + seg_len])
+    if not m:
+        return None
+    return int(m.group(1)), float(m.group(2)), float(m.group(3))
+
+
+def multipart_frames(data):
+    """Yield (headers, jpeg) for every part of a recorded multipart stream."""
+    pos = 0
+    while True:
+        start = data.find(b"Content-Type: image/jpeg", pos)
+        if start < 0:
+            return
+        end = data.find(b"\r\n\r\n", start)
+        if end < 0:
+            return
+        headers = {}
+        for line in data[start:end].split(b"\r\n"):
+            key, _, value = line.partition(b":")
+            headers[key.strip().lower().decode()] = value.strip().decode()
+        length = int(headers.get("content-length", 0))
+        jpeg = data[end + 4:end + 4 + length]
+        if len(jpeg) < length:
+            return
+        yield headers, jpeg
+        pos = end + 4 + length
+
+
+def read_frames(paths):
+    """List of (seq, capture, send) in file order, and frames without metadata."""
+    frames = []
+    missing = 0
+    for path in paths:
+        with open(path, "rb") as f:
+            data = f.read()
+        if data.startswith(b"\xff\xd8"):
+            parts = [({}, data)]
+        else:
+            parts = multipart_frames(data)
+        for headers, jpeg in parts:
+            if "x-frame-seq" in headers:
+                frames.append((int(headers["x-frame-seq"]), float(headers["x-timestamp"]),
+                               float(headers["x-send-timestamp"])))
+                continue
+            meta = jpeg_meta(jpeg)
+            if meta:
+                frames.append(meta)
+            else:
+                missing += 1
+    return frames, missing
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("files", nargs="+", help="multipart recording(s) or single JPEG frames")
+    parser.add_argument("--sort", action="store_true", help="order frames by sequence, e.g. for saved frame files")
+    args = parser.parse_args()
+
+    frames, missing = read_frames(args.files)
+    if args.sort:
+        frames.sort()
+    if not frames:
+        print("no frames with metadata (%d without)" % missing)
+        return
+
+    seen = set()
+    duplicates = reordered = gaps = lost = 0
+    last = None
+    for seq, _, _ in frames:
+        if seq in seen:
+            duplicates += 1
+            continue
+        seen.add(seq)
+        if last is not None:
+            if seq < last:
+                reordered += 1
+            elif seq > last + 1:
+                gaps += 1
+                lost += seq - last - 1
+        last = max(seq, last) if last is not None else seq
+
+    unique = sorted({seq: (cap, send) for seq, cap, send in frames}.items())
+    latency = [(send - cap) * 1000 for _, (cap, send) in unique]
+    interval = [(b[1][0] - a[1][0]) * 1000 for a, b in zip(unique, unique[1:])]
+    span = unique[-1][1][0] - unique[0][1][0]
+    expected = unique[-1][0] - unique[0][0] + 1
+
+    print("frames   %d received, %d unique, seq %d-%d, %d without metadata" % (
+        len(frames), len(unique), unique[0][0], unique[-1][0], missing))
+    print("drops    %d frames in %d gaps (%.1f%% of %d produced)" % (lost, gaps, 100.0 * lost / expected, expected))
+    print("dups     %d   reordered %d" % (duplicates, reordered))
+    print("capture->send %s" % fmt_ms(latency))
+    print("capture interval %s" % fmt_ms(interval))
+    if span > 0:
+        print("rate     %.2f fps delivered over %.1f s" % ((len(unique) - 1) / span, span))
+
+
+if __name__ == "__main__":
+    main()
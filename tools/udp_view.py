@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+"""Receive the car's UDP video stream and save the frames.
+
+    python3 tools/udp_view.py 192.168.4.1 --latest /tmp/car.jpg
+    python3 tools/udp_view.py 192.168.4.1 --save frames/
+
+Subscribes to UDP port 5000 on the car, reassembles JPEG frames from their
+fragments and drops any frame that is still incomplete once a newer one has
+finished, so a lost datagram costs one frame instead of stalling the view.
+--latest keeps overwriting one file, which any image viewer that reloads on
+change can display; --save keeps every frame. Stats are printed each second.
+
+Datagram layout (little endian), see udp_stream.h:
+    magic "RV", version, flags, frame_id u32, frag u16, frag_count u16,
+    frame_len u32, then up to 1400 payload bytes.
+"""
+
+import argparse
+import os
+import socket
+import struct
+import time
+
+PORT = 5000
+VERSION = 1
+HEADER = struct.Struct("<2sBBIHHI")
+SUBSCRIBE = b"RVSU"
+UNSUBSCRIBE = b"RVBY"
+RENEW_S = 1.0
+
+
+class Reassembler:
+    """Collect fragments per frame id and hand back complete frames in order."""
+
+    def __init__(self, max_pending=4):
+        self.max_pending = max_pending
+        self.pending = {}
+        self.last_complete = 0
+        self.complete = 0
+        self.dropped = 0
+        self.invalid = 0
+
+    def feed(self, datagram):
+        """Return (frame_id, jpeg) when datagram completes a frame, else None."""
+        if len(datagram) < HEADER.size:
+            self.invalid += 1
+            return None
+        magic, version, _, frame_id, frag, count, length = HEADER.unpack_from(datagram)
+        if magic != b"RV" or version != VERSION or frag >= count:
+            self.invalid += 1
+            return None
+        # Late fragments of a frame that is already superseded
+        if frame_id <= self.last_complete:
+            return None
+
+        frags = self.pending.setdefault(frame_id, {"count": count, "length": length, "parts": {}})
+        frags["parts"][frag] = datagram[HEADER.size:]
+        if len(frags["parts"]) < count:
+            # Too many frames waiting: the oldest are the ones that lost a
+            # fragment, and the newest may still complete
+            if len(self.pending) > self.max_pending:
+                self.drop_older(sorted(self.pending)[-self.max_pending])
+            return None
+
+        del self.pending[frame_id]
+        jpeg = b"".join(frags["parts"][i] for i in range(count))
+        if len(jpeg) != length:
+            self.invalid += 1
+            return None
+        self.drop_older(frame_id)
+        self.last_complete = frame_id
+        self.complete += 1
+        return frame_id, jpeg
+
+    def drop_older(self, frame_id):
+        for old in [f for f in self.pending if f < frame_id]:
+            del self.pending[old]
+            self.dropped += 1
+
+
+def write_atomic(path, data):
+    tmp = path + ".tmp"
+    with open(tmp, "wb") as f:
+        f.write(data)
+    os.replace(tmp, path)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("host", help="car address, e.g. 192.168.4.1")
+    parser.add_argument("--port", type=int, default=PORT)
+    parser.add_argument("--latest", help="file rewritten with every complete frame")
+    parser.add_argument("--save", help="directory to save every complete frame in")
+    parser.add_argument("--duration", type=float, default=0, help="stop after this many seconds, 0 to run until ^C")
+    args = parser.parse_args()
+
+    if args.save:
+        os.makedirs(args.save, exist_ok=True)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.settimeout(0.2)
+    car = (args.host, args.port)
+    frames = Reassembler()
+
+    start = time.monotonic()
+    next_renew = next_report = start
+    reported = 0
+    try:
+        while not args.duration or time.monotonic() - start < args.duration:
+            now = time.monotonic()
+            if now >= next_renew:
+                sock.sendto(SUBSCRIBE, car)
+                next_renew = now + RENEW_S
+            if now >= next_report:
+                print("%6.1fs  %3d fps  complete %d  dropped %d  invalid %d" % (
+                    now - start, frames.complete - reported, frames.complete, frames.dropped, frames.invalid))
+                reported = frames.complete
+                next_report = now + 1.0
+            try:
+                datagram = sock.recv(2048)
+            except socket.timeout:
+                continue
+            frame = frames.feed(datagram)
+            if not frame:
+                continue
+            frame_id, jpeg = frame
+            if args.latest:
+                write_atomic(args.latest, jpeg)
+            if args.save:
+                with open(os.path.join(args.save, "frame_%08d.jpg" % frame_id), "wb") as f:
+                    f.write(jpeg)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        sock.sendto(UNSUBSCRIBE, car)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,217 @@
+/*
+  ESP32_CAM_Robot_Car
+  udp_stream.cpp
+  Optional low-latency video transport: JPEG frames fragmented into
+  sequenced UDP datagrams
+
+*/
+
+#include "udp_stream.h"
+#include "frame_hub.h"
+#include "deferred_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+
+typedef struct
+{
+  struct sockaddr_in addr;
+  int64_t last_seen_us;  // 0 marks a free entry
+} receiver_t;
+
+static receiver_t receivers[UDP_STREAM_MAX_RECEIVERS];
+static udp_stream_stats_t udp_stats;
+static portMUX_TYPE udp_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t udp_task = NULL;
+
+static void subscribe(const struct sockaddr_in *from, bool add, int64_t now)
+{
+  receiver_t *free_entry = NULL;
+  for (int i = 0; i < UDP_STREAM_MAX_RECEIVERS; i++)
+  {
+    receiver_t *r = &receivers[i];
+    if (r->last_seen_us && r->addr.sin_addr.s_addr == from->sin_addr.s_addr &&
+        r->addr.sin_port == from->sin_port)
+    {
+      r->last_seen_us = add ? now : 0;
+      return;
+    }
+    if (!r->last_seen_us && !free_entry)
+      free_entry = r;
+  }
+  if (add && free_entry)
+  {
+    free_entry->addr = *from;
+    free_entry->last_seen_us = now;
+  }
+}
+
+// Handle subscription messages, waiting up to the socket timeout for the
+// first one when block is set, then expire silent receivers. Returns the
+// number of active receivers.
+static int poll_receivers(int sock, bool block)
+{
+  char msg[8];
+  struct sockaddr_in from;
+  socklen_t from_len = sizeof(from);
+  int flags = block ? 0 : MSG_DONTWAIT;
+  int n;
+  while ((n = recvfrom(sock, msg, sizeof(msg), flags, (struct sockaddr *)&from, &from_len)) >= 0)
+  {
+    if (n == 4 && !memcmp(msg, UDP_STREAM_SUBSCRIBE, 4))
+      subscribe(&from, true, esp_timer_get_time());
+    else if (n == 4 && !memcmp(msg, UDP_STREAM_UNSUBSCRIBE, 4))
+      subscribe(&from, false, 0);
+    flags = MSG_DONTWAIT;
+    from_len = sizeof(from);
+  }
+
+  int64_t now = esp_timer_get_time();
+  int count = 0;
+  for (int i = 0; i < UDP_STREAM_MAX_RECEIVERS; i++)
+  {
+    if (receivers[i].last_seen_us && now - receivers[i].last_seen_us > UDP_STREAM_TIMEOUT_MS * 1000LL)
+      receivers[i].last_seen_us = 0;
+    if (receivers[i].last_seen_us)
+      count++;
+  }
+  portENTER_CRITICAL(&udp_lock);
+  udp_stats.receivers = count;
+  portEXIT_CRITICAL(&udp_lock);
+  return count;
+}
+
+// sendto fails with ENOMEM when the WiFi driver is out of TX buffers. Give
+// it one tick to drain before giving up on the datagram.
+static bool send_datagram(int sock, const uint8_t *packet, size_t len, const struct sockaddr_in *to)
+{
+  for (int attempt = 0; attempt < 2; attempt++)
+  {
+    if (sendto(sock, packet, len, 0, (const struct sockaddr *)to, sizeof(*to)) == (int)len)
+      return true;
+    if (errno != ENOMEM && errno != EAGAIN)
+      return false;
+    vTaskDelay(1);
+  }
+  return false;
+}
+
+// Fragment one frame to every receiver. A fragment that cannot be sent
+// aborts the rest of the frame, since the receiver will drop it anyway.
+static void send_frame(int sock, const hub_frame_t *frame)
+{
+  uint8_t packet[sizeof(udp_frag_header_t) + UDP_STREAM_PAYLOAD];
+  udp_frag_header_t *header = (udp_frag_header_t *)packet;
+  header->magic[0] = 'R';
+  header->magic[1] = 'V';
+  header->version = UDP_STREAM_VERSION;
+  header->flags = 0;
+  header->frame_id = frame->seq;
+  header->frag_count = (frame->len + UDP_STREAM_PAYLOAD - 1) / UDP_STREAM_PAYLOAD;
+  header->frame_len = frame->len;
+
+  bool sent[UDP_STREAM_MAX_RECEIVERS] = {};
+  for (int i = 0; i < UDP_STREAM_MAX_RECEIVERS; i++)
+    sent[i] = receivers[i].last_seen_us != 0;
+
+  uint32_t fragments = 0;
+  for (uint16_t frag = 0; frag < header->frag_count; frag++)
+  {
+    size_t offset = (size_t)frag * UDP_STREAM_PAYLOAD;
+    size_t len = frame->len - offset < UDP_STREAM_PAYLOAD ? frame->len - offset : UDP_STREAM_PAYLOAD;
+    header->frag = frag;
+    memcpy(packet + sizeof(udp_frag_header_t), frame->buf + offset, len);
+    for (int i = 0; i < UDP_STREAM_MAX_RECEIVERS; i++)
+    {
+      if (!sent[i])
+        continue;
+      if (send_datagram(sock, packet, sizeof(udp_frag_header_t) + len, &receivers[i].addr))
+        fragments++;
+      else
+        sent[i] = false;
+    }
+  }
+
+  portENTER_CRITICAL(&udp_lock);
+  udp_stats.fragments += fragments;
+  for (int i = 0; i < UDP_STREAM_MAX_RECEIVERS; i++)
+  {
+    if (sent[i])
+      udp_stats.frames++;
+    else if (receivers[i].last_seen_us)
+      udp_stats.aborted++;
+  }
+  portEXIT_CRITICAL(&udp_lock);
+}
+
+static void udp_stream_task(void *arg)
+{
+  int sock = (int)(intptr_t)arg;
+  int client = -1;
+  uint32_t last_seq = 0;
+
+  while (true)
+  {
+    if (!poll_receivers(sock, client < 0))
+    {
+      if (client >= 0)
+      {
+        frame_hub_detach(client);
+        client = -1;
+      }
+      continue;
+    }
+    if (client < 0)
+    {
+      client = frame_hub_attach_internal();
+      if (client < 0)
+      {
+        dlog_write(DLOG_STREAM_ERROR, client, (uintptr_t)"UDP stream: no free frame hub client");
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        continue;
+      }
+    }
+
+    hub_frame_t *frame = frame_hub_acquire(last_seq, pdMS_TO_TICKS(100));
+    if (!frame)
+      continue;
+    last_seq = frame->seq;
+    send_frame(sock, frame);
+    frame_hub_release(frame);
+  }
+}
+
+void udp_stream_start()
+{
+  if (udp_task)
+    return;
+  int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (sock < 0)
+  {
+    Serial.println("UDP stream: socket failed");
+    return;
+  }
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(UDP_STREAM_PORT);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+  {
+    Serial.println("UDP stream: bind failed");
+    close(sock);
+    return;
+  }
+  // Bounds how long an idle sender blocks waiting for a subscription, so
+  // expired receivers are noticed
+  struct timeval timeout = {1, 0};
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  xTaskCreate(udp_stream_task, "udp_stream", 4096, (void *)(intptr_t)sock, 5, &udp_task);
+  Serial.printf("UDP stream listening on port %d\n", UDP_STREAM_PORT);
+}
+
+void udp_stream_get_stats(udp_stream_stats_t *stats)
+{
+  portENTER_CRITICAL(&udp_lock);
+  *stats = udp_stats;
+  portEXIT_CRITICAL(&udp_lock);
+}
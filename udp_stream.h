@@ -0,0 +1,55 @@
+/*
+  ESP32_CAM_Robot_Car
+  udp_stream.h
+  Optional low-latency video transport: JPEG frames fragmented into
+  sequenced UDP datagrams
+
+*/
+
+#ifndef UDP_STREAM_H
+#define UDP_STREAM_H
+
+#include "Arduino.h"
+
+#define UDP_STREAM_PORT 5000
+#define UDP_STREAM_VERSION 1
+// Payload bytes per datagram; header plus payload stays under a 1500 byte MTU
+#define UDP_STREAM_PAYLOAD 1400
+#define UDP_STREAM_MAX_RECEIVERS 2
+// Receivers that have not renewed their subscription for this long are dropped
+#define UDP_STREAM_TIMEOUT_MS 3000
+
+// Receivers send these 4 byte messages to UDP_STREAM_PORT. A subscription
+// must be renewed at least every UDP_STREAM_TIMEOUT_MS.
+#define UDP_STREAM_SUBSCRIBE "RVSU"
+#define UDP_STREAM_UNSUBSCRIBE "RVBY"
+
+// Every datagram starts with this header, little endian. A frame is complete
+// once all frag_count fragments with its frame_id have arrived; receivers
+// should drop incomplete frames rather than wait for them.
+typedef struct __attribute__((packed))
+{
+  uint8_t magic[2];     // 'R', 'V'
+  uint8_t version;      // UDP_STREAM_VERSION
+  uint8_t flags;        // reserved, 0
+  uint32_t frame_id;    // frame hub sequence number
+  uint16_t frag;        // fragment index, 0 based
+  uint16_t frag_count;
+  uint32_t frame_len;   // JPEG length in bytes
+} udp_frag_header_t;
+
+typedef struct
+{
+  uint8_t receivers;
+  uint32_t frames;       // frames sent completely
+  uint32_t fragments;
+  uint32_t aborted;      // frames cut short because the network stack was out of buffers
+} udp_stream_stats_t;
+
+// Open the UDP socket and start the sender task. Frames are only pulled
+// from the frame hub while at least one receiver is subscribed.
+void udp_stream_start();
+
+void udp_stream_get_stats(udp_stream_stats_t *stats);
+
+#endif
@@ -0,0 +1,418 @@
+/*
+  ESP32_CAM_Robot_Car
+  web_assets.h
+  Generated by tools/embed_assets.py from web/, do not edit
+
+*/
+
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include "Arduino.h"
+
+typedef struct
+{
+  const uint8_t *data;  // gzip compressed
+  size_t len;
+  size_t raw_len;
+  const char *content_type;
+  const char *etag;
+} web_asset_t;
+
+// web/index.html: 18687 bytes, 14894 minified, 4877 gzipped
+static const uint8_t INDEX_HTML_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xdd, 0x5b, 0xff, 0x52, 0xdb, 0x48,
+    0xb6, 0xfe, 0x9f, 0xa7, 0x68, 0x3c, 0x99, 0x58, 0x9a, 0x91, 0x65, 0x1b, 0x30, 0x43, 0x6c, 0x0c,
+    0x4b, 0x0c, 0x99, 0xc9, 0x56, 0x32, 0xc9, 0x86, 0xdc, 0x3b, 0xb7, 0x2a, 0x95, 0x02, 0x59, 0x6a,
+    0xd9, 0x02, 0x59, 0x72, 0xa4, 0x36, 0xc6, 0x61, 0xfc, 0x1c, 0xf7, 0x81, 0xee, 0x8b, 0xed, 0x77,
+    0xba, 0x5b, 0xb2, 0x84, 0x65, 0x87, 0x9d, 0x9d, 0xad, 0xdd, 0xba, 0xc3, 0x80, 0xe5, 0xd6, 0xe9,
+    0xd3, 0x5f, 0x9f, 0xdf, 0xa7, 0xa5, 0x1c, 0xef, 0x7a, 0xb1, 0x2b, 0x16, 0x53, 0xce, 0xc6, 0x62,
+    0x12, 0x9e, 0xec, 0x1c, 0x67, 0x1f, 0xdc, 0xf1, 0xf0, 0x31, 0xe1, 0xc2, 0x61, 0xee, 0xd8, 0x49,
+    0x52, 0x2e, 0xfa, 0xb5, 0x99, 0xf0, 0x1b, 0x47, 0xb5, 0x6c, 0x38, 0x72, 0x26, 0xbc, 0x5f, 0xbb,
+    0x0b, 0xf8, 0x7c, 0x1a, 0x27, 0xa2, 0xc6, 0xdc, 0x38, 0x12, 0x3c, 0x02, 0xd9, 0x3c, 0xf0, 0xc4,
+    0xb8, 0xef, 0xf1, 0xbb, 0xc0, 0xe5, 0x0d, 0xf9, 0xc5, 0x0a, 0xa2, 0x40, 0x04, 0x4e, 0xd8, 0x48,
+    0x5d, 0x27, 0xe4, 0xfd, 0x36, 0xf1, 0x10, 0x81, 0x08, 0xf9, 0xc9, 0xc5, 0xe5, 0xfb, 0xfd, 0x3d,
+    0x36, 0x38, 0x7b, 0xcb, 0x3e, 0xc4, 0xc3, 0x58, 0x1c, 0x37, 0xd5, 0xf0, 0xce, 0x71, 0x2a, 0x16,
+    0xf4, 0x39, 0x8c, 0xbd, 0x05, 0x7b, 0xd8, 0xf1, 0xc1, 0xbb, 0xe1, 0x3b, 0x93, 0x20, 0x5c, 0x74,
+    0xd9, 0x59, 0x02, 0x56, 0x16, 0xfb, 0x85, 0x87, 0x77, 0x5c, 0x04, 0xae, 0x63, 0xb1, 0xd4, 0x89,
+    0xd2, 0x46, 0xca, 0x93, 0xc0, 0xef, 0xed, 0x0c, 0x1d, 0xf7, 0x76, 0x94, 0xc4, 0xb3, 0xc8, 0xeb,
+    0xb2, 0xef, 0xda, 0x47, 0xf4, 0xd3, 0xdb, 0x71, 0xe3, 0x30, 0x4e, 0xf0, 0x9d, 0xfb, 0xf4, 0xd3,
+    0x53, 0xfc, 0xd2, 0xe0, 0x2b, 0xef, 0xb2, 0xf6, 0xe1, 0xf4, 0xbe, 0xb7, 0xb3, 0xdc, 0x19, 0xef,
+    0x65, 0xeb, 0xe8, 0xf1, 0x23, 0x35, 0x9e, 0x72, 0x57, 0x04, 0x71, 0x64, 0x4f, 0x9c, 0x20, 0x02,
+    0x85, 0x17, 0xa4, 0xd3, 0xd0, 0x01, 0x0a, 0x3f, 0xe4, 0xf2, 0xfe, 0x77, 0x13, 0x1e, 0xcd, 0xac,
+    0xc7, 0x64, 0x74, 0xb7, 0xe1, 0x05, 0x89, 0x1a, 0xed, 0x42, 0x38, 0xe1, 0x6c, 0x12, 0xe5, 0xf4,
+    0x45, 0x46, 0x51, 0x1c, 0xf1, 0x9e, 0x9a, 0x30, 0x4f, 0x9c, 0x29, 0x0d, 0xd0, 0x67, 0x6f, 0x67,
+    0x12, 0x44, 0x4a, 0x7c, 0x5d, 0xb6, 0x7f, 0xd0, 0x22, 0x34, 0xa5, 0xbd, 0xed, 0x1f, 0xd2, 0x4f,
+    0x6f, 0x67, 0xea, 0x78, 0x5e, 0x10, 0x8d, 0xba, 0x4c, 0x02, 0x1e, 0xc6, 0x89, 0xc7, 0x93, 0x46,
+    0xe2, 0x78, 0xc1, 0x2c, 0xed, 0xb2, 0x03, 0x1a, 0x9b, 0x38, 0xc9, 0x08, 0xbc, 0x44, 0x0c, 0xe6,
+    0xed, 0xc2, 0x40, 0x12, 0x8c, 0xc6, 0x02, 0x43, 0x2d, 0xb5, 0xd3, 0xef, 0xb4, 0x06, 0xd7, 0x77,
+    0x59, 0x00, 0xa7, 0xa0, 0x39, 0x61, 0x30, 0x8a, 0x1a, 0x81, 0xe0, 0x13, 0xac, 0x91, 0x8a, 0x84,
+    0x0b, 0x77, 0x4c, 0x2c, 0xfc, 0x60, 0x34, 0x4b, 0x38, 0x18, 0xe4, 0xa0, 0x5a, 0xd9, 0x6a, 0xf2,
+    0xb2, 0x31, 0xe7, 0xc3, 0xdb, 0x40, 0x34, 0x34, 0x80, 0x21, 0xf7, 0xe3, 0x84, 0x17, 0x88, 0x1a,
+    0xc3, 0x30, 0x76, 0x6f, 0x1b, 0xa9, 0x70, 0x12, 0x51, 0x35, 0xc1, 0xf1, 0x05, 0x4f, 0xd6, 0xe9,
+    0x39, 0x09, 0x64, 0x9d, 0x7a, 0xc5, 0x46, 0x0f, 0x04, 0x51, 0x18, 0x44, 0x7c, 0x33, 0xfb, 0x8c,
+    0x4f, 0x99, 0x3c, 0x1b, 0xcd, 0xb7, 0x17, 0x4c, 0x46, 0x45, 0x19, 0x49, 0x0c, 0xbd, 0x1d, 0xad,
+    0xaa, 0x76, 0xab, 0xf5, 0x7d, 0x6f, 0x67, 0xcc, 0x95, 0x6c, 0x9d, 0x99, 0x88, 0x9f, 0xa0, 0x94,
+    0x8e, 0xd2, 0xc0, 0x5f, 0x26, 0xdc, 0x0b, 0x1c, 0x66, 0x14, 0x34, 0x7f, 0xd4, 0x82, 0x76, 0x4c,
+    0xe6, 0x44, 0x1e, 0x33, 0xe2, 0x24, 0x80, 0x7a, 0x1c, 0x65, 0x51, 0x21, 0x86, 0xe0, 0x4e, 0x53,
+    0x6e, 0x02, 0xcb, 0x93, 0x54, 0x97, 0xd9, 0xd5, 0x37, 0x94, 0x57, 0xbd, 0xbb, 0x89, 0x73, 0xdf,
+    0x28, 0xed, 0x90, 0x06, 0xb2, 0x5d, 0xc2, 0xab, 0x5d, 0x03, 0xc3, 0x77, 0x63, 0xd6, 0x60, 0x64,
+    0xaa, 0x66, 0x2e, 0x0e, 0x25, 0x80, 0xb2, 0x38, 0xfe, 0xdf, 0xdb, 0x49, 0x1e, 0x35, 0xd8, 0x77,
+    0xc3, 0x99, 0x10, 0x71, 0x94, 0x3e, 0x49, 0x31, 0x37, 0xb3, 0x54, 0x04, 0xfe, 0xa2, 0xa1, 0x95,
+    0x09, 0xe5, 0x4c, 0x1d, 0x84, 0xd0, 0x21, 0x17, 0x73, 0xce, 0x55, 0xf0, 0x88, 0x9c, 0x3b, 0x98,
+    0xcc, 0x68, 0x14, 0x92, 0xf0, 0xdc, 0x59, 0x92, 0x52, 0x58, 0x9b, 0xc6, 0x01, 0x26, 0x24, 0xbd,
+    0x35, 0xa5, 0x95, 0x26, 0x34, 0xdc, 0x21, 0xe6, 0xc4, 0x33, 0x41, 0x60, 0x25, 0xd0, 0x18, 0xec,
+    0x03, 0xb1, 0x90, 0xd7, 0x5a, 0x5d, 0xad, 0x95, 0xae, 0x5a, 0xeb, 0xf3, 0xbb, 0xee, 0x98, 0xbb,
+    0xb7, 0xdc, 0x63, 0x3f, 0xb2, 0xb5, 0x30, 0x96, 0xc5, 0x43, 0x3b, 0x88, 0xa6, 0x33, 0xd1, 0xa0,
+    0x30, 0x35, 0x7d, 0xd2, 0xae, 0xa5, 0xec, 0xb2, 0x45, 0xf7, 0xf6, 0x56, 0xbe, 0xd1, 0x65, 0x70,
+    0x0b, 0x05, 0xa3, 0xc4, 0xf4, 0x04, 0xb6, 0x3f, 0xe4, 0x61, 0x91, 0xb9, 0xd6, 0x80, 0xde, 0xb6,
+    0x36, 0xaa, 0x72, 0x7c, 0x2b, 0xf8, 0xd4, 0xc1, 0x4f, 0xdf, 0xaf, 0x31, 0x95, 0xd7, 0x56, 0x79,
+    0x2c, 0xe5, 0x21, 0xd4, 0x98, 0x45, 0x73, 0x8c, 0xcd, 0xc1, 0x4c, 0xce, 0x4c, 0x9c, 0x68, 0xc4,
+    0x61, 0x0d, 0xf7, 0x56, 0x7e, 0x5d, 0xce, 0x0e, 0x95, 0x80, 0x20, 0x53, 0xa6, 0x3d, 0x5d, 0x99,
+    0x45, 0xa5, 0x9f, 0xe5, 0x5b, 0x2f, 0xcc, 0x23, 0x41, 0xb4, 0xf7, 0x56, 0xf1, 0x5d, 0x6a, 0xa7,
+    0x2c, 0x38, 0x19, 0xfd, 0xd7, 0x2c, 0x22, 0x4b, 0x7c, 0xbe, 0xff, 0x38, 0x35, 0xee, 0xb7, 0xce,
+    0x3b, 0x83, 0xa3, 0x1e, 0x6b, 0xfe, 0xc0, 0x3e, 0xce, 0x92, 0x2f, 0xb3, 0x38, 0x48, 0x39, 0xfb,
+    0xa1, 0xf9, 0x38, 0x56, 0x49, 0x1c, 0x6b, 0xe9, 0xb2, 0x68, 0x45, 0xab, 0xa8, 0xa0, 0xb6, 0x66,
+    0xab, 0xbd, 0x21, 0x9d, 0xae, 0xd6, 0x6b, 0x64, 0x38, 0x5e, 0x1c, 0xbd, 0x7a, 0xf5, 0x02, 0xab,
+    0x96, 0x26, 0x2d, 0x09, 0xc4, 0x5b, 0x20, 0x66, 0xa3, 0x04, 0x86, 0x4e, 0x28, 0x34, 0x93, 0xfd,
+    0x4a, 0x26, 0xfe, 0xc1, 0xc1, 0x3e, 0x32, 0x5f, 0x05, 0x93, 0x0f, 0xb0, 0xcd, 0xd5, 0xec, 0x83,
+    0xca, 0xd9, 0x17, 0x87, 0x17, 0x87, 0xaf, 0xce, 0x7a, 0x4c, 0x7f, 0x1f, 0x86, 0x20, 0x59, 0xf1,
+    0xda, 0xcb, 0x79, 0xbd, 0x71, 0xee, 0xe0, 0xd1, 0x3c, 0x29, 0x30, 0xec, 0x54, 0x32, 0xec, 0xc8,
+    0xff, 0xaa, 0xe0, 0xbc, 0x24, 0xde, 0x85, 0xf9, 0x87, 0xec, 0xe1, 0x2e, 0x48, 0x83, 0x61, 0x10,
+    0x4a, 0xb7, 0x1b, 0x07, 0x9e, 0x07, 0xbf, 0xae, 0x98, 0xf8, 0x8b, 0xbc, 0x23, 0xd5, 0x21, 0x27,
+    0x76, 0xc7, 0xf1, 0x1d, 0x90, 0x3c, 0x94, 0x55, 0x98, 0x09, 0x73, 0x4d, 0x7a, 0x99, 0x7d, 0x75,
+    0x1d, 0x44, 0xa1, 0x3b, 0xfe, 0x78, 0xde, 0x26, 0xd5, 0x67, 0xd3, 0x6c, 0x18, 0xa5, 0x33, 0x0c,
+    0x21, 0xcb, 0x55, 0x8c, 0xf1, 0xb8, 0xef, 0xcc, 0x42, 0xf1, 0xc8, 0x88, 0x9c, 0x16, 0xfd, 0x48,
+    0x4e, 0x3f, 0x27, 0xce, 0x42, 0x31, 0x91, 0x2e, 0xf4, 0x89, 0x8a, 0xca, 0x7e, 0x4d, 0x3a, 0x47,
+    0xed, 0x33, 0x18, 0x65, 0x21, 0xd4, 0x99, 0x4e, 0xb9, 0x83, 0x61, 0x97, 0x67, 0xa5, 0x4f, 0x9e,
+    0xe9, 0x0a, 0x79, 0x53, 0xc5, 0x81, 0xca, 0x7a, 0x67, 0xcd, 0xc6, 0x0b, 0x79, 0xa3, 0x72, 0xf1,
+    0xae, 0x1f, 0xbb, 0xb3, 0xf4, 0x51, 0xec, 0xab, 0xa6, 0xec, 0x66, 0x28, 0xd3, 0x30, 0x90, 0x5e,
+    0x30, 0x8b, 0x22, 0x92, 0x44, 0x43, 0x24, 0xa4, 0xc9, 0x87, 0x6a, 0xac, 0x95, 0x9e, 0x57, 0xc2,
+    0x9e, 0xd5, 0x9d, 0x8f, 0x9c, 0xab, 0x55, 0xf0, 0x67, 0x96, 0xc6, 0x58, 0x73, 0x45, 0xfa, 0x34,
+    0x80, 0x62, 0x3c, 0x9b, 0x50, 0x58, 0xcf, 0xd8, 0xa0, 0xbc, 0xd3, 0x8c, 0x92, 0xd1, 0xd0, 0x31,
+    0x5a, 0x16, 0xc3, 0xff, 0xfb, 0xf4, 0x61, 0x3e, 0x16, 0xae, 0xde, 0xca, 0xde, 0x5e, 0x45, 0xd9,
+    0xd8, 0x59, 0x2f, 0x37, 0x7d, 0x7f, 0xbf, 0xb5, 0x7f, 0x50, 0xb1, 0xd1, 0xcd, 0x8a, 0x2d, 0x96,
+    0x38, 0x8d, 0x76, 0xdb, 0xd6, 0xb1, 0x6f, 0xa3, 0x8a, 0xbe, 0x2d, 0xfe, 0x4a, 0xa1, 0x6e, 0x92,
+    0xd4, 0x24, 0xfe, 0xda, 0x50, 0xc1, 0xf9, 0x3f, 0x47, 0x7b, 0x05, 0x4c, 0xff, 0x7e, 0xcd, 0x6d,
+    0x04, 0x99, 0xfe, 0x93, 0x12, 0x6b, 0xad, 0x64, 0x93, 0x45, 0x49, 0x30, 0x8c, 0x50, 0xce, 0x24,
+    0xa8, 0x6b, 0xf2, 0xac, 0x54, 0x1a, 0xdb, 0x02, 0xc6, 0x0f, 0xc2, 0xb0, 0x11, 0xc6, 0xf3, 0xf5,
+    0x08, 0x58, 0xd6, 0x4c, 0x85, 0x1e, 0xd6, 0x55, 0xf6, 0xad, 0x75, 0x66, 0x30, 0xe3, 0x7f, 0xf1,
+    0x3a, 0xff, 0x01, 0xaa, 0x2f, 0xe9, 0x72, 0xbb, 0x4b, 0x3e, 0x49, 0x01, 0x4f, 0x63, 0x51, 0x29,
+    0xdb, 0x2c, 0xae, 0xa3, 0x72, 0x48, 0xe7, 0x01, 0x7a, 0x91, 0x8a, 0xaa, 0x68, 0x1a, 0xa7, 0x81,
+    0x6a, 0x7b, 0x12, 0x1e, 0x3a, 0x94, 0xd3, 0x2a, 0xeb, 0xc6, 0xb5, 0x3a, 0xa5, 0x7c, 0x7b, 0xb5,
+    0x82, 0x04, 0xfb, 0x8f, 0x57, 0xc3, 0xb6, 0x8a, 0x4b, 0x2b, 0xbf, 0x50, 0x22, 0x7f, 0x94, 0xb4,
+    0xca, 0x5a, 0xd9, 0xfb, 0x96, 0xbb, 0x64, 0x1e, 0x82, 0xec, 0xbd, 0x28, 0x2c, 0x62, 0x65, 0x17,
+    0x5d, 0xd5, 0xfd, 0x6c, 0xae, 0x2e, 0xa5, 0x1b, 0x69, 0xf1, 0xb4, 0xec, 0x83, 0xb4, 0xc0, 0x64,
+    0x35, 0xb7, 0x4a, 0x82, 0x79, 0x9f, 0x51, 0xab, 0x55, 0x18, 0x53, 0xc1, 0xe3, 0x95, 0x30, 0xb3,
+    0x32, 0x45, 0x7e, 0x09, 0xb9, 0x2f, 0x74, 0x27, 0x2b, 0xe3, 0xfb, 0x7e, 0xd9, 0xf6, 0x1a, 0xa5,
+    0xc2, 0x53, 0x5b, 0x47, 0xa1, 0x7d, 0x58, 0x49, 0xb2, 0x72, 0x8e, 0xb2, 0xda, 0x8d, 0xd3, 0x56,
+    0xdb, 0xca, 0x12, 0x86, 0x94, 0x01, 0xc6, 0x26, 0x3a, 0xaa, 0x60, 0x8b, 0xfc, 0x7f, 0x8c, 0xbd,
+    0x43, 0xd9, 0x8a, 0x6e, 0xbd, 0x49, 0xbd, 0x9a, 0x2e, 0xf3, 0xd7, 0xfd, 0x31, 0x37, 0xce, 0xa2,
+    0x65, 0x1d, 0xac, 0xeb, 0xbc, 0x68, 0x47, 0x55, 0x05, 0x34, 0x35, 0x1b, 0x13, 0x07, 0x51, 0x9f,
+    0x44, 0xee, 0x80, 0x32, 0x29, 0xa9, 0xc4, 0x19, 0x62, 0xb9, 0x99, 0xe0, 0x5a, 0x96, 0x6d, 0x65,
+    0x56, 0x4a, 0xc4, 0x1d, 0xd5, 0x6c, 0x17, 0x0f, 0x6c, 0x1a, 0x72, 0xac, 0x6a, 0x57, 0x06, 0xdd,
+    0xb2, 0x24, 0x81, 0x59, 0x6a, 0x79, 0xda, 0x87, 0x59, 0x75, 0x4e, 0x08, 0x92, 0x38, 0xdc, 0x80,
+    0x64, 0x65, 0x1c, 0x12, 0xc9, 0xc1, 0x9f, 0x84, 0x24, 0x37, 0xc8, 0xa7, 0x2d, 0xdb, 0x29, 0x2e,
+    0xab, 0xce, 0x0c, 0xca, 0xeb, 0x66, 0xe7, 0x08, 0xb6, 0x1b, 0xc6, 0x29, 0xdf, 0x20, 0x4b, 0x4d,
+    0xdb, 0xc9, 0x6d, 0xb4, 0xb3, 0x31, 0x3e, 0x96, 0x4c, 0xbb, 0x6c, 0xf5, 0x8f, 0xd4, 0xa9, 0xdb,
+    0x9c, 0x92, 0x79, 0x0b, 0x7e, 0x8f, 0xf2, 0x87, 0x4e, 0x55, 0xba, 0xcc, 0xe5, 0xca, 0xbf, 0x4b,
+    0xd1, 0xa9, 0x5d, 0xdd, 0x9c, 0x01, 0xbf, 0x6a, 0x01, 0xd6, 0x8f, 0x03, 0xa9, 0xc7, 0x8c, 0x05,
+    0xe4, 0xf8, 0xa2, 0x55, 0x6d, 0xe5, 0xea, 0xae, 0xd1, 0xf2, 0xf8, 0x08, 0xf2, 0x95, 0x75, 0xc5,
+    0xe6, 0xbb, 0xf1, 0xb6, 0x99, 0xe9, 0xe6, 0x9b, 0x1b, 0x6f, 0x2c, 0x77, 0x8e, 0x9b, 0xfa, 0x84,
+    0xf6, 0xb8, 0xa9, 0xcf, 0x8a, 0xe9, 0xa8, 0x96, 0x3e, 0x92, 0x26, 0x1d, 0xdf, 0xea, 0xf3, 0x0f,
+    0x37, 0x74, 0xd2, 0xb4, 0x5f, 0xa3, 0x53, 0x51, 0x3a, 0xf4, 0x55, 0xe7, 0x3e, 0xb8, 0xf0, 0x82,
+    0x3b, 0x16, 0x78, 0xfd, 0x1a, 0x1d, 0x3f, 0x39, 0x93, 0x95, 0x55, 0xd4, 0xb2, 0x19, 0x8f, 0xdc,
+    0xa5, 0xa6, 0xe7, 0xe8, 0xbb, 0x52, 0xed, 0x35, 0xc9, 0x41, 0x5e, 0x36, 0x14, 0x9f, 0xda, 0xc9,
+    0xff, 0xfd, 0xef, 0x71, 0x13, 0x74, 0xa0, 0xa6, 0x63, 0xac, 0xd5, 0x0a, 0x35, 0x96, 0x26, 0x6e,
+    0xbf, 0x96, 0xb3, 0xcf, 0x84, 0x4b, 0x7c, 0xf5, 0x84, 0x66, 0x0e, 0xae, 0xbc, 0x05, 0x62, 0xa2,
+    0x4f, 0x71, 0x6a, 0x05, 0xe4, 0xda, 0x8f, 0xd2, 0x9c, 0xe5, 0x9a, 0x63, 0xc9, 0x53, 0x6e, 0x2a,
+    0x5f, 0xe9, 0x33, 0x39, 0x39, 0x16, 0x1e, 0x93, 0x46, 0x02, 0x52, 0x69, 0x24, 0xb5, 0x93, 0x63,
+    0x7d, 0x0c, 0xa0, 0x39, 0xe8, 0x6f, 0xba, 0x57, 0x54, 0xdb, 0x1b, 0x71, 0xc4, 0x1d, 0x81, 0xe4,
+    0x59, 0x3b, 0x79, 0x4d, 0x22, 0x39, 0x6e, 0xaa, 0xdb, 0x27, 0xc7, 0x4d, 0xe1, 0x6d, 0xe3, 0x49,
+    0x93, 0xf5, 0xc1, 0x4d, 0x26, 0x9c, 0x4b, 0x3a, 0xcf, 0x5a, 0x63, 0xa0, 0x2f, 0x9a, 0x80, 0x98,
+    0xe1, 0xfc, 0x26, 0xf3, 0x2a, 0xc0, 0x7b, 0x0a, 0x30, 0xcc, 0x65, 0xee, 0x24, 0x5e, 0x8d, 0xc5,
+    0x91, 0x1b, 0x06, 0xee, 0x2d, 0x34, 0x80, 0x36, 0x7a, 0x30, 0xf1, 0x8c, 0xba, 0xeb, 0x24, 0x75,
+    0xab, 0x6d, 0xf6, 0x6a, 0x27, 0xaf, 0xde, 0x7d, 0xf8, 0xed, 0xec, 0xc3, 0xf9, 0x53, 0xb0, 0xfc,
+    0x01, 0x08, 0x62, 0x96, 0x44, 0x14, 0x3b, 0x36, 0x62, 0xd8, 0x23, 0x0c, 0x6f, 0x2e, 0x5e, 0x7d,
+    0xfc, 0xb6, 0x34, 0xff, 0xb8, 0x20, 0x08, 0x85, 0x0c, 0x41, 0x1b, 0x61, 0x1c, 0x10, 0x8c, 0x0f,
+    0xaf, 0x7f, 0xfe, 0xe5, 0x31, 0x8e, 0x3f, 0x4b, 0x17, 0x14, 0xeb, 0xb6, 0x2a, 0xa3, 0x23, 0x11,
+    0x5c, 0xfc, 0xf7, 0xc5, 0x87, 0xcb, 0x8b, 0x3f, 0x5b, 0x19, 0x07, 0xda, 0x1e, 0x70, 0x6b, 0x5c,
+    0x05, 0x40, 0xde, 0x80, 0x2e, 0x3a, 0x87, 0x52, 0x1b, 0x24, 0x06, 0xf6, 0xee, 0xd7, 0x7f, 0x89,
+    0x46, 0x8a, 0x50, 0x62, 0xdf, 0xdf, 0x82, 0xa6, 0x55, 0xc0, 0xf2, 0xea, 0xd5, 0x16, 0xb5, 0x64,
+    0xcb, 0x2b, 0x0d, 0x9f, 0x5c, 0x4e, 0x39, 0xf7, 0xba, 0x1b, 0xb0, 0xd1, 0x51, 0x13, 0xfa, 0x1c,
+    0x0c, 0xec, 0x01, 0xa7, 0xaa, 0x3d, 0x8b, 0x85, 0xb2, 0x8a, 0x53, 0xc4, 0xa1, 0xc6, 0x90, 0xb3,
+    0xfb, 0xb5, 0x16, 0x3e, 0x9d, 0x7b, 0x90, 0x77, 0x3a, 0x35, 0x76, 0xe7, 0x84, 0x33, 0x90, 0xee,
+    0xb5, 0x5a, 0x12, 0xf7, 0x98, 0xa6, 0x14, 0x80, 0xcb, 0x79, 0x75, 0x4b, 0x8c, 0x83, 0xd4, 0x96,
+    0xa4, 0xb4, 0x83, 0x5c, 0x85, 0x8c, 0x55, 0x40, 0xcf, 0xe1, 0xec, 0xd7, 0xd6, 0xa4, 0x48, 0x37,
+    0x94, 0xf9, 0xa2, 0x2a, 0x9a, 0x70, 0x91, 0x2c, 0x88, 0x1b, 0x8d, 0x3e, 0x41, 0x08, 0xb7, 0xc1,
+    0x94, 0xc9, 0x60, 0xb5, 0x26, 0x09, 0xe5, 0x8e, 0x1b, 0xe5, 0x20, 0x2b, 0xbc, 0x61, 0x7c, 0xaf,
+    0x43, 0xba, 0xdc, 0xe3, 0x55, 0x0a, 0x76, 0x95, 0x5b, 0x2e, 0xdc, 0xaf, 0x5b, 0x4c, 0xee, 0x3c,
+    0x2b, 0x11, 0x4f, 0x91, 0xa0, 0x59, 0x97, 0xb5, 0x56, 0x42, 0xd8, 0x82, 0xf7, 0x23, 0x9a, 0x5c,
+    0xfe, 0xcf, 0x41, 0xa5, 0x52, 0x27, 0x72, 0x17, 0x57, 0xd4, 0x2f, 0xf3, 0x32, 0x58, 0x21, 0xd9,
+    0x1b, 0x45, 0x78, 0x84, 0x8a, 0xad, 0x44, 0xac, 0x27, 0x57, 0x0a, 0xb8, 0x99, 0x65, 0x0e, 0x9d,
+    0x9d, 0x54, 0x4e, 0x6a, 0xea, 0xa4, 0x54, 0xbe, 0x4c, 0xdd, 0x24, 0x98, 0x8a, 0x93, 0x9d, 0x66,
+    0x93, 0x9d, 0x27, 0x74, 0xde, 0xe7, 0xc6, 0x93, 0x09, 0x3d, 0x1e, 0x62, 0xa3, 0x98, 0xc9, 0x83,
+    0x43, 0x87, 0xa1, 0xf1, 0x4a, 0x83, 0x54, 0x3e, 0x23, 0xfa, 0x8d, 0x0f, 0x2f, 0xd1, 0x38, 0x70,
+    0xc1, 0x9c, 0x94, 0x7d, 0x8a, 0xa7, 0x6e, 0xec, 0x71, 0x4b, 0x99, 0x19, 0x0b, 0xe3, 0xec, 0x6a,
+    0x1c, 0x7c, 0xb6, 0x89, 0xe3, 0x6f, 0xe3, 0x20, 0xe4, 0x10, 0x32, 0x47, 0x49, 0x2c, 0x27, 0x05,
+    0x29, 0xf3, 0xe2, 0x79, 0x44, 0x43, 0x0b, 0xe6, 0x3b, 0x61, 0xc8, 0x28, 0xcc, 0x30, 0x11, 0x4b,
+    0xa2, 0xa6, 0x4e, 0x83, 0xec, 0xe7, 0x8b, 0x8f, 0x0c, 0x0a, 0x93, 0xc5, 0x8e, 0x4d, 0xad, 0x46,
+    0x8a, 0x95, 0x2f, 0xaf, 0xde, 0xbd, 0xbf, 0x64, 0x7d, 0xf6, 0x80, 0xe8, 0x83, 0xb2, 0xc8, 0x62,
+    0xd2, 0x7a, 0x51, 0x45, 0x5b, 0x4c, 0x3a, 0x20, 0xfa, 0x08, 0x5c, 0x25, 0xce, 0x84, 0xab, 0x5a,
+    0xfb, 0xc0, 0x62, 0x5f, 0x66, 0x8e, 0x3a, 0x2d, 0xed, 0x58, 0xa8, 0x8d, 0x52, 0x59, 0xc8, 0x1d,
+    0x6a, 0x72, 0xf8, 0x72, 0x97, 0xfd, 0x64, 0x01, 0x35, 0xd2, 0xdc, 0x1d, 0x0f, 0xbb, 0xec, 0xc8,
+    0x62, 0x8e, 0xe7, 0x4c, 0xa9, 0x96, 0xec, 0xb2, 0x17, 0x30, 0x0e, 0x94, 0x8d, 0x5c, 0x5c, 0xf9,
+    0x53, 0x59, 0xba, 0x59, 0xcc, 0xc5, 0x3d, 0x24, 0xf9, 0x2b, 0x64, 0x52, 0x0c, 0x00, 0x80, 0x97,
+    0x48, 0xd2, 0x36, 0x10, 0x60, 0xd9, 0xe9, 0x55, 0x02, 0x9d, 0xe0, 0x2b, 0x60, 0x94, 0x54, 0x4b,
+    0x65, 0xbf, 0xc5, 0xb0, 0x46, 0x24, 0xae, 0xe8, 0xb1, 0x59, 0x1b, 0x10, 0x0a, 0x66, 0x88, 0x81,
+    0x9f, 0xf2, 0x81, 0x5b, 0xce, 0xa7, 0xc0, 0x2c, 0xd9, 0x1e, 0x2d, 0x7b, 0x24, 0xc4, 0x4b, 0x2e,
+    0x52, 0x29, 0x1e, 0x84, 0x1d, 0x52, 0x41, 0xca, 0xbf, 0xcc, 0xc0, 0x9c, 0xb3, 0x68, 0x36, 0x19,
+    0x42, 0x3f, 0x48, 0x9a, 0xf2, 0x76, 0xc2, 0x5d, 0x94, 0x9b, 0xb8, 0x74, 0x04, 0xc6, 0x42, 0xb4,
+    0xdc, 0x29, 0x0b, 0xc4, 0x4a, 0x7a, 0x1f, 0x3f, 0x9c, 0x0d, 0x2e, 0xae, 0x2e, 0x2f, 0xfe, 0x06,
+    0x19, 0xb6, 0x3b, 0x54, 0x21, 0x0b, 0x06, 0x92, 0x3e, 0xf8, 0x84, 0xa1, 0x5c, 0xe9, 0x8d, 0x42,
+    0x4d, 0x85, 0xb8, 0x2b, 0x1f, 0x1d, 0x00, 0x73, 0xb2, 0xc8, 0x2c, 0x02, 0xfb, 0x4f, 0x92, 0x80,
+    0xa7, 0x30, 0x88, 0xc7, 0x10, 0xe8, 0xae, 0xd4, 0x32, 0x94, 0x46, 0x8c, 0x44, 0x00, 0x25, 0xb0,
+    0xd8, 0x67, 0xb3, 0x08, 0x45, 0x20, 0x5a, 0x7f, 0xee, 0xad, 0xec, 0xca, 0x41, 0xf3, 0x75, 0xcb,
+    0xa7, 0x82, 0xb4, 0x3e, 0xe1, 0x4e, 0x4a, 0x0f, 0xf3, 0x64, 0x4d, 0x8d, 0x75, 0x83, 0x69, 0x6a,
+    0x4b, 0x60, 0x1a, 0x02, 0xd0, 0xc1, 0x4a, 0x52, 0x98, 0x98, 0x94, 0xe4, 0x25, 0xff, 0x82, 0x91,
+    0x96, 0xfe, 0xf6, 0x1e, 0x9b, 0xcc, 0xe1, 0xd3, 0xa4, 0x29, 0x96, 0x57, 0x93, 0x3e, 0x7d, 0x86,
+    0x4a, 0x84, 0x48, 0xe5, 0x25, 0x3a, 0xb0, 0x59, 0xa4, 0x4b, 0xca, 0x38, 0x8a, 0x60, 0xfa, 0xbf,
+    0xa5, 0x06, 0x3d, 0xf9, 0x54, 0xbb, 0xe7, 0xf3, 0x95, 0x55, 0x1b, 0xd7, 0xf3, 0xb4, 0xdb, 0x6c,
+    0x3e, 0x7b, 0xf0, 0x62, 0x77, 0x36, 0x81, 0xb4, 0x6d, 0xb4, 0xc9, 0xf2, 0xa1, 0xa9, 0x3d, 0x86,
+    0xfd, 0x2c, 0x9b, 0xf3, 0xf4, 0x9a, 0x9e, 0x4f, 0xa6, 0xf6, 0x30, 0x88, 0x9c, 0x64, 0xf1, 0x91,
+    0xde, 0x7e, 0xe8, 0xb3, 0x3a, 0x24, 0xe3, 0x2c, 0x86, 0x33, 0xdf, 0xe7, 0x49, 0x5d, 0xde, 0x8e,
+    0x23, 0x48, 0x20, 0x85, 0xa5, 0xe0, 0x2e, 0x7e, 0x4f, 0xb0, 0x1a, 0xe4, 0x72, 0xe6, 0xde, 0xaa,
+    0xfd, 0xe7, 0x9e, 0x93, 0xa2, 0x94, 0x9c, 0xa5, 0x9f, 0xd9, 0xd4, 0x09, 0x12, 0xa8, 0x2b, 0x92,
+    0x22, 0x64, 0xb2, 0x6d, 0xd8, 0x21, 0xc5, 0x1a, 0xb4, 0xaf, 0x80, 0x36, 0xdd, 0xc3, 0xc7, 0x31,
+    0xe3, 0xb6, 0xe7, 0x08, 0xc7, 0x1e, 0x2e, 0x04, 0x7f, 0xc3, 0xa3, 0x91, 0x18, 0xd3, 0xf0, 0x8f,
+    0x7d, 0xb6, 0x47, 0xfb, 0x51, 0xaa, 0x4e, 0xc9, 0x48, 0xfa, 0x99, 0x30, 0xec, 0x74, 0x1c, 0xf8,
+    0xc2, 0x00, 0xe8, 0xc0, 0x67, 0x46, 0x26, 0xd6, 0xe7, 0xcf, 0x15, 0xd9, 0x6e, 0xbf, 0x0f, 0x1d,
+    0x79, 0xdc, 0x47, 0xcd, 0xe9, 0x99, 0x30, 0x7f, 0xef, 0x83, 0x10, 0x06, 0xfc, 0x9d, 0x0a, 0x77,
+    0x3a, 0x8e, 0xb5, 0xa3, 0x78, 0x0e, 0x59, 0x35, 0x24, 0xb9, 0x2c, 0xde, 0x97, 0x7a, 0x7f, 0xaa,
+    0x7b, 0xea, 0x33, 0xdc, 0xa5, 0xed, 0x15, 0x4c, 0xa9, 0xa4, 0x87, 0x1e, 0xa3, 0x68, 0x06, 0x7b,
+    0x40, 0x9b, 0x6b, 0xe4, 0xe2, 0xb7, 0xa8, 0x17, 0x42, 0xa0, 0x65, 0x4b, 0xf9, 0x44, 0x37, 0x53,
+    0x4f, 0x16, 0xa5, 0xe9, 0xf5, 0x10, 0x19, 0x4b, 0x68, 0x57, 0xf8, 0xa0, 0xed, 0xd0, 0x7b, 0x24,
+    0xaf, 0x23, 0x61, 0xd0, 0x68, 0x2f, 0xdf, 0x2a, 0xd9, 0x43, 0xb6, 0xa9, 0x53, 0xb5, 0x3f, 0x6d,
+    0x25, 0xab, 0xeb, 0xef, 0xd9, 0x61, 0xa7, 0xb3, 0xdf, 0x31, 0xd9, 0x8f, 0xac, 0x6d, 0x32, 0xd9,
+    0x67, 0x3f, 0x92, 0xd4, 0xa3, 0xed, 0x2a, 0x59, 0x61, 0x43, 0x10, 0x13, 0xf6, 0x8a, 0x02, 0xd8,
+    0x5b, 0x5c, 0x52, 0xcd, 0xcf, 0xfa, 0x90, 0x57, 0x6e, 0x2c, 0xf6, 0xbb, 0xf7, 0x17, 0xbf, 0xae,
+    0xe4, 0x0e, 0xff, 0xa3, 0x1d, 0xab, 0x38, 0xf5, 0x89, 0xb6, 0xf0, 0x59, 0xee, 0x81, 0x3d, 0x67,
+    0xad, 0x7b, 0xdf, 0xb7, 0x18, 0x41, 0x67, 0x27, 0x27, 0xec, 0xc8, 0xd4, 0x43, 0x9f, 0xa5, 0x28,
+    0x69, 0xd3, 0x06, 0x59, 0xe1, 0x7f, 0x21, 0xda, 0x1d, 0x9d, 0x91, 0x25, 0x19, 0xb4, 0xb1, 0x53,
+    0xc9, 0x2b, 0xf7, 0x5a, 0x4b, 0xee, 0x36, 0xe3, 0x45, 0xd7, 0xc4, 0xea, 0x33, 0xf5, 0xe4, 0xb0,
+    0x50, 0x03, 0xab, 0xd3, 0xde, 0xe8, 0x03, 0xf8, 0x33, 0xe5, 0x4f, 0x67, 0xe9, 0xd8, 0xc8, 0x54,
+    0xc7, 0x78, 0x28, 0xfb, 0x5d, 0x05, 0x57, 0x8a, 0x07, 0x80, 0xd5, 0x52, 0xd7, 0xcf, 0xf1, 0xd9,
+    0x7f, 0xf6, 0x80, 0xbf, 0xcb, 0xe7, 0x02, 0x17, 0x6f, 0x1d, 0x31, 0xb6, 0xa5, 0x5b, 0xaa, 0xf9,
+    0xcb, 0x6b, 0x70, 0xaf, 0xc3, 0xb8, 0x7d, 0x7a, 0xe4, 0x6f, 0x5c, 0x57, 0xb9, 0x48, 0x8c, 0xdc,
+    0x18, 0x44, 0xcb, 0x2c, 0x8c, 0x9f, 0xde, 0x39, 0x09, 0x38, 0x91, 0x24, 0x96, 0xcf, 0xb1, 0x77,
+    0x5c, 0xe3, 0xef, 0xf2, 0xd9, 0x83, 0x5c, 0x7a, 0x79, 0x6d, 0xee, 0xd8, 0x08, 0x1a, 0x91, 0x91,
+    0x59, 0x50, 0xc1, 0x40, 0x9f, 0x60, 0x8a, 0x6c, 0x89, 0xf9, 0x58, 0x18, 0x60, 0xa4, 0x83, 0xd1,
+    0xae, 0xe2, 0x90, 0xdb, 0x3c, 0x49, 0xe2, 0xc4, 0xe0, 0xa6, 0x32, 0xd6, 0x95, 0x6d, 0x69, 0x86,
+    0x93, 0x94, 0x34, 0x46, 0xb1, 0x41, 0x09, 0x67, 0x92, 0xb2, 0x1f, 0xb4, 0x31, 0x4a, 0xad, 0xcb,
+    0x3b, 0xa1, 0x74, 0x2d, 0x76, 0xc2, 0x0e, 0x0f, 0x4c, 0x19, 0x47, 0x56, 0x5e, 0x54, 0xe0, 0x08,
+    0x6c, 0x54, 0xfa, 0x20, 0xc5, 0x19, 0x32, 0xed, 0xc1, 0xaa, 0xa7, 0xc4, 0x9c, 0xd8, 0xec, 0xaa,
+    0x11, 0xcd, 0x09, 0x4c, 0x38, 0x95, 0xf4, 0x05, 0xd3, 0x8b, 0x13, 0x81, 0xa0, 0xd8, 0x67, 0x9a,
+    0x2e, 0x45, 0x49, 0xc9, 0x0d, 0xd3, 0xa6, 0x71, 0xc3, 0x70, 0x2c, 0x36, 0x94, 0x42, 0x71, 0xb0,
+    0xdd, 0x21, 0x56, 0xd5, 0xd3, 0xd5, 0xac, 0x4f, 0x52, 0x37, 0x28, 0xf6, 0x0c, 0xf5, 0x3d, 0x83,
+    0xdb, 0xa0, 0xa4, 0x28, 0xef, 0xf9, 0x61, 0x0c, 0x19, 0x94, 0xef, 0xfe, 0xc0, 0xa6, 0xac, 0x49,
+    0x3b, 0x35, 0xcd, 0xcf, 0xa5, 0x6d, 0xf8, 0x13, 0xa1, 0x03, 0xbf, 0x21, 0x9f, 0x8d, 0xeb, 0x24,
+    0xae, 0xe4, 0xa4, 0xd6, 0x85, 0xb6, 0xe5, 0xad, 0x25, 0x7b, 0xf6, 0xf0, 0xa9, 0x83, 0xf8, 0xfb,
+    0x82, 0x7e, 0x5f, 0x7c, 0xb6, 0x27, 0xce, 0xd4, 0x98, 0x12, 0x50, 0xa3, 0x5a, 0x18, 0x4d, 0x25,
+    0x5a, 0x5b, 0xc4, 0xaf, 0x82, 0x7b, 0xee, 0x19, 0x6d, 0xd3, 0xb4, 0x6f, 0x90, 0xd5, 0x8d, 0x7a,
+    0xb3, 0x0e, 0x93, 0x2a, 0x3b, 0xff, 0x38, 0x9e, 0xab, 0xb2, 0x87, 0x56, 0x7e, 0x82, 0x99, 0x49,
+    0x33, 0xba, 0x36, 0x95, 0x11, 0x25, 0x84, 0x22, 0xb1, 0x6f, 0xd2, 0x38, 0x32, 0x4c, 0x3d, 0x76,
+    0xa3, 0x02, 0xaf, 0x92, 0xb8, 0x17, 0x47, 0x64, 0xee, 0x37, 0xb6, 0x9c, 0x96, 0xda, 0x7e, 0x10,
+    0xa2, 0x6a, 0x35, 0x04, 0xd1, 0x08, 0xdb, 0x71, 0xc5, 0x0c, 0x42, 0xb8, 0x9a, 0xa5, 0x90, 0x76,
+    0xbe, 0x24, 0xd2, 0xff, 0x05, 0x55, 0xb2, 0x91, 0x78, 0xb9, 0x78, 0x8d, 0xe2, 0x51, 0xa7, 0xf5,
+    0x3a, 0xf8, 0xf3, 0x7b, 0x31, 0xd0, 0xef, 0xcd, 0xf4, 0x77, 0xae, 0xa7, 0x9d, 0x56, 0x73, 0xfa,
+    0x82, 0x7e, 0x5f, 0x30, 0x4a, 0xf1, 0xcf, 0x1e, 0x0a, 0x52, 0xad, 0xd3, 0xf9, 0x0c, 0x19, 0x2a,
+    0x0a, 0x4e, 0x42, 0x21, 0xa5, 0xa6, 0xd7, 0xcd, 0x6e, 0xd1, 0xc2, 0xe6, 0xd2, 0x62, 0xd7, 0xec,
+    0xc7, 0x9d, 0xeb, 0xf2, 0x6c, 0x0d, 0xad, 0x62, 0x72, 0x01, 0x34, 0xcd, 0x2d, 0x4f, 0x83, 0xd9,
+    0xd6, 0x55, 0x12, 0x54, 0x82, 0x36, 0xbf, 0xe9, 0x2c, 0x85, 0x30, 0xac, 0xeb, 0xcf, 0x38, 0x22,
+    0x55, 0xe4, 0xb5, 0x73, 0xa9, 0xaa, 0x01, 0x73, 0x90, 0xa2, 0x66, 0x56, 0x25, 0xf3, 0xce, 0x2a,
+    0x63, 0xc7, 0x51, 0x6f, 0xa7, 0x90, 0x7c, 0xdd, 0x90, 0x3b, 0xc9, 0x6b, 0x6a, 0x11, 0x60, 0x18,
+    0x46, 0x9e, 0xb9, 0xf5, 0x94, 0x2c, 0x8b, 0x4b, 0x5e, 0x58, 0x38, 0x27, 0xcc, 0xcd, 0xc1, 0x62,
+    0x7b, 0x64, 0x43, 0x58, 0x46, 0x65, 0x7a, 0xe9, 0x5e, 0x84, 0xec, 0x1f, 0x55, 0x93, 0x0c, 0x5f,
+    0x4b, 0xca, 0xc3, 0x1f, 0xb3, 0xfe, 0x84, 0x51, 0x0c, 0x80, 0x1f, 0xca, 0x42, 0xb7, 0x29, 0x4b,
+    0xb4, 0xd4, 0x66, 0x17, 0x8e, 0x3b, 0x56, 0xf5, 0x1a, 0x60, 0x85, 0x8b, 0xbc, 0xf0, 0xa1, 0x12,
+    0xc7, 0x0f, 0x78, 0xe8, 0xa5, 0xb2, 0xca, 0x22, 0x4e, 0xaa, 0x6c, 0xf3, 0x10, 0x90, 0xa9, 0x98,
+    0x41, 0xbd, 0x88, 0x92, 0x0b, 0x69, 0x1c, 0xa5, 0xcd, 0x9c, 0xea, 0xb0, 0x39, 0x47, 0x67, 0x20,
+    0xf3, 0x07, 0x1b, 0x3b, 0x77, 0x3c, 0xab, 0x65, 0xf3, 0xfe, 0x88, 0xca, 0xd9, 0xe5, 0x7a, 0x7d,
+    0x72, 0x21, 0x81, 0x18, 0xab, 0xdc, 0xa2, 0x90, 0xe9, 0x6a, 0x45, 0xde, 0xbd, 0x8c, 0x67, 0x70,
+    0xb8, 0xed, 0x0e, 0xa2, 0x66, 0x51, 0xc1, 0xa2, 0x77, 0x86, 0x18, 0x28, 0x27, 0xbf, 0x91, 0xd5,
+    0x3c, 0xac, 0xbf, 0x9e, 0x23, 0x81, 0x3a, 0x75, 0x9d, 0xf2, 0x6e, 0x78, 0x03, 0x08, 0x36, 0x3a,
+    0x61, 0xb4, 0x34, 0x46, 0x4e, 0x60, 0xb1, 0xbf, 0x5e, 0xbe, 0xfb, 0xd5, 0x96, 0x79, 0xd8, 0x50,
+    0x65, 0x88, 0x99, 0x27, 0x62, 0x92, 0x6e, 0x4e, 0xb9, 0xc5, 0x81, 0x56, 0xcb, 0xad, 0xb9, 0x10,
+    0xd2, 0x82, 0x3d, 0x89, 0x09, 0xff, 0x92, 0xbd, 0x61, 0xf4, 0xcd, 0x9b, 0x89, 0xc5, 0x15, 0x75,
+    0x54, 0x4b, 0xf6, 0x61, 0x35, 0x20, 0xfb, 0xaf, 0x25, 0xfb, 0x5d, 0x8e, 0xa0, 0x36, 0x5f, 0x32,
+    0xfc, 0xc1, 0xd7, 0x0f, 0x97, 0x97, 0xaf, 0xe5, 0x58, 0x02, 0xe0, 0x4b, 0xe6, 0xbd, 0x9c, 0x60,
+    0x70, 0xcc, 0x9d, 0xa9, 0x1c, 0xa4, 0x8b, 0xab, 0xdb, 0xe1, 0x92, 0xdd, 0xbe, 0x94, 0xce, 0x40,
+    0x86, 0x50, 0x28, 0x06, 0x7b, 0x3b, 0x8f, 0x24, 0xdf, 0xa3, 0x26, 0x49, 0xb7, 0x46, 0x79, 0x8f,
+    0x94, 0x6f, 0x6b, 0x5d, 0x8e, 0xe7, 0xef, 0xde, 0xea, 0xbd, 0xbc, 0x89, 0x1d, 0x8f, 0x9a, 0xea,
+    0x4c, 0xa7, 0x86, 0xf9, 0x90, 0xab, 0x77, 0x68, 0xbc, 0x34, 0x1f, 0xa8, 0xa2, 0x1b, 0xf4, 0xd4,
+    0xc3, 0x24, 0xe3, 0xa5, 0x4d, 0x9d, 0xa1, 0x89, 0x9e, 0x26, 0xe5, 0xf5, 0xac, 0x3d, 0xac, 0x77,
+    0x07, 0xfd, 0x97, 0x59, 0xdf, 0x77, 0xda, 0xee, 0xb6, 0x7a, 0x43, 0xd8, 0xd0, 0x6d, 0x4f, 0x12,
+    0xc9, 0xb6, 0xbf, 0xde, 0x95, 0xd7, 0xea, 0xe9, 0x43, 0x03, 0x61, 0x41, 0x4d, 0x91, 0x91, 0xb7,
+    0x48, 0xac, 0x8e, 0x20, 0x32, 0xea, 0xd9, 0x70, 0x12, 0x08, 0xa2, 0xac, 0xb7, 0xeb, 0x9a, 0x4a,
+    0xbf, 0x9a, 0xd1, 0x55, 0x81, 0xbe, 0xb7, 0x0c, 0x7c, 0x40, 0x0a, 0xbc, 0xe7, 0xcf, 0x07, 0x28,
+    0x0d, 0x57, 0x95, 0xe1, 0x83, 0x52, 0xf3, 0x79, 0x1f, 0x6a, 0x72, 0x1f, 0x27, 0x78, 0x9a, 0x90,
+    0x25, 0xf8, 0x01, 0x62, 0x8d, 0x0a, 0xdd, 0xe7, 0x3a, 0x08, 0x5f, 0xf4, 0x4f, 0x1e, 0xb2, 0x70,
+    0x83, 0x5e, 0xcb, 0xb8, 0x4e, 0xa8, 0x79, 0x48, 0x65, 0xf9, 0xff, 0xec, 0xe1, 0x1c, 0xea, 0x0b,
+    0xa2, 0x80, 0x9c, 0x30, 0x2b, 0x86, 0x29, 0x7a, 0x5e, 0xd8, 0xea, 0x1a, 0x45, 0xc2, 0xd2, 0x5c,
+    0x52, 0xdd, 0xf2, 0x50, 0x0e, 0x59, 0xb5, 0xd7, 0x11, 0x16, 0x0c, 0x3c, 0x96, 0xb5, 0x8c, 0xb0,
+    0x4b, 0xd4, 0x19, 0x88, 0x1d, 0x69, 0xb7, 0x66, 0x11, 0x22, 0x6b, 0x60, 0x2e, 0x97, 0x00, 0xc8,
+    0xdc, 0xfe, 0x26, 0x0f, 0xe9, 0x69, 0xe7, 0xea, 0xbf, 0x04, 0x46, 0x08, 0x9c, 0x4e, 0x7f, 0x48,
+    0xa5, 0xa4, 0x5f, 0xa3, 0xae, 0x8e, 0xd7, 0x91, 0xa6, 0x2c, 0x7f, 0x8d, 0x20, 0xe1, 0x13, 0x84,
+    0x8c, 0x22, 0xcd, 0xa8, 0x9a, 0x49, 0xf6, 0x36, 0x4c, 0xdd, 0x04, 0xa8, 0xec, 0x4b, 0x7f, 0xb7,
+    0xb5, 0xb4, 0xc6, 0x1b, 0x99, 0x6e, 0x98, 0xd3, 0x5e, 0x5a, 0x41, 0xdf, 0x78, 0x69, 0x0d, 0xac,
+    0x73, 0x13, 0x33, 0xcf, 0xfb, 0xbb, 0x06, 0x05, 0xc4, 0xdd, 0xfe, 0xb9, 0xf9, 0xfb, 0xef, 0xe7,
+    0x3d, 0x32, 0xab, 0x8b, 0xde, 0xca, 0x86, 0x50, 0xaa, 0x2a, 0xe3, 0x3a, 0x85, 0x0a, 0x72, 0x6b,
+    0xb2, 0x06, 0xfd, 0xdd, 0xdd, 0x81, 0x95, 0x7f, 0xef, 0x0f, 0xcc, 0xae, 0xbc, 0x2f, 0x4d, 0xc7,
+    0xd2, 0x9f, 0x18, 0xb5, 0xce, 0x9f, 0x3f, 0xbf, 0x80, 0x0d, 0x0c, 0x4e, 0xc9, 0x68, 0xbb, 0xbb,
+    0xf8, 0x8a, 0x54, 0xc4, 0x5d, 0xc5, 0x37, 0xf0, 0x4e, 0x07, 0xa7, 0xc8, 0xf4, 0x66, 0xd7, 0xa7,
+    0x3f, 0x75, 0x67, 0x54, 0xbc, 0x61, 0xf8, 0x86, 0x30, 0x2d, 0x6e, 0x20, 0x2d, 0x75, 0x0d, 0x4e,
+    0xd7, 0xbe, 0xbc, 0xae, 0x3b, 0xf3, 0xe1, 0xd5, 0xc8, 0x09, 0xa2, 0x02, 0xad, 0x6f, 0xdc, 0x9b,
+    0x5d, 0x4e, 0x7f, 0xea, 0x3e, 0x82, 0xfd, 0x15, 0x75, 0xb1, 0xa3, 0x08, 0x0d, 0x7c, 0x46, 0x83,
+    0x75, 0x07, 0xa7, 0x63, 0x23, 0x32, 0xbb, 0x23, 0xfc, 0x41, 0xa2, 0xeb, 0xe5, 0xea, 0x84, 0x1d,
+    0x25, 0x8b, 0x4b, 0xe9, 0x03, 0x71, 0x72, 0x16, 0x86, 0x46, 0x5d, 0x3d, 0xd3, 0x41, 0x70, 0x41,
+    0xd1, 0x48, 0x51, 0xdc, 0x50, 0x32, 0xce, 0x8e, 0xec, 0x0c, 0x12, 0x1c, 0x87, 0x85, 0xab, 0x17,
+    0x07, 0x7e, 0x45, 0x0b, 0x06, 0x23, 0x01, 0xbc, 0xac, 0xd8, 0x80, 0x6d, 0x2b, 0xc3, 0xcb, 0xca,
+    0x8a, 0xdc, 0x8b, 0xe1, 0xb8, 0xba, 0x18, 0x7a, 0xa9, 0x8b, 0x8c, 0x65, 0x05, 0xc9, 0x36, 0x68,
+    0xda, 0xd5, 0x1a, 0x8e, 0xa4, 0x2e, 0x60, 0x1c, 0x00, 0x54, 0x60, 0x40, 0x29, 0x9f, 0x06, 0xd8,
+    0xef, 0x67, 0x6b, 0xb7, 0x4d, 0x46, 0x6f, 0x6a, 0xeb, 0xbc, 0xe9, 0x6f, 0x8c, 0xa6, 0xea, 0x6c,
+    0x1e, 0x66, 0x72, 0xfb, 0x2d, 0x9a, 0xd5, 0x83, 0x05, 0x50, 0x87, 0x9b, 0xa9, 0xf3, 0x27, 0x06,
+    0x20, 0x9b, 0x6c, 0x26, 0x2b, 0x3d, 0x1b, 0x00, 0x69, 0xb4, 0x99, 0x54, 0x2a, 0x95, 0x47, 0x70,
+    0x51, 0xe2, 0x19, 0x6f, 0x26, 0x2c, 0x3e, 0x8b, 0x01, 0xe5, 0x54, 0x29, 0x6b, 0x1e, 0x44, 0x5e,
+    0x3c, 0xb7, 0xe9, 0xe8, 0xc6, 0x00, 0x24, 0x3b, 0x40, 0x94, 0x4e, 0x7e, 0xf9, 0xf8, 0xf6, 0x4d,
+    0xbf, 0x2e, 0x9f, 0x48, 0xd4, 0xad, 0x62, 0x6c, 0xa9, 0x5d, 0xca, 0xe9, 0x8c, 0xc8, 0xa7, 0xdc,
+    0xab, 0xc1, 0x2f, 0xbf, 0x28, 0x3e, 0x37, 0x36, 0x3d, 0xc3, 0x21, 0x0d, 0xff, 0x58, 0xef, 0x1e,
+    0xb5, 0xeb, 0xa4, 0x67, 0x22, 0xbd, 0x86, 0x69, 0xde, 0xae, 0x31, 0x8e, 0xa7, 0x9b, 0xf8, 0x3a,
+    0x54, 0x52, 0x5b, 0xf4, 0x40, 0x88, 0x8a, 0x15, 0xc4, 0x30, 0x44, 0x1b, 0x26, 0x99, 0xc3, 0x30,
+    0xc3, 0xb2, 0xa1, 0x11, 0xe2, 0xd5, 0xba, 0x88, 0x9a, 0xea, 0xfc, 0xe8, 0xf4, 0xca, 0x1d, 0x22,
+    0x52, 0x9e, 0xa3, 0x48, 0x51, 0x2d, 0xcd, 0x52, 0x83, 0x28, 0xad, 0x38, 0x50, 0xc4, 0x4c, 0x3e,
+    0xcb, 0xda, 0xb0, 0xa0, 0x15, 0xaf, 0x2f, 0xc8, 0xd7, 0x38, 0x69, 0xec, 0xab, 0x87, 0xa7, 0x52,
+    0xd2, 0x52, 0x38, 0x93, 0xf2, 0x7c, 0x65, 0x70, 0x41, 0xaa, 0x66, 0xa8, 0x62, 0x4e, 0x49, 0x43,
+    0x36, 0xbe, 0x05, 0x21, 0xf5, 0x50, 0xd6, 0x70, 0x74, 0x2a, 0xd7, 0x1f, 0xd5, 0xfb, 0xc4, 0x4a,
+    0x98, 0x2c, 0x3f, 0x46, 0x0f, 0x64, 0xac, 0x61, 0xee, 0x2c, 0x49, 0xe4, 0x91, 0x95, 0x90, 0x27,
+    0x63, 0xcf, 0x1e, 0x8a, 0xbc, 0x4f, 0x33, 0xde, 0x5d, 0xa6, 0x75, 0x89, 0x68, 0xdf, 0x63, 0x65,
+    0x12, 0x6c, 0x09, 0xf7, 0xbf, 0x20, 0x21, 0x2f, 0xad, 0xa8, 0x8c, 0x76, 0x88, 0x70, 0xb0, 0xb4,
+    0xfe, 0x90, 0xc7, 0xe5, 0x51, 0x41, 0x1d, 0xb8, 0x12, 0x3b, 0x8a, 0x72, 0xb9, 0xcf, 0x25, 0x9b,
+    0xcd, 0x94, 0x22, 0x9d, 0x69, 0xa5, 0x5b, 0x09, 0x64, 0x8c, 0x53, 0xef, 0x01, 0x83, 0x56, 0x6c,
+    0x71, 0x37, 0xd0, 0xb9, 0x3c, 0x08, 0xe9, 0x85, 0x63, 0x4d, 0xde, 0x4b, 0xca, 0xb8, 0xb0, 0xcd,
+    0xc4, 0xb4, 0x92, 0xbc, 0x1a, 0x28, 0xc4, 0xd6, 0xa5, 0x46, 0x3b, 0xdb, 0x02, 0x86, 0x13, 0xda,
+    0xbb, 0xad, 0x04, 0x57, 0x32, 0xe4, 0xe7, 0xeb, 0xcf, 0xd6, 0xd6, 0x9f, 0x99, 0xd6, 0x2c, 0x5f,
+    0x3f, 0x0f, 0xfa, 0xd9, 0xea, 0xf3, 0x2d, 0xcc, 0xb3, 0x70, 0x6f, 0x5a, 0xf7, 0x9b, 0xa9, 0x40,
+    0x34, 0x41, 0x20, 0xce, 0x01, 0xcc, 0xd7, 0x00, 0xcc, 0x4d, 0x6b, 0x9e, 0x03, 0xc8, 0x13, 0x46,
+    0x06, 0x60, 0xf1, 0x8d, 0xe0, 0xe3, 0xa1, 0x2a, 0x70, 0x05, 0x30, 0x7c, 0xfd, 0x06, 0xe1, 0x2a,
+    0xf5, 0x98, 0xd6, 0xd9, 0x16, 0xda, 0xec, 0x88, 0x19, 0x58, 0xcf, 0xd6, 0xb0, 0x9e, 0x99, 0x56,
+    0xe7, 0xf8, 0x4c, 0xa5, 0x51, 0xa4, 0xae, 0xc0, 0x58, 0x50, 0x3c, 0xb7, 0x02, 0xe3, 0x2b, 0x7d,
+    0xc2, 0x60, 0x17, 0x8f, 0xa6, 0xe8, 0xac, 0x92, 0x4f, 0x3a, 0x35, 0x94, 0x6b, 0xd5, 0xdf, 0xa3,
+    0x6f, 0x4a, 0x79, 0xf6, 0x22, 0xf9, 0xe0, 0xf5, 0x2b, 0x16, 0x27, 0x4c, 0xbd, 0x48, 0x95, 0x70,
+    0xf9, 0x9e, 0x82, 0x2c, 0x29, 0xd5, 0xdb, 0x2c, 0x9c, 0xde, 0x75, 0x24, 0x97, 0xa1, 0x47, 0x06,
+    0xcc, 0xe7, 0x0e, 0x05, 0x8f, 0x5d, 0xd2, 0x7d, 0x8c, 0x22, 0x49, 0xa3, 0x30, 0xbb, 0xf4, 0xcd,
+    0x18, 0x1a, 0x0b, 0xd3, 0xda, 0x5d, 0x64, 0x12, 0x05, 0x4a, 0xca, 0xac, 0x39, 0x44, 0x60, 0xfc,
+    0xfa, 0x6f, 0xc1, 0xf8, 0xb5, 0x84, 0xf1, 0x2b, 0x14, 0xb6, 0xb2, 0xfa, 0xb1, 0x42, 0x88, 0x6d,
+    0xb4, 0x4c, 0x5d, 0x09, 0x2c, 0x97, 0x7f, 0x42, 0x95, 0xce, 0x56, 0x65, 0xba, 0x6e, 0xb6, 0xf2,
+    0xb8, 0xf9, 0x57, 0xe7, 0xce, 0xb9, 0x94, 0x3c, 0xb1, 0x23, 0xa2, 0x96, 0xc7, 0xdc, 0x8f, 0x59,
+    0xd0, 0xa1, 0xf5, 0x68, 0x44, 0x27, 0xdc, 0x76, 0x2d, 0x6f, 0x87, 0x26, 0x08, 0x9c, 0x4f, 0x4d,
+    0x9e, 0xaa, 0xa1, 0x9d, 0xac, 0x2d, 0x2f, 0x43, 0x62, 0x16, 0x51, 0x7d, 0x3a, 0x88, 0x93, 0x0b,
+    0xe4, 0x21, 0x7b, 0x75, 0xf4, 0xba, 0x65, 0x9e, 0x8e, 0xc4, 0x05, 0x68, 0x4f, 0x8a, 0xee, 0x65,
+    0x8e, 0x83, 0x52, 0x14, 0x47, 0xfa, 0x29, 0x87, 0xe8, 0x1a, 0xf1, 0xa8, 0x21, 0x4a, 0xab, 0xa5,
+    0x69, 0xa9, 0x4d, 0x31, 0x9c, 0x0e, 0x8f, 0x4b, 0xc7, 0x90, 0x85, 0x82, 0xbe, 0x84, 0x3b, 0x8a,
+    0x45, 0x61, 0xcf, 0x4b, 0x8d, 0xfd, 0x66, 0x9b, 0x58, 0xcb, 0xf2, 0xbc, 0xa9, 0x90, 0xa7, 0x4c,
+    0x51, 0x32, 0x9f, 0x32, 0xae, 0x66, 0x16, 0xd7, 0xd8, 0x08, 0xab, 0x62, 0x5a, 0x35, 0xbc, 0xe9,
+    0x66, 0x95, 0xa0, 0x1c, 0x21, 0x59, 0x28, 0x8c, 0x72, 0x52, 0xa9, 0xb0, 0x21, 0xb5, 0xe6, 0xd2,
+    0x57, 0x6a, 0xa1, 0x7c, 0x28, 0xe5, 0xa5, 0x78, 0x7f, 0xd9, 0xaa, 0xee, 0x47, 0xbc, 0x65, 0x79,
+    0x80, 0x09, 0xdb, 0x0e, 0x07, 0x50, 0x04, 0x65, 0x25, 0x50, 0xaf, 0x52, 0x50, 0xa9, 0x3c, 0x60,
+    0x58, 0x2b, 0x3a, 0x2a, 0xa0, 0xc2, 0x82, 0x94, 0x66, 0xcb, 0xfe, 0xd8, 0xd4, 0x2f, 0xf5, 0x34,
+    0xd5, 0x3f, 0x0b, 0xfd, 0x3b, 0xe7, 0xb8, 0xa9, 0x6d, 0x2e, 0x3a, 0x00, 0x00,
+};
+static const web_asset_t INDEX_HTML_ASSET = {INDEX_HTML_GZ, sizeof(INDEX_HTML_GZ), 14894, "text/html", "\"7b20e05654a85a0d\""};
+
+// web/update.html: 3647 bytes, 2622 minified, 1288 gzipped
+static const uint8_t UPDATE_HTML_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x85, 0x56, 0x6d, 0x6f, 0xdb, 0x36,
+    0x10, 0xfe, 0xae, 0x5f, 0x71, 0x73, 0xd1, 0x52, 0xda, 0x22, 0xf9, 0x25, 0x49, 0xd1, 0xf9, 0x25,
+    0x40, 0xea, 0xb6, 0xc8, 0x80, 0x15, 0x0d, 0x9a, 0x16, 0xed, 0x50, 0xf4, 0x03, 0x2d, 0x51, 0x16,
+    0x57, 0x89, 0xd4, 0x48, 0xca, 0x8e, 0x51, 0xf4, 0xbf, 0xef, 0x8e, 0x94, 0x5d, 0x27, 0x6d, 0x36,
+    0x18, 0x81, 0x24, 0xf2, 0xee, 0xb9, 0xe3, 0x3d, 0xcf, 0x1d, 0x33, 0xff, 0xe5, 0xc5, 0x9b, 0xe5,
+    0xbb, 0xbf, 0xae, 0x5f, 0x42, 0xe5, 0x9a, 0xfa, 0x22, 0x9a, 0xef, 0x1f, 0x82, 0x17, 0xf8, 0x68,
+    0x84, 0xe3, 0x90, 0x57, 0xdc, 0x58, 0xe1, 0x16, 0x83, 0xce, 0x95, 0xe9, 0xb3, 0xc1, 0x7e, 0x59,
+    0xf1, 0x46, 0x2c, 0x06, 0x1b, 0x29, 0xb6, 0xad, 0x36, 0x6e, 0x00, 0xb9, 0x56, 0x4e, 0x28, 0x34,
+    0xdb, 0xca, 0xc2, 0x55, 0x8b, 0x42, 0x6c, 0x64, 0x2e, 0x52, 0xff, 0x71, 0x22, 0x95, 0x74, 0x92,
+    0xd7, 0xa9, 0xcd, 0x79, 0x2d, 0x16, 0x63, 0xc2, 0x70, 0xd2, 0xd5, 0xe2, 0xe2, 0xe5, 0xcd, 0xf5,
+    0xe9, 0x04, 0x96, 0x97, 0xaf, 0xe1, 0xad, 0x5e, 0x69, 0x07, 0x4b, 0x6e, 0xe0, 0x7d, 0x5b, 0x70,
+    0x27, 0xe6, 0xc3, 0x60, 0x11, 0xcd, 0xad, 0xdb, 0xd1, 0x73, 0xa5, 0x8b, 0x1d, 0x7c, 0x8d, 0x4a,
+    0x0c, 0x93, 0x96, 0xbc, 0x91, 0xf5, 0x6e, 0x0a, 0x97, 0x06, 0x51, 0x4f, 0xc0, 0x72, 0x65, 0x53,
+    0x2b, 0x8c, 0x2c, 0x67, 0x51, 0xc3, 0xcd, 0x5a, 0xaa, 0x29, 0x4c, 0x46, 0xed, 0xed, 0x2c, 0x5a,
+    0xf1, 0xfc, 0xcb, 0xda, 0xe8, 0x4e, 0x15, 0x53, 0x78, 0x54, 0x8e, 0xe8, 0x37, 0x8b, 0xbe, 0x45,
+    0x19, 0x25, 0xcb, 0xa5, 0x12, 0x06, 0x11, 0x8f, 0x6d, 0xb6, 0x95, 0x74, 0x02, 0xdd, 0xb4, 0x29,
+    0x84, 0x49, 0x0d, 0x2f, 0x64, 0x67, 0xa7, 0x70, 0x4e, 0x50, 0x2d, 0x2f, 0x0a, 0xa9, 0xd6, 0x7b,
+    0xe4, 0x86, 0xdf, 0x86, 0xc3, 0x4d, 0xe1, 0x6c, 0xd4, 0xaf, 0x84, 0xc8, 0x23, 0xe0, 0x9d, 0xd3,
+    0x04, 0x72, 0x9b, 0xda, 0x8a, 0x17, 0x7a, 0x4b, 0x6b, 0x93, 0xf6, 0x16, 0xce, 0xf0, 0xcf, 0xac,
+    0x57, 0x3c, 0x1e, 0x9d, 0xf8, 0x5f, 0x36, 0x4e, 0x28, 0x9b, 0x6a, 0x82, 0x59, 0xe4, 0xba, 0xd6,
+    0x06, 0x93, 0x3c, 0x3d, 0x3d, 0xdd, 0x43, 0xa5, 0x4e, 0xb7, 0xe8, 0xea, 0x13, 0xee, 0xda, 0x5a,
+    0xf3, 0x22, 0x2d, 0xb5, 0x69, 0xd0, 0xf8, 0x78, 0x3f, 0xa4, 0xf3, 0x2d, 0x92, 0xaa, 0xed, 0xdc,
+    0x27, 0xb7, 0x6b, 0x91, 0x95, 0x52, 0xd6, 0x62, 0xf0, 0x19, 0x0d, 0x0b, 0x69, 0xdb, 0x9a, 0x63,
+    0xa5, 0x56, 0xb5, 0xce, 0xbf, 0x7c, 0xcf, 0x71, 0x8c, 0x4e, 0x84, 0xdc, 0x9f, 0x60, 0x3c, 0x1a,
+    0x3d, 0xbe, 0x8f, 0x61, 0xbb, 0x55, 0x23, 0x9d, 0x47, 0xb9, 0x53, 0xc5, 0xb3, 0xe5, 0xe5, 0xab,
+    0x73, 0x74, 0xed, 0x13, 0xee, 0x2b, 0x76, 0xa8, 0x8e, 0x47, 0xee, 0x8b, 0xef, 0xab, 0x38, 0x05,
+    0xa5, 0xd5, 0x8f, 0x35, 0x3d, 0x23, 0x8b, 0xbc, 0x33, 0x96, 0x40, 0x5a, 0x2d, 0x51, 0x3c, 0xe6,
+    0xa1, 0x14, 0xa6, 0x95, 0xde, 0xfc, 0x40, 0xd5, 0xa3, 0xb3, 0x73, 0x3e, 0x3a, 0xfb, 0x9d, 0x7c,
+    0x1e, 0xb5, 0x46, 0xaf, 0x8d, 0xb0, 0xf6, 0xa7, 0xa5, 0x39, 0xd4, 0x20, 0xe4, 0x81, 0xc5, 0xdc,
+    0x9b, 0xa7, 0x2b, 0xfe, 0x03, 0x6a, 0x39, 0xa6, 0xdf, 0x2c, 0xaa, 0x84, 0x5c, 0x57, 0x6e, 0x7a,
+    0xe7, 0x28, 0x87, 0xe4, 0xc7, 0x7e, 0x91, 0x92, 0x2a, 0x6b, 0xa2, 0xb7, 0x92, 0x45, 0x21, 0xd4,
+    0x5d, 0x6c, 0xe4, 0xa0, 0x7e, 0xa8, 0x76, 0x7b, 0xf0, 0x50, 0xf7, 0x9e, 0x04, 0x7a, 0x75, 0x06,
+    0xa5, 0x8c, 0xbd, 0xa2, 0x91, 0x23, 0xbf, 0x0c, 0xa3, 0xec, 0xd4, 0x12, 0xf0, 0x7c, 0xd8, 0xf7,
+    0xc1, 0x7c, 0xd8, 0x37, 0x27, 0x35, 0x04, 0x3e, 0x0a, 0xb9, 0x81, 0xbc, 0xe6, 0xd6, 0x2e, 0x06,
+    0x07, 0x55, 0x53, 0x83, 0x55, 0x93, 0x9f, 0x76, 0xd7, 0x2b, 0x69, 0x9a, 0x2d, 0x37, 0xe2, 0xd0,
+    0x66, 0x68, 0x17, 0xcd, 0xbd, 0xae, 0x64, 0x81, 0x3d, 0xee, 0x75, 0x36, 0x00, 0x6c, 0xf1, 0x4a,
+    0x17, 0x0b, 0x76, 0xfd, 0xe6, 0xe6, 0x1d, 0x03, 0x9e, 0x53, 0x4a, 0x0b, 0x36, 0xec, 0xbc, 0x13,
+    0x03, 0xa1, 0x72, 0x4f, 0x11, 0x6b, 0xba, 0xda, 0xc9, 0x96, 0x1b, 0x37, 0x24, 0x88, 0x14, 0x77,
+    0x39, 0xdb, 0xa7, 0x73, 0xa4, 0x59, 0x4a, 0xc8, 0x33, 0x0b, 0xc1, 0x8d, 0x04, 0xca, 0xc2, 0x08,
+    0x61, 0x7b, 0x4c, 0x9e, 0xe7, 0xa2, 0x75, 0x0b, 0x96, 0xad, 0xa4, 0x62, 0xf7, 0xec, 0x83, 0x12,
+    0x18, 0x6c, 0x78, 0xdd, 0xe1, 0x67, 0xc8, 0xfd, 0x70, 0x16, 0xb2, 0xf6, 0xf1, 0xfb, 0x72, 0xd0,
+    0x41, 0xf6, 0x3c, 0x50, 0xe4, 0xf6, 0xa2, 0x77, 0xb8, 0xee, 0x17, 0xa7, 0xf3, 0x61, 0x7b, 0xb7,
+    0x74, 0xc7, 0x92, 0x18, 0x3c, 0xb0, 0x45, 0x8c, 0x0e, 0x2e, 0xe6, 0x43, 0xdc, 0xa3, 0x80, 0xe1,
+    0xd1, 0xfa, 0x68, 0xb8, 0x8f, 0x85, 0xa0, 0xcd, 0xf6, 0xfb, 0x56, 0xff, 0xb0, 0xb9, 0x91, 0xad,
+    0xbb, 0x88, 0x86, 0x43, 0xac, 0x39, 0x55, 0x04, 0x99, 0x45, 0x62, 0x3f, 0x5e, 0xbd, 0x05, 0xab,
+    0xc1, 0x55, 0x02, 0x48, 0x86, 0x39, 0x57, 0x50, 0xea, 0x1a, 0xe5, 0xe4, 0x97, 0xbc, 0x10, 0x4a,
+    0x61, 0x32, 0xf8, 0x50, 0x09, 0x64, 0x8b, 0xd6, 0x5a, 0xbe, 0x16, 0x84, 0x52, 0x71, 0x0b, 0x1f,
+    0xc4, 0x6a, 0x69, 0x76, 0xad, 0x0b, 0x00, 0xb2, 0xc1, 0x2d, 0x28, 0xe4, 0x5a, 0x58, 0x07, 0x6b,
+    0x2d, 0x2c, 0xf0, 0x5a, 0xab, 0x35, 0x48, 0x05, 0x1f, 0xd3, 0x70, 0xf6, 0xf4, 0xe6, 0xea, 0x72,
+    0x72, 0xfe, 0x14, 0xb8, 0x2a, 0x08, 0x83, 0xbc, 0x72, 0x0c, 0x6b, 0x44, 0xd9, 0x59, 0xb4, 0x47,
+    0xa0, 0x95, 0x46, 0x89, 0x60, 0x16, 0x01, 0xcc, 0x55, 0xdc, 0x41, 0x41, 0x50, 0x0a, 0x97, 0x1b,
+    0xee, 0xf2, 0x0a, 0xa4, 0xcb, 0xa2, 0x42, 0xe7, 0x5d, 0x83, 0x73, 0x3e, 0x5b, 0x0b, 0xf7, 0xb2,
+    0x16, 0xf4, 0xfa, 0x7c, 0xf7, 0x47, 0x11, 0xb3, 0xc0, 0x36, 0x4b, 0x32, 0xad, 0x02, 0x5b, 0xb0,
+    0x00, 0x6e, 0x77, 0x2a, 0x87, 0xb2, 0x53, 0x5e, 0x3f, 0x10, 0x8b, 0xc4, 0x4f, 0x3a, 0x85, 0x59,
+    0x92, 0x02, 0xd0, 0xc2, 0x55, 0xd2, 0x66, 0xff, 0x74, 0xc2, 0xec, 0x6e, 0x44, 0x2d, 0x72, 0xa7,
+    0x4d, 0xcc, 0x8e, 0x46, 0x00, 0x59, 0x7d, 0x46, 0x4c, 0x7a, 0xda, 0x4f, 0xa3, 0xcf, 0xb3, 0x48,
+    0x96, 0x10, 0xff, 0x42, 0x9f, 0x09, 0xe6, 0xee, 0x3a, 0x83, 0x5d, 0x27, 0xb0, 0xe9, 0xc4, 0x06,
+    0x13, 0x79, 0x21, 0x4a, 0x8e, 0x34, 0xc4, 0xc9, 0xac, 0x0f, 0x72, 0x98, 0x0b, 0x0b, 0x78, 0x30,
+    0xef, 0xbd, 0x0d, 0x3b, 0x78, 0xf9, 0xce, 0x3d, 0xf2, 0xb8, 0x97, 0xde, 0xdd, 0x16, 0xff, 0xee,
+    0x16, 0x34, 0xf0, 0x5f, 0xa1, 0x82, 0x05, 0x79, 0xec, 0x21, 0x32, 0xdf, 0xd4, 0x59, 0x3f, 0xa2,
+    0xd0, 0x97, 0xf9, 0x41, 0xcd, 0x66, 0x51, 0xb0, 0xcd, 0x9c, 0xb8, 0x75, 0xcb, 0x70, 0xb3, 0xd2,
+    0x2e, 0xdb, 0x07, 0xbb, 0xad, 0x0c, 0x7e, 0x2b, 0xb1, 0x85, 0x8f, 0xaf, 0xff, 0xbc, 0x72, 0xae,
+    0x7d, 0x2b, 0x30, 0x4d, 0xeb, 0xcf, 0x8e, 0x7b, 0x99, 0x6e, 0x85, 0x8a, 0x43, 0xf7, 0x9e, 0xc0,
+    0xa1, 0x6f, 0x93, 0x50, 0xbf, 0xad, 0x54, 0x78, 0x2b, 0x65, 0x79, 0x10, 0xd0, 0x93, 0x27, 0x10,
+    0xde, 0x32, 0xe4, 0xcd, 0xd5, 0x47, 0x1c, 0xf5, 0x82, 0x0a, 0x71, 0xde, 0xe3, 0x88, 0x7e, 0x76,
+    0x69, 0x0c, 0xdf, 0xc5, 0x7c, 0xcb, 0x91, 0xde, 0x3b, 0x4e, 0x59, 0xb0, 0x8d, 0x19, 0xca, 0x2c,
+    0x45, 0x9d, 0x61, 0xd4, 0x60, 0x45, 0x54, 0x65, 0x9c, 0xdc, 0x9e, 0x77, 0x25, 0x0a, 0x3a, 0x4e,
+    0x92, 0x3e, 0x45, 0xfc, 0x9f, 0xa2, 0x4f, 0xfa, 0x0a, 0x07, 0x1a, 0xee, 0xb0, 0x7b, 0x5a, 0x45,
+    0x0c, 0x1f, 0x2f, 0x2b, 0x8d, 0x6e, 0xe2, 0x10, 0xe0, 0x04, 0x56, 0xb0, 0xb8, 0x80, 0x55, 0xe6,
+    0xf4, 0x8d, 0x33, 0x78, 0xe3, 0xc4, 0xe3, 0xa7, 0x49, 0x86, 0xb7, 0xcf, 0x8d, 0xc3, 0x21, 0x14,
+    0x4f, 0xf0, 0xb0, 0x23, 0x96, 0x24, 0xd9, 0xdf, 0x78, 0xa3, 0xc4, 0x8c, 0x25, 0xfe, 0x82, 0xa5,
+    0x68, 0x41, 0x9e, 0x28, 0xce, 0x23, 0x4d, 0x88, 0x0d, 0x61, 0x7d, 0xf5, 0x35, 0x11, 0x9b, 0xac,
+    0x16, 0x6a, 0xed, 0xaa, 0xa5, 0x6e, 0x50, 0x7e, 0x7c, 0x45, 0x85, 0x20, 0x82, 0x7b, 0x8a, 0xc2,
+    0x34, 0x5e, 0x04, 0x43, 0x44, 0x12, 0x05, 0xfc, 0x4a, 0xf3, 0x1b, 0x86, 0x08, 0x83, 0xd9, 0x38,
+    0x5e, 0x27, 0xf0, 0x1b, 0xb0, 0xc7, 0x48, 0xd1, 0xb7, 0x9e, 0x03, 0xe5, 0xbb, 0x1d, 0x7d, 0x12,
+    0x1f, 0x07, 0x7e, 0xca, 0x29, 0x59, 0xe2, 0x46, 0x8b, 0x15, 0x17, 0xef, 0x70, 0x67, 0x06, 0x07,
+    0x77, 0x61, 0x8c, 0x36, 0xff, 0xe7, 0xcf, 0xfa, 0xa1, 0x52, 0x72, 0xac, 0x74, 0xc1, 0xbc, 0x7b,
+    0xaf, 0x63, 0x1a, 0xea, 0x81, 0xbc, 0x57, 0xf8, 0xfa, 0x02, 0x67, 0x33, 0xc9, 0x83, 0x96, 0x33,
+    0xde, 0xa2, 0x40, 0x7c, 0xd7, 0x7a, 0x61, 0x9c, 0x78, 0x9e, 0x0e, 0xc4, 0xe0, 0x0e, 0x59, 0x25,
+    0xfe, 0x28, 0x78, 0xf3, 0xf4, 0x13, 0x6c, 0x3e, 0xec, 0xef, 0x9c, 0x61, 0xf8, 0x37, 0xf1, 0x5f,
+    0xaf, 0x2c, 0x62, 0xce, 0x3e, 0x0a, 0x00, 0x00,
+};
+static const web_asset_t UPDATE_HTML_ASSET = {UPDATE_HTML_GZ, sizeof(UPDATE_HTML_GZ), 2622, "text/html", "\"eb250cc5d9df70cd\""};
+
+#endif